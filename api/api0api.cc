@@ -34,6 +34,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
 #include "innodb0types.h"
 #include "lock0lock.h"
 #include "lock0types.h"
+#include "log0log.h"
 #include "pars0pars.h"
 #include "rem0cmp.h"
 #include "row0ins.h"
@@ -44,6 +45,8 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
 #include "row0upd.h"
 #include "row0vers.h"
 #include "srv0srv.h"
+#include "sync0prof.h"
+#include "trx0purge.h"
 #include "trx0roll.h"
 #include "ut0counter.h"
 #include "ut0dbg.h"
@@ -292,10 +295,17 @@ static bool ib_btr_cursor_is_positioned(const Btree_pcursor *pcur) noexcept {
          (pcur->m_pos_state == Btr_pcur_positioned::IS_POSITIONED || pcur->m_pos_state == Btr_pcur_positioned::WAS_POSITIONED);
 }
 
-/** Delays an INSERT, DELETE or UPDATE operation if the purge is lagging. */
-static void ib_delay_dml_if_needed() {
-  if (srv_dml_needed_delay) {
-    os_thread_sleep(srv_dml_needed_delay);
+/**
+ * Delays an INSERT, DELETE or UPDATE operation if the purge is lagging.
+ * 
+ * @param[in,out] trx              Transaction doing the operation.
+ */
+static void ib_delay_dml_if_needed(Trx *trx) noexcept {
+  const auto delay = srv_trx_sys->m_purge->m_dml_throttle.acquire();
+
+  if (delay > 0) {
+    trx->m_dml_delay_us += delay;
+    os_thread_sleep(delay);
   }
 }
 
@@ -672,8 +682,14 @@ ib_err_t ib_trx_start(ib_trx_t ib_trx, ib_trx_level_t ib_trx_level) {
   ut_a(ib_trx_level <= IB_TRX_SERIALIZABLE);
 
   if (trx->m_conc_state == TRX_NOT_STARTED) {
-    auto started = trx->start(ULINT_UNDEFINED);
-    ut_a(started);
+    if (trx->m_read_only || srv_config.m_trx_auto_read_only) {
+      /* The transaction is registered in the trx system on its first
+      write or lock, one that only does consistent reads never is. */
+      trx->start_read_only();
+    } else {
+      auto started = trx->start(ULINT_UNDEFINED);
+      ut_a(started);
+    }
 
     trx->m_isolation_level = static_cast<Trx_isolation>(ib_trx_level);
   } else {
@@ -700,6 +716,18 @@ ib_trx_t ib_trx_begin(ib_trx_level_t ib_trx_level) {
   return reinterpret_cast<ib_trx_t>(trx);
 }
 
+ib_trx_t ib_trx_begin_read_only(ib_trx_level_t ib_trx_level) {
+  auto trx = srv_trx_sys->create_user_trx(nullptr);
+
+  trx->m_read_only = true;
+
+  auto started = ib_trx_start(reinterpret_cast<ib_trx_t>(trx), ib_trx_level);
+
+  ut_a(started == DB_SUCCESS);
+
+  return reinterpret_cast<ib_trx_t>(trx);
+}
+
 ib_trx_state_t ib_trx_state(ib_trx_t ib_trx) {
   auto trx = reinterpret_cast<Trx *>(ib_trx);
 
@@ -736,6 +764,36 @@ ib_err_t ib_trx_commit(ib_trx_t ib_trx) {
   return DB_SUCCESS;
 }
 
+ib_err_t ib_trx_commit_async(ib_trx_t ib_trx, ib_trx_durable_cb_t callback, void *ctx) {
+  auto trx = reinterpret_cast<Trx *>(ib_trx);
+
+  IB_CHECK_PANIC();
+
+  ut_a(callback != nullptr);
+
+  trx->m_flush_log_async = true;
+
+  auto err = trx->commit();
+  ut_a(err == DB_SUCCESS);
+
+  const auto lsn = trx->m_commit_lsn;
+
+  err = ib_schema_unlock(ib_trx);
+  ut_a(err == DB_SUCCESS || err == DB_SCHEMA_NOT_LOCKED);
+
+  /* Register before releasing the handle: shutdown waits for the user
+  transactions to go away and the log flusher serves all the waiters
+  before it exits. */
+  log_sys->add_durable_waiter(lsn, callback, ctx);
+
+  err = ib_trx_release(ib_trx);
+  ut_a(err == DB_SUCCESS);
+
+  ib_wake_master_thread();
+
+  return DB_SUCCESS;
+}
+
 ib_err_t ib_trx_rollback(ib_trx_t ib_trx) {
   auto trx = reinterpret_cast<Trx *>(ib_trx);
 
@@ -2524,10 +2582,10 @@ static ib_err_t ib_insert_row_with_lock_retry(que_thr_t *thr, ins_node_t *node,
  * @return DB_SUCCESS or err code
  */
 static ib_err_t ib_execute_insert_query_graph(Table *table, que_fork_t *ins_graph, ins_node_t *node) noexcept {
-  /* This is a short term solution to fix the purge lag. */
-  ib_delay_dml_if_needed();
-
   auto trx = ins_graph->trx;
+
+  ib_delay_dml_if_needed(trx);
+
   auto savept = trx_savept_take(trx);
   auto thr = que_fork_get_first_thr(ins_graph);
 
@@ -2816,8 +2874,7 @@ static ib_err_t ib_execute_update_query_graph(ib_cursor_t *cursor, Btree_pcursor
 
   auto node = q_proc->node.upd;
 
-  /* This is a short term solution to fix the purge lag. */
-  ib_delay_dml_if_needed();
+  ib_delay_dml_if_needed(trx);
 
   ut_a(pcur->get_index()->is_clustered());
   node->m_pcur->copy_stored_position(pcur);
@@ -3994,7 +4051,12 @@ ib_err_t ib_schema_lock_exclusive(ib_trx_t ib_trx) {
 
   if (trx->m_dict_operation_lock_mode == 0 || trx->m_dict_operation_lock_mode == RW_X_LATCH) {
 
-    srv_dict_sys->lock_data_dictionary(trx);
+    /* DDL needs a registered transaction. */
+    err = trx->set_rw_mode();
+
+    if (err == DB_SUCCESS) {
+      srv_dict_sys->lock_data_dictionary(trx);
+    }
   } else {
     err = DB_SCHEMA_NOT_LOCKED;
   }
@@ -4662,6 +4724,72 @@ ib_err_t ib_get_index_stat_n_diff_key_vals(ib_crsr_t ib_crsr, const char *index_
   return DB_SUCCESS;
 }
 
+ib_err_t ib_validate_index(ib_crsr_t ib_crsr, const char *index_name) {
+  IB_CHECK_PANIC();
+
+  auto cursor = reinterpret_cast<ib_cursor_t *>(ib_crsr);
+  auto prebuilt = cursor->prebuilt;
+
+  ut_a(prebuilt->m_trx != nullptr);
+
+  auto index = prebuilt->m_table->get_index_on_name(index_name);
+
+  if (index == nullptr) {
+    return DB_NOT_FOUND;
+  }
+
+  return srv_btree_sys->validate_index(index, prebuilt->m_trx) ? DB_SUCCESS : DB_CORRUPTION;
+}
+
+ib_err_t ib_lock_get_hot_records(std::vector<ib_lock_hot_rec_t> &hot_recs, size_t n) {
+  IB_CHECK_PANIC();
+
+  hot_recs.clear();
+
+  for (auto &hot_rec : srv_lock_sys->get_hot_records(n)) {
+    hot_recs.push_back(ib_lock_hot_rec_t{
+      .table_name = std::move(hot_rec.m_table_name),
+      .index_name = std::move(hot_rec.m_index_name),
+      .space_id = uint32_t(hot_rec.m_page_id.space_id()),
+      .page_no = uint32_t(hot_rec.m_page_id.page_no()),
+      .heap_no = uint32_t(hot_rec.m_heap_no),
+      .n_waits = hot_rec.m_n_waits,
+      .wait_time_us = hot_rec.m_wait_time_us
+    });
+  }
+
+  return DB_SUCCESS;
+}
+
+ib_err_t ib_latch_get_stats(std::vector<ib_latch_stats_t> &stats, size_t n) {
+  IB_CHECK_PANIC();
+
+  stats.clear();
+
+  for (auto &site : sync_latch_profile_get(n)) {
+    stats.push_back(ib_latch_stats_t{
+      .file_name = std::move(site.m_file),
+      .line = uint32_t(site.m_line),
+      .is_rw_lock = site.m_kind == LATCH_KIND_RW_LOCK,
+      .n_acquires = site.m_n_acquires,
+      .n_contended = site.m_n_contended,
+      .n_spin_rounds = site.m_n_spin_rounds,
+      .n_os_waits = site.m_n_os_waits,
+      .wait_time_us = site.m_wait_time_us
+    });
+  }
+
+  return DB_SUCCESS;
+}
+
+ib_err_t ib_latch_reset_stats() {
+  IB_CHECK_PANIC();
+
+  sync_latch_profile_reset();
+
+  return DB_SUCCESS;
+}
+
 ib_err_t ib_update_table_statistics(ib_crsr_t crsr) {
   auto cursor = reinterpret_cast<ib_cursor_t *>(crsr);
   auto table = cursor->prebuilt->m_table;
@@ -29,7 +29,9 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
 #include "innodb0types.h"
 #include "log0recv.h"
 #include "os0sync.h"
+#include "row0pread.h"
 #include "srv0srv.h"
+#include "sync0prof.h"
 #include "trx0sys.h"
 
 static char *srv_file_flush_method_str = nullptr;
@@ -401,6 +403,71 @@ static ib_err_t ib_cfg_var_set_LRU_old_blocks_pct(struct ib_cfg_var *cfg_var, co
 
 /* ib_cfg_var_get_generic() is used to get the value of lru_old_blocks_pct */
 
+/**
+ * Set the value of the config variable "sort_block_size". The value is
+ * rounded up to a multiple of the page size.
+ *
+ * @param cfg_var - in/out: configuration variable to manipulate, must be "sort_block_size"
+ * @param value - in: value to set, must point to ulint variable
+ *
+ * @return DB_SUCCESS if set successfully
+ */
+static ib_err_t ib_cfg_var_set_sort_block_size(struct ib_cfg_var *cfg_var, const void *value) {
+  ut_a(strcasecmp(cfg_var->name, "sort_block_size") == 0);
+  ut_a(cfg_var->type == IB_CFG_ULINT);
+
+  if (cfg_var->validate != nullptr) {
+    ib_err_t ret;
+
+    ret = cfg_var->validate(cfg_var, value);
+
+    if (ret != DB_SUCCESS) {
+      return (ret);
+    }
+  }
+
+  *(ulint *)cfg_var->tank = ut_calc_align(*(const ulint *)value, UNIV_PAGE_SIZE);
+
+  return DB_SUCCESS;
+}
+
+/* ib_cfg_var_get_generic() is used to get the value of sort_block_size */
+
+/**
+ * Set the value of the config variable "latch_profile". The flag is read
+ * by every latch acquisition without a lock.
+ *
+ * @param cfg_var - in/out: configuration variable to manipulate, must be "latch_profile"
+ * @param value - in: value to set, must point to bool variable
+ *
+ * @return DB_SUCCESS if set successfully
+ */
+static ib_err_t ib_cfg_var_set_latch_profile(struct ib_cfg_var *cfg_var, const void *value) {
+  ut_a(strcasecmp(cfg_var->name, "latch_profile") == 0);
+  ut_a(cfg_var->type == IB_CFG_IBOOL);
+
+  static_cast<std::atomic<bool> *>(cfg_var->tank)->store(*static_cast<const bool *>(value), std::memory_order_release);
+
+  return DB_SUCCESS;
+}
+
+/**
+ * Retrieve the value of the config variable "latch_profile".
+ *
+ * @param cfg_var - in: configuration variable whose value to retrieve, must be "latch_profile"
+ * @param value - out: place to store the retrieved value, must point to bool variable
+ *
+ * @return DB_SUCCESS if retrieved successfully
+ */
+static ib_err_t ib_cfg_var_get_latch_profile(const struct ib_cfg_var *cfg_var, void *value) {
+  ut_a(strcasecmp(cfg_var->name, "latch_profile") == 0);
+  ut_a(cfg_var->type == IB_CFG_IBOOL);
+
+  *static_cast<bool *>(value) = static_cast<const std::atomic<bool> *>(cfg_var->tank)->load(std::memory_order_relaxed);
+
+  return DB_SUCCESS;
+}
+
 /* There is no ib_cfg_var_set_version() */
 
 /**
@@ -482,6 +549,16 @@ static const ib_cfg_var cfg_vars_defaults[] = {
    STRUCT_FLD(get, ib_cfg_var_get_generic),
    STRUCT_FLD(tank, &srv_config.m_data_home)},
 
+  {STRUCT_FLD(name, "deadlock_detect_interval"),
+   STRUCT_FLD(type, IB_CFG_ULINT),
+   STRUCT_FLD(flag, IB_CFG_FLAG_NONE),
+   STRUCT_FLD(min_val, 1),
+   STRUCT_FLD(max_val, 1000),
+   STRUCT_FLD(validate, ib_cfg_var_validate_numeric),
+   STRUCT_FLD(set, ib_cfg_var_set_generic),
+   STRUCT_FLD(get, ib_cfg_var_get_generic),
+   STRUCT_FLD(tank, &srv_config.m_deadlock_detect_interval)},
+
   {STRUCT_FLD(name, "doublewrite"),
    STRUCT_FLD(type, IB_CFG_IBOOL),
    STRUCT_FLD(flag, IB_CFG_FLAG_READONLY_AFTER_STARTUP),
@@ -531,6 +608,36 @@ static const ib_cfg_var cfg_vars_defaults[] = {
    STRUCT_FLD(get, ib_cfg_var_get_generic),
    STRUCT_FLD(tank, &srv_config.m_force_recovery)},
 
+  {STRUCT_FLD(name, "index_build_memory"),
+   STRUCT_FLD(type, IB_CFG_ULINT),
+   STRUCT_FLD(flag, IB_CFG_FLAG_NONE),
+   STRUCT_FLD(min_val, 16 * 1024 * 1024),
+   STRUCT_FLD(max_val, ULINT_MAX),
+   STRUCT_FLD(validate, ib_cfg_var_validate_numeric),
+   STRUCT_FLD(set, ib_cfg_var_set_generic),
+   STRUCT_FLD(get, ib_cfg_var_get_generic),
+   STRUCT_FLD(tank, &srv_config.m_index_build_memory)},
+
+  {STRUCT_FLD(name, "index_build_threads"),
+   STRUCT_FLD(type, IB_CFG_ULINT),
+   STRUCT_FLD(flag, IB_CFG_FLAG_NONE),
+   STRUCT_FLD(min_val, 0),
+   STRUCT_FLD(max_val, Parallel_reader::MAX_THREADS),
+   STRUCT_FLD(validate, ib_cfg_var_validate_numeric),
+   STRUCT_FLD(set, ib_cfg_var_set_generic),
+   STRUCT_FLD(get, ib_cfg_var_get_generic),
+   STRUCT_FLD(tank, &srv_config.m_index_build_threads)},
+
+  {STRUCT_FLD(name, "index_fill_factor"),
+   STRUCT_FLD(type, IB_CFG_ULINT),
+   STRUCT_FLD(flag, IB_CFG_FLAG_NONE),
+   STRUCT_FLD(min_val, 10),
+   STRUCT_FLD(max_val, 100),
+   STRUCT_FLD(validate, ib_cfg_var_validate_numeric),
+   STRUCT_FLD(set, ib_cfg_var_set_generic),
+   STRUCT_FLD(get, ib_cfg_var_get_generic),
+   STRUCT_FLD(tank, &srv_config.m_index_fill_factor)},
+
   {STRUCT_FLD(name, "io_capacity"),
    STRUCT_FLD(type, IB_CFG_ULONG),
    STRUCT_FLD(flag, IB_CFG_FLAG_NONE),
@@ -541,6 +648,26 @@ static const ib_cfg_var cfg_vars_defaults[] = {
    STRUCT_FLD(get, ib_cfg_var_get_generic),
    STRUCT_FLD(tank, &srv_config.m_io_capacity)},
 
+  {STRUCT_FLD(name, "latch_profile"),
+   STRUCT_FLD(type, IB_CFG_IBOOL),
+   STRUCT_FLD(flag, IB_CFG_FLAG_NONE),
+   STRUCT_FLD(min_val, 0),
+   STRUCT_FLD(max_val, 0),
+   STRUCT_FLD(validate, nullptr),
+   STRUCT_FLD(set, ib_cfg_var_set_latch_profile),
+   STRUCT_FLD(get, ib_cfg_var_get_latch_profile),
+   STRUCT_FLD(tank, &sync_latch_profile)},
+
+  {STRUCT_FLD(name, "lock_schedule"),
+   STRUCT_FLD(type, IB_CFG_ULINT),
+   STRUCT_FLD(flag, IB_CFG_FLAG_READONLY_AFTER_STARTUP),
+   STRUCT_FLD(min_val, 0),
+   STRUCT_FLD(max_val, 2),
+   STRUCT_FLD(validate, ib_cfg_var_validate_numeric),
+   STRUCT_FLD(set, ib_cfg_var_set_generic),
+   STRUCT_FLD(get, ib_cfg_var_get_generic),
+   STRUCT_FLD(tank, &srv_config.m_lock_schedule)},
+
   {STRUCT_FLD(name, "lock_wait_timeout"),
    STRUCT_FLD(type, IB_CFG_ULINT),
    STRUCT_FLD(flag, IB_CFG_FLAG_NONE),
@@ -611,6 +738,56 @@ static const ib_cfg_var cfg_vars_defaults[] = {
    STRUCT_FLD(get, ib_cfg_var_get_generic),
    STRUCT_FLD(tank, &srv_config.m_max_purge_lag)},
 
+  {STRUCT_FLD(name, "purge_threads"),
+   STRUCT_FLD(type, IB_CFG_ULINT),
+   STRUCT_FLD(flag, IB_CFG_FLAG_READONLY_AFTER_STARTUP),
+   STRUCT_FLD(min_val, 1),
+   STRUCT_FLD(max_val, 32),
+   STRUCT_FLD(validate, ib_cfg_var_validate_numeric),
+   STRUCT_FLD(set, ib_cfg_var_set_generic),
+   STRUCT_FLD(get, ib_cfg_var_get_generic),
+   STRUCT_FLD(tank, &srv_config.m_n_purge_threads)},
+
+  {STRUCT_FLD(name, "purge_batch_size"),
+   STRUCT_FLD(type, IB_CFG_ULINT),
+   STRUCT_FLD(flag, IB_CFG_FLAG_NONE),
+   STRUCT_FLD(min_val, 1),
+   STRUCT_FLD(max_val, 5000),
+   STRUCT_FLD(validate, ib_cfg_var_validate_numeric),
+   STRUCT_FLD(set, ib_cfg_var_set_generic),
+   STRUCT_FLD(get, ib_cfg_var_get_generic),
+   STRUCT_FLD(tank, &srv_config.m_purge_batch_size)},
+
+  {STRUCT_FLD(name, "rollback_segments"),
+   STRUCT_FLD(type, IB_CFG_ULINT),
+   STRUCT_FLD(flag, IB_CFG_FLAG_READONLY_AFTER_STARTUP),
+   STRUCT_FLD(min_val, 1),
+   STRUCT_FLD(max_val, TRX_SYS_MAX_SYSTEM_RSEGS),
+   STRUCT_FLD(validate, ib_cfg_var_validate_numeric),
+   STRUCT_FLD(set, ib_cfg_var_set_generic),
+   STRUCT_FLD(get, ib_cfg_var_get_generic),
+   STRUCT_FLD(tank, &srv_config.m_n_rollback_segments)},
+
+  {STRUCT_FLD(name, "undo_tablespaces"),
+   STRUCT_FLD(type, IB_CFG_ULINT),
+   STRUCT_FLD(flag, IB_CFG_FLAG_READONLY_AFTER_STARTUP),
+   STRUCT_FLD(min_val, 0),
+   STRUCT_FLD(max_val, TRX_SYS_MAX_UNDO_SPACES),
+   STRUCT_FLD(validate, ib_cfg_var_validate_numeric),
+   STRUCT_FLD(set, ib_cfg_var_set_generic),
+   STRUCT_FLD(get, ib_cfg_var_get_generic),
+   STRUCT_FLD(tank, &srv_config.m_n_undo_tablespaces)},
+
+  {STRUCT_FLD(name, "undo_tablespace_max_size"),
+   STRUCT_FLD(type, IB_CFG_ULINT),
+   STRUCT_FLD(flag, IB_CFG_FLAG_NONE),
+   STRUCT_FLD(min_val, 0),
+   STRUCT_FLD(max_val, IB_UINT64_T_MAX),
+   STRUCT_FLD(validate, ib_cfg_var_validate_numeric),
+   STRUCT_FLD(set, ib_cfg_var_set_generic),
+   STRUCT_FLD(get, ib_cfg_var_get_generic),
+   STRUCT_FLD(tank, &srv_config.m_undo_tablespace_max_size)},
+
   {STRUCT_FLD(name, "lru_old_blocks_pct"),
    STRUCT_FLD(type, IB_CFG_ULINT),
    STRUCT_FLD(flag, IB_CFG_FLAG_NONE),
@@ -694,6 +871,16 @@ static const ib_cfg_var cfg_vars_defaults[] = {
    STRUCT_FLD(get, ib_cfg_var_get_generic),
    STRUCT_FLD(tank, &ses_rollback_on_timeout)},
 
+  {STRUCT_FLD(name, "sort_block_size"),
+   STRUCT_FLD(type, IB_CFG_ULINT),
+   STRUCT_FLD(flag, IB_CFG_FLAG_READONLY_AFTER_STARTUP),
+   STRUCT_FLD(min_val, 1024 * 1024),
+   STRUCT_FLD(max_val, 16 * 1024 * 1024),
+   STRUCT_FLD(validate, ib_cfg_var_validate_numeric),
+   STRUCT_FLD(set, ib_cfg_var_set_sort_block_size),
+   STRUCT_FLD(get, ib_cfg_var_get_generic),
+   STRUCT_FLD(tank, &srv_config.m_sort_block_size)},
+
   {STRUCT_FLD(name, "stats_sample_pages"),
    STRUCT_FLD(type, IB_CFG_ULINT),
    STRUCT_FLD(flag, IB_CFG_FLAG_NONE),
@@ -724,6 +911,16 @@ static const ib_cfg_var cfg_vars_defaults[] = {
    STRUCT_FLD(get, ib_cfg_var_get_generic),
    STRUCT_FLD(tank, &srv_n_spin_wait_rounds)},
 
+  {STRUCT_FLD(name, "trx_auto_read_only"),
+   STRUCT_FLD(type, IB_CFG_IBOOL),
+   STRUCT_FLD(flag, IB_CFG_FLAG_NONE),
+   STRUCT_FLD(min_val, 0),
+   STRUCT_FLD(max_val, 0),
+   STRUCT_FLD(validate, nullptr),
+   STRUCT_FLD(set, ib_cfg_var_set_generic),
+   STRUCT_FLD(get, ib_cfg_var_get_generic),
+   STRUCT_FLD(tank, &srv_config.m_trx_auto_read_only)},
+
   {STRUCT_FLD(name, "use_sys_malloc"),
    STRUCT_FLD(type, IB_CFG_IBOOL),
    STRUCT_FLD(flag, IB_CFG_FLAG_NONE),
@@ -942,8 +1139,14 @@ ib_err_t ib_cfg_init() {
   IB_CFG_SET("additional_mem_pool_size", 4 * 1024 * 1024);
   IB_CFG_SET("buffer_pool_size", 8 * 1024 * 1024);
   IB_CFG_SET("data_home_dir", "./");
+  IB_CFG_SET("deadlock_detect_interval", 100);
   IB_CFG_SET("file_per_table", true);
   IB_CFG_SET("flush_method", "fsync");
+  IB_CFG_SET("index_build_memory", 256 * 1024 * 1024);
+  IB_CFG_SET("index_build_threads", 0);
+  IB_CFG_SET("index_fill_factor", 100);
+  IB_CFG_SET("latch_profile", false);
+  IB_CFG_SET("lock_schedule", 0);
   IB_CFG_SET("lock_wait_timeout", 60);
   IB_CFG_SET("log_buffer_size", 384 * 1024);
   IB_CFG_SET("log_file_size", 16 * 1024 * 1024);
@@ -954,6 +1157,11 @@ ib_err_t ib_cfg_init() {
   IB_CFG_SET("rollback_on_timeout", true);
   IB_CFG_SET("read_io_threads", 4);
   IB_CFG_SET("write_io_threads", 4);
+  IB_CFG_SET("purge_threads", 1);
+  IB_CFG_SET("purge_batch_size", 20);
+  IB_CFG_SET("rollback_segments", 32);
+  IB_CFG_SET("sort_block_size", 1024 * 1024);
+  IB_CFG_SET("trx_auto_read_only", false);
 #undef IB_CFG_SET
 
   return (DB_SUCCESS);
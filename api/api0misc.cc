@@ -83,6 +83,7 @@ bool ib_handle_errors(db_err *new_err, Trx *trx, que_thr_t *thr, trx_savept_t *s
       case DB_CANNOT_ADD_CONSTRAINT:
       case DB_TOO_MANY_CONCURRENT_TRXS:
       case DB_OUT_OF_FILE_SPACE:
+      case DB_READONLY:
         if (savept) {
           /* Roll back the latest, possibly incomplete
           insertion or update */
@@ -136,6 +136,13 @@ static const ib_status_t status_vars[] = {
   {"row_total_updated", IB_STATUS_ULINT, &export_vars.innodb_rows_updated},
   {"row_total_deleted", IB_STATUS_ULINT, &export_vars.innodb_rows_deleted},
 
+  /* Purge lag DML throttle */
+  {"dml_purge_delays", IB_STATUS_ULINT, &export_vars.innodb_dml_purge_delays},
+
+  {"dml_purge_delay_time_in_ms", IB_STATUS_ULINT, &export_vars.innodb_dml_purge_delay_time},
+
+  {"dml_purge_rate_per_sec", IB_STATUS_ULINT, &export_vars.innodb_dml_purge_rate},
+
   /* Miscellaneous */
   {"page_size", IB_STATUS_ULINT, &export_vars.innodb_page_size},
 
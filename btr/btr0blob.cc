@@ -249,7 +249,7 @@ db_err Blob::store_big_rec_extern_fields(
 ) noexcept {
 
   ut_ad(rec_offs_validate(rec, index, offsets));
-  ut_ad(local_mtr->memo_contains(index->get_lock(), MTR_MEMO_X_LOCK));
+  ut_ad(local_mtr->memo_contains(index->get_lock(), MTR_MEMO_X_LOCK) || local_mtr->memo_contains(index->get_lock(), MTR_MEMO_SX_LOCK));
   ut_ad(local_mtr->memo_contains(rec_block, MTR_MEMO_PAGE_X_FIX));
   ut_ad(rec_block->get_frame() == page_align(rec));
   ut_a(index->is_clustered());
@@ -431,7 +431,7 @@ void Blob::free_externally_stored_field(
 ) noexcept {
 
 #ifdef UNIV_DEBUG
-  ut_ad(local_mtr->memo_contains(index->get_lock(), MTR_MEMO_X_LOCK));
+  ut_ad(local_mtr->memo_contains(index->get_lock(), MTR_MEMO_X_LOCK) || local_mtr->memo_contains(index->get_lock(), MTR_MEMO_SX_LOCK));
   ut_ad(local_mtr->memo_contains_page(field_ref, MTR_MEMO_PAGE_X_FIX));
   ut_ad(!rec || rec_offs_validate(rec, index, offsets));
 
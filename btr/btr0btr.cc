@@ -280,7 +280,9 @@ ulint Btree::get_size(const Index *index, ulint flag) noexcept{
 
   mtr.start();
 
-  mtr_s_lock(index->get_lock(), &mtr);
+  /* Not S: we latch the root and the space, which a thread holding SX may
+  have latched before it waits for X. */
+  mtr_sx_lock(index->get_lock(), &mtr);
 
   auto root = root_get(index->m_page_id, &mtr);
 
@@ -360,7 +362,7 @@ ulint *Btree::page_get_father_node_ptr(ulint *offsets, mem_heap_t *heap, Btree_c
   const auto page_no = btr_cur->get_block()->get_page_no();
   const auto index = btr_cur->get_index();
 
-  ut_ad(mtr->memo_contains(index->get_lock(), MTR_MEMO_X_LOCK));
+  ut_ad(mtr->memo_contains(index->get_lock(), MTR_MEMO_X_LOCK) || mtr->memo_contains(index->get_lock(), MTR_MEMO_SX_LOCK));
 
   ut_ad(index->get_page_no() != page_no);
 
@@ -953,7 +955,7 @@ void Btree::insert_on_non_leaf_level(Index *index, ulint level, DTuple *tuple, m
   ut_a(err == DB_SUCCESS);
 }
 
-void Btree::attach_half_pages(Index *index, Buf_block *block, rec_t *split_rec, Buf_block *new_block, ulint direction, mtr_t *mtr) noexcept {
+void Btree::attach_half_pages(Index *index, Buf_block *block, rec_t *split_rec, Buf_block *new_block, ulint direction, page_cur_t *parent_cur, mtr_t *mtr) noexcept {
   page_t *lower_page;
   page_t *upper_page;
   ulint lower_page_no;
@@ -976,13 +978,25 @@ void Btree::attach_half_pages(Index *index, Buf_block *block, rec_t *split_rec,
     upper_page = block->get_frame();
     upper_page_no = block->get_page_no();
 
-    /* Look up the index for the node pointer to page */
-    auto offsets = page_get_father_block(nullptr, heap, index, block, mtr, &btr_cur);
+    rec_t *node_ptr;
+    ulint *offsets;
+
+    if (parent_cur != nullptr) {
+      node_ptr = page_cur_get_rec(parent_cur);
+
+      Phy_rec record{index, node_ptr};
+
+      offsets = record.get_col_offsets(nullptr, ULINT_UNDEFINED, &heap, Current_location());
+    } else {
+      /* Look up the index for the node pointer to page */
+      offsets = page_get_father_block(nullptr, heap, index, block, mtr, &btr_cur);
+      node_ptr = btr_cur.get_rec();
+    }
 
     /* Replace the address of the old child node (= page) with the
     address of the new lower half */
 
-    node_ptr_set_child_page_no(btr_cur.get_rec(), offsets, lower_page_no, mtr);
+    node_ptr_set_child_page_no(node_ptr, offsets, lower_page_no, mtr);
     mem_heap_empty(heap);
 
   } else {
@@ -1004,7 +1018,13 @@ void Btree::attach_half_pages(Index *index, Buf_block *block, rec_t *split_rec,
   /* Insert it next to the pointer to the lower half. Note that this
   may generate recursion leading to a split on the higher level. */
 
-  insert_on_non_leaf_level(index, level + 1, node_ptr_upper, mtr, Current_location());
+  if (parent_cur != nullptr) {
+    /* The caller checked that the node pointer fits on the parent */
+    auto rec = page_cur_tuple_insert(parent_cur, node_ptr_upper, index, 0, mtr);
+    ut_a(rec != nullptr);
+  } else {
+    insert_on_non_leaf_level(index, level + 1, node_ptr_upper, mtr, Current_location());
+  }
 
   /* Free the memory heap */
   mem_heap_free(heap);
@@ -1015,9 +1035,10 @@ void Btree::attach_half_pages(Index *index, Buf_block *block, rec_t *split_rec,
   const auto next_page_no = page_get_next(page, mtr);
   const auto space = block->get_space();
 
-  /* Update page links of the level */
+  /* Update page links of the level. Only the brother on the side of
+  the new page changes. */
 
-  if (prev_page_no != FIL_NULL) {
+  if (prev_page_no != FIL_NULL && direction == FSP_DOWN) {
     auto prev_block = block_get(space, prev_page_no, RW_X_LATCH, mtr);
 
 #ifdef UNIV_BTR_DEBUG
@@ -1027,7 +1048,7 @@ void Btree::attach_half_pages(Index *index, Buf_block *block, rec_t *split_rec,
     page_set_next(prev_block->get_frame(), lower_page_no, mtr);
   }
 
-  if (next_page_no != FIL_NULL) {
+  if (next_page_no != FIL_NULL && direction == FSP_UP) {
     auto next_block = block_get(space, next_page_no, RW_X_LATCH, mtr);
 
 #ifdef UNIV_BTR_DEBUG
@@ -1064,6 +1085,101 @@ bool Btree::page_tuple_smaller(Btree_cursor *btr_cur, const DTuple *tuple, ulint
   return cmp_dtuple_rec(btr_cur->get_index()->m_cmp_ctx, tuple, first_rec, offsets) < 0;
 }
 
+rec_t *Btree::page_split_decide(
+  Btree_cursor *btr_cur, const DTuple *tuple, ulint n_ext, ulint n_iterations, byte &direction, page_no_t &hint_page_no,
+  bool &insert_left, mem_heap_t **heap
+) noexcept {
+  rec_t *split_rec{};
+  ulint *offsets{};
+  auto page = btr_cur->get_block()->get_frame();
+  const auto page_no = btr_cur->get_block()->get_page_no();
+  const auto n_uniq = btr_cur->get_index()->get_n_unique_in_tree();
+
+  if (n_iterations > 0) {
+
+    direction = FSP_UP;
+    hint_page_no = page_no + 1;
+    split_rec = page_get_split_rec(btr_cur, tuple, n_ext);
+
+    if (unlikely(split_rec == nullptr)) {
+      insert_left = page_tuple_smaller(btr_cur, tuple, offsets, n_uniq, heap);
+    }
+
+  } else if (page_get_split_rec_to_right(btr_cur, split_rec)) {
+
+    direction = FSP_UP;
+    hint_page_no = page_no + 1;
+
+  } else if (page_get_split_rec_to_left(btr_cur, split_rec)) {
+
+    direction = FSP_DOWN;
+    hint_page_no = page_no - 1;
+
+    ut_ad(split_rec);
+
+  } else {
+
+    direction = FSP_UP;
+    hint_page_no = page_no + 1;
+
+    /* If there is only one record in the index page, we
+    can't split the node in the middle by default. We need
+    to determine whether the new record will be inserted
+    to the left or right. */
+
+    if (page_get_n_recs(page) > 1) {
+      split_rec = page_get_middle_rec(page);
+    } else if (page_tuple_smaller(btr_cur, tuple, offsets, n_uniq, heap)) {
+      split_rec = page_rec_get_next(page_get_infimum_rec(page));
+    } else {
+      split_rec = nullptr;
+    }
+  }
+
+  return split_rec;
+}
+
+void Btree::page_split_move_recs(
+  Btree_cursor *btr_cur, Buf_block *block, Buf_block *new_block, const rec_t *split_rec, rec_t *move_limit, ulint direction,
+  Buf_block *&left_block, Buf_block *&right_block, mtr_t *mtr
+) noexcept {
+  if (direction == FSP_DOWN
+#ifdef UNIV_BTR_AVOID_COPY
+      && page_rec_is_supremum(move_limit)) {
+    /* Instead of moving all records, make the new page the empty page. */
+    left_block = block;
+    right_block = new_block;
+  } else if (
+    direction == FSP_DOWN
+#endif /* UNIV_BTR_AVOID_COPY */
+  ) {
+    auto success{page_move_rec_list_start(new_block, block, move_limit, btr_cur->get_index(), mtr)};
+    ut_a(success);
+
+    left_block = new_block;
+    right_block = block;
+
+    m_lock_sys->update_split_left(right_block, left_block);
+
+#ifdef UNIV_BTR_AVOID_COPY
+  } else if (split_rec == nullptr) {
+    /* Instead of moving all records, make the new page the empty page. */
+    left_block = new_block;
+    right_block = block;
+#endif /* UNIV_BTR_AVOID_COPY */
+
+  } else {
+
+    auto success{page_move_rec_list_end(new_block, block, move_limit, btr_cur->get_index(), mtr)};
+    ut_a(success);
+
+    left_block = block;
+    right_block = new_block;
+
+    m_lock_sys->update_split_right(right_block, left_block);
+  }
+}
+
 rec_t *Btree::page_split_and_insert(Btree_cursor *btr_cur, const DTuple *tuple, ulint n_ext, mtr_t *mtr) noexcept {
   Buf_block *left_block;
   Buf_block *right_block;
@@ -1092,57 +1208,15 @@ rec_t *Btree::page_split_and_insert(Btree_cursor *btr_cur, const DTuple *tuple,
     ut_ad(mtr->memo_contains(block, MTR_MEMO_PAGE_X_FIX));
     ut_ad(page_get_n_recs(page) >= 1);
 
-    auto page_no = block->get_page_no();
-
     /* 1. Decide the split record; split_rec == nullptr means that the
     tuple to be inserted should be the first record on the upper
     half-page */
 
     byte direction;
-    rec_t *split_rec{};
     bool insert_left{};
     page_no_t hint_page_no;
 
-    if (n_iterations > 0) {
-
-      direction = FSP_UP;
-      hint_page_no = page_no + 1;
-      split_rec = page_get_split_rec(btr_cur, tuple, n_ext);
-
-      if (unlikely(split_rec == nullptr)) {
-        insert_left = page_tuple_smaller(btr_cur, tuple, offsets, n_uniq, &heap);
-      }
-
-    } else if (page_get_split_rec_to_right(btr_cur, split_rec)) {
-
-      direction = FSP_UP;
-      hint_page_no = page_no + 1;
-
-    } else if (page_get_split_rec_to_left(btr_cur, split_rec)) {
-
-      direction = FSP_DOWN;
-      hint_page_no = page_no - 1;
-
-      ut_ad(split_rec);
-
-    } else {
-
-      direction = FSP_UP;
-      hint_page_no = page_no + 1;
-
-      /* If there is only one record in the index page, we
-      can't split the node in the middle by default. We need
-      to determine whether the new record will be inserted
-      to the left or right. */
-
-      if (page_get_n_recs(page) > 1) {
-        split_rec = page_get_middle_rec(page);
-      } else if (page_tuple_smaller(btr_cur, tuple, offsets, n_uniq, &heap)) {
-        split_rec = page_rec_get_next(page_get_infimum_rec(page));
-      } else {
-        split_rec = nullptr;
-      }
-    }
+    auto split_rec = page_split_decide(btr_cur, tuple, n_ext, n_iterations, direction, hint_page_no, insert_left, &heap);
 
     /* 2. Allocate a new page to the index */
     auto new_block = page_alloc(btr_cur->get_index(), hint_page_no, direction, page_get_level(page, mtr), mtr);
@@ -1177,7 +1251,7 @@ rec_t *Btree::page_split_and_insert(Btree_cursor *btr_cur, const DTuple *tuple,
 
     /* 4. Do first the modifications in the tree structure */
 
-    attach_half_pages(btr_cur->get_index(), block, first_rec, new_block, direction, mtr);
+    attach_half_pages(btr_cur->get_index(), block, first_rec, new_block, direction, nullptr, mtr);
 
     /* If the split is made on the leaf level and the insert will fit
     on the appropriate half-page, we may release the tree x-latch.
@@ -1199,41 +1273,7 @@ rec_t *Btree::page_split_and_insert(Btree_cursor *btr_cur, const DTuple *tuple,
     }
 
     /* 5. Move then the records to the new page */
-    if (direction == FSP_DOWN
-  #ifdef UNIV_BTR_AVOID_COPY
-        && page_rec_is_supremum(move_limit)) {
-      /* Instead of moving all records, make the new page the empty page. */
-      left_block = block;
-      right_block = new_block;
-    } else if (
-      direction == FSP_DOWN
-  #endif /* UNIV_BTR_AVOID_COPY */
-    ) {
-      auto success{page_move_rec_list_start(new_block, block, move_limit, btr_cur->get_index(), mtr)};
-      ut_a(success);
-
-      left_block = new_block;
-      right_block = block;
-
-      m_lock_sys->update_split_left(right_block, left_block);
-
-  #ifdef UNIV_BTR_AVOID_COPY
-    } else if (split_rec == nullptr) {
-      /* Instead of moving all records, make the new page the empty page. */
-      left_block = new_block;
-      right_block = block;
-  #endif /* UNIV_BTR_AVOID_COPY */
-
-    } else {
-
-      auto success{page_move_rec_list_end(new_block, block, move_limit, btr_cur->get_index(), mtr)};
-      ut_a(success);
-
-      left_block = block;
-      right_block = new_block;
-
-      m_lock_sys->update_split_right(right_block, left_block);
-    }
+    page_split_move_recs(btr_cur, block, new_block, split_rec, move_limit, direction, left_block, right_block, mtr);
 
     /* At this point, split_rec, move_limit and first_rec may point
     to garbage on the old page. */
@@ -1292,6 +1332,148 @@ rec_t *Btree::page_split_and_insert(Btree_cursor *btr_cur, const DTuple *tuple,
   return rec;
 }
 
+bool Btree::page_split_leaf(Btree_cursor *btr_cur, page_cur_t *parent_cur, const DTuple *tuple, ulint n_ext, mtr_t *mtr) noexcept {
+  auto index = btr_cur->get_index();
+  auto block = btr_cur->get_block();
+  auto page = block->get_frame();
+  const auto space = block->get_space();
+  auto parent_page = page_cur_get_page(parent_cur);
+
+  ut_ad(page_is_leaf(page));
+  ut_ad(page_get_n_recs(page) >= 1);
+  ut_ad(mtr->memo_contains(block, MTR_MEMO_PAGE_X_FIX));
+  ut_ad(mtr->memo_contains(page_cur_get_block(parent_cur), MTR_MEMO_PAGE_X_FIX));
+  ut_ad(page_get_level(parent_page, mtr) == 1);
+
+  auto heap = mem_heap_create(1024);
+
+  /* 1. Decide the split record as page_split_and_insert() does */
+
+  byte direction;
+  bool insert_left{};
+  page_no_t hint_page_no;
+
+  auto split_rec = page_split_decide(btr_cur, tuple, n_ext, 0, direction, hint_page_no, insert_left, &heap);
+
+  /* 2. Calculate the first record on the upper half-page and check that
+  the tuple will fit on its half-page and the node pointer to the upper
+  half on the parent. Nothing has been latched or modified yet. */
+
+  rec_t *first_rec;
+  rec_t *move_limit;
+  bool insert_will_fit;
+
+  if (split_rec != nullptr) {
+    first_rec = move_limit = split_rec;
+
+    Phy_rec record{index, split_rec};
+
+    auto offsets = record.get_col_offsets(nullptr, index->get_n_unique_in_tree(), &heap, Current_location());
+
+    insert_will_fit = page_insert_fits(btr_cur, split_rec, offsets, tuple, n_ext, heap);
+
+    insert_left = cmp_dtuple_rec(index->m_cmp_ctx, tuple, split_rec, offsets) < 0;
+
+  } else {
+
+    auto buf = reinterpret_cast<byte *>(mem_heap_alloc(heap, rec_get_converted_size(index, tuple, n_ext)));
+
+    first_rec = rec_convert_dtuple_to_rec(buf, index, tuple, n_ext);
+
+    move_limit = page_rec_get_next(btr_cur->get_rec());
+
+    insert_will_fit = page_insert_fits(btr_cur, nullptr, nullptr, tuple, n_ext, heap);
+  }
+
+  if (!insert_will_fit) {
+    mem_heap_free(heap);
+    return false;
+  }
+
+  {
+    const auto node_ptr = index->build_node_ptr(first_rec, FIL_NULL, heap, 0);
+
+    if (rec_get_converted_size(index, node_ptr, 0) > page_get_max_insert_size(parent_page, 1)) {
+      mem_heap_free(heap);
+      return false;
+    }
+  }
+
+  /* 3. Latch the brother whose link changes, the root for the file
+  segment header and the tablespace. We hold the leaf and parent latches
+  without the tree latch: wait for none of them. */
+
+  const auto brother_page_no = direction == FSP_UP ? page_get_next(page, mtr) : page_get_prev(page, mtr);
+
+  if (brother_page_no != FIL_NULL && block_get_nowait(space, brother_page_no, RW_X_LATCH, mtr) == nullptr) {
+    mem_heap_free(heap);
+    return false;
+  }
+
+  if (page_get_page_no(parent_page) != index->get_page_no() &&
+      block_get_nowait(space, index->get_page_no(), RW_X_LATCH, mtr) == nullptr) {
+    mem_heap_free(heap);
+    return false;
+  }
+
+  auto space_latch = m_fsp->m_fil->space_get_latch(space);
+
+  if (!rw_lock_x_lock_nowait(space_latch)) {
+    mem_heap_free(heap);
+    return false;
+  }
+
+  mtr->memo_push(space_latch, MTR_MEMO_X_LOCK);
+
+  ulint n_reserved;
+
+  if (!m_fsp->reserve_free_extents(&n_reserved, space, 1, FSP_NORMAL, mtr)) {
+    mem_heap_free(heap);
+    return false;
+  }
+
+  /* 4. Allocate the new page; from here on the tree changes. Searches
+  that waited for a leaf latch without the tree latch must restart. The
+  counter is index wide: a search that waited restarts after any split
+  in the index, not only one of its own leaf, see Index::m_n_smo. */
+
+  index->m_n_smo.fetch_add(1, std::memory_order_release);
+
+  auto new_block = page_alloc(index, hint_page_no, direction, 0, mtr);
+
+  if (new_block == nullptr) {
+    m_fsp->m_fil->space_release_free_extents(space, n_reserved);
+    mem_heap_free(heap);
+    return false;
+  }
+
+  page_create(new_block, index, 0, mtr);
+
+  /* 5. Insert the node pointer to the parent, update the brother links
+  and move the records */
+
+  attach_half_pages(index, block, first_rec, new_block, direction, parent_cur, mtr);
+
+  Buf_block *left_block;
+  Buf_block *right_block;
+
+  page_split_move_recs(btr_cur, block, new_block, split_rec, move_limit, direction, left_block, right_block, mtr);
+
+  ut_ad(page_validate(left_block->get_frame(), index));
+  ut_ad(page_validate(right_block->get_frame(), index));
+
+  m_fsp->m_fil->space_release_free_extents(space, n_reserved);
+
+  /* 6. Position the cursor for the insert on the half-page where the
+  tuple belongs, both halves are x-latched in mtr */
+
+  page_cur_search(insert_left ? left_block : right_block, index, tuple, PAGE_CUR_LE, btr_cur->get_page_cur());
+
+  mem_heap_free(heap);
+
+  return true;
+}
+
 void Btree::level_list_remove(space_id_t space, page_t *page, mtr_t *mtr) noexcept {
   ut_ad(mtr->memo_contains_page(page, MTR_MEMO_PAGE_X_FIX));
   ut_ad(space == page_get_space_id(page));
@@ -76,9 +76,10 @@ inline void set_deleted_flag(rec_t *rec, bool set_flag) noexcept {
   rec_set_deleted_flag(rec, set_flag);
 }
 
-void Btree_cursor::latch_leaves(page_t *page, space_id_t space, page_no_t page_no, ulint latch_mode, mtr_t *mtr) noexcept {
+bool Btree_cursor::latch_leaves(page_t *page, space_id_t space, page_no_t page_no, ulint latch_mode, mtr_t *mtr) noexcept {
   ulint mode;
   Buf_block *block;
+  Buf_block *left_block{};
   page_no_t left_page_no;
   page_no_t right_page_no;
 
@@ -88,23 +89,30 @@ void Btree_cursor::latch_leaves(page_t *page, space_id_t space, page_no_t page_n
       mode = latch_mode == BTR_SEARCH_LEAF ? RW_S_LATCH : RW_X_LATCH;
       block = m_btree->block_get(space, page_no, mode, mtr);
       block->m_check_index_page_at_flush = true;
-      return;
+      return true;
 
     case BTR_MODIFY_TREE:
       /* x-latch also brothers from left to right */
       left_page_no = m_btree->page_get_prev(page, mtr);
 
       if (left_page_no != FIL_NULL) {
-        block = m_btree->block_get(space, left_page_no, RW_X_LATCH, mtr);
-#ifdef UNIV_BTR_DEBUG
-        ut_a(m_btree->page_get_next(block->get_frame(), mtr) == page_get_page_no(page));
-#endif /* UNIV_BTR_DEBUG */
-        block->m_check_index_page_at_flush = true;
+        left_block = m_btree->block_get(space, left_page_no, RW_X_LATCH, mtr);
+        left_block->m_check_index_page_at_flush = true;
       }
 
       block = m_btree->block_get(space, page_no, RW_X_LATCH, mtr);
       block->m_check_index_page_at_flush = true;
 
+      /* The left brother was read before the page was latched: a leaf
+      split without the tree latch may have put a new page in between. */
+      if (m_btree->page_get_prev(page, mtr) != left_page_no) {
+        return false;
+      }
+
+#ifdef UNIV_BTR_DEBUG
+      ut_a(left_block == nullptr || m_btree->page_get_next(left_block->get_frame(), mtr) == page_get_page_no(page));
+#endif /* UNIV_BTR_DEBUG */
+
       right_page_no = m_btree->page_get_next(page, mtr);
 
       if (right_page_no != FIL_NULL) {
@@ -115,7 +123,7 @@ void Btree_cursor::latch_leaves(page_t *page, space_id_t space, page_no_t page_n
         block->m_check_index_page_at_flush = true;
       }
 
-      return;
+      return true;
 
     case BTR_SEARCH_PREV:
     case BTR_MODIFY_PREV:
@@ -124,20 +132,142 @@ void Btree_cursor::latch_leaves(page_t *page, space_id_t space, page_no_t page_n
       left_page_no = m_btree->page_get_prev(page, mtr);
 
       if (left_page_no != FIL_NULL) {
-        block = m_btree->block_get(space, left_page_no, mode, mtr);
-        m_left_block = block;
-#ifdef UNIV_BTR_DEBUG
-        ut_a(m_btree->page_get_next(m_left_block->get_frame(), mtr) == page_get_page_no(page));
-#endif /* UNIV_BTR_DEBUG */
+        left_block = m_btree->block_get(space, left_page_no, mode, mtr);
+        m_left_block = left_block;
         m_left_block->m_check_index_page_at_flush = true;
       }
 
       block = m_btree->block_get(space, page_no, mode, mtr);
       block->m_check_index_page_at_flush = true;
-      return;
+
+      if (m_btree->page_get_prev(page, mtr) != left_page_no) {
+        return false;
+      }
+
+#ifdef UNIV_BTR_DEBUG
+      ut_a(left_block == nullptr || m_btree->page_get_next(left_block->get_frame(), mtr) == page_get_page_no(page));
+#endif /* UNIV_BTR_DEBUG */
+
+      return true;
   }
 
   ut_error;
+
+  return false;
+}
+
+bool Btree_cursor::latch_leaves_nowait(page_t *page, space_id_t space, page_no_t page_no, ulint latch_mode, mtr_t *mtr) noexcept {
+  Buf_block *block;
+  Buf_block *left_block{};
+  page_no_t left_page_no{FIL_NULL};
+
+  const auto mode = latch_mode == BTR_SEARCH_LEAF || latch_mode == BTR_SEARCH_PREV ? RW_S_LATCH : RW_X_LATCH;
+  const auto prev = latch_mode == BTR_SEARCH_PREV || latch_mode == BTR_MODIFY_PREV;
+
+  if (prev) {
+    /* latch also left brother */
+    left_page_no = m_btree->page_get_prev(page, mtr);
+
+    if (left_page_no != FIL_NULL) {
+      left_block = m_btree->block_get_nowait(space, left_page_no, mode, mtr);
+
+      if (left_block == nullptr) {
+        return false;
+      }
+
+      m_left_block = left_block;
+      m_left_block->m_check_index_page_at_flush = true;
+    }
+  } else {
+    ut_ad(latch_mode == BTR_SEARCH_LEAF || latch_mode == BTR_MODIFY_LEAF);
+  }
+
+  block = m_btree->block_get_nowait(space, page_no, mode, mtr);
+
+  if (block == nullptr) {
+    return false;
+  }
+
+  block->m_check_index_page_at_flush = true;
+
+  if (prev) {
+    /* See latch_leaves() */
+    if (m_btree->page_get_prev(page, mtr) != left_page_no) {
+      return false;
+    }
+
+#ifdef UNIV_BTR_DEBUG
+    ut_a(left_block == nullptr || m_btree->page_get_next(left_block->get_frame(), mtr) == page_get_page_no(page));
+#endif /* UNIV_BTR_DEBUG */
+  }
+
+  return true;
+}
+
+bool Btree_cursor::latch_leaves_and_release_tree(
+  page_t *page, space_id_t space, page_no_t page_no, ulint latch_mode, Buf_block *parent, ulint savepoint, mtr_t *mtr
+) noexcept {
+  auto lock = m_index->get_lock();
+  const auto leaf_savepoint = mtr->set_savepoint();
+
+  if (latch_leaves_nowait(page, space, page_no, latch_mode, mtr)) {
+    if (parent != nullptr) {
+      mtr->memo_release(parent, MTR_MEMO_PAGE_S_FIX);
+    }
+
+    mtr->release_s_latch_at_savepoint(savepoint, lock);
+
+    return true;
+  }
+
+  /* The tree can't change while we hold the S-latch. */
+  const auto n_smo = m_index->m_n_smo.load(std::memory_order_acquire);
+
+  mtr->rollback_to_savepoint(leaf_savepoint);
+
+  if (parent != nullptr) {
+    mtr->memo_release(parent, MTR_MEMO_PAGE_S_FIX);
+  }
+
+  mtr->release_s_latch_at_savepoint(savepoint, lock);
+
+  if (latch_mode == BTR_SEARCH_PREV || latch_mode == BTR_MODIFY_PREV) {
+    /* The left brother can't be read safely without the tree latch: wait
+    until the leaf is released and search again. */
+    (void) m_btree->block_get(space, page_no, latch_mode == BTR_SEARCH_PREV ? RW_S_LATCH : RW_X_LATCH, mtr);
+
+    return false;
+  }
+
+  return latch_leaves(page, space, page_no, latch_mode, mtr) && m_index->m_n_smo.load(std::memory_order_acquire) == n_smo;
+}
+
+ulint Btree_cursor::non_leaf_latch(ulint height, ulint level, ulint latch_mode) noexcept {
+  ut_ad(height > 0);
+
+  if (height == level) {
+    return RW_X_LATCH;
+  } else if (height == 1 && latch_mode != BTR_CONT_MODIFY_TREE) {
+    return RW_S_LATCH;
+  } else {
+    return RW_NO_LATCH;
+  }
+}
+
+void Btree_cursor::tree_x_latch(mtr_t *mtr) noexcept {
+  auto lock = m_index->get_lock();
+
+  if (rw_lock_get_writer(lock) == RW_LOCK_EX) {
+    /* Only we can hold X, because we hold at least SX. */
+    ut_ad(mtr->memo_contains(lock, MTR_MEMO_X_LOCK));
+    return;
+  }
+
+  ut_ad(mtr->memo_contains(lock, MTR_MEMO_SX_LOCK));
+
+  mtr_x_lock(lock, mtr);
+
+  m_index->m_n_smo.fetch_add(1, std::memory_order_release);
 }
 
 void Btree_cursor::search_to_nth_level(Paths *paths, const Index *index, ulint level, const DTuple *tuple, ulint mode, ulint latch_mode, mtr_t *mtr, Source_location loc) noexcept{
@@ -156,6 +286,9 @@ void Btree_cursor::search_to_nth_level(Paths *paths, const Index *index, ulint l
   IF_DEBUG(ulint insert_planned;)
   ulint estimate;
   ulint root_height{};
+  uint64_t n_smo{};
+  bool tree_s_latched;
+  Buf_block *parent_block;
   mem_heap_t *heap = nullptr;
   ulint offsets_[REC_OFFS_NORMAL_SIZE];
   ulint *offsets = offsets_;
@@ -181,19 +314,26 @@ void Btree_cursor::search_to_nth_level(Paths *paths, const Index *index, ulint l
   m_flag = BTR_CUR_BINARY;
   m_index = index;
 
+search_again:
   /* Store the position of the tree latch we push to mtr so that we
   know how to release it when we have latched leaf node(s) */
 
   savepoint = mtr->set_savepoint();
 
+  tree_s_latched = false;
+  parent_block = nullptr;
+
   if (latch_mode == BTR_MODIFY_TREE) {
-    mtr_x_lock(index->get_lock(), mtr);
+    /* Readers can traverse the tree until the modification starts,
+    see tree_x_latch(). */
+    mtr_sx_lock(index->get_lock(), mtr);
 
   } else if (latch_mode == BTR_CONT_MODIFY_TREE) {
     /* Do nothing */
-    ut_ad(mtr->memo_contains(index->get_lock(), MTR_MEMO_X_LOCK));
+    ut_ad(mtr->memo_contains(index->get_lock(), MTR_MEMO_X_LOCK) || mtr->memo_contains(index->get_lock(), MTR_MEMO_SX_LOCK));
   } else {
     mtr_s_lock(index->get_lock(), mtr);
+    tree_s_latched = true;
   }
 
   page_cursor = get_page_cur();
@@ -242,6 +382,14 @@ void Btree_cursor::search_to_nth_level(Paths *paths, const Index *index, ulint l
     if (height == 0 && latch_mode <= BTR_MODIFY_LEAF) {
 
       rw_latch = latch_mode;
+
+      /* Don't wait for the leaf latch while holding the tree S-latch,
+      see latch_leaves_and_release_tree() */
+      buf_mode = BUF_GET_NOWAIT;
+
+    } else if (height != ULINT_UNDEFINED && height > 0) {
+
+      rw_latch = non_leaf_latch(height, level, latch_mode);
     }
 
   retry_page_get:
@@ -257,6 +405,31 @@ void Btree_cursor::search_to_nth_level(Paths *paths, const Index *index, ulint l
 
     block = get_buf_pool()->get(req, nullptr);
 
+    if (block == nullptr && buf_mode == BUF_GET_NOWAIT) {
+      /* The leaf is latched by another thread: release the tree
+      S-latch, wait for the leaf and check that the tree did not
+      change in between. */
+      n_smo = index->m_n_smo.load(std::memory_order_acquire);
+
+      if (parent_block != nullptr) {
+        mtr->memo_release(parent_block, MTR_MEMO_PAGE_S_FIX);
+        parent_block = nullptr;
+      }
+
+      mtr->release_s_latch_at_savepoint(savepoint, index->get_lock());
+      tree_s_latched = false;
+
+      buf_mode = req.m_mode = BUF_GET;
+
+      block = get_buf_pool()->get(req, nullptr);
+
+      if (index->m_n_smo.load(std::memory_order_acquire) != n_smo) {
+        mtr->rollback_to_savepoint(savepoint);
+
+        goto search_again;
+      }
+    }
+
     if (block == nullptr) {
 
       ut_ad(m_thr != nullptr);
@@ -273,11 +446,6 @@ void Btree_cursor::search_to_nth_level(Paths *paths, const Index *index, ulint l
 
     block->m_check_index_page_at_flush = true;
 
-    if (rw_latch != RW_NO_LATCH) {
-
-      buf_block_dbg_add_level(IF_SYNC_DEBUG(block, SYNC_TREE_NODE));
-    }
-
     ut_ad(index->m_id == m_btree->page_get_index_id(page));
 
     if (unlikely(height == ULINT_UNDEFINED)) {
@@ -286,21 +454,64 @@ void Btree_cursor::search_to_nth_level(Paths *paths, const Index *index, ulint l
       height = m_btree->page_get_level(page, mtr);
       root_height = height;
       m_tree_height = root_height + 1;
+
+      if (height > 0 && (rw_latch = non_leaf_latch(height, level, latch_mode)) != RW_NO_LATCH) {
+        /* The level of the root can't change while we hold the tree latch */
+        block = m_btree->block_get(space, page_no, rw_latch, mtr);
+      }
+    }
+
+    if (rw_latch != RW_NO_LATCH) {
+
+      buf_block_dbg_add_level(IF_SYNC_DEBUG(block, SYNC_TREE_NODE));
+    }
+
+    if (height == 1 && rw_latch == RW_S_LATCH) {
+      /* Released when the leaf is latched */
+      parent_block = block;
     }
 
     if (height == 0) {
-      if (rw_latch == RW_NO_LATCH) {
+      if (!tree_s_latched) {
 
-        latch_leaves(page, space, page_no, latch_mode, mtr);
-      }
+        if (rw_latch == RW_NO_LATCH) {
+          ut_ad(latch_mode == BTR_MODIFY_TREE || latch_mode == BTR_CONT_MODIFY_TREE);
 
-      if ((latch_mode != BTR_MODIFY_TREE) && (latch_mode != BTR_CONT_MODIFY_TREE)) {
+          if (!latch_leaves(page, space, page_no, latch_mode, mtr)) {
+            mtr->rollback_to_savepoint(savepoint);
 
-        /* Release the tree s-latch */
+            goto search_again;
+          }
+        }
+
+        if (parent_block != nullptr) {
+          mtr->memo_release(parent_block, MTR_MEMO_PAGE_S_FIX);
+        }
+
+      } else if (rw_latch == RW_NO_LATCH) {
+
+        /* Latch the leaves and release the parent and the tree s-latch */
+
+        if (!latch_leaves_and_release_tree(page, space, page_no, latch_mode, parent_block, savepoint, mtr)) {
+          mtr->rollback_to_savepoint(savepoint);
+
+          goto search_again;
+        }
+
+      } else {
+
+        /* Release the parent and the tree s-latch */
+
+        if (parent_block != nullptr) {
+          mtr->memo_release(parent_block, MTR_MEMO_PAGE_S_FIX);
+        }
 
         mtr->release_s_latch_at_savepoint(savepoint, index->get_lock());
       }
 
+      parent_block = nullptr;
+      tree_s_latched = false;
+
       page_mode = mode;
     }
 
@@ -316,10 +527,7 @@ void Btree_cursor::search_to_nth_level(Paths *paths, const Index *index, ulint l
 
     if (level == height) {
 
-      if (level > 0) {
-        /* x-latch the page */
-        page = m_btree->page_get(space, page_no, RW_X_LATCH, mtr);
-      }
+      /* A page on a non-leaf level was x-latched before the search */
 
       break;
     }
@@ -377,13 +585,14 @@ void Btree_cursor::open_at_index_side(
 
   latch_mode = latch_mode & ~BTR_ESTIMATE;
 
+search_again:
   /* Store the position of the tree latch we push to mtr so that we
   know how to release it when we have latched the leaf node */
 
   auto savepoint = mtr->set_savepoint();
 
   if (latch_mode == BTR_MODIFY_TREE) {
-    mtr_x_lock(index->get_lock(), mtr);
+    mtr_sx_lock(index->get_lock(), mtr);
   } else {
     mtr_s_lock(index->get_lock(), mtr);
   }
@@ -396,6 +605,8 @@ void Btree_cursor::open_at_index_side(
 
   auto height = ULINT_UNDEFINED;
 
+  Buf_block *parent_block{};
+
   for (;;) {
   
     Buf_pool::Request req {
@@ -421,14 +632,30 @@ void Btree_cursor::open_at_index_side(
       root_height = height;
     }
 
+    if (height == 1 && latch_mode != BTR_CONT_MODIFY_TREE) {
+      /* See non_leaf_latch() */
+      parent_block = get_btree()->block_get(space, page_no, RW_S_LATCH, mtr);
+    }
+
     if (height == 0) {
-      latch_leaves(page, space, page_no, latch_mode, mtr);
+      if (latch_mode == BTR_MODIFY_TREE || latch_mode == BTR_CONT_MODIFY_TREE) {
 
-      if (latch_mode != BTR_MODIFY_TREE && latch_mode != BTR_CONT_MODIFY_TREE) {
+        if (!latch_leaves(page, space, page_no, latch_mode, mtr)) {
 
-        /* Release the tree s-latch */
+          mtr->rollback_to_savepoint(savepoint);
 
-        mtr->release_s_latch_at_savepoint(savepoint, index->get_lock());
+          goto search_again;
+        }
+
+        if (parent_block != nullptr) {
+          mtr->memo_release(parent_block, MTR_MEMO_PAGE_S_FIX);
+        }
+
+      } else if (!latch_leaves_and_release_tree(page, space, page_no, latch_mode, parent_block, savepoint, mtr)) {
+
+        mtr->rollback_to_savepoint(savepoint);
+
+        goto search_again;
       }
     }
 
@@ -484,8 +711,11 @@ void Btree_cursor::open_at_rnd_pos(const Index *index, ulint latch_mode, mtr_t *
   ulint *offsets = offsets_;
   rec_offs_init(offsets_);
 
+search_again:
+  auto savepoint = mtr->set_savepoint();
+
   if (latch_mode == BTR_MODIFY_TREE) {
-    mtr_x_lock(index->get_lock(), mtr);
+    mtr_sx_lock(index->get_lock(), mtr);
   } else {
     mtr_s_lock(index->get_lock(), mtr);
   }
@@ -499,6 +729,8 @@ void Btree_cursor::open_at_rnd_pos(const Index *index, ulint latch_mode, mtr_t *
 
   auto height = ULINT_UNDEFINED;
 
+  Buf_block *parent_block{};
+
   for (;;) {
 
     Buf_pool::Request req {
@@ -521,8 +753,31 @@ void Btree_cursor::open_at_rnd_pos(const Index *index, ulint latch_mode, mtr_t *
       height = m_btree->page_get_level(page, mtr);
     }
 
+    if (height == 1) {
+      /* See non_leaf_latch() */
+      parent_block = m_btree->block_get(space, page_no, RW_S_LATCH, mtr);
+    }
+
     if (height == 0) {
-      latch_leaves(page, space, page_no, latch_mode, mtr);
+      if (latch_mode == BTR_MODIFY_TREE) {
+
+        if (!latch_leaves(page, space, page_no, latch_mode, mtr)) {
+
+          mtr->rollback_to_savepoint(savepoint);
+
+          goto search_again;
+        }
+
+        if (parent_block != nullptr) {
+          mtr->memo_release(parent_block, MTR_MEMO_PAGE_S_FIX);
+        }
+
+      } else if (!latch_leaves_and_release_tree(page, space, page_no, latch_mode, parent_block, savepoint, mtr)) {
+
+        mtr->rollback_to_savepoint(savepoint);
+
+        goto search_again;
+      }
     }
 
     page_cur_open_on_rnd_user_rec(block, page_cursor);
@@ -761,7 +1016,7 @@ db_err Btree_cursor::pessimistic_insert(ulint flags, DTuple *entry, rec_t **rec,
 
   *big_rec = nullptr;
 
-  ut_ad(mtr->memo_contains(get_index()->get_lock(), MTR_MEMO_X_LOCK));
+  ut_ad(mtr->memo_contains(get_index()->get_lock(), MTR_MEMO_X_LOCK) || mtr->memo_contains(get_index()->get_lock(), MTR_MEMO_SX_LOCK));
   ut_ad(mtr->memo_contains(get_block(), MTR_MEMO_PAGE_X_FIX));
 
   /* Try first an optimistic insert; reset the cursor flag: we do not
@@ -821,6 +1076,9 @@ db_err Btree_cursor::pessimistic_insert(ulint flags, DTuple *entry, rec_t **rec,
     }
   }
 
+  /* The page has to be split: block the readers of the tree */
+  tree_x_latch(mtr);
+
   if (index->get_page_no() == get_block()->get_page_no()) {
 
     /* The page is the root page */
@@ -849,6 +1107,108 @@ db_err Btree_cursor::pessimistic_insert(ulint flags, DTuple *entry, rec_t **rec,
   return DB_SUCCESS;
 }
 
+bool Btree_cursor::split_leaf(const DTuple *entry, ulint n_ext, mtr_t *mtr) noexcept {
+  auto index = m_index;
+  auto block = get_block();
+  auto page = block->get_frame();
+  const auto space = block->get_space();
+
+  ut_ad(page_is_leaf(page));
+  ut_ad(mtr->memo_contains(block, MTR_MEMO_PAGE_X_FIX));
+
+  if (block->get_page_no() == index->get_page_no() || page_rec_needs_ext(rec_get_converted_size(index, entry, n_ext))) {
+    /* Root raises and records that have to be stored externally
+    are left to pessimistic_insert() */
+    return false;
+  }
+
+  auto lock = index->get_lock();
+  const auto savepoint = mtr->set_savepoint();
+
+  /* We hold the leaf latch: don't wait for the tree latch. The S-latch
+  only keeps the upper levels still while we look for the parent. */
+
+  if (!rw_lock_s_lock_nowait(lock, __FILE__, __LINE__)) {
+    return false;
+  }
+
+  mtr->memo_push(lock, MTR_MEMO_S_LOCK);
+
+  auto heap = mem_heap_create(256);
+  auto user_rec = page_rec_get_next(page_get_infimum_rec(page));
+  auto tuple = index->build_node_ptr(user_rec, 0, heap, 0);
+
+  page_cur_t parent_cur;
+  Buf_block *parent{};
+  auto page_no = index->get_page_no();
+
+  for (auto height = ULINT_UNDEFINED;;) {
+    Buf_block *node;
+
+    if (height == 1) {
+      /* Searches s-latch the pages on level 1: see non_leaf_latch() */
+      node = m_btree->block_get_nowait(space, page_no, RW_X_LATCH, mtr);
+
+      if (node == nullptr) {
+        break;
+      }
+    } else {
+      node = m_btree->block_get(space, page_no, RW_NO_LATCH, mtr);
+    }
+
+    if (height == ULINT_UNDEFINED) {
+      height = m_btree->page_get_level(node->get_frame(), mtr);
+
+      ut_ad(height > 0);
+
+      if (height == 1) {
+        /* The root is the parent, latch it */
+        continue;
+      }
+    }
+
+    page_cur_search(node, index, tuple, PAGE_CUR_LE, &parent_cur);
+
+    if (height == 1) {
+      parent = node;
+      break;
+    }
+
+    --height;
+
+    auto node_ptr = page_cur_get_rec(&parent_cur);
+
+    {
+      Phy_rec record{index, node_ptr};
+
+      auto offsets = record.get_col_offsets(nullptr, ULINT_UNDEFINED, &heap, Current_location());
+
+      page_no = m_btree->node_ptr_get_child_page_no(node_ptr, offsets);
+    }
+  }
+
+  /* The parent is x-latched, the tree can be released */
+  mtr->release_s_latch_at_savepoint(savepoint, lock);
+
+  bool split{};
+
+  if (parent != nullptr) {
+    auto node_ptr = page_cur_get_rec(&parent_cur);
+
+    Phy_rec record{index, node_ptr};
+
+    auto offsets = record.get_col_offsets(nullptr, ULINT_UNDEFINED, &heap, Current_location());
+
+    ut_a(m_btree->node_ptr_get_child_page_no(node_ptr, offsets) == block->get_page_no());
+
+    split = m_btree->page_split_leaf(this, &parent_cur, entry, n_ext, mtr);
+  }
+
+  mem_heap_free(heap);
+
+  return split;
+}
+
 db_err Btree_cursor::upd_lock_and_undo(
   ulint flags,
   const upd_t *update,
@@ -1261,7 +1621,7 @@ db_err Btree_cursor::pessimistic_update(
   auto index = m_index;
   auto block = get_block();
 
-  ut_ad(mtr->memo_contains(index->get_lock(), MTR_MEMO_X_LOCK));
+  ut_ad(mtr->memo_contains(index->get_lock(), MTR_MEMO_X_LOCK) || mtr->memo_contains(index->get_lock(), MTR_MEMO_SX_LOCK));
   ut_ad(mtr->memo_contains(block, MTR_MEMO_PAGE_X_FIX));
 
   auto optim_err = optimistic_update(flags, update, cmpl_info, thr, mtr);
@@ -1731,7 +2091,7 @@ db_err Btree_cursor::pessimistic_delete(bool has_reserved_extents, trx_rb_ctx rb
   auto page = block->get_frame();
   auto index = get_index();
 
-  ut_ad(mtr->memo_contains(index->get_lock(), MTR_MEMO_X_LOCK));
+  ut_ad(mtr->memo_contains(index->get_lock(), MTR_MEMO_X_LOCK) || mtr->memo_contains(index->get_lock(), MTR_MEMO_SX_LOCK));
   ut_ad(mtr->memo_contains(block, MTR_MEMO_PAGE_X_FIX));
 
   db_err err{DB_SUCCESS};
@@ -1772,6 +2132,8 @@ db_err Btree_cursor::pessimistic_delete(bool has_reserved_extents, trx_rb_ctx rb
     /* If there is only one record, drop the whole page in
     btr_discard_page, if this is not the root page */
 
+    tree_x_latch(mtr);
+
     m_btree->discard_page(this, mtr);
 
     err = DB_SUCCESS;
@@ -1800,6 +2162,8 @@ db_err Btree_cursor::pessimistic_delete(bool has_reserved_extents, trx_rb_ctx rb
         so that it is equal to the new leftmost node pointer
         on the page */
 
+        tree_x_latch(mtr);
+
         m_btree->node_ptr_delete(index, block, mtr);
 
         auto node_ptr = index->build_node_ptr(next_rec, block->get_page_no(), heap, level);
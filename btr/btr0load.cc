@@ -0,0 +1,339 @@
+/** Copyright (c) 2024 Sunny Bains. All rights reserved. */
+
+/** @file btr/btr0load.cc
+Bottom-up B-tree builder for new indexes. */
+
+#include "btr0load.h"
+
+#include "btr0btr.h"
+#include "buf0buf.h"
+#include "fsp0fsp.h"
+#include "log0log.h"
+#include "mem0mem.h"
+#include "mtr0log.h"
+#include "page0cur.h"
+#include "page0page.h"
+#include "rem0rec.h"
+#include "ut0mem.h"
+
+Btree_load::Btree_load(FSP *fsp, Btree *btree, Index *index, trx_id_t trx_id, ulint fill_factor) noexcept
+  : m_fsp(fsp), m_btree(btree), m_index(index), m_trx_id(trx_id) {
+
+  ut_a(fill_factor > 0 && fill_factor <= 100);
+
+  m_fill_limit = page_get_free_space_of_empty() * fill_factor / 100;
+
+  m_heap = mem_heap_create(1024);
+  m_rec_heap = mem_heap_create(UNIV_PAGE_SIZE);
+
+  m_empty_buf = reinterpret_cast<byte *>(mem_alloc(2 * UNIV_PAGE_SIZE));
+  m_empty_page = reinterpret_cast<page_t *>(ut_align(m_empty_buf, UNIV_PAGE_SIZE));
+
+  /* The root of a new index is an empty leaf page, we use it as the
+  template of the page images. */
+
+  mtr_t mtr;
+
+  mtr.start();
+
+  auto root = m_btree->root_block_get(m_index->m_page_id, &mtr)->get_frame();
+
+  ut_a(page_get_n_recs(root) == 0);
+  ut_a(page_is_leaf(root));
+
+  memcpy(m_empty_page, root, UNIV_PAGE_SIZE);
+
+  mtr.commit();
+}
+
+Btree_load::~Btree_load() noexcept {
+  for (auto &level : m_levels) {
+    mem_free(level.m_buf);
+  }
+
+  mem_free(m_empty_buf);
+
+  mem_heap_free(m_rec_heap);
+  mem_heap_free(m_heap);
+}
+
+void Btree_load::image_empty(Level &level) noexcept {
+  memcpy(level.m_page, m_empty_page, UNIV_PAGE_SIZE);
+
+  level.m_last_rec = page_get_infimum_rec(level.m_page);
+}
+
+db_err Btree_load::insert(const DTuple *tuple, ulint n_ext) noexcept {
+  const auto size = rec_get_converted_size(m_index, tuple, n_ext);
+
+  if (n_ext > 0 || page_rec_needs_ext(size)) {
+    return DB_TOO_BIG_RECORD;
+  }
+
+  auto rec = rec_convert_dtuple_to_rec(reinterpret_cast<byte *>(mem_heap_alloc(m_rec_heap, size)), m_index, tuple, 0);
+
+  Phy_rec record(m_index, rec);
+
+  auto offsets = record.get_col_offsets(nullptr, ULINT_UNDEFINED, &m_rec_heap, Current_location());
+
+  const auto err = append(0, rec, offsets);
+
+  mem_heap_empty(m_rec_heap);
+
+  return err;
+}
+
+db_err Btree_load::append(ulint level, const rec_t *rec, ulint *offsets) noexcept {
+  if (level == m_levels.size()) {
+    auto &new_level = m_levels.emplace_back();
+
+    new_level.m_buf = reinterpret_cast<byte *>(mem_alloc(2 * UNIV_PAGE_SIZE));
+    new_level.m_page = reinterpret_cast<page_t *>(ut_align(new_level.m_buf, UNIV_PAGE_SIZE));
+
+    image_empty(new_level);
+  }
+
+  ut_ad(level < m_levels.size());
+
+  /* Note that write_page() may add a level and move m_levels. */
+  auto page = m_levels[level].m_page;
+
+  /* Leave at least two records on each page. */
+  if (page_get_n_recs(page) >= 2 && page_get_data_size(page) + rec_offs_size(offsets) > m_fill_limit) {
+    const auto err = write_page(level);
+
+    if (err != DB_SUCCESS) {
+      return err;
+    }
+  }
+
+  auto &l = m_levels[level];
+
+  auto inserted = page_cur_insert_rec_low(l.m_last_rec, m_index, rec, offsets, nullptr);
+
+  if (inserted == nullptr && page_get_n_recs(l.m_page) > 0) {
+    const auto err = write_page(level);
+
+    if (err != DB_SUCCESS) {
+      return err;
+    }
+
+    inserted = page_cur_insert_rec_low(m_levels[level].m_last_rec, m_index, rec, offsets, nullptr);
+  }
+
+  if (inserted == nullptr) {
+    return DB_TOO_BIG_RECORD;
+  }
+
+  m_levels[level].m_last_rec = inserted;
+
+  return DB_SUCCESS;
+}
+
+void Btree_load::page_finish(Buf_block *block, ulint level, bool leftmost, mtr_t *mtr) noexcept {
+  auto page = block->get_frame();
+
+  if (level == 0) {
+    if (!m_index->is_clustered()) {
+      page_update_max_trx_id(block, m_trx_id, mtr);
+    }
+  } else if (leftmost) {
+    /* The first record on the leftmost page of a non-leaf level is
+    smaller than any key. */
+    m_btree->set_min_rec_mark(page_rec_get_next(page_get_infimum_rec(page)), mtr);
+  }
+}
+
+db_err Btree_load::write_page(ulint level) noexcept {
+  const auto space = m_index->get_space_id();
+
+  log_sys->free_check();
+
+  mtr_t mtr;
+
+  mtr.start();
+
+  mtr_x_lock(m_index->get_lock(), &mtr);
+
+  ulint n_reserved;
+
+  if (!m_fsp->reserve_free_extents(&n_reserved, space, 1, FSP_NORMAL, &mtr)) {
+    mtr.commit();
+    return DB_OUT_OF_FILE_SPACE;
+  }
+
+  auto &l = m_levels[level];
+  const auto prev_page_no = l.m_prev_page_no;
+  const auto hint_page_no = prev_page_no == FIL_NULL ? 0 : prev_page_no + 1;
+
+  auto block = m_btree->page_alloc(m_index, hint_page_no, FSP_UP, level, &mtr);
+
+  if (block == nullptr) {
+    mtr.commit();
+    m_fsp->m_fil->space_release_free_extents(space, n_reserved);
+    return DB_OUT_OF_FILE_SPACE;
+  }
+
+  auto page = block->get_frame();
+  const auto page_no = block->get_page_no();
+
+  /* The allocation is logged as usual, the page itself is built without
+  redo and logged as one page image. */
+  const auto log_mode = mtr.set_log_mode(MTR_LOG_NONE);
+
+  m_btree->page_create(block, m_index, level, &mtr);
+
+  page_copy_rec_list_end_to_created_page(page, page_get_infimum_rec(l.m_page), m_index, &mtr);
+
+  page_finish(block, level, prev_page_no == FIL_NULL, &mtr);
+
+  if (prev_page_no != FIL_NULL) {
+    Btree::page_set_prev(page, prev_page_no, &mtr);
+  }
+
+  const auto old_mode = mtr.set_log_mode(log_mode);
+  ut_a(old_mode == MTR_LOG_NONE);
+
+  mlog_log_full_page(page, &mtr);
+
+  if (prev_page_no != FIL_NULL) {
+    auto prev_block = m_btree->block_get(space, prev_page_no, RW_X_LATCH, &mtr);
+
+    Btree::page_set_next(prev_block->get_frame(), page_no, &mtr);
+  }
+
+  /* Build the node pointer while the page is latched, the tuple
+  points to the first record. */
+  auto heap = mem_heap_create(256);
+  auto first_rec = page_rec_get_next(page_get_infimum_rec(page));
+  auto node_ptr = m_index->build_node_ptr(first_rec, page_no, heap, level);
+  const auto size = rec_get_converted_size(m_index, node_ptr, 0);
+  auto node_ptr_rec = rec_convert_dtuple_to_rec(reinterpret_cast<byte *>(mem_heap_alloc(heap, size)), m_index, node_ptr, 0);
+
+  ut_ad(page_validate(page, m_index));
+
+  mtr.commit();
+
+  m_fsp->m_fil->space_release_free_extents(space, n_reserved);
+
+  l.m_prev_page_no = page_no;
+  ++l.m_n_pages;
+
+  image_empty(l);
+
+  db_err err{DB_SUCCESS};
+
+  /* A level with one page is moved to the root by finish(), the node
+  pointers go to the level above when the second page is written. */
+
+  if (l.m_n_pages == 1) {
+    Phy_rec record(m_index, node_ptr_rec);
+
+    auto offsets = record.get_col_offsets(nullptr, ULINT_UNDEFINED, &heap, Current_location());
+    auto buf = reinterpret_cast<byte *>(mem_heap_alloc(m_heap, rec_offs_size(offsets)));
+
+    l.m_first_node_ptr = rec_copy(buf, node_ptr_rec, offsets);
+
+  } else {
+
+    if (l.m_n_pages == 2) {
+      Phy_rec record(m_index, m_levels[level].m_first_node_ptr);
+
+      auto offsets = record.get_col_offsets(nullptr, ULINT_UNDEFINED, &heap, Current_location());
+
+      err = append(level + 1, m_levels[level].m_first_node_ptr, offsets);
+    }
+
+    if (err == DB_SUCCESS) {
+      Phy_rec record(m_index, node_ptr_rec);
+
+      auto offsets = record.get_col_offsets(nullptr, ULINT_UNDEFINED, &heap, Current_location());
+
+      err = append(level + 1, node_ptr_rec, offsets);
+    }
+  }
+
+  mem_heap_free(heap);
+
+  return err;
+}
+
+void Btree_load::write_root(ulint level) noexcept {
+  auto &l = m_levels[level];
+
+  ut_a(l.m_n_pages == 0);
+
+  log_sys->free_check();
+
+  mtr_t mtr;
+
+  mtr.start();
+
+  mtr_x_lock(m_index->get_lock(), &mtr);
+
+  auto root_block = m_btree->root_block_get(m_index->m_page_id, &mtr);
+  auto root = root_block->get_frame();
+
+  /* See write_page(), the root is logged as one page image too. */
+  const auto log_mode = mtr.set_log_mode(MTR_LOG_NONE);
+
+  /* The segment headers and the brother links of the root are kept. */
+  m_btree->page_empty(root_block, m_index, level, &mtr);
+
+  page_copy_rec_list_end_to_created_page(root, page_get_infimum_rec(l.m_page), m_index, &mtr);
+
+  page_finish(root_block, level, true, &mtr);
+
+  const auto old_mode = mtr.set_log_mode(log_mode);
+  ut_a(old_mode == MTR_LOG_NONE);
+
+  mlog_log_full_page(root, &mtr);
+
+  ut_ad(page_validate(root, m_index));
+
+  mtr.commit();
+
+  image_empty(l);
+}
+
+void Btree_load::flush() noexcept {
+  /* The page images must be durable before the index is used. The pages
+  themselves are flushed like any other dirty page, the page images in the
+  log cover them until then. */
+  log_sys->buffer_flush_to_disk();
+}
+
+db_err Btree_load::finish() noexcept {
+  if (m_levels.empty() || (m_levels[0].m_n_pages == 0 && page_get_n_recs(m_levels[0].m_page) == 0)) {
+    /* No records, the root is already empty. */
+    return DB_SUCCESS;
+  }
+
+  for (ulint level = 0; level < m_levels.size(); ++level) {
+    /* The page image of a level with written pages always has records,
+    the record that didn't fit was appended to the emptied image. */
+    if (m_levels[level].m_n_pages == 0) {
+      ut_a(level + 1 == m_levels.size());
+
+      write_root(level);
+
+      flush();
+
+      return DB_SUCCESS;
+    }
+
+    const auto err = write_page(level);
+
+    if (err != DB_SUCCESS) {
+      return err;
+    }
+
+    /* The level has at least two pages now and their node pointers
+    are on the level above. */
+    ut_a(level + 1 < m_levels.size());
+  }
+
+  ut_error;
+
+  return DB_ERROR;
+}
@@ -306,6 +306,8 @@ void Buf_pool::release(Buf_block *block, ulint rw_latch, mtr_t *mtr) {
     rw_lock_s_unlock(&(block->m_rw_lock));
   } else if (rw_latch == RW_X_LATCH) {
     rw_lock_x_unlock(&(block->m_rw_lock));
+  } else if (rw_latch == RW_SX_LATCH) {
+    rw_lock_sx_unlock(&(block->m_rw_lock));
   }
 }
 
@@ -758,9 +760,10 @@ Buf_block *Buf_pool::get(Request &req, Buf_block *guess) {
 
   ut_ad(req.m_mtr != nullptr);
   ut_ad(req.m_mtr->m_state == MTR_ACTIVE);
-  ut_ad(req.m_rw_latch == RW_S_LATCH || req.m_rw_latch == RW_X_LATCH || req.m_rw_latch == RW_NO_LATCH);
+  ut_ad(req.m_rw_latch == RW_S_LATCH || req.m_rw_latch == RW_X_LATCH || req.m_rw_latch == RW_SX_LATCH || req.m_rw_latch == RW_NO_LATCH);
   ut_ad(req.m_mode != BUF_GET_NO_LATCH || req.m_rw_latch == RW_NO_LATCH);
-  ut_ad(req.m_mode == BUF_GET || req.m_mode == BUF_GET_IF_IN_POOL || req.m_mode == BUF_GET_NO_LATCH);
+  ut_ad(req.m_mode != BUF_GET_NOWAIT || req.m_rw_latch == RW_S_LATCH || req.m_rw_latch == RW_X_LATCH);
+  ut_ad(req.m_mode == BUF_GET || req.m_mode == BUF_GET_IF_IN_POOL || req.m_mode == BUF_GET_NOWAIT || req.m_mode == BUF_GET_NO_LATCH);
 
   ++m_stat.n_page_gets;
 
@@ -866,6 +869,32 @@ Buf_block *Buf_pool::get(Request &req, Buf_block *guess) {
   ut_ad(block->m_page.m_buf_fix_count > 0);
   ut_ad(block->get_state() == BUF_BLOCK_FILE_PAGE);
 
+  if (req.m_mode == BUF_GET_NOWAIT) {
+    bool success;
+
+    if (req.m_rw_latch == RW_S_LATCH) {
+      success = rw_lock_s_lock_nowait(&block->m_rw_lock, req.m_file, req.m_line);
+      fix_type = MTR_MEMO_PAGE_S_FIX;
+    } else {
+      success = rw_lock_x_lock_func_nowait(&block->m_rw_lock, req.m_file, req.m_line);
+      fix_type = MTR_MEMO_PAGE_X_FIX;
+    }
+
+    if (!success) {
+      mutex_enter(&block->m_mutex);
+
+      block->fix_dec();
+
+      mutex_exit(&block->m_mutex);
+
+      return nullptr;
+    }
+
+    req.m_mtr->memo_push(block, fix_type);
+
+    return block;
+  }
+
   switch (req.m_rw_latch) {
     case RW_NO_LATCH:
       if (must_read) {
@@ -897,6 +926,12 @@ Buf_block *Buf_pool::get(Request &req, Buf_block *guess) {
       fix_type = MTR_MEMO_PAGE_S_FIX;
       break;
 
+    case RW_SX_LATCH:
+      rw_lock_sx_lock_func(&block->m_rw_lock, 0, req.m_file, req.m_line);
+
+      fix_type = MTR_MEMO_PAGE_SX_FIX;
+      break;
+
     default:
       ut_ad(req.m_rw_latch == RW_X_LATCH);
       rw_lock_x_lock_func(&block->m_rw_lock, 0, req.m_file, req.m_line);
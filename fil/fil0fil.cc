@@ -1077,7 +1077,7 @@ byte *Fil::op_log_parse_or_replay(byte *ptr, byte *end_ptr, ulint type, space_id
         /* Rename the table if there is not yet a tablespace
       with the same name */
 
-        if (get_space_id_for_table(new_name) == ULINT_UNDEFINED) {
+        if (get_space_id_for_table(new_name) == FIL_NULL) {
           /* We do not care of the old name, that is
         why we pass nullptr as the first argument */
           if (!rename_tablespace(nullptr, space_id, new_name)) {
@@ -1091,7 +1091,7 @@ byte *Fil::op_log_parse_or_replay(byte *ptr, byte *end_ptr, ulint type, space_id
     case MLOG_FILE_CREATE:
       if (tablespace_exists_in_mem(space_id)) {
         /* Do nothing */
-      } else if (get_space_id_for_table(name) != ULINT_UNDEFINED) {
+      } else if (get_space_id_for_table(name) != FIL_NULL) {
         /* Do nothing */
       } else if (log_flags & MLOG_FILE_FLAG_TEMP) {
         /* Temporary table, do nothing */
@@ -2039,7 +2039,7 @@ bool Fil::space_for_table_exists_in_mem(
   return false;
 }
 
-ulint Fil::get_space_id_for_table(const char *name) {
+space_id_t Fil::get_space_id_for_table(const char *name) {
   mutex_enter(&m_mutex);
 
   auto path = make_ibd_name(name, false);
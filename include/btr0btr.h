@@ -194,6 +194,28 @@ struct Btree {
    */
   [[nodiscard]] rec_t *page_split_and_insert(Btree_cursor *cursor, const DTuple *tuple, ulint n_ext, mtr_t *mtr) noexcept;
 
+  /**
+   * Splits a leaf page to halves without the index tree latch. The caller
+   * holds x-latches on the leaf and on its parent on level 1. The siblings,
+   * the root and the tablespace latch are acquired without waiting, because
+   * the leaf latch was acquired first; if any of them is busy, or if the
+   * split would not make room for the tuple on the leaf or for the new
+   * node pointer on the parent, nothing is done. NOTE: the parent and the
+   * leaf can be modified only if the function returns true, but other
+   * pages may have been latched. If the page was split the cursor is
+   * positioned for the insert of the tuple on the half-page where it
+   * belongs, the tuple can then be inserted in the same mtr.
+   *
+   * @param[in,out] cursor      Cursor positioned on the leaf
+   * @param[in,out] parent_cur  Cursor on the node pointer to the leaf
+   * @param[in] tuple           Tuple that did not fit on the leaf
+   * @param[in] n_ext           Number of externally stored columns
+   * @param[in,out] mtr         Mini-transaction
+   *
+   * @return true if the page was split
+   */
+  [[nodiscard]] bool page_split_leaf(Btree_cursor *cursor, page_cur_t *parent_cur, const DTuple *tuple, ulint n_ext, mtr_t *mtr) noexcept;
+
   /**
    * Inserts a data tuple to a tree on a non-leaf level. It is assumed
    * that mtr holds an x-latch on the tree.
@@ -388,6 +410,37 @@ struct Btree {
     return block;
   }
 
+  /**
+   * Gets a buffer page if its latch can be acquired without waiting,
+   * and declares its latching order level.
+   * 
+   * @param[in] space_id        Space id
+   * @param[in] page_no         Page number
+   * @param[in] rw_latch        RW_S_LATCH or RW_X_LATCH
+   * @param[in,out] mtr         Mini-transaction.
+   * 
+   * @return	buffer block or nullptr if the page is latched by another thread
+   */
+  [[nodiscard]] inline Buf_block *block_get_nowait(space_id_t space_id, page_no_t page_no, ulint rw_latch, mtr_t *mtr) noexcept {
+    Buf_pool::Request req {
+      .m_rw_latch = rw_latch,
+      .m_page_id = { space_id, page_no },
+      .m_mode = BUF_GET_NOWAIT,
+      .m_file = __FILE__,
+      .m_line = __LINE__,
+      .m_mtr = mtr
+    };
+
+    auto block = srv_buf_pool->get(req, nullptr);
+
+    if (block != nullptr) {
+
+      buf_block_dbg_add_level(IF_SYNC_DEBUG(block, SYNC_TREE_NODE));
+    }
+
+    return block;
+  }
+
   /**
    * Gets a buffer page and declares its latching order level.
    * 
@@ -572,6 +625,8 @@ struct Btree {
 private:
 #endif /* UNIT_TEST */
 
+  friend struct Btree_load;
+
 #ifdef UNIV_BTR_DEBUG
   /**
    * Validates the root file segment.
@@ -720,6 +775,48 @@ private:
    */
   [[nodiscard]] bool page_insert_fits(Btree_cursor *cursor, const rec_t *split_rec, const ulint *offsets, const DTuple *tuple, ulint n_ext, mem_heap_t *heap) noexcept;
 
+  /**
+   * Decides the split record and the direction of a page split, step 1 of
+   * page_split_and_insert().
+   *
+   * @param[in] cursor          The cursor at which the insert should be made.
+   * @param[in] tuple           The tuple to insert.
+   * @param[in] n_ext           Number of externally stored columns.
+   * @param[in] n_iterations    Number of failed attempts to insert after a split.
+   * @param[out] direction      FSP_UP or FSP_DOWN.
+   * @param[out] hint_page_no   Hint for the page number of the new page.
+   * @param[out] insert_left    true if the tuple goes to the lower half page,
+   *                            only set if the split record is nullptr.
+   * @param[in,out] heap        Heap for offsets.
+   *
+   * @return the first record on the upper half page, or nullptr if the tuple
+   *  should be first
+   */
+  [[nodiscard]] rec_t *page_split_decide(
+    Btree_cursor *cursor, const DTuple *tuple, ulint n_ext, ulint n_iterations, byte &direction, page_no_t &hint_page_no,
+    bool &insert_left, mem_heap_t **heap
+  ) noexcept;
+
+  /**
+   * Moves the records of a split page to the new half page and updates the
+   * record locks, step 5 of page_split_and_insert().
+   *
+   * @param[in] cursor          The cursor at which the insert should be made.
+   * @param[in,out] block       Page to be split.
+   * @param[in,out] new_block   The new half page.
+   * @param[in] split_rec       First record on the upper half page, or nullptr
+   *                            if the tuple will be first.
+   * @param[in] move_limit      First record on the page that goes to the upper half.
+   * @param[in] direction       FSP_UP or FSP_DOWN.
+   * @param[out] left_block     The lower half page.
+   * @param[out] right_block    The upper half page.
+   * @param[in,out] mtr         Mini-transaction.
+   */
+  void page_split_move_recs(
+    Btree_cursor *cursor, Buf_block *block, Buf_block *new_block, const rec_t *split_rec, rec_t *move_limit, ulint direction,
+    Buf_block *&left_block, Buf_block *&right_block, mtr_t *mtr
+  ) noexcept;
+
   /**
    * Attaches the halves of an index page on the appropriate level in an
    * index tree.
@@ -729,9 +826,12 @@ private:
    * @param[in] split_rec       First record on upper half page.
    * @param[in,out] new_block   The new half page.
    * @param[in] direction       FSP_UP or FSP_DOWN.
+   * @param[in,out] parent_cur  Cursor on the x-latched node pointer to block,
+   *                            if the parent has room for the new node pointer,
+   *                            else nullptr and the father is searched for.
    * @param[in] mtr             Mini-transaction handle.
    */
-  void attach_half_pages(Index *index, Buf_block *block, rec_t *split_rec, Buf_block *new_block, ulint direction, mtr_t *mtr) noexcept;
+  void attach_half_pages(Index *index, Buf_block *block, rec_t *split_rec, Buf_block *new_block, ulint direction, page_cur_t *parent_cur, mtr_t *mtr) noexcept;
 
   /**
    * Determine if a tuple is smaller than any record on the page.
@@ -227,6 +227,27 @@ struct Btree_cursor {
    */
   [[nodiscard]] db_err pessimistic_insert(ulint flags, DTuple *entry, rec_t **rec, big_rec_t **big_rec, ulint n_ext, que_thr_t *thr, mtr_t *mtr) noexcept;
 
+  /**
+   * Splits the leaf page of the cursor to make room for an entry without
+   * latching the index tree, if the node pointer to the new page fits on
+   * the parent page. Only the leaf, its parent, the changed brother, the
+   * root and the tablespace are latched, none of them by waiting: splits in
+   * different parts of the index can then run concurrently. The cursor must
+   * be positioned by a BTR_MODIFY_LEAF search. The entry is not inserted:
+   * if the leaf was split the cursor is repositioned on the half-page where
+   * the entry belongs and the caller can retry the optimistic insert in the
+   * same mtr, without another search.
+   *
+   * @param[in] entry           Entry that did not fit on the leaf
+   * @param[in] n_ext           Number of externally stored columns
+   * @param[in,out] mtr         Mini-transaction, it may hold more latches
+   *                            on return even if the leaf was not split.
+   *
+   * @return true if the leaf was split, false if the split needs the
+   *  pessimistic insert under the tree latch
+   */
+  [[nodiscard]] bool split_leaf(const DTuple *entry, ulint n_ext, mtr_t *mtr) noexcept;
+
   /**
    * Updates a record when the update causes no size changes in its fields.
    *
@@ -546,8 +567,78 @@ private:
    * @param[in] latch_mode      The latch mode BTR_SEARCH_LEAF, BTR_MODIFY_LEAF,
    *                            BTR_MODIFY_TREE, BTR_SEARCH_PREV, or BTR_MODIFY_PREV.
    * @param[in,out] mtr         The mini-transaction handle.
+   *
+   * @return false if the left brother was split or freed before it was
+   *  latched, the caller must then release the latches and search again.
+   */
+  [[nodiscard]] bool latch_leaves(page_t *page, space_id_t space, page_no_t page_no, ulint latch_mode, mtr_t *mtr) noexcept;
+
+  /**
+   * Latches the leaf page or pages requested by a search that holds the
+   * index S-latch, but only if no latch has to be waited for.
+   * 
+   * @param[in] page            The leaf page where the search converged.
+   * @param[in] space           The space id.
+   * @param[in] page_no         The page number of the leaf.
+   * @param[in] latch_mode      The latch mode BTR_SEARCH_LEAF, BTR_MODIFY_LEAF,
+   *                            BTR_SEARCH_PREV, or BTR_MODIFY_PREV.
+   * @param[in,out] mtr         The mini-transaction handle.
+   * 
+   * @return true if all the pages were latched, false if some page is latched
+   *  by another thread or the left brother changed; the latches acquired so
+   *  far are then still held.
+   */
+  [[nodiscard]] bool latch_leaves_nowait(page_t *page, space_id_t space, page_no_t page_no, ulint latch_mode, mtr_t *mtr) noexcept;
+
+  /**
+   * Latches the leaf page or pages requested by a search and releases the
+   * index S-latch. The index S-latch must not be held while waiting for a
+   * leaf latch: the holder of the leaf latch may hold the index SX-latch and
+   * wait for X to modify the tree. If a latch can't be acquired at once, the
+   * index S-latch is released first, and the tree is checked for structure
+   * modifications after the wait. The s-latch on the parent is released
+   * too, before any wait: split_leaf() x-latches the parent after the leaf.
+   * 
+   * @param[in] page            The leaf page where the search converged.
+   * @param[in] space           The space id.
+   * @param[in] page_no         The page number of the leaf.
+   * @param[in] latch_mode      The latch mode BTR_SEARCH_LEAF, BTR_MODIFY_LEAF,
+   *                            BTR_SEARCH_PREV, or BTR_MODIFY_PREV.
+   * @param[in] parent          The s-latched parent of the leaf, or nullptr
+   *                            if the leaf is the root.
+   * @param[in] savepoint       Savepoint of the index S-latch in the mtr.
+   * @param[in,out] mtr         The mini-transaction handle.
+   * 
+   * @return false if the tree may have changed, the caller must then release
+   *  the latches down to savepoint and search again.
+   */
+  [[nodiscard]] bool latch_leaves_and_release_tree(
+    page_t *page, space_id_t space, page_no_t page_no, ulint latch_mode, Buf_block *parent, ulint savepoint, mtr_t *mtr
+  ) noexcept;
+
+  /**
+   * Returns the latch a search must hold on a non-leaf page before it
+   * searches the page. split_leaf() modifies pages on level 1 without the
+   * tree latch, so they are s-latched unless the search continues a tree
+   * modification; the page on the target level of the search is x-latched.
+   * 
+   * @param[in] height          Level of the page.
+   * @param[in] level           Target level of the search.
+   * @param[in] latch_mode      The latch mode of the search.
+   * 
+   * @return RW_NO_LATCH, RW_S_LATCH or RW_X_LATCH
+   */
+  [[nodiscard]] static ulint non_leaf_latch(ulint height, ulint level, ulint latch_mode) noexcept;
+
+  /**
+   * Upgrades the index SX-latch taken by BTR_MODIFY_TREE to X before the
+   * tree structure is modified. Readers are blocked only from here until
+   * the mini-transaction commits. Does nothing if the index is already
+   * X-latched.
+   * 
+   * @param[in,out] mtr         The mini-transaction handle.
    */
-  void latch_leaves(page_t *page, space_id_t space, page_no_t page_no, ulint latch_mode, mtr_t *mtr) noexcept;
+  void tree_x_latch(mtr_t *mtr) noexcept;
 
     /**
      * Inserts a record if there is enough space, or if enough space can
@@ -0,0 +1,182 @@
+/** Copyright (c) 2024 Sunny Bains. All rights reserved. */
+
+/** @file include/btr0load.h
+Bottom-up B-tree builder for new indexes.
+
+The tuples must arrive in ascending order and the index must be empty and
+invisible to other transactions, as it is during index creation. The
+records of each level are appended to a page image that is not in the
+buffer pool. When the image reaches the fill factor it is copied to a newly
+allocated index page without redo logging, the finished page is logged as
+a single MLOG_FULL_PAGE record, and a node pointer to the page is appended
+to the level above. No tree descents, record locks or undo log records are
+needed. When the build is finished the only page of the top level is copied
+to the root and the log is flushed before the index is made visible. */
+
+#pragma once
+
+#include "innodb0types.h"
+
+#include <vector>
+
+#include "db0err.h"
+#include "mem0types.h"
+#include "page0types.h"
+#include "rem0types.h"
+#include "trx0types.h"
+
+struct FSP;
+struct Btree;
+struct Buf_block;
+struct DTuple;
+struct Index;
+struct mtr_t;
+
+struct Btree_load {
+  /**
+   * Constructor.
+   *
+   * @param[in] fsp             File space.
+   * @param[in] btree           B-tree.
+   * @param[in,out] index       Index to build, it must be empty.
+   * @param[in] trx_id          Transaction that creates the index, the
+   *                            PAGE_MAX_TRX_ID of secondary index leaves.
+   * @param[in] fill_factor     Percentage of the free space of an empty page
+   *                            that is filled before a new page is started.
+   */
+  Btree_load(FSP *fsp, Btree *btree, Index *index, trx_id_t trx_id, ulint fill_factor) noexcept;
+
+  /**
+   * Destructor.
+   */
+  ~Btree_load() noexcept;
+
+  /**
+   * Appends a tuple to the index. The tuple must not be smaller than
+   * the previous one and it must fit on a page without externally
+   * stored columns.
+   *
+   * @param[in] tuple           Tuple to append.
+   * @param[in] n_ext           Number of externally stored columns.
+   *
+   * @return DB_SUCCESS, DB_TOO_BIG_RECORD or DB_OUT_OF_FILE_SPACE
+   */
+  [[nodiscard]] db_err insert(const DTuple *tuple, ulint n_ext) noexcept;
+
+  /**
+   * Writes the remaining page images and the root and flushes the log.
+   * Must be called once after the last insert() if all the inserts
+   * succeeded.
+   *
+   * @return DB_SUCCESS or DB_OUT_OF_FILE_SPACE
+   */
+  [[nodiscard]] db_err finish() noexcept;
+
+ private:
+  /** Records of one level that are not yet in the index */
+  struct Level {
+    /** Memory for m_page */
+    byte *m_buf{};
+
+    /** Page image, aligned to the page size */
+    page_t *m_page{};
+
+    /** Last record on m_page, or the infimum */
+    rec_t *m_last_rec{};
+
+    /** Last page written on this level, FIL_NULL if none */
+    page_no_t m_prev_page_no{FIL_NULL};
+
+    /** Number of pages written on this level */
+    ulint m_n_pages{};
+
+    /** Node pointer to the first page on this level, it is appended to
+    the level above only when the second page is written. */
+    rec_t *m_first_node_ptr{};
+  };
+
+  /**
+   * Appends a record to the page image of a level. Writes the image
+   * first if the record doesn't fit or the fill factor is reached.
+   *
+   * @param[in] level           Level of the record.
+   * @param[in] rec             Record to append.
+   * @param[in] offsets         Phy_rec::get_col_offsets(rec).
+   *
+   * @return DB_SUCCESS, DB_TOO_BIG_RECORD or DB_OUT_OF_FILE_SPACE
+   */
+  [[nodiscard]] db_err append(ulint level, const rec_t *rec, ulint *offsets) noexcept;
+
+  /**
+   * Copies the page image of a level to a new index page, links it to
+   * the previous page on the level and appends its node pointer to the
+   * level above.
+   *
+   * @param[in] level           Level to write.
+   *
+   * @return DB_SUCCESS or DB_OUT_OF_FILE_SPACE
+   */
+  [[nodiscard]] db_err write_page(ulint level) noexcept;
+
+  /**
+   * Copies the page image of the top level to the root page.
+   *
+   * @param[in] level           The top level.
+   */
+  void write_root(ulint level) noexcept;
+
+  /**
+   * Flushes the log up to the current LSN, which covers the page images
+   * of the index.
+   */
+  void flush() noexcept;
+
+  /**
+   * Sets the fields of a new index page that depend on its position in
+   * the tree.
+   *
+   * @param[in,out] block       Page that was filled.
+   * @param[in] level           Level of the page.
+   * @param[in] leftmost        true if it is the first page on the level.
+   * @param[in,out] mtr         Mini-transaction.
+   */
+  void page_finish(Buf_block *block, ulint level, bool leftmost, mtr_t *mtr) noexcept;
+
+  /**
+   * Empties the page image of a level.
+   *
+   * @param[in,out] level       Level to empty.
+   */
+  void image_empty(Level &level) noexcept;
+
+ private:
+  /** File space */
+  FSP *m_fsp{};
+
+  /** B-tree */
+  Btree *m_btree{};
+
+  /** The index being built */
+  Index *m_index{};
+
+  /** Transaction that creates the index */
+  trx_id_t m_trx_id{};
+
+  /** A page image is written when its data size would exceed this */
+  ulint m_fill_limit{};
+
+  /** Copy of the empty root page, used for emptying the page images */
+  byte *m_empty_buf{};
+
+  /** The empty page image, aligned to the page size */
+  page_t *m_empty_page{};
+
+  /** The levels, the leaf level first */
+  std::vector<Level> m_levels{};
+
+  /** Heap for the first node pointers of the levels */
+  mem_heap_t *m_heap{};
+
+  /** Heap for the records being appended, emptied after each insert */
+  mem_heap_t *m_rec_heap{};
+};
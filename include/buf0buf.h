@@ -609,6 +609,8 @@ inline void buf_page_release_latch(Buf_block *block, ulint rw_latch) {
     rw_lock_s_unlock(&block->m_rw_lock);
   } else if (rw_latch == RW_X_LATCH) {
     rw_lock_x_unlock(&block->m_rw_lock);
+  } else if (rw_latch == RW_SX_LATCH) {
+    rw_lock_sx_unlock(&block->m_rw_lock);
   }
 }
 
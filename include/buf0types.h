@@ -103,6 +103,11 @@ constexpr ulint BUF_GET = 10;
 /** Get if in pool */
 constexpr ulint BUF_GET_IF_IN_POOL = 11;
 
+/** Get and latch only if the latch can be acquired at once, else
+return nullptr. Used by searches that must not wait for a page latch
+while holding the index latch. */
+constexpr ulint BUF_GET_NOWAIT = 13;
+
 /** Get and bufferfix, but set no latch; we have separated
 this case, because it is error-prone programming not to set
 a latch, and it should be used with care */
@@ -542,7 +547,7 @@ struct Buf_pool {
       /** Modify clock value if node is ..._GUESS_ON_CLOCK */
       uint64_t m_modify_clock{};
 
-      /** BUF_GET, BUF_GET_IF_IN_POOL, BUF_GET_NO_LATCH. */
+      /** BUF_GET, BUF_GET_IF_IN_POOL, BUF_GET_NOWAIT, BUF_GET_NO_LATCH. */
       ulint m_mode;
     };
 
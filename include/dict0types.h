@@ -960,6 +960,15 @@ struct Index {
   /** read-write lock protecting the upper levels of the index tree */
   mutable rw_lock_t m_lock;
 
+  /** Number of tree structure modifications, incremented when m_lock is
+  upgraded from SX to X and by leaf splits done without the tree latch.
+  A search that releases the S-latch to wait for a leaf latch compares it
+  to detect that the tree changed in between. It is not scoped to a
+  subtree: any change in the index restarts such a search. Only searches
+  that already blocked on a leaf pay for this, with one more descent from
+  the root. */
+  mutable std::atomic<uint64_t> m_n_smo{};
+
   /** Client compare context. For use defined column types and BLOBs
   the client is responsible for comparing the column values. This field
   is the argument for the callback compare function. */
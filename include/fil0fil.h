@@ -494,6 +494,16 @@ struct Fil {
     return m_n_log_flushes;
   }
 
+  /**
+   * @brief Looks up a single-table or undo tablespace by the name it was
+   * created with in the tablespace memory cache.
+   * 
+   * @param name - table name in the standard 'databasename/tablename' format,
+   *   or the name of an undo tablespace file without the extension
+   * @return space id, FIL_NULL if not found
+   */
+  space_id_t get_space_id_for_table(const char *name);
+
 private:
   /**
    * @brief Frees a space object from the tablespace memory cache. Closes the files in
@@ -539,15 +549,6 @@ private:
    */
   void node_complete_io(fil_node_t *node, IO_request io_request);
 
-  /**
-   * @brief Checks if a single-table tablespace for a given table name
-   * exists in the tablespace memory cache.
-   * 
-   * @param name - table name in the standard 'databasename/tablename' format
-   * @return space id, ULINT_UNDEFINED if not found
-   */
-  ulint get_space_id_for_table(const char *name);
-
   /**
    * @brief Returns the table space by a given id, nullptr if not found.
    * 
@@ -33,7 +33,9 @@ Created 5/7/1996 Heikki Tuuri
 #include "srv0srv.h"
 
 #include <map>
+#include <string>
 #include <unordered_map>
+#include <vector>
 
 struct Trx_sys;
 struct Buf_block;
@@ -489,6 +491,29 @@ struct Lock_sys {
    */
   void cancel_waiting_and_release(Lock *lock) noexcept;
 
+  /**
+   * @brief Searches the waits-for graph for deadlocks and resolves them.
+   *
+   * Run periodically by the deadlock detector thread. Only the lock waits
+   * enqueued since the previous run are searched from: a new cycle in the
+   * waits-for graph must go through a new edge. For each cycle found, the
+   * transaction of least weight on it is chosen as the victim and its lock
+   * wait is cancelled. The caller must own the kernel mutex.
+   */
+  void deadlock_detect() noexcept;
+
+  /**
+   * @brief Computes the scheduling weights of the transactions for LOCK_SCHEDULE_CATS.
+   *
+   * The weight of a transaction is 1 plus the number of transactions that wait for
+   * it, directly or through other waiting transactions. For the chain of waits, each
+   * waiting transaction follows the first lock ahead of it in the queue that it has
+   * to wait for. Run periodically by the deadlock detector thread, so that the
+   * release of a lock does not have to search the waits-for graph. The caller must
+   * own the kernel mutex.
+   */
+  void update_schedule_weights() noexcept;
+
   /**
    * @brief Removes locks on a table to be dropped or truncated.
    *
@@ -540,11 +565,10 @@ struct Lock_sys {
    * @param[in] rec The user record.
    * @param[in] index The clustered index.
    * @param[in] offsets The column offsets obtained from Phy_rec::get_col_offsets(rec, index).
-   * @param[in] has_kernel_mutex True if the caller owns the kernel mutex.
    * 
    * @return true if the transaction id is sensible, false otherwise.
    */
-  [[nodiscard]] bool check_trx_id_sanity(trx_id_t trx_id, const rec_t *rec, const Index *index, const ulint *offsets, bool has_kernel_mutex) noexcept;
+  [[nodiscard]] bool check_trx_id_sanity(trx_id_t trx_id, const rec_t *rec, const Index *index, const ulint *offsets) noexcept;
 
   /**
    * @brief Prints information about a table lock.
@@ -611,10 +635,10 @@ struct Lock_sys {
 
     const auto trx_id = row_get_rec_trx_id(rec, index, offsets);
 
-    if (srv_trx_sys->is_active(trx_id)) {
+    if (srv_trx_sys->is_active_off_kernel(trx_id)) {
       /* The modifying or inserting transaction is active */
 
-      return srv_trx_sys->get_on_id(trx_id);
+      return srv_trx_sys->get_on_id_off_kernel(trx_id);
     } else {
       return nullptr;
     }
@@ -683,6 +707,24 @@ struct Lock_sys {
     m_print_lock_monitor = false;
   }
 
+  /**
+   * @brief Sets the order in which waiting record locks are granted.
+   *
+   * @param[in] schedule The scheduling policy.
+   */
+  void set_schedule(Lock_schedule schedule) noexcept {
+    m_schedule = schedule;
+  }
+
+  /**
+   * @brief Gets the order in which waiting record locks are granted.
+   *
+   * @return The scheduling policy.
+   */
+  [[nodiscard]] Lock_schedule get_schedule() const noexcept {
+    return m_schedule;
+  }
+
   /**
    * @brief Checks if the print InnoDB lock monitor flag is set.
    *
@@ -722,6 +764,44 @@ struct Lock_sys {
    */
   static void destroy(Lock_sys *&lock_sys) noexcept;
 
+  /**
+   * @brief Lock wait statistics of a record, see get_hot_records().
+   */
+  struct Hot_rec {
+    /** Name of the table of the record */
+    std::string m_table_name{};
+
+    /** Name of the index of the record */
+    std::string m_index_name{};
+
+    /** Page of the record */
+    Page_id m_page_id{};
+
+    /** Heap number of the record on the page */
+    ulint m_heap_no{};
+
+    /** Number of lock requests that waited for the record */
+    ulint m_n_waits{};
+
+    /** Total time of the lock waits that ended, in microseconds */
+    uint64_t m_wait_time_us{};
+  };
+
+  /**
+   * @brief Gets the records with the most lock wait time.
+   *
+   * Every record lock wait is counted when it is enqueued and its wait time added
+   * when it ends. The profile keeps at most REC_WAIT_PROFILE_SIZE records, when it
+   * is full the record with the fewest waits is replaced by the new one, which
+   * inherits its count (space-saving counting): a hot record is never evicted by
+   * a burst of records that wait once.
+   *
+   * @param[in] n Maximum number of records to return.
+   *
+   * @return the records, the longest total wait time first.
+   */
+  [[nodiscard]] std::vector<Hot_rec> get_hot_records(ulint n) const noexcept;
+
 #ifndef UNIT_TESTING
 private:
 #endif /* !UNIT_TESTING */
@@ -793,29 +873,10 @@ private:
 #endif /* UNIV_DEBUG */
 
   /**
-   * @brief Checks if a lock request results in a deadlock.
+   * @brief Looks recursively for a cycle in the waits-for graph.
    *
-   * This function determines whether a lock request by a transaction
-   * results in a deadlock situation. If a deadlock is detected, it
-   * decides whether the requesting transaction should be chosen as
-   * the victim to resolve the deadlock.
-   *
-   * @param[in] lock Lock transaction is requesting.
-   * @param[in] trx Transaction requesting the lock.
-   * 
-   * @return true if a deadlock was detected and the requesting transaction
-   *         was chosen as the victim; false if no deadlock was detected, or
-   *         if a deadlock was detected but other transaction(s) were chosen
-   *         as victim(s).
-   */
-  [[nodiscard]] bool deadlock_occurs(Lock *lock, Trx *trx) noexcept;
-
-  /**
-   * @brief Looks recursively for a deadlock.
-   *
-   * This function performs a recursive search to detect deadlocks in the lock system.
-   * It checks if the transaction `trx` waiting for the lock `wait_lock` causes a deadlock
-   * starting from the transaction `start`.
+   * This function searches the waits-for graph from the transaction `trx` waiting
+   * for the lock `wait_lock` for a path back to the transaction `start`.
    *
    * @param[in] start The recursion starting point.
    * @param[in] trx A transaction waiting for a lock.
@@ -824,14 +885,17 @@ private:
    *                     LOCK_MAX_N_STEPS_..., the function returns LOCK_EXCEED_MAX_DEPTH.
    * @param[in] depth The recursion depth. If this exceeds LOCK_MAX_DEPTH_IN_DEADLOCK_CHECK,
    *                  the function returns LOCK_EXCEED_MAX_DEPTH.
+   * @param[out] cycle The waiting transactions on the cycle found, `start` last.
+   * @param[in,out] visited The transactions whose m_deadlock_mark was set, the
+   *                        caller must reset the marks after the search.
    *
    * @return 0 if no deadlock is found.
-   * @return LOCK_VICTIM_IS_START if a deadlock is found and 'start' is chosen as the victim.
-   * @return LOCK_VICTIM_IS_OTHER if a deadlock is found and another transaction is chosen as the victim.
-   *         In this case, the search must be repeated as there may be another deadlock.
+   * @return LOCK_DEADLOCK_FOUND if a cycle through 'start' is found.
    * @return LOCK_EXCEED_MAX_DEPTH if the lock search exceeds the maximum steps or depth.
    */
-  [[nodiscard]] ulint deadlock_recursive(Trx *start, Trx *trx, Lock *wait_lock, ulint *cost, ulint depth) noexcept;
+  [[nodiscard]] ulint deadlock_search(
+    const Trx *start, Trx *trx, Lock *wait_lock, ulint *cost, ulint depth, std::vector<Trx *> &cycle, std::vector<Trx *> &visited
+  ) noexcept;
 
   /**
    * @brief Gets the wait flag of a lock.
@@ -1069,6 +1133,43 @@ private:
    */
   [[nodiscard]] bool rec_has_to_wait_in_queue(const Rec_locks &rec_locks, Lock *wait_lock, ulint heap_no) const noexcept;
 
+  /**
+   * @brief Checks if a waiting record lock request has to wait for a granted lock.
+   *
+   * Unlike rec_has_to_wait_in_queue() this ignores the other waiting requests and
+   * looks at the whole queue, not just the locks ahead of the request.
+   *
+   * @param[in] rec_locks The record lock queue of the page.
+   * @param[in] wait_lock The waiting record lock request.
+   * @param[in] heap_no The heap number of the record.
+   *
+   * @return true if the request still has to wait.
+   */
+  [[nodiscard]] bool rec_has_to_wait_for_granted(const Rec_locks &rec_locks, const Lock *wait_lock, ulint heap_no) const noexcept;
+
+  /**
+   * @brief Grants the waiting requests in a record lock queue that no longer have to wait.
+   *
+   * With LOCK_SCHEDULE_FIFO a request is granted if no conflicting request is ahead
+   * of it in the queue. With the other policies the waiting requests are looked at in
+   * the order of the policy, a request is granted if it does not conflict with a
+   * granted lock, and then moved to the front of the queue.
+   *
+   * @param[in,out] rec_locks The record lock queue of the page.
+   * @param[in] heap_no Only grant requests on this record, or ULINT_UNDEFINED for all.
+   */
+  void rec_grant_waiting(Rec_locks &rec_locks, ulint heap_no) noexcept;
+
+  /**
+   * @brief Finds the transaction that a waiting lock request waits for.
+   *
+   * @param[in] wait_lock The waiting lock request.
+   *
+   * @return the transaction of the first lock ahead in the queue that the request
+   *  has to wait for, or nullptr.
+   */
+  [[nodiscard]] Trx *wait_blocker(const Lock *wait_lock) const noexcept;
+
   /**
    * @brief Grants a lock to a waiting lock request and releases the waiting transaction.
    *
@@ -1358,6 +1459,77 @@ private:
 #endif /* !UNIT_TESTING */
 
 
+  /** Maximum number of records in the lock wait profile. */
+  static constexpr ulint REC_WAIT_PROFILE_SIZE = 4096;
+
+  /**
+   * @brief Key of a record in the lock wait profile.
+   */
+  struct Rec_wait_key {
+    bool operator==(const Rec_wait_key &) const noexcept = default;
+
+    struct Hash {
+      size_t operator()(const Rec_wait_key &key) const noexcept {
+        return Page_id::Hash{}(key.m_page_id) ^ (key.m_heap_no * 0x9e3779b97f4a7c15ULL);
+      }
+    };
+
+    /** Page of the record */
+    Page_id m_page_id{};
+
+    /** Heap number of the record on the page */
+    ulint m_heap_no{};
+  };
+
+  /** The records of the lock wait profile ordered by their number of waits */
+  using Rec_waits = std::multimap<ulint, Rec_wait_key>;
+
+  /**
+   * @brief A record in the lock wait profile.
+   */
+  struct Rec_wait_entry {
+    /** The statistics of the record */
+    Hot_rec m_hot_rec;
+
+    /** The position of the record in m_rec_waits */
+    Rec_waits::iterator m_rec_waits_it;
+  };
+
+  /**
+   * @brief Counts a record lock wait in the lock wait profile.
+   *
+   * @param[in] lock The waiting record lock request.
+   */
+  void rec_profile_wait_start(const Lock *lock) noexcept;
+
+  /**
+   * @brief Adds the time of an ended record lock wait to the lock wait profile.
+   *
+   * @param[in] lock The record lock request that waited.
+   * @param[in] wait_time_us The wait time in microseconds.
+   */
+  void rec_profile_wait_end(const Lock *lock, uint64_t wait_time_us) noexcept;
+
+  /**
+   * @brief Returns the record lock queue of a page.
+   *
+   * @param[in] page_id The page id.
+   *
+   * @return The lock queue of the page, or nullptr if there are no record
+   *  locks on the page.
+   */
+  [[nodiscard]] Rec_locks *rec_get_locks(const Page_id &page_id) noexcept {
+    auto it = m_rec_locks.find(page_id);
+
+    return it == m_rec_locks.end() ? nullptr : &it->second;
+  }
+
+  [[nodiscard]] const Rec_locks *rec_get_locks(const Page_id &page_id) const noexcept {
+    auto it = m_rec_locks.find(page_id);
+
+    return it == m_rec_locks.end() ? nullptr : &it->second;
+  }
+
   /**
    * @brief The lock table.
    *
@@ -1382,6 +1554,15 @@ private:
    */
   Trx_sys *m_trx_sys{};
 
+  /**
+   * @brief The transactions that started a lock wait since the last run of
+   * the deadlock detector, the new edges of the waits-for graph.
+   *
+   * Protected by the kernel mutex. A transaction is removed when it releases
+   * its locks, so that the detector never sees a freed transaction.
+   */
+  std::vector<Trx *> m_deadlock_waiters{};
+
   /**
    * @brief Whether to print the InnoDB lock monitor.
    *
@@ -1389,6 +1570,16 @@ private:
    * about lock requests and waits.
    */
   bool m_print_lock_monitor{false};
+
+  /** The order in which waiting record locks are granted */
+  Lock_schedule m_schedule{LOCK_SCHEDULE_FIFO};
+
+  /** The record lock wait profile, see get_hot_records(); protected by the kernel mutex */
+  std::unordered_map<Rec_wait_key, Rec_wait_entry, Rec_wait_key::Hash> m_rec_wait_profile{};
+
+  /** The records of m_rec_wait_profile by their number of waits, the one to
+  evict first is at the front; protected by the kernel mutex */
+  Rec_waits m_rec_waits{};
 };
 
-UT_LIST_NODE_GETTER_DEFINITION(Lock, m_trx_locks);
\ No newline at end of file
+UT_LIST_NODE_GETTER_DEFINITION(Lock, m_trx_locks);
@@ -699,5 +699,31 @@ struct Rec_lock_get_node;
  * acquired on a record. The list has a list node that is embedded in a nested
  * union/structure. We have to generate a specific template for it. See lock0lock.cc
  * for the implementation.
+ *
+ * The queue also keeps the wait statistics of its lifetime, they are protected
+ * by the kernel mutex.
  */
-using Rec_locks = ut_list_base<Lock, Rec_lock_get_node>;
\ No newline at end of file
+struct Rec_locks : public ut_list_base<Lock, Rec_lock_get_node> {
+  /** Number of lock requests that had to wait in the queue */
+  ulint m_n_waits{};
+
+  /** Number of waiting lock requests that were granted */
+  ulint m_n_grants{};
+
+  /** Total time the granted lock requests waited, in microseconds */
+  uint64_t m_wait_time_us{};
+};
+
+/** The order in which the waiting record lock requests are granted when
+a record lock is released */
+enum Lock_schedule : ulint {
+  /** In the order of the requests in the queue */
+  LOCK_SCHEDULE_FIFO = 0,
+
+  /** Contention-aware (CATS): first the request of the transaction that
+  blocks the most other transactions */
+  LOCK_SCHEDULE_CATS,
+
+  /** First the request of the oldest transaction */
+  LOCK_SCHEDULE_AGE
+};
@@ -41,12 +41,28 @@ Created 12/9/1995 Heikki Tuuri
 #include "sync0sync.h"
 #include "ut0lst.h"
 
+#include <vector>
+
 struct Log;
 struct log_group_t;
 
 extern Log *log_sys;
 
 struct Log {
+  /** Callback invoked once a commit LSN is durable, see add_durable_waiter(). */
+  using Durable_callback = void (*)(void *ctx);
+
+  /** A client waiting for its commit LSN to become durable. */
+  struct Durable_waiter {
+    /** Commit LSN of the transaction */
+    lsn_t m_lsn;
+
+    /** Invoked once the log has been written (and flushed) up to m_lsn */
+    Durable_callback m_callback;
+
+    /** Client context passed to m_callback */
+    void *m_ctx;
+  };
 
   /**
    * Constructor */
@@ -451,6 +467,43 @@ struct Log {
   * @param flush True if the logs should be flushed to disk.
   */
  void buffer_sync_in_background(bool flush) noexcept;
+
+ /**
+  * @brief Registers a callback to be invoked once the log is durable up to
+  * the given LSN, according to the srv_config.m_flush_log_at_trx_commit policy.
+  * The waiters are served in groups by the log flusher thread, which does
+  * one log write (+ flush) for all the commits registered since its last
+  * write. If the LSN is already durable, or the policy does not require a
+  * write at commit, the callback is invoked by the calling thread before
+  * this function returns.
+  *
+  * Note: The caller must not own any synchronization objects.
+  *
+  * @param lsn The commit LSN of the transaction.
+  * @param callback Invoked once lsn is durable.
+  * @param ctx Client context passed to callback.
+  */
+ void add_durable_waiter(lsn_t lsn, Durable_callback callback, void *ctx) noexcept;
+
+ /**
+  * @brief Waits until there are durability waiters to serve or the
+  * log flusher thread is signalled with wake_durable_flusher().
+  */
+ void wait_for_durable_waiters() noexcept;
+
+ /**
+  * @brief Writes (+ flushes) the log up to the current LSN and invokes
+  * the callbacks of all the durability waiters that it covered. Called
+  * by the log flusher thread only.
+  *
+  * @return false if there were no waiters.
+  */
+ bool complete_durable_waiters() noexcept;
+
+ /**
+  * @brief Wakes up the log flusher thread, e.g., at shutdown.
+  */
+ void wake_durable_flusher() noexcept;
  
  /**
   * @brief Advances the smallest lsn for which there are unflushed
@@ -843,6 +896,13 @@ public:
   MUST own the log mutex! */
   Cond_var* m_one_flushed_event{};
 
+  /** Commits waiting for their LSN to become durable, protected by m_mutex */
+  std::vector<Durable_waiter> m_durable_waiters{};
+
+  /** Set when m_durable_waiters is not empty; the log flusher thread waits
+  for this. To set or reset this event, the thread MUST own the log mutex! */
+  Cond_var* m_durable_event{};
+
   /** Number of log i/os initiated thus far */
   ulint m_n_log_ios{};
 
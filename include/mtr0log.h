@@ -139,6 +139,26 @@ byte *mlog_parse_nbytes(mlog_type_t type, byte *ptr, byte *end_ptr, byte *page);
  */
 byte *mlog_parse_string(byte *ptr, byte *end_ptr, byte *page);
 
+/**
+ * @brief Logs the contents of a file page as a single MLOG_FULL_PAGE record.
+ *        The brother links and the page from FIL_PAGE_TYPE up to the trailer
+ *        are logged, the checksum, page number and LSN fields are not.
+ * 
+ * @param page Page that was written without logging.
+ * @param mtr Mini-transaction handle.
+ */
+void mlog_log_full_page(const page_t *page, mtr_t *mtr);
+
+/**
+ * @brief Parses a log record written by mlog_log_full_page.
+ * 
+ * @param ptr Buffer.
+ * @param end_ptr Buffer end.
+ * @param page Page where to apply the log record, or nullptr.
+ * @return Parsed record end, nullptr if not a complete record.
+ */
+byte *mlog_parse_full_page(byte *ptr, byte *end_ptr, byte *page);
+
 /**
  *  @brief Opens a buffer for mlog, writes the initial log record
  *    Reserves space for further log entries. The log entry must be
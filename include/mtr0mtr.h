@@ -122,7 +122,7 @@ struct mtr_t {
    */
   void memo_push(void *object, mtr_memo_type_t type) noexcept { 
     ut_ad(type >= MTR_MEMO_PAGE_S_FIX);
-    ut_ad(type <= MTR_MEMO_X_LOCK);
+    ut_ad(type <= MTR_MEMO_SX_LOCK);
     ut_ad(m_magic_n == MTR_MAGIC_N);
     ut_ad(m_state == MTR_ACTIVE);
 
@@ -239,6 +239,19 @@ struct mtr_t {
     memo_push(lock, MTR_MEMO_X_LOCK);
   }
 
+  /**
+   * @brief Locks a lock in sx-mode.
+   * 
+   * @param[in] lock            The rw-lock.
+   * @param[in] file            The file name.
+   * @param[in] line The line number.
+   */
+  inline void sx_lock_func(rw_lock_t *lock, const char *file, ulint line) {
+    rw_lock_sx_lock_func(lock, 0, file, line);
+
+    memo_push(lock, MTR_MEMO_SX_LOCK);
+  }
+
   /* @return true if the mtr is active. */
   [[nodiscard]] inline bool is_active() const noexcept {
     return m_state == MTR_ACTIVE;
@@ -336,3 +349,6 @@ struct mtr_t {
 
 /** This macro locks an rw-lock in x-mode. */
 #define mtr_x_lock(B, MTR) (MTR)->x_lock_func((B), __FILE__, __LINE__)
+
+/** This macro locks an rw-lock in sx-mode. */
+#define mtr_sx_lock(B, MTR) (MTR)->sx_lock_func((B), __FILE__, __LINE__)
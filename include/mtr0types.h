@@ -25,7 +25,8 @@ enum mtr_log_mode_t : byte {
 
 /**
  * @brief Types for the mlock objects to store in the mtr memo;
- * NOTE that the first 3 values must be RW_S_LATCH, RW_X_LATCH, RW_NO_LATCH
+ * NOTE that the first 4 values must be RW_S_LATCH, RW_X_LATCH, RW_NO_LATCH,
+ * RW_SX_LATCH
  */
 enum mtr_memo_type_t : byte {
   /** Page is fixed in an S-latch */
@@ -37,6 +38,9 @@ enum mtr_memo_type_t : byte {
   /** Page is fixed in no latch */
   MTR_MEMO_BUF_FIX = RW_NO_LATCH,
 
+  /** Page is fixed in an SX-latch */
+  MTR_MEMO_PAGE_SX_FIX = RW_SX_LATCH,
+
   /** Page is modified */
   MTR_MEMO_MODIFY = 54,
 
@@ -45,6 +49,9 @@ enum mtr_memo_type_t : byte {
 
   /** Page is locked in X-mode */
   MTR_MEMO_X_LOCK = 56,
+
+  /** Lock is held in SX-mode */
+  MTR_MEMO_SX_LOCK = 57,
 };
 
 /** @name Log item types
@@ -171,6 +171,77 @@ struct AIO {
   virtual std::string to_string() noexcept = 0;
 };
 
+/** An io_uring that is owned by one thread, for i/o on files that are not
+ * tablespace files, e.g., the temporary files of a merge sort. There are no
+ * handler threads, the owner submits the requests and waits for them. If
+ * io_uring can't be set up the requests are done synchronously in submit(). */
+struct AIO_ring {
+  /** A read or write of a file, it must not be moved or freed while it
+   * is in flight. */
+  struct Request {
+    /** true for a read, false for a write. */
+    bool m_read{};
+
+    /** File handle. */
+    int m_fh{-1};
+
+    /** Buffer where to read or from which to write. */
+    byte *m_ptr{};
+
+    /** Number of bytes to read or write. */
+    ulint m_len{};
+
+    /** File offset in bytes. */
+    off_t m_off{};
+
+    /** Number of bytes read or written so far. */
+    ulint m_done{};
+
+    /** true while the request is in flight. */
+    bool m_pending{};
+
+    /** false if the request failed or a read hit the end of the file. */
+    bool m_ok{true};
+  };
+
+  /**
+  * @brief Creates a ring.
+  *
+  * @param[in] n_entries        Maximum number of requests in flight.
+  *
+  * @retval AIO_ring* Pointer to the created instance. Call destroy() below to delete it.
+  */
+  static AIO_ring *create(ulint n_entries) noexcept;
+
+  /** Destroy an instance that was created using AIO_ring::create(), there
+   * must be no requests in flight.
+   * @param[own] aio_ring The instance to destroy.
+   */
+  static void destroy(AIO_ring *&aio_ring) noexcept;
+
+  /** Destructor */
+  virtual ~AIO_ring() = default;
+
+  /**
+  * @brief Submits a request. A partial read or write is resubmitted for
+  * the remaining bytes by wait().
+  *
+  * @param[in,out] req          Request with m_read, m_fh, m_ptr, m_len and
+  *                             m_off set.
+  * @return DB_SUCCESS or error code.
+  */
+  [[nodiscard]] virtual db_err submit(Request &req) noexcept = 0;
+
+  /**
+  * @brief Waits until a request that was submitted completes. Other requests
+  * that complete meanwhile are accounted in their Request.
+  *
+  * @param[in,out] req          Request to wait for.
+  * @return DB_SUCCESS or DB_ERROR if the i/o failed.
+  */
+  [[nodiscard]] virtual db_err wait(Request &req) noexcept = 0;
+};
+
 inline const char* to_string(IO_request request) noexcept {
   switch(request) {
     case IO_request::None:
@@ -97,6 +97,27 @@ void os_thread_yield() noexcept;
  */
 void os_thread_sleep(ulint tm) noexcept;
 
+/** Number of slots in the table of per-thread run states. If there are
+more threads than slots some of them share a slot, which only makes the
+state less precise. */
+constexpr ulint OS_THREAD_RUN_STATE_SLOTS = 1024;
+
+/** Returns the run state slot of the calling thread. Latches record it
+for their owner so that waiters can check if the owner is running.
+@return	slot number, < OS_THREAD_RUN_STATE_SLOTS */
+uint32_t os_thread_get_slot() noexcept;
+
+/** Notes that the calling thread is about to block in the OS, or that
+it has woken up.
+@param[in] parked               true before blocking, false after. */
+void os_thread_set_parked(bool parked) noexcept;
+
+/** Checks whether the thread(s) owning a run state slot is blocked in
+the OS, in which case spinning for a latch it holds is pointless.
+@param[in] slot                 Slot returned by os_thread_get_slot().
+@return	true if blocked */
+bool os_thread_is_parked(uint32_t slot) noexcept;
+
 /** Gets the last operating system error code for the calling thread.
 @return	last error on Windows, 0 otherwise */
 ulint os_thread_get_last_error();
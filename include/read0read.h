@@ -33,7 +33,8 @@ struct Trx;
 
 /**
  * Opens a read view where exactly the transactions serialized before this
- * point in time are seen in the view.
+ * point in time are seen in the view. The view is built from the snapshot
+ * published by the trx system, the caller need not own the kernel mutex.
  *
  * @param cr_trx_id trx_id of creating transaction, or 0 used in purge
  * @param heap memory heap from which allocated
@@ -43,7 +44,7 @@ read_view_t *read_view_open_now(trx_id_t cr_trx_id, mem_heap_t *heap);
 
 /**
  * Makes a copy of the oldest existing read view, or opens a new. The view
- * must be closed with ..._close.
+ * must be closed with ..._close. The caller must own the trx system mutex.
  *
  * @param cr_trx_id trx_id of creating transaction, or 0 used in purge
  * @param heap memory heap from which allocated
@@ -56,6 +57,13 @@ read_view_t *read_view_oldest_copy_or_open_new(trx_id_t cr_trx_id, mem_heap_t *h
  */
 void read_view_close(read_view_t *view);
 
+/** Sets the creator of a read view opened by a transaction that had no
+ * id yet, so that the view sees the changes of the transaction.
+ * @param view read view
+ * @param cr_trx_id trx_id of the creating transaction
+ */
+void read_view_set_creator(read_view_t *view, trx_id_t cr_trx_id);
+
 /** Closes a consistent read view for client. This function is called at an SQL
  * statement end if the trx isolation level is <= TRX_ISO_READ_COMMITTED.
  * @param trx trx which has a read view
@@ -135,7 +143,9 @@ inline bool read_view_sees_trx_id(const read_view_t *view, trx_id_t trx_id) {
 
   if (trx_id >= view->low_limit_id) {
 
-    return false;
+    /* A transaction that got its id after it opened its read view, see
+    Trx::set_rw_mode(), still sees its own changes. */
+    return trx_id == view->creator_trx_id && view->type == VIEW_NORMAL;
   }
 
   /* We go through the trx ids in the array smallest first: this order
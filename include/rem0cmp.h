@@ -24,6 +24,8 @@ Created 7/1/1994 Heikki Tuuri
 
 #pragma once
 
+#include <array>
+
 #include "data0data.h"
 #include "data0type.h"
 #include "dict0dict.h"
@@ -103,6 +105,91 @@ int cmp_data_data_slow(
  */
 inline int cmp_dfield_dfield(void *cmp_ctx, const dfield_t *dfield1, const dfield_t *dfield2) noexcept;
 
+/**
+ * Checks if the values of a type are ordered like their bytes, the shorter
+ * value padded with the pad character of the type. The other types are
+ * compared as whole fields or by the client.
+ *
+ * @param[in] mtype     Main type.
+ * @param[in] prtype    Precise type.
+ *
+ * @return true if the values can be compared byte by byte
+ */
+inline bool cmp_type_is_binary_comparable(ulint mtype, ulint prtype) noexcept {
+  if (mtype >= DATA_FLOAT) {
+    return false;
+  } else if (mtype == DATA_BLOB && !(prtype & DATA_BINARY_TYPE)) {
+    return dtype_get_charset_coll(prtype) == DATA_CLIENT_LATIN1_SWEDISH_CHARSET_COLL;
+  } else {
+    return true;
+  }
+}
+
+/**
+ * Transforms the character code so that it is ordered appropriately for the
+ * language. This is only used for the latin1 char set. The client does the
+ * comparisons for other char sets.
+ * 
+ * @param[in] code code of a character stored in database record
+ * 
+ * @return	collation order position
+ */
+constexpr ulint cmp_collate(ulint code) noexcept {
+  // return((ulint) srv_latin1_ordering[code]);
+  /* FIXME: Default to ASCII */
+  return code;
+}
+
+/**
+ * @return true if cmp_collate() maps every character code to itself.
+ */
+constexpr bool cmp_collate_is_identity() noexcept {
+  for (ulint code{}; code < 256; ++code) {
+    if (cmp_collate(code) != code) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+/**
+ * Checks if the values of a binary comparable type are ordered like their
+ * raw bytes. cmp_data_data() maps the bytes of the latin1 string types
+ * through cmp_collate(), the shortcuts that compare raw bytes (the key
+ * prefixes, the merge sort radix sort and Cmp_search_key) can only be used
+ * for those types while cmp_collate() is the identity.
+ *
+ * @param[in] mtype     Main type.
+ * @param[in] prtype    Precise type.
+ *
+ * @return true if the raw bytes of the values can be compared
+ */
+inline bool cmp_type_is_byte_ordered(ulint mtype, ulint prtype) noexcept {
+  if (!cmp_type_is_binary_comparable(mtype, prtype)) {
+    return false;
+  }
+
+  const auto collated = mtype <= DATA_CHAR || (mtype == DATA_BLOB && !(prtype & DATA_BINARY_TYPE));
+
+  return !collated || cmp_collate_is_identity();
+}
+
+/**
+ * Encodes the leading fields of a tuple into a normalized key prefix. If
+ * the prefixes of two tuples differ, the tuples compare like the prefixes
+ * compare as unsigned integers. If they are equal, the fields must be
+ * compared with cmp_dfield_dfield(). The prefix ends at the first field
+ * that is not byte ordered (cmp_type_is_byte_ordered()) or that can have
+ * values of different lengths.
+ *
+ * @param[in] fields    Fields of the tuple, with their types set.
+ * @param[in] n_fields  Number of fields to encode.
+ *
+ * @return the key prefix
+ */
+uint64_t cmp_dfield_key_prefix(const dfield_t *fields, ulint n_fields) noexcept;
+
 /**
  * This function is used to compare a data tuple to a physical record.
  * Only dtuple->n_fields_cmp first fields are taken into account for
@@ -139,6 +226,72 @@ int cmp_dtuple_rec_with_match(
   ulint *matched_bytes
 ) noexcept;
 
+/**
+ * A search tuple that is prepared once for comparing it with many records,
+ * e.g., in the binary search of a page. If all the fields to compare are
+ * byte ordered (cmp_type_is_byte_ordered()) the record fields compare like
+ * their bytes, the tuple is then a normalized key and the fields are compared
+ * a word at a time without looking at their types. Otherwise
+ * cmp_dtuple_rec_with_match() is used.
+ */
+struct Cmp_search_key {
+  /** Keys with more fields to compare use cmp_dtuple_rec_with_match() */
+  static constexpr ulint MAX_FIELDS = 16;
+
+  /**
+   * Constructor.
+   *
+   * @param[in] cmp_ctx        Client compare context.
+   * @param[in] dtuple         Search tuple, it must not be modified while
+   *                           the key is in use.
+   */
+  Cmp_search_key(void *cmp_ctx, const DTuple *dtuple) noexcept;
+
+  /**
+   * Compares the search tuple to a physical record, like
+   * cmp_dtuple_rec_with_match().
+   *
+   * @param[in] rec            Physical record.
+   * @param[in] offsets        Array returned by Phy_rec::get_col_offsets().
+   * @param[in,out] matched_fields  Number of already completely matched fields.
+   * @param[in,out] matched_bytes   Number of already matched bytes within the
+   *                           first field not completely matched.
+   *
+   * @return 1, 0, -1, if dtuple is greater, equal, less than rec, respectively
+   */
+  [[nodiscard]] int compare(const rec_t *rec, const ulint *offsets, ulint *matched_fields, ulint *matched_bytes) const noexcept;
+
+  /** A field of the search tuple */
+  struct Field {
+    /** Value of the field */
+    const byte *m_data{};
+
+    /** Length of the value, or UNIV_SQL_NULL */
+    ulint m_len{};
+
+    /** Pad character of the type, ULINT_UNDEFINED if none */
+    ulint m_pad{};
+  };
+
+  /** Client compare context */
+  void *m_cmp_ctx{};
+
+  /** The search tuple */
+  const DTuple *m_dtuple{};
+
+  /** Info bits of the search tuple */
+  ulint m_info_bits{};
+
+  /** Number of fields to compare */
+  ulint m_n_fields{};
+
+  /** true if the fields are compared as bytes */
+  bool m_binary{};
+
+  /** The fields to compare, set if m_binary */
+  std::array<Field, MAX_FIELDS> m_fields{};
+};
+
 /**
  * Compares a data tuple to a physical record.
  * @see cmp_dtuple_rec_with_match
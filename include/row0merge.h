@@ -188,6 +188,7 @@ db_err row_merge_drop_table(Trx *trx, Table *table);
  * Build indexes on a table by reading a clustered index,
  * creating a temporary file containing index entries, merge sorting
  * these index entries and inserting sorted index entries to indexes.
+ * The secondary indexes are built concurrently.
  *
  * @param trx        in: transaction
  * @param old_table  in: table where rows are read from
@@ -611,10 +611,12 @@ class Parallel_reader::Scan_ctx {
     m_reader->release_threads(unused_threads);
   }
 
-  /** S lock the index. */
+  /** Latch the index so that the tree structure doesn't change. The latch
+  is SX, not S: the scan waits for page latches while holding it, which
+  must not block a tree modification that holds SX and waits for X. */
   void index_s_lock();
 
-  /** S unlock the index. */
+  /** Release the index latch taken by index_s_lock(). */
   void index_s_unlock();
 
   /** @return true if at least one thread owns the S latch on the index. */
@@ -36,7 +36,8 @@ Created 3/14/1997 Heikki Tuuri
 /** Creates a purge node to a query graph.
 @return	own: purge node */
 purge_node_t *row_purge_node_create(
-  que_thr_t *parent, /** in: parent node, i.e., a thr node */
+  que_thr_t *parent, /** in: parent node, i.e., a thr node, or nullptr
+                     if the node is used outside a query graph */
   mem_heap_t *heap
 ); /** in: memory heap where created */
 
@@ -45,6 +46,17 @@ function used in an SQL execution graph.
 @return	query thread to run next or nullptr */
 que_thr_t *row_purge_step(que_thr_t *thr); /** in: query thread */
 
+/**
+ * Does the purge operation for the undo log record in node->undo_rec. The
+ * caller must release node->reservation and empty node->heap afterwards.
+ * Used by the purge worker threads which get their records from the purge
+ * coordinator instead of fetching them from the history list.
+ *
+ * @param[in,out] node          Purge node, undo_rec and roll_ptr must be set.
+ * @param[in] trx               Transaction doing the purge.
+ */
+void row_purge_rec(purge_node_t *node, Trx *trx);
+
 /* Purge node structure */
 
 struct purge_node_t {
@@ -273,6 +273,53 @@ struct Config {
   
   /* Maximum allowable purge history length. <= 0 means 'infinite'. */
   ulong m_max_purge_lag{0};
+
+  /** The order in which waiting record locks are granted, see Lock_schedule */
+  ulint m_lock_schedule{0};
+
+  /** Interval in milliseconds between two runs of the deadlock detector,
+   * this is also the longest a deadlocked lock wait goes undetected. */
+  ulint m_deadlock_detect_interval{100};
+
+  /** Percentage of each page that is filled when a secondary index is
+   * built from sorted data, the rest is left free for later inserts. */
+  ulint m_index_fill_factor{100};
+
+  /** Number of threads that scan and sort when indexes are built,
+   * 0 means one for each CPU. */
+  ulint m_index_build_threads{0};
+
+  /** Memory in bytes for the sort buffers and file blocks of an index
+   * build, the number of threads is reduced to fit it. */
+  ulint m_index_build_memory{256 * 1024 * 1024};
+
+  /** Size of the blocks of the temporary files of the merge sort in
+   * bytes, a multiple of UNIV_PAGE_SIZE. */
+  ulint m_sort_block_size{1024 * 1024};
+
+  /** Number of purge threads. With 1 the master thread does the purge
+   * itself, otherwise it coordinates this many purge worker threads. */
+  ulint m_n_purge_threads{1};
+
+  /** Number of undo log pages that purge handles in one batch. The
+   * batch size grows beyond this while the history list keeps growing. */
+  ulint m_purge_batch_size{20};
+
+  /** Number of rollback segments in the system tablespace, including the
+   * SYSTEM rollback segment. Missing ones are created at startup. */
+  ulint m_n_rollback_segments{32};
+
+  /** Number of undo tablespaces. With 0 the undo logs are only in the
+   * rollback segment of the system tablespace. */
+  ulint m_n_undo_tablespaces{0};
+
+  /** An undo tablespace that grows over this size in bytes is truncated
+   * once the purge has passed all its undo logs. 0 means never. */
+  ulint m_undo_tablespace_max_size{128 * 1024 * 1024};
+
+  /** Whether transactions started by ib_trx_begin() take the read-only
+   * fast path until their first write or lock. */
+  bool m_trx_auto_read_only{};
 };
 
 /*-------------------------------------------*/
@@ -310,10 +357,9 @@ extern bool srv_print_latch_waits;
 
 extern ulint srv_activity_count;
 extern ulint srv_fatal_semaphore_wait_threshold;
-extern ulint srv_dml_needed_delay;
 
-/** Mutex protecting the server, trx structs, query threads, and lock table:
- * we allocate it from dynamic memory to get it to the same DRAM page as
+/** Mutex protecting the lock table and the query threads, see Trx_sys::m_mutex
+ * for the trx structs: we allocate it from dynamic memory to get it to the same DRAM page as
  * other hotspot semaphores */
 extern mutex_t *kernel_mutex_temp;
 
@@ -461,7 +507,7 @@ struct InnoDB {
    * Tells the Innobase server that there has been activity in the database
    * and wakes up the master thread if it is suspended (not sleeping). Used
    * in the client interface. Note that there is a small chance that the master
-   * thread stays suspended (we do not protect our operation with the kernel
+   * thread stays suspended (we do not protect our operation with the server
    * mutex, for performace reasons).
    */
   static void active_wake_master_thread() noexcept;
@@ -499,6 +545,27 @@ struct InnoDB {
    */
   static os_thread_ret_t lock_timeout_thread(void *arg) noexcept;
 
+  /**
+   * A thread which searches the waits-for graph of the lock waits
+   * for deadlocks and rolls back a victim of each.
+   * 
+   * @param[in,out] arg	Callback argument
+   * 
+   * @return	a dummy parameter
+   */
+  static os_thread_ret_t lock_deadlock_thread(void *arg) noexcept;
+
+  /**
+   * A thread which writes the log for the commits done with
+   * ib_trx_commit_async() and notifies the clients once their commit
+   * is durable.
+   * 
+   * @param[in,out] arg	Callback argument
+   * 
+   * @return	a dummy parameter
+   */
+  static os_thread_ret_t log_flusher_thread(void *arg) noexcept;
+
   /**
    * A thread which prints the info output by various InnoDB monitors.
    * 
@@ -735,6 +802,15 @@ struct Export_vars {
 
   /** srv_n_rows_deleted */
   ulint innodb_rows_deleted;                   
+
+  /** Dml_throttle::m_n_delayed */
+  ulint innodb_dml_purge_delays;
+
+  /** Dml_throttle::m_delay_us / 1000 */
+  ulint innodb_dml_purge_delay_time;
+
+  /** Dml_throttle::rate() */
+  ulint innodb_dml_purge_rate;
 };
 
 struct Fil;
@@ -61,8 +61,8 @@ Sync_check *sync_array_create(
 /** Frees the resources in a wait array. */
 void sync_array_free(Sync_check *arr); /** in, own: sync wait array */
 
-/** Reserves a wait array cell for waiting for an object.
-The event of the cell is reset to nonsignalled state. */
+/** Reserves a wait array cell for waiting for an object. The cell only
+records the wait, the thread parks on the object's own lock word. */
 void sync_array_reserve_cell(
   Sync_check *arr, /** in: wait array */
   void *object,      /** in: pointer to the object to wait for */
@@ -72,30 +72,22 @@ void sync_array_reserve_cell(
   ulint *index
 ); /** out: index of the reserved cell */
 
-/** This function should be called when a thread starts to wait on
-a wait array cell. In the debug version this function checks
+/** This function should be called when a thread is about to park on the
+object of a wait array cell. In the debug version this function checks
 if the wait for a semaphore will result in a deadlock, in which
-case prints info and asserts. */
-void sync_array_wait_event(
+case prints info and asserts. The caller must free the cell once the
+wait is over. */
+void sync_array_wait_start(
   Sync_check *arr, /** in: wait array */
   ulint index
 ); /** in: index of the reserved cell */
 
-/** Frees the cell. NOTE! sync_array_wait_event frees the cell
-automatically! */
+/** Frees the cell. */
 void sync_array_free_cell(
   Sync_check *arr, /** in: wait array */
   ulint index
 ); /** in: index of the cell in array */
 
-/** Note that one of the wait objects was signalled. */
-void sync_array_object_signalled(Sync_check *arr); /** in: wait array */
-
-/** If the wakeup algorithm does not work perfectly at semaphore relases,
-this function will do the waking (see the comment in mutex_exit). This
-function should be called about every 1 second in the server. */
-void sync_arr_wake_threads_if_sema_free();
-
 /** Prints warnings of long semaphore waits to stderr.
 @return	true if fatal semaphore wait threshold was exceeded */
 bool sync_array_print_long_waits(void);
@@ -10,7 +10,34 @@
 #include "os0thread.h"
 #include "ut0lst.h"
 
-using lock_word_t = std::atomic<bool>;
+struct Latch_site;
+
+/** The lock word doubles as the futex that waiters park on, it must
+therefore be 32 bits wide. */
+using lock_word_t = std::atomic<uint32_t>;
+
+/** States of mutex_t::lock_word @{ */
+
+/** Mutex is free */
+constexpr uint32_t MUTEX_UNLOCKED = 0;
+
+/** Mutex is held and nobody is parked on the lock word */
+constexpr uint32_t MUTEX_LOCKED = 1;
+
+/** Mutex is held and there may be threads parked on the lock word */
+constexpr uint32_t MUTEX_LOCKED_WAITERS = 2;
+
+/* @} */
+
+/** Scale of mutex_t::m_spin_avg, the average is kept in fixed point */
+constexpr uint32_t MUTEX_SPIN_AVG_SCALE = 8;
+
+/** Value of mutex_t::m_spin_success when every spin succeeds */
+constexpr uint32_t MUTEX_SPIN_SUCCESS_MAX = 256;
+
+/** On average one in this many spin waits ignores the learnt budget and
+spins for SYNC_SPIN_ROUNDS */
+constexpr ulint MUTEX_SPIN_PROBE_INTERVAL = 16;
 
 /** Value of mutex_struct::magic_n */
 constexpr ulint MUTEX_MAGIC_N = 979585;
@@ -20,21 +47,27 @@ struct mutex_t {
 
   mutex_t() = default;
 
-  void init() {
-    ut_a(event == nullptr);
-    event = os_event_create(nullptr);
-  }
+  /** One of MUTEX_UNLOCKED, MUTEX_LOCKED or MUTEX_LOCKED_WAITERS. Threads
+  that give up spinning set it to MUTEX_LOCKED_WAITERS and wait on it
+  directly (a futex on Linux), mutex_exit() wakes one of them only if it
+  swaps out that state. */
+  lock_word_t lock_word{};
 
-  /** Used by sync0arr.c for the wait queue */
-  Cond_var* event{};
+  /** Run state slot of the thread that last acquired the mutex, see
+  os_thread_get_slot(). Waiters do not spin while that thread is parked. */
+  std::atomic<uint32_t> m_owner_slot{};
 
-  /** lock_word is the target of the atomic test-and-set
-  instruction when atomic operations are enabled. */
-  lock_word_t lock_word{};
+  /** Moving average of the spin rounds that it took to acquire the mutex,
+  when spinning succeeded, times MUTEX_SPIN_AVG_SCALE. It tracks how long
+  the mutex is typically held. Seeded from SYNC_SPIN_ROUNDS in
+  mutex_create(). */
+  std::atomic<uint32_t> m_spin_avg{};
+
+  /** Moving average of the spin success rate, 0..MUTEX_SPIN_SUCCESS_MAX */
+  std::atomic<uint32_t> m_spin_success{MUTEX_SPIN_SUCCESS_MAX};
 
-  /** This ulint is set to 1 if there are (or may be) threads waiting in
-  the global wait array for this mutex to be released. Otherwise, this is 0. */
-  std::atomic<bool> m_waiters{};
+  /** Contention counters shared with the mutexes created at the same place */
+  Latch_site *m_site{};
 
   /** All allocated mutexes are put into a list. Pointers to the
   next and prev. */
@@ -0,0 +1,181 @@
+/** Copyright (c) 2024 Sunny Bains. All rights reserved. */
+
+/** @file include/sync0prof.h
+Latch contention profiler.
+
+All mutexes and rw-locks created at the same source location share one
+Latch_site, which is looked up once when the latch is created. While
+sync_latch_profile is set (configuration variable "latch_profile") every
+acquisition is counted in the site; contended acquisitions also record the
+spin rounds, OS waits and the time spent waiting. The counters are sharded
+by CPU. When profiling is off the cost is one load and a predictable
+branch per acquisition. */
+
+#pragma once
+
+#include "innodb0types.h"
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "ut0counter.h"
+
+/** Type of the latches created at a site */
+enum Latch_kind : uint8_t {
+  /** mutex_t */
+  LATCH_KIND_MUTEX,
+
+  /** rw_lock_t */
+  LATCH_KIND_RW_LOCK
+};
+
+/** Counters of all the latches created at one source location. */
+struct Latch_site {
+  using Counter = ut::CPU_sharded_counter<8>;
+
+  /** Counts an acquisition.
+  @param[in] contended          true if the thread had to spin or wait.
+  @param[in] spin_rounds        Spin rounds if contended.
+  @param[in] os_waits           Number of times the thread parked.
+  @param[in] wait_time          Time from the first failed attempt until
+                                the latch was acquired. */
+  void acquired(bool contended, ulint spin_rounds, ulint os_waits, std::chrono::microseconds wait_time) noexcept;
+
+  /** File where the latches were created */
+  const char *m_file{};
+
+  /** Line where the latches were created */
+  ulint m_line{};
+
+  /** Type of the latches */
+  Latch_kind m_kind{};
+
+  /** Number of acquisitions */
+  Counter m_n_acquires{};
+
+  /** Number of acquisitions that could not get the latch at once */
+  Counter m_n_contended{};
+
+  /** Total spin rounds of the contended acquisitions */
+  Counter m_n_spin_rounds{};
+
+  /** Total number of times that a thread parked */
+  Counter m_n_os_waits{};
+
+  /** Total time spent waiting, in microseconds */
+  Counter m_wait_time_us{};
+};
+
+/** A snapshot of the counters of a Latch_site */
+struct Latch_site_stats {
+  /** File name without the directory, and line, where the latches were created */
+  std::string m_file{};
+
+  /** Line where the latches were created */
+  ulint m_line{};
+
+  /** Type of the latches */
+  Latch_kind m_kind{};
+
+  /** Number of acquisitions */
+  uint64_t m_n_acquires{};
+
+  /** Number of contended acquisitions */
+  uint64_t m_n_contended{};
+
+  /** Total spin rounds */
+  uint64_t m_n_spin_rounds{};
+
+  /** Total number of OS waits */
+  uint64_t m_n_os_waits{};
+
+  /** Total wait time in microseconds */
+  uint64_t m_wait_time_us{};
+};
+
+/** true if latch acquisitions are counted. Read relaxed on every
+acquisition, a thread may count a few acquisitions after the flag is
+cleared or miss a few after it is set. */
+extern std::atomic<bool> sync_latch_profile;
+
+/** Tracks one blocking latch acquisition and accounts it in the site of
+the latch when it goes out of scope, at which point the latch is held. */
+struct Latch_wait {
+  /** Constructor.
+  @param[in,out] site           Site of the latch, may be nullptr. */
+  explicit Latch_wait(Latch_site *site) noexcept : m_site(sync_latch_profile.load(std::memory_order_relaxed) ? site : nullptr) {}
+
+  ~Latch_wait() noexcept {
+    if (m_site != nullptr) {
+      using namespace std::chrono;
+
+      const auto wait_time = m_contended ? duration_cast<microseconds>(steady_clock::now() - m_start) : microseconds{0};
+
+      m_site->acquired(m_contended, m_spin_rounds, m_os_waits, wait_time);
+    }
+  }
+
+  /** Notes that the latch could not be acquired at once. Only the first
+  call starts the timer. */
+  void contended() noexcept {
+    if (m_site != nullptr && !m_contended) {
+      m_contended = true;
+      m_start = std::chrono::steady_clock::now();
+    }
+  }
+
+  /** Adds spin rounds.
+  @param[in] n                  Number of rounds spun. */
+  void spun(ulint n) noexcept { m_spin_rounds += n; }
+
+  /** Notes that the thread is about to park. */
+  void parked() noexcept { ++m_os_waits; }
+
+  /** Site to account in, nullptr if profiling was off at the start */
+  Latch_site *m_site{};
+
+  /** true if the latch could not be acquired at once */
+  bool m_contended{};
+
+  /** Spin rounds so far */
+  ulint m_spin_rounds{};
+
+  /** Number of OS waits so far */
+  ulint m_os_waits{};
+
+  /** Time of the first failed attempt */
+  std::chrono::steady_clock::time_point m_start{};
+};
+
+/** Counts an uncontended acquisition.
+@param[in,out] site             Site of the latch, may be nullptr. */
+inline void sync_latch_acquired(Latch_site *site) noexcept {
+  if (sync_latch_profile.load(std::memory_order_relaxed) && site != nullptr) [[unlikely]] {
+    site->m_n_acquires.inc();
+  }
+}
+
+/** Returns the site for latches created at a source location, creating it
+on first use. Sites are never freed.
+@param[in] file                 File where the latch is created.
+@param[in] line                 Line where the latch is created.
+@param[in] kind                 Type of the latch.
+@return	site */
+Latch_site *sync_latch_site_get(const char *file, ulint line, Latch_kind kind) noexcept;
+
+/** Returns the sites that waited the longest, the ones with most contended
+acquisitions first if there is no wait time. Sites that were never
+acquired while profiling are skipped.
+@param[in] n                    Maximum number of sites, 0 for all.
+@return	snapshot of the counters, in descending order */
+std::vector<Latch_site_stats> sync_latch_profile_get(ulint n) noexcept;
+
+/** Resets the counters of all sites. */
+void sync_latch_profile_reset() noexcept;
+
+/** Prints the hottest latch sites.
+@param[in,out] ib_stream        Where to print.
+@param[in] n                    Maximum number of sites, 0 for all. */
+void sync_latch_profile_print(ib_stream_t ib_stream, ulint n) noexcept;
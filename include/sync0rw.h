@@ -36,6 +36,7 @@ Created 9/11/1995 Heikki Tuuri
 #include <atomic>
 
 #include "os0sync.h"
+#include "sync0prof.h"
 #include "sync0sync.h"
 #include "ut0rnd.h"
 #include "ut0lst.h"
@@ -45,13 +46,18 @@ smaller than 30 and the order of the numerical values like below! */
 constexpr int RW_S_LATCH = 1;
 constexpr int RW_X_LATCH = 2;
 constexpr int RW_NO_LATCH = 3;
+constexpr int RW_SX_LATCH = 4;
 
 /** We decrement m_lock_word by this amount for each x_lock. It is also the
 start value for the m_lock_word, meaning that it limits the maximum number
 of concurrent read locks before the rw_lock breaks. The current value of
-0x00100000 allows 1,048,575 concurrent readers and 2047 recursive writers.*/
+0x00100000 allows 524,287 concurrent readers while an sx-lock is held. */
 constexpr int X_LOCK_DECR = 0x00100000;
 
+/** We decrement m_lock_word by this amount for the first sx_lock. The
+lock word stays positive, so readers are still let in. */
+constexpr int X_LOCK_HALF_DECR = X_LOCK_DECR / 2;
+
 typedef struct rw_lock_struct rw_lock_t;
 
 #ifdef UNIV_SYNC_DEBUG
@@ -164,7 +170,7 @@ corresponding function. */
 /** NOTE! The following macros should be used in rw s-locking, not the
 corresponding function. */
 
-#define rw_lock_s_lock_nowait(M, F, L) rw_lock_s_lock_low((M), 0, (F), (L))
+#define rw_lock_s_lock_nowait(M, F, L) rw_lock_s_lock_nowait_func((M), (F), (L))
 
 #ifdef UNIV_SYNC_DEBUG
 #define rw_lock_s_unlock_gen(L, P) rw_lock_s_unlock_func(P, L)
@@ -224,6 +230,42 @@ inline void rw_lock_x_unlock_func(
 /** Releases an exclusive mode lock. */
 #define rw_lock_x_unlock(L) rw_lock_x_unlock_gen(L, 0)
 
+/** NOTE! The following macro should be used in rw sx-locking, not the
+corresponding function. */
+
+#define rw_lock_sx_lock(M) rw_lock_sx_lock_func((M), 0, __FILE__, __LINE__)
+
+/** NOTE! The following macro should be used in rw sx-locking, not the
+corresponding function. */
+
+#define rw_lock_sx_lock_gen(M, P) rw_lock_sx_lock_func((M), (P), __FILE__, __LINE__)
+
+/** NOTE! Use the corresponding macro, not directly this function! Lock an
+rw-lock in shared-exclusive mode for the current thread. An sx-lock is
+compatible with s-locks of other threads but not with their sx- or x-locks.
+If the rw-lock is sx- or x-locked by another thread, or there is an
+exclusive lock request waiting, the function spins a preset time (controlled
+by SYNC_SPIN_ROUNDS), waiting for the lock, before suspending the thread.
+If the same thread has an sx- or x-lock on the rw-lock, locking succeeds,
+with the following exception: if pass != 0, only a single sx-lock may be
+taken on the lock. The sx-lock holder can later take an x-lock, which waits
+only for the readers to exit.
+@param[in,out] lock             Lock to sx-lock.
+@param[in] pass                 Pass value; != 0, if the lock will be
+                                passed to another thread to unlock
+@param[in] file_name            File name where lock requested
+@param[in] line                 Line where requested */
+void rw_lock_sx_lock_func(rw_lock_t *lock, ulint pass, const char *file_name, ulint line);
+
+#ifdef UNIV_SYNC_DEBUG
+#define rw_lock_sx_unlock_gen(L, P) rw_lock_sx_unlock_func(P, L)
+#else
+#define rw_lock_sx_unlock_gen(L, P) rw_lock_sx_unlock_func(L)
+#endif /* UNIV_SYNC_DEBUG */
+
+/** Releases a shared-exclusive mode lock. */
+#define rw_lock_sx_unlock(L) rw_lock_sx_unlock_gen(L, 0)
+
 /** This function is used in the insert buffer to move the ownership of an
 x-latch on a buffer frame to the current thread. The x-latch was set by
 the buffer read operation and it protected the buffer frame while the
@@ -242,7 +284,7 @@ bool rw_lock_own(
   rw_lock_t *lock, /** in: rw-lock */
   ulint lock_type
 ) /** in: lock type: RW_LOCK_SHARED,
-                                  RW_LOCK_EX */
+                                  RW_LOCK_SX, RW_LOCK_EX */
   __attribute__((warn_unused_result));
 #endif /* UNIV_SYNC_DEBUG */
 
@@ -251,7 +293,7 @@ bool rw_lock_is_locked(
   rw_lock_t *lock, /** in: rw-lock */
   ulint lock_type
 ); /** in: lock type: RW_LOCK_SHARED,
-                                         RW_LOCK_EX */
+                                         RW_LOCK_SX, RW_LOCK_EX */
 
 #ifdef UNIV_SYNC_DEBUG
 /** Prints debug info of an rw-lock. */
@@ -290,10 +332,11 @@ Do not use its fields directly! */
 /** The structure used in the spin lock implementation of a read-write
 lock. Several threads may have a shared lock simultaneously in this
 lock, but only one writer may have an exclusive lock, in which case no
-shared locks are allowed. To prevent starving of a writer blocked by
-readers, a writer may queue for x-lock by decrementing m_lock_word: no
-new readers will be let in while the thread waits for readers to
-exit. */
+shared locks are allowed. A writer may instead take a shared-exclusive
+lock, which excludes other writers but still lets readers in. To prevent
+starving of a writer blocked by readers, a writer may queue for x-lock by
+decrementing m_lock_word: no new readers will be let in while the thread
+waits for readers to exit. */
 struct rw_lock_struct {
   /** Holds the state of the lock. */
   std::atomic<int32_t> m_lock_word;
@@ -325,15 +368,20 @@ struct rw_lock_struct {
   guaranteed to have sane and non-stale
   value iff recursive flag is set. */
 
-  /** Used by sync0arr.c for thread queueing */
-  Cond_var* m_event;
+  /** Futex word that s- and x-lock waiters park on. It is bumped by
+the thread that frees the lock before it wakes them up. */
+  std::atomic<uint32_t> m_wake_seq;
 
-  /** Event for next-writer to wait on. A thread
+  /** Futex word for the next-writer to park on. A thread
   must decrement m_lock_word before waiting. */
-  Cond_var* m_wait_ex_event;
+  std::atomic<uint32_t> m_wait_ex_seq;
 
-  /** Event for next-writer to wait on. A thread
-  must decrement m_lock_word before waiting. */
+  /** Number of sx-locks held by the writer thread. Only the writer
+  thread modifies this, while it holds the sx- or x-lock. */
+  ulint m_sx_recursive;
+
+  /** Contention counters shared with the rw-locks created at the same place */
+  Latch_site *m_site;
 
   /** All allocated rw locks are put into a list */
   UT_LIST_NODE_T(rw_lock_t) list;
@@ -399,7 +447,7 @@ struct rw_lock_debug_struct {
   /** Pass value given in the lock operation */
   ulint pass;
 
-  /** Type of the lock: RW_LOCK_EX, RW_LOCK_SHARED, RW_LOCK_WAIT_EX */
+  /** Type of the lock: RW_LOCK_EX, RW_LOCK_SX, RW_LOCK_SHARED, RW_LOCK_WAIT_EX */
   ulint lock_type;
 
   /** File name where the lock was obtained */
@@ -461,25 +509,44 @@ already false.
 @param[in,out] lock             Lock to set. */
 inline void rw_lock_reset_waiter_flag(rw_lock_t *lock) {
   bool t{true};
-  ;
   lock->m_waiters.compare_exchange_strong(t, false);
 }
 
+/** Bumps a futex word of an rw-lock and wakes up the threads parked on it.
+@param[in,out] seq              Futex word, m_wake_seq or m_wait_ex_seq.
+@param[in] all                  true to wake all the threads, false to
+                                wake just one */
+inline void rw_lock_signal(std::atomic<uint32_t> &seq, bool all) {
+  seq.fetch_add(1);
+
+  if (all) {
+    seq.notify_all();
+  } else {
+    seq.notify_one();
+  }
+}
+
 /** Returns the write-status of the lock - this function made more sense
 with the old rw_lock implementation.
 @param[in] lock                 Lock for which we want the writer count.
-@return	RW_LOCK_NOT_LOCKED, RW_LOCK_EX, RW_LOCK_WAIT_EX */
+@return	RW_LOCK_NOT_LOCKED, RW_LOCK_SX, RW_LOCK_EX, RW_LOCK_WAIT_EX */
 inline ulint rw_lock_get_writer(const rw_lock_t *lock) {
   auto lock_word = lock->m_lock_word.load();
 
-  if (lock_word > 0) {
+  ut_ad(lock_word <= X_LOCK_DECR);
+
+  if (lock_word > X_LOCK_HALF_DECR) {
     /* return NOT_LOCKED in s-lock state, like the writer
     member of the old lock implementation. */
     return RW_LOCK_NOT_LOCKED;
-  } else if (((-lock_word) % X_LOCK_DECR) == 0) {
+  } else if (lock_word > 0) {
+    /* sx-locked, no x-locks */
+    return RW_LOCK_SX;
+  } else if (lock_word == 0 || lock_word == -X_LOCK_HALF_DECR || lock_word <= -X_LOCK_DECR) {
+    /* x-locked, possibly also sx-locked by the same thread */
     return RW_LOCK_EX;
   } else {
-    ut_ad(lock_word > -X_LOCK_DECR);
+    /* x-waiter, possibly holding an sx-lock */
     return RW_LOCK_WAIT_EX;
   }
 }
@@ -490,12 +557,18 @@ inline ulint rw_lock_get_writer(const rw_lock_t *lock) {
 inline ulint rw_lock_get_reader_count(const rw_lock_t *lock) {
   auto lock_word = lock->m_lock_word.load();
 
-  if (lock_word > 0) {
+  if (lock_word > X_LOCK_HALF_DECR) {
     /* s-locked, no x-waiters */
     return X_LOCK_DECR - lock_word;
-  } else if (lock_word < 0 && lock_word > -X_LOCK_DECR) {
+  } else if (lock_word > 0) {
+    /* s-locked, with an sx-lock */
+    return X_LOCK_HALF_DECR - lock_word;
+  } else if (lock_word < 0 && lock_word > -X_LOCK_HALF_DECR) {
     /* s-locked, with x-waiters */
     return (ulint)(-lock_word);
+  } else if (lock_word < -X_LOCK_HALF_DECR && lock_word > -X_LOCK_DECR) {
+    /* s-locked, with an x-waiter that holds an sx-lock */
+    return (ulint)(-(lock_word + X_LOCK_HALF_DECR));
   } else {
     return 0;
   }
@@ -509,11 +582,34 @@ inline ulint rw_lock_get_x_lock_count(const rw_lock_t *lock) {
   auto lock_copy = lock->m_lock_word.load();
   ut_ad(lock_copy <= X_LOCK_DECR);
 
-  /* If there is a reader, m_lock_word is not divisible by X_LOCK_DECR */
-  if (lock_copy > 0 || (-lock_copy) % X_LOCK_DECR != 0) {
+  if (lock_copy == 0 || lock_copy == -X_LOCK_HALF_DECR) {
+    /* One x-lock, with or without sx-locks */
+    return 1;
+  } else if (lock_copy > -X_LOCK_DECR) {
+    /* s- or sx-locks, or an x-waiter */
     return 0;
+  } else if (lock_copy > -(X_LOCK_DECR + X_LOCK_HALF_DECR)) {
+    /* Two or more x-locks, no sx-locks. The second x-lock decrements
+    m_lock_word by X_LOCK_DECR, the others by 1. */
+    return 2 - (lock_copy + X_LOCK_DECR);
+  } else {
+    /* Two or more x-locks and sx-locks */
+    return 2 - (lock_copy + X_LOCK_DECR + X_LOCK_HALF_DECR);
+  }
+}
+
+/** Returns the number of sx-locks held by the writer thread. Does not
+reserve the lock mutex, so the caller must be sure it is not changed
+during the call.
+@param[in] lock                 Lock for which sx-lock count required.
+@return	value of sx-lock count */
+inline ulint rw_lock_get_sx_lock_count(const rw_lock_t *lock) {
+  auto lock_copy = lock->m_lock_word.load();
+
+  if (lock_copy <= X_LOCK_HALF_DECR && lock->m_sx_recursive > 0) {
+    return lock->m_sx_recursive;
   } else {
-    return ((-lock_copy) / X_LOCK_DECR) + 1;
+    return 0;
   }
 }
 
@@ -524,11 +620,15 @@ need not be atomic since they are performed by the current lock holder.
 Returns true if the decrement was made, false if not.
 @param[in,out] lock             Lock to decrement.
 @param[in] amount               Amount to decrement.
+@param[in] threshold            The decrement is only made while
+                                m_lock_word is above this: 0 for an
+                                s-lock, X_LOCK_HALF_DECR for an sx- or
+                                x-lock.
 @return	true if decr occurs */
-inline bool rw_lock_lock_word_decr(rw_lock_t *lock, ulint amount) {
+inline bool rw_lock_lock_word_decr(rw_lock_t *lock, ulint amount, lint threshold) {
   auto local_lock_word = lock->m_lock_word.load();
 
-  while (local_lock_word > 0) {
+  while (local_lock_word > threshold) {
     if (lock->m_lock_word.compare_exchange_strong(local_lock_word, local_lock_word - amount)) {
       return true;
     }
@@ -568,7 +668,7 @@ spinning.
 @param[in] line                 Line in file_name where requested
 @return	true on success */
 inline bool rw_lock_s_lock_low(rw_lock_t *lock, ulint pass, const char *file_name, ulint line) {
-  if (!rw_lock_lock_word_decr(lock, 1)) {
+  if (!rw_lock_lock_word_decr(lock, 1, 0)) {
     /* Locking did not succeed */
     return false;
   } else {
@@ -585,6 +685,23 @@ inline bool rw_lock_s_lock_low(rw_lock_t *lock, ulint pass, const char *file_nam
   }
 }
 
+/** NOTE! Use the corresponding macro, not directly this function! Lock an
+rw-lock in shared mode for the current thread if the lock can be obtained
+immediately.
+@param[in] lock                 Lock instance to lock in S-mode.
+@param[in] file_name            File name where lock requested
+@param[in] line                 Line in file_name where requested
+@return	true if success */
+inline bool rw_lock_s_lock_nowait_func(rw_lock_t *lock, const char *file_name, ulint line) {
+  if (!rw_lock_s_lock_low(lock, 0, file_name, line)) {
+    return false;
+  }
+
+  sync_latch_acquired(lock->m_site);
+
+  return true;
+}
+
 /** NOTE! Use the corresponding macro, not directly this function! Lock an
 rw-lock in shared mode for the current thread. If the rw-lock is locked
 in exclusive mode, or there is an exclusive lock request waiting, the
@@ -613,6 +730,7 @@ inline void rw_lock_s_lock_func(rw_lock_t *lock, ulint pass, const char *file_na
 #endif                                       /* UNIV_SYNC_DEBUG */
 
   if (rw_lock_s_lock_low(lock, pass, file_name, line)) {
+    sync_latch_acquired(lock->m_site);
     return; /* Success */
   } else {
     /* Did not succeed, try spin wait */
@@ -638,13 +756,14 @@ inline bool rw_lock_x_lock_func_nowait(rw_lock_t *lock, const char *file_name, u
     threads can modify (lock, unlock, or reserve) m_lock_word while
     there is an exclusive writer and this is the writer thread. */
 
-    if (lock->m_lock_word == 0) {
+    if (lock->m_lock_word == 0 || lock->m_lock_word == -X_LOCK_HALF_DECR) {
       /* There is another X-LOCK. */
       lock->m_lock_word -= X_LOCK_DECR;
     } else if (lock->m_lock_word <= -X_LOCK_DECR) {
       /* THere is more than one X-LOCK. */
       --lock->m_lock_word;
     } else {
+      /* We hold only sx-locks, the upgrade must wait for the readers. */
       return false;
     }
 
@@ -661,6 +780,8 @@ inline bool rw_lock_x_lock_func_nowait(rw_lock_t *lock, const char *file_name, u
   lock->m_last_x_line = line;
   lock->m_last_x_file_name = file_name;
 
+  sync_latch_acquired(lock->m_site);
+
   ut_ad(rw_lock_validate(lock));
 
   return true;
@@ -676,20 +797,24 @@ inline void rw_lock_s_unlock_func(
 #endif /* UNIV_SYNC_DEBUG */
   rw_lock_t *lock
 ) {
-  ut_ad((lock->m_lock_word % X_LOCK_DECR) != 0);
+  ut_ad(lock->m_lock_word > -X_LOCK_DECR);
+  ut_ad(lock->m_lock_word != 0);
+  ut_ad(lock->m_lock_word < X_LOCK_DECR);
 
 #ifdef UNIV_SYNC_DEBUG
   rw_lock_remove_debug_info(lock, pass, RW_LOCK_SHARED);
 #endif /* UNIV_SYNC_DEBUG */
 
   /* Increment lock_word to indicate 1 less reader */
-  if (rw_lock_lock_word_incr(lock, 1) == 0) {
+  const auto lock_word = rw_lock_lock_word_incr(lock, 1);
+
+  if (lock_word == 0 || lock_word == -X_LOCK_HALF_DECR) {
 
     /* wait_ex waiter exists. It may not be asleep, but we signal
     anyway. We do not wake other waiters, because they can't
-    exist without wait_ex waiter and wait_ex waiter goes first.*/
-    os_event_set(lock->m_wait_ex_event);
-    sync_array_object_signalled(sync_primary_wait_array);
+    exist without wait_ex waiter and wait_ex waiter goes first.
+    There can only be one wait_ex waiter. */
+    rw_lock_signal(lock->m_wait_ex_seq, false);
   }
 
   ut_ad(rw_lock_validate(lock));
@@ -705,12 +830,13 @@ inline void rw_lock_x_unlock_func(
 #endif /* UNIV_SYNC_DEBUG */
   rw_lock_t *lock
 ) {
-  ut_ad(lock->m_lock_word == 0 || lock->m_lock_word <= -X_LOCK_DECR);
+  ut_ad(lock->m_lock_word == 0 || lock->m_lock_word == -X_LOCK_HALF_DECR || lock->m_lock_word <= -X_LOCK_DECR);
 
   /* lock->m_recursive flag also indicates if lock->m_writer_thread is
   valid or stale. If we are the last of the recursive callers
   then we must unset lock->m_recursive flag to indicate that the
-  lock->m_writer_thread is now stale.
+  lock->m_writer_thread is now stale. If we still hold an sx-lock
+  the writer thread stays valid.
 
   Note that since we still hold the x-lock we can safely read the lock_word. */
   if (lock->m_lock_word == 0) {
@@ -722,14 +848,65 @@ inline void rw_lock_x_unlock_func(
   rw_lock_remove_debug_info(lock, pass, RW_LOCK_EX);
 #endif /* UNIV_SYNC_DEBUG */
 
-  if (rw_lock_lock_word_incr(lock, X_LOCK_DECR) == X_LOCK_DECR) {
-    /* Lock is now free. May have to signal read/write waiters.
-    We do not need to signal wait_ex waiters, since they cannot
-    exist when there is a writer. */
+  if (lock->m_lock_word == 0 || lock->m_lock_word == -X_LOCK_HALF_DECR) {
+    /* There is one x-lock. After this the lock is free, or only
+    sx-locked by us, either way readers and writers that were
+    waiting may now proceed. We do not need to signal wait_ex
+    waiters, since they cannot exist when there is a writer. */
+    rw_lock_lock_word_incr(lock, X_LOCK_DECR);
+
     if (lock->m_waiters.load()) {
       rw_lock_reset_waiter_flag(lock);
-      os_event_set(lock->m_event);
-      sync_array_object_signalled(sync_primary_wait_array);
+      rw_lock_signal(lock->m_wake_seq, true);
+    }
+  } else if (lock->m_lock_word == -X_LOCK_DECR || lock->m_lock_word == -(X_LOCK_DECR + X_LOCK_HALF_DECR)) {
+    /* There are two x-locks */
+    lock->m_lock_word += X_LOCK_DECR;
+  } else {
+    /* There are more than two x-locks */
+    ut_ad(lock->m_lock_word < -X_LOCK_DECR);
+    ++lock->m_lock_word;
+  }
+
+  ut_ad(rw_lock_validate(lock));
+}
+
+/** Releases a shared-exclusive mode lock.
+@param[in,out] lock             Lock instance to sx-unlock
+@param[in] pass                 Value; != 0, if the lock may have
+                                been passed to another thread to unlock */
+inline void rw_lock_sx_unlock_func(
+#ifdef UNIV_SYNC_DEBUG
+  ulint pass,
+#endif /* UNIV_SYNC_DEBUG */
+  rw_lock_t *lock
+) {
+  ut_ad(rw_lock_get_sx_lock_count(lock) > 0);
+
+#ifdef UNIV_SYNC_DEBUG
+  rw_lock_remove_debug_info(lock, pass, RW_LOCK_SX);
+#endif /* UNIV_SYNC_DEBUG */
+
+  if (--lock->m_sx_recursive == 0) {
+    /* Last sx-lock in a possible recursive chain. Since we still
+    hold the sx-lock we can safely read the lock_word. */
+    if (lock->m_lock_word > 0) {
+      /* No x-lock either, the writer thread becomes stale. */
+      lock->m_recursive = false;
+
+      rw_lock_lock_word_incr(lock, X_LOCK_HALF_DECR);
+
+      /* The lock is now free of writers. May have to signal
+      read/write waiters. We do not need to signal wait_ex waiters,
+      since they cannot exist while there is an sx-lock. */
+      if (lock->m_waiters.load()) {
+        rw_lock_reset_waiter_flag(lock);
+        rw_lock_signal(lock->m_wake_seq, true);
+      }
+    } else {
+      /* We still hold an x-lock */
+      ut_ad(lock->m_lock_word == -X_LOCK_HALF_DECR || lock->m_lock_word <= -(X_LOCK_DECR + X_LOCK_HALF_DECR));
+      lock->m_lock_word += X_LOCK_HALF_DECR;
     }
   }
 
@@ -37,6 +37,7 @@ Created 9/5/1995 Heikki Tuuri
 #include "os0thread.h"
 #include "sync0arr.h"
 #include "sync0mutex.h"
+#include "sync0prof.h"
 #include "ut0counter.h"
 #include "ut0mem.h"
 
@@ -267,7 +268,17 @@ V
 Kernel mutex				If a kernel operation needs a file
 |					page allocation, it must reserve the
 |					fsp x-latch before acquiring the kernel
-|					mutex.
+|					mutex. The kernel mutex protects the
+|					lock system and the query thread
+|					states.
+V
+Transaction system mutex		Protects the trx list, the trx id
+|					counter and the active transaction
+|					snapshot. Starting a transaction needs
+|					only this mutex.
+V
+Server mutex				Protects the server thread slots and
+|					the activity counters.
 V
 Search system mutex
 |
@@ -337,10 +348,25 @@ constexpr ulint SYNC_FSP_PAGE = 395;
 
 /*-------------------------------*/
 
+/* The kernel mutex protects the lock system and the query thread states,
+the trx system and the server thread table have mutexes of their own. They
+are acquired in this order:
+
+  kernel mutex (lock system, query threads)
+    -> trx system mutex (trx list, trx ids, snapshot)
+    -> read view mutex
+    -> server mutex (thread slots, activity counters)
+
+A thread that holds the kernel mutex may look up transactions under the
+trx system mutex, never the other way round. Starting a transaction and
+creating a read view take only the trx system and view mutexes. */
 constexpr ulint SYNC_KERNEL = 300;
 constexpr ulint SYNC_REC_LOCK = 299;
 constexpr ulint SYNC_TRX_LOCK_HEAP = 298;
+constexpr ulint SYNC_TRX_SYS = 296;
+constexpr ulint SYNC_READ_VIEW = 295;
 constexpr ulint SYNC_TRX_SYS_HEADER = 290;
+constexpr ulint SYNC_SRV_SYS = 285;
 constexpr ulint SYNC_LOG = 170;
 constexpr ulint SYNC_RECV = 168;
 constexpr ulint SYNC_WORK_QUEUE = 162;
@@ -369,6 +395,7 @@ constexpr ulint RW_LOCK_EXCLUSIVE = 351;
 constexpr ulint RW_LOCK_SHARED = 352;
 constexpr ulint RW_LOCK_WAIT_EX = 353;
 constexpr ulint SYNC_MUTEX = 354;
+constexpr ulint RW_LOCK_SX = 355;
 
 /* NOTE! The structure appears here only for the compiler to know its size.
 Do not use its fields directly! The structure used in the spin lock
@@ -380,12 +407,16 @@ implementation of a mutual exclusion semaphore. */
 mutexes and read-write locks. */
 extern Sync_check *sync_primary_wait_array;
 
-/** Constant determining how long spin wait is continued before suspending
+/** Upper bound on how long spin wait is continued before suspending
 the thread. A value 600 rounds on a 1995 100 MHz Pentium seems to correspond
-to 20 microseconds. */
+to 20 microseconds. Mutexes learn their own budget below this bound. */
 
 #define SYNC_SPIN_ROUNDS srv_n_spin_wait_rounds
 
+/** Fewest spin rounds that a mutex may learn to use, unless
+SYNC_SPIN_ROUNDS is smaller */
+constexpr ulint SYNC_SPIN_MIN_ROUNDS = 4;
+
 /** The number of mutex_exit calls. Intended for performance monitoring. */
 using counter_t = ut::CPU_sharded_counter<8>;
 extern counter_t mutex_exit_count;
@@ -407,18 +438,13 @@ extern ut_mutex_list_base_node_t mutex_list;
 /** Mutex protecting the mutex_list variable */
 extern mutex_t mutex_list_mutex;
 
-/**
- * Sets the waiters field in a mutex.
- *
- * @param mutex - mutex
- * @param n - value to set
- */
-void mutex_set_waiters(mutex_t *mutex, ulint n);
-
 /**
  * Reserves a mutex for the current thread. If the mutex is reserved, the
- * function spins a preset time (controlled by SYNC_SPIN_ROUNDS) waiting
- * for the mutex before suspending the thread.
+ * function spins for a while waiting for the mutex before suspending the
+ * thread. The spin budget is learnt per mutex from its hold time and spin
+ * success rate, capped by SYNC_SPIN_ROUNDS, and is skipped while the owner
+ * of the mutex is itself blocked. Now and then a wait spins for the full
+ * SYNC_SPIN_ROUNDS, so that the budget can grow again.
  *
  * @param mutex - pointer to mutex
  * @param file_name - file name where mutex requested
@@ -438,28 +464,37 @@ void mutex_set_debug_info(mutex_t *mutex, const char *file_name, ulint line);
 #endif /* UNIV_SYNC_DEBUG */
 
 /**
- * Releases the threads waiting in the primary wait array for this mutex.
+ * Wakes up one of the threads parked on the lock word of this mutex.
  *
  * @param mutex - mutex
  */
 void mutex_signal_object(mutex_t *mutex);
 
 /**
- * Performs an atomic test-and-set instruction to the lock_word field of a mutex.
+ * Tries to move the lock_word field of a mutex from unlocked to locked.
  *
  * @param mutex - mutex
- * @return the previous value of lock_word: 0 or 1
+ * @return 0 if the mutex was acquired, 1 otherwise
  */
 inline byte mutex_test_and_set(mutex_t *mutex) {
-  return mutex->lock_word.exchange(true);
+  uint32_t expected{MUTEX_UNLOCKED};
+
+  return !mutex->lock_word.compare_exchange_strong(expected, MUTEX_LOCKED);
 }
 
-/** Performs a reset instruction to the lock_word field of a mutex. This
-instruction also serializes memory operations to the program order. */
-inline void mutex_reset_lock_word(mutex_t *mutex) /*!< in: mutex */
-{
+/** Records the calling thread as the owner of the mutex, for the spinning
+heuristics of the waiters.
+@param[in,out] mutex            Mutex that was just acquired. */
+inline void mutex_set_owner(mutex_t *mutex) {
+  mutex->m_owner_slot.store(os_thread_get_slot(), std::memory_order_relaxed);
+}
 
-  mutex->lock_word.store(false);
+/** Performs a reset instruction to the lock_word field of a mutex. This
+instruction also serializes memory operations to the program order.
+@param[in,out] mutex            Mutex to release.
+@return the lock word value before the reset */
+inline uint32_t mutex_reset_lock_word(mutex_t *mutex) {
+  return mutex->lock_word.exchange(MUTEX_UNLOCKED);
 }
 
 /**
@@ -468,15 +503,15 @@ inline void mutex_reset_lock_word(mutex_t *mutex) /*!< in: mutex */
  * @param mutex - mutex
  * @return the value of the lock word
  */
-inline lock_word_t mutex_get_lock_word(const mutex_t *mutex) {
+inline uint32_t mutex_get_lock_word(const mutex_t *mutex) {
   return mutex->lock_word.load();
 }
 
-/** Gets the waiters field in a mutex.
+/** Checks whether there may be threads parked on the mutex.
 @param[in] mutex                Get the waiters or this mutex.
-@return	value to set */
+@return	1 if there may be waiters, 0 otherwise */
 inline ulint mutex_get_waiters(const mutex_t *mutex) {
-  return mutex->m_waiters.load();
+  return mutex_get_lock_word(mutex) == MUTEX_LOCKED_WAITERS;
 }
 
 /**
@@ -490,21 +525,11 @@ inline void mutex_exit(mutex_t *mutex) {
 
   IF_SYNC_DEBUG(sync_thread_reset_level(mutex);)
 
-  mutex_reset_lock_word(mutex);
-
-  /* A problem: we assume that mutex_reset_lock word
-  is a memory barrier, that is when we read the waiters
-  field next, the read must be serialized in memory
-  after the reset. A speculative processor might
-  perform the read first, which could leave a waiting
-  thread hanging indefinitely.
-
-  Our current solution call every second
-  sync_arr_wake_threads_if_sema_free()
-  to wake up possible hanging threads if
-  they are missed in mutex_signal_object. */
+  /* The waiter state and the release are read and written by the same
+  atomic exchange, a waiter that parks after this point will see the
+  lock word change and not sleep, so no wakeup can be missed. */
 
-  if (mutex_get_waiters(mutex) != 0) {
+  if (mutex_reset_lock_word(mutex) == MUTEX_LOCKED_WAITERS) {
 
     mutex_signal_object(mutex);
   }
@@ -529,6 +554,8 @@ inline void mutex_enter_func(mutex_t *mutex, const char *file_name, ulint line)
   ut_d(mutex->count_using++);
 
   if (!mutex_test_and_set(mutex)) {
+    mutex_set_owner(mutex);
+    sync_latch_acquired(mutex->m_site);
     ut_d(mutex->thread_id = os_thread_get_curr_id());
     IF_SYNC_DEBUG(mutex_set_debug_info(mutex, file_name, line);)
 
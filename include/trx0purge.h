@@ -34,12 +34,94 @@ Created 3/26/1996 Heikki Tuuri
 #include "trx0undo.h"
 #include "usr0sess.h"
 
+#include <atomic>
+#include <vector>
+
+struct Purge_worker;
+
 /**
  * A dummy undo record used as a return value when we have a whole undo log
  * which needs no purge
  */
 extern trx_undo_rec_t trx_purge_dummy_rec;
 
+/** Size of the record queue of a purge worker, must be a power of 2. */
+constexpr ulint PURGE_WORKER_QUEUE_SIZE = 64;
+
+/** Maximum number of undo records a purge batch can have dispatched to
+the purge workers and not yet purged. This is also the size of the purge
+array, one cell is reserved for every record that is being purged. */
+constexpr ulint PURGE_MAX_RECS_IN_FLIGHT = 256;
+
+/** The adaptive purge batch size never grows beyond this multiple of
+the configured purge_batch_size. */
+constexpr ulint PURGE_BATCH_SIZE_MAX_FACTOR = 16;
+
+/** When the copies of the undo records dispatched in a batch use more memory
+than this, the coordinator waits for the workers and frees them. */
+constexpr ulint PURGE_MAX_HEAP_SIZE = 4 * 1024 * 1024;
+
+/** Number of tokens the DML throttle lets through at once after an idle period */
+constexpr uint64_t DML_THROTTLE_BURST = 16;
+
+/** The DML throttle never goes below this many operations per second */
+constexpr double DML_THROTTLE_MIN_RATE = 10.0;
+
+/** Minimum interval in microseconds over which the purge and history
+growth rates are measured to adjust the DML throttle */
+constexpr uint64_t DML_THROTTLE_INTERVAL_US = 100000;
+
+/**
+ * Meters INSERT, UPDATE and DELETE operations when the purge is lagging.
+ * It is a token bucket: the purge coordinator sets the rate at which the
+ * tokens are issued and every DML operation takes one. If none is available
+ * the caller is delayed until its token is issued, so the delay grows with
+ * the load instead of being the same for every operation. While the purge
+ * keeps up no token is taken and the DML does not touch the shared state.
+ */
+struct Dml_throttle {
+  /**
+   * Sets the token rate.
+   * 
+   * @param[in] rate              Tokens per second, 0 disables the throttle.
+   */
+  void set_rate(double rate) noexcept;
+
+  /**
+   * Takes a token if the purge is lagging.
+   * 
+   * @return microseconds the caller must wait for its token, 0 if none.
+   */
+  [[nodiscard]] uint64_t acquire() noexcept;
+
+  /**
+   * @return the current token rate per second, 0 if the throttle is off.
+   */
+  [[nodiscard]] double rate() const noexcept {
+    const auto interval = m_interval_us.load(std::memory_order_relaxed);
+
+    return interval == 0 ? 0.0 : 1000000.0 / interval;
+  }
+
+  /** True while the history list is longer than max_purge_lag */
+  std::atomic<bool> m_lagging{};
+
+  /** Microseconds between two tokens, 0 if DML is not throttled */
+  std::atomic<uint64_t> m_interval_us{};
+
+  /** Time at which the next token is issued, in microseconds */
+  std::atomic<uint64_t> m_next_us{};
+
+  /** Number of tokens taken while the purge was lagging, throttled or not */
+  std::atomic<ulint> m_n_acquired{};
+
+  /** Number of DML operations that had to wait for their token */
+  std::atomic<ulint> m_n_delayed{};
+
+  /** Total time DML operations waited for their tokens, in microseconds */
+  std::atomic<uint64_t> m_delay_us{};
+};
+
 enum Purge_state {
   /** Unknown state. */
   PURGE_STATE_UNKNOWN = 0,
@@ -124,12 +206,20 @@ struct Purge_sys {
   void rec_release(trx_undo_inf_t *cell) noexcept;
 
   /**
-   * This function runs a purge batch.
+   * This function runs a purge batch. If there is more than one purge thread
+   * configured the calling thread acts as the coordinator: it fetches the
+   * undo records and dispatches them to the purge workers by row.
    * 
    * @return	number of undo log pages handled in the batch
    */
   ulint run() noexcept;
 
+  /**
+   * Stops and joins the purge worker threads, if they were started. Must be
+   * called when no purge batch is running, before the threads are shut down.
+   */
+  void stop_workers() noexcept;
+
   /**
    * @return string representation of the purge sub-system.
    */
@@ -224,6 +314,67 @@ private:
    */
   trx_undo_rec_t *get_next_rec(mem_heap_t *heap) noexcept;
 
+  /**
+   * Sets the DML throttle rate from the rates measured since the last
+   * adjustment. While the history list is longer than max_purge_lag the DML
+   * rate is scaled by the ratio of the purge rate to the history growth rate
+   * and by how far the history list is over the limit.
+   * 
+   * @param[in] history_len       Current length of the history list.
+   */
+  void update_dml_throttle(ulint history_len) noexcept;
+
+  /**
+   * Adjusts the batch size to the history list length: it is doubled while
+   * the history list keeps growing and halved back to the configured size
+   * once purge is keeping up.
+   * 
+   * @param[in] history_len       Current length of the history list.
+   */
+  void adapt_batch_size(ulint history_len) noexcept;
+
+  /**
+   * Marks an undo tablespace that has grown too big inactive and truncates
+   * it once the purge has passed all its undo logs. One undo tablespace is
+   * handled at a time. NOTE that when this function is called, the caller
+   * must not have any latches on undo log pages!
+   */
+  void truncate_undo_spaces() noexcept;
+
+  /**
+   * Creates the purge worker threads. They are created on the first purge
+   * batch because the purge system itself is created under the kernel mutex.
+   */
+  void start_workers() noexcept;
+
+  /**
+   * Waits until the purge workers have completed more than n_recs_done records.
+   * 
+   * @param[in] n_recs_done       Number of records completed when the caller
+   *                              last checked.
+   */
+  void wait_for_workers(ulint n_recs_done) noexcept;
+
+  /**
+   * Waits until the purge workers have completed all the records of the batch.
+   *
+   * @param[in] n_recs_dispatched Number of records dispatched in the batch.
+   */
+  void wait_for_all_workers(ulint n_recs_dispatched) noexcept;
+
+  /**
+   * Fetches the undo records of the current batch and dispatches them to the
+   * purge workers. Returns when all of them have been purged.
+   */
+  void dispatch() noexcept;
+
+  /**
+   * The purge worker thread main loop.
+   * 
+   * @param[in,out] worker        Worker that this thread runs.
+   */
+  void worker_loop(Purge_worker *worker) noexcept;
+
 public:
   /** Purge system state */
   Purge_state m_state{PURGE_STATE_UNKNOWN};
@@ -292,4 +443,42 @@ public:
   /** Temporary storage used during a purge: can be emptied after
    * purge completes */
   mem_heap_t *m_heap{};
+
+  /** Number of undo log pages to handle in the next purge batch */
+  ulint m_batch_size{};
+
+  /** History list length at the start of the previous purge batch */
+  ulint m_prev_history_len{};
+
+  /** Purge worker threads, empty if the purge is single threaded */
+  std::vector<Purge_worker *> m_workers{};
+
+  /** Signalled by a purge worker every time it completes a record */
+  Cond_var *m_done_event{};
+
+  /** Number of records the purge workers have completed in the current batch */
+  std::atomic<ulint> m_n_recs_done{};
+
+  /** Set to tell the purge workers to exit */
+  std::atomic<bool> m_stop_workers{};
+
+  /** Meters DML when the purge is lagging */
+  Dml_throttle m_dml_throttle{};
+
+  /** Number of undo logs removed from the history list */
+  ulint m_n_logs_purged{};
+
+  /** The fields below are the values at the last DML throttle adjustment */
+
+  /** Time of the last adjustment in microseconds, 0 if none yet */
+  uint64_t m_throttle_time_us{};
+
+  /** m_n_logs_purged */
+  ulint m_throttle_n_logs_purged{};
+
+  /** History list length */
+  ulint m_throttle_history_len{};
+
+  /** Dml_throttle::m_n_acquired */
+  ulint m_throttle_n_acquired{};
 };
@@ -84,6 +84,16 @@ byte *trx_undo_rec_skip_row_ref(
                           record, at the start of the row reference */
   Index *index /*!< in: clustered index */);
 
+/**
+ * @brief Folds the table id and the first field of the row reference of an
+ * update undo log record. All the undo records of a row fold to the same value.
+ *
+ * @param[in] undo_rec Update undo log record.
+ *
+ * @return The fold value.
+ */
+ulint trx_undo_update_rec_fold_row(trx_undo_rec_t *undo_rec) noexcept;
+
 /** Reads from an undo log update record the system field values of the old
 version.
 @return	remaining part of undo log record after reading these values */
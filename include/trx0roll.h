@@ -44,7 +44,7 @@ bool trx_is_recv(const Trx *trx); /*!< in: transaction */
 trx_savept_t trx_savept_take(Trx *trx); /*!< in: transaction */
 
 /** Creates an undo number array. */
-trx_undo_arr_t *trx_undo_arr_create(void);
+trx_undo_arr_t *trx_undo_arr_create(ulint n_cells = UNIV_MAX_PARALLELISM); /*!< in: number of cells */
 
 /** Frees an undo number array. */
 void trx_undo_arr_free(trx_undo_arr_t *arr); /*!< in: undo number array */
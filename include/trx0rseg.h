@@ -52,6 +52,42 @@ trx_rseg_t *trx_rseg_get_on_id(ulint id);
  */
 page_no_t trx_rseg_header_create(space_id_t space, ulint max_size, ulint *slot_no, mtr_t *mtr);
 
+/**
+ * Creates a rollback segment header in the given slot of the trx system
+ * header. The slot must not be in use.
+ * 
+ * @param[in] space The space id.
+ * @param[in] max_size The maximum size in pages.
+ * @param[in] slot_no The rollback segment id == slot number in trx sys.
+ * @param[in] mtr The mini-transaction handle.
+ * 
+ * @return	page number of the created segment, FIL_NULL if fail
+ */
+page_no_t trx_rseg_header_create_in_slot(space_id_t space, ulint max_size, ulint slot_no, mtr_t *mtr);
+
+/**
+ * Creates a new rollback segment in a free slot of the trx system header
+ * and adds it to the rseg list and array.
+ * 
+ * @param[in] space The space id, its latch must be x-locked in mtr.
+ * @param[in] mtr The mini-transaction handle.
+ * 
+ * @return	the rollback segment, nullptr if no slot or no space left
+ */
+trx_rseg_t *trx_rseg_create(space_id_t space, mtr_t *mtr);
+
+/**
+ * Recreates an unused rollback segment with an empty header in a new
+ * tablespace, keeping its id. Used when an undo tablespace is truncated.
+ * 
+ * @param[in,out] rseg The rollback segment, it must not have any undo logs.
+ *   The caller must own its mutex, acquired before the space latch and
+ *   the kernel mutex.
+ * @param[in] space The new space id, its latch must be x-locked in mtr.
+ * @param[in] mtr The mini-transaction handle.
+ */
+void trx_rseg_reset(trx_rseg_t *rseg, space_id_t space, mtr_t *mtr);
+
 /**
  * Creates the memory copies for rollback segments and initializes the
  * rseg list and array in srv_trx_sys at a database startup.
@@ -124,6 +160,10 @@ struct trx_rseg_t {
   /** true if the last not yet purged log needs purging */
   bool last_del_marks;
 
+  /** Undo tablespace where the rollback segment is, nullptr if it is
+   * in the system tablespace */
+  Undo_space *undo_space;
+
   /* the list of the rollback segment memory objects */
   UT_LIST_NODE_T(trx_rseg_t) rseg_list;
 };
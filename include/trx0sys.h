@@ -37,11 +37,17 @@ Created 3/26/1996 Heikki Tuuri
 #include "trx0types.h"
 #include "ut0byte.h"
 #include "ut0lst.h"
+#include "ut0mpmcbq.h"
 #include "data0type.h"
 #include "mtr0log.h"
 #include "srv0srv.h"
 #include "trx0trx.h"
 
+#include <atomic>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
 /* The typedef for rseg slot in the file copy */
 using trx_sysf_rseg_t = byte;
 
@@ -81,6 +87,10 @@ id must fit in one byte, therefore 256; each slot is currently 8 bytes
 in size */
 constexpr ulint TRX_SYS_N_RSEGS = 256;
 
+/** Number of rollback segment slots that can be used: the rollback segment
+id is stored in 7 bits of a roll pointer, see trx_undo_build_roll_ptr() */
+constexpr ulint TRX_SYS_N_USABLE_RSEGS = 128;
+
 static_assert(UNIV_PAGE_SIZE >= 4096, "error UNIV_PAGE_SIZE < 4096");
 
 /* Rollback segment specification slot offsets */
@@ -102,8 +112,68 @@ two) is assigned, the field TRX_SYS_TRX_ID_STORE on the transaction system
 page is updated */
 constexpr ulint TRX_SYS_TRX_ID_WRITE_MARGIN = 256;
 
-/** The transaction system central memory data structure; protected by the
-kernel mutex */
+/** Maximum number of undo tablespaces. Their rollback segments share the
+TRX_SYS_N_USABLE_RSEGS ids with the ones in the system tablespace: 16 undo
+tablespaces would take all 128 ids, the last one would not fit in the roll
+pointer. */
+constexpr ulint TRX_SYS_MAX_UNDO_SPACES = 8;
+
+/** Number of rollback segments created in each undo tablespace */
+constexpr ulint TRX_UNDO_SPACE_N_RSEGS = 8;
+
+/** Maximum number of rollback segments in the system tablespace, including
+the SYSTEM rollback segment */
+constexpr ulint TRX_SYS_MAX_SYSTEM_RSEGS = 64;
+
+static_assert(
+  TRX_SYS_MAX_UNDO_SPACES * TRX_UNDO_SPACE_N_RSEGS + TRX_SYS_MAX_SYSTEM_RSEGS <= TRX_SYS_N_USABLE_RSEGS,
+  "error too many rollback segments"
+);
+
+/** Number of shards of the pool of free client transaction objects, a thread
+always uses the same shard */
+constexpr ulint TRX_POOL_N_SHARDS = 16;
+
+/** Number of free client transaction objects kept in each shard of the pool,
+must be a power of 2 */
+constexpr ulint TRX_POOL_SHARD_SIZE = 32;
+
+/** A tablespace of its own for undo logs. It is a file undo_<nnn>.ibd in the
+data home directory which contains TRX_UNDO_SPACE_N_RSEGS rollback segments.
+When the file grows over the configured limit it is marked inactive: no more
+transactions are assigned to its rollback segments and, once the purge has
+passed all its undo logs, the file is recreated at its initial size. */
+struct Undo_space {
+  /** Number of the undo tablespace, from 1 */
+  ulint m_no{};
+
+  /** Tablespace id, it changes when the file is truncated */
+  space_id_t m_id{};
+
+  /** false while the tablespace is waiting to be truncated; written
+  under Trx_sys::m_mutex, read without it by trx_assign_rseg() */
+  std::atomic<bool> m_active{true};
+};
+
+/** Immutable copy of the set of active transactions, so that read views can
+be created from it without holding the trx system mutex. Starting, numbering
+and committing a transaction publish a new copy while they hold the trx
+system mutex, a read view only loads the latest one. */
+struct Trx_snapshot {
+  /** Value of Trx_sys::m_max_trx_id when the snapshot was published. */
+  trx_id_t m_max_trx_id{};
+
+  /** The smallest transaction number of the active transactions, or
+  m_max_trx_id if none of them has been assigned one yet. */
+  trx_id_t m_low_limit_no{};
+
+  /** Ids of the active and prepared transactions, smallest first. */
+  std::vector<trx_id_t> m_ids{};
+};
+
+/** The transaction system central memory data structure. The transaction
+lists and counters are protected by Trx_sys::m_mutex, the rollback segment
+list by the kernel mutex. */
 struct Trx_sys {
 
   /**
@@ -165,12 +235,36 @@ struct Trx_sys {
   [[nodiscard]] ulint frseg_find_free(mtr_t *mtr) noexcept;
 
   /**
-   * Checks that trx is in the trx list.
+   * Checks that trx is in the trx list. Acquires the trx system mutex.
    * 
    * @return	true if is in
    */
   [[nodiscard]] bool in_trx_list(Trx *in_trx) noexcept;
 
+  /**
+   * Acquires the trx system mutex. If the caller also needs the kernel
+   * mutex, the kernel mutex must be acquired first.
+   */
+  void mutex_acquire() const noexcept {
+    mutex_enter(&m_mutex);
+  }
+
+  /**
+   * Releases the trx system mutex.
+   */
+  void mutex_release() const noexcept {
+    mutex_exit(&m_mutex);
+  }
+
+  /**
+   * Checks if the trx system mutex is owned by the calling thread.
+   *
+   * @return	true if owned
+   */
+  [[nodiscard]] bool mutex_is_owned() const noexcept {
+    return mutex_own(&m_mutex);
+  }
+
   /**
    * Writes the value of max_trx_id to the file based trx system header.
    */
@@ -183,17 +277,77 @@ struct Trx_sys {
    * 
    * @return	the trx handle or NULL if not found
    */
-  [[nodiscard]] Trx *get_on_id(trx_id_t trx_id) noexcept {
-    ut_ad(mutex_own(&kernel_mutex));
+  [[nodiscard]] Trx *get_on_id(trx_id_t trx_id) const noexcept {
+    ut_ad(mutex_own(&m_mutex));
 
-    for (const auto trx : m_trx_list) {
-      if (trx_id == trx->m_id) {
+    auto it = m_trx_ids.find(trx_id);
 
-        return trx;
-      }
-    }
+    return it == m_trx_ids.end() ? nullptr : it->second;
+  }
 
-    return nullptr;
+  /**
+   * Adds the trx to the front of the trx list and to the trx id hash. The
+   * trx must have the biggest id in the list.
+   *
+   * @param[in] trx	Transaction to add
+   */
+  void trx_list_push_front(Trx *trx) noexcept {
+    ut_ad(mutex_own(&m_mutex));
+    ut_ad(m_trx_list.empty() || m_trx_list.front()->m_id < trx->m_id);
+
+    m_trx_list.push_front(trx);
+
+    const auto inserted = m_trx_ids.emplace(trx->m_id, trx).second;
+    ut_a(inserted);
+  }
+
+  /**
+   * Removes the trx from the trx list and from the trx id hash.
+   *
+   * @param[in] trx	Transaction to remove
+   */
+  void trx_list_remove(Trx *trx) noexcept {
+    ut_ad(mutex_own(&m_mutex));
+
+    m_trx_list.remove(trx);
+
+    const auto n_erased = m_trx_ids.erase(trx->m_id);
+    ut_a(n_erased == 1);
+  }
+
+  /**
+   * Adds an active or prepared transaction to the active set and publishes
+   * a new snapshot.
+   *
+   * @param[in] trx	Transaction that was started or recovered
+   */
+  void snapshot_add(const Trx *trx) noexcept;
+
+  /**
+   * Removes a transaction from the active set and publishes a new snapshot.
+   * After this read views created by other transactions see its changes.
+   *
+   * @param[in] trx	Transaction that is committed in memory
+   */
+  void snapshot_remove(const Trx *trx) noexcept;
+
+  /**
+   * Assigns a new transaction number to an active transaction and publishes
+   * a new snapshot.
+   *
+   * @param[in,out] trx	Transaction that is committing
+   */
+  void assign_trx_no(Trx *trx) noexcept;
+
+  /**
+   * Returns the latest published snapshot of the active transactions. Does
+   * not require the trx system mutex. The snapshot includes every
+   * transaction that started or committed before the call.
+   *
+   * @return	the snapshot, never nullptr
+   */
+  [[nodiscard]] std::shared_ptr<const Trx_snapshot> snapshot() const noexcept {
+    return m_snapshot.load(std::memory_order_acquire);
   }
 
   /**
@@ -205,7 +359,7 @@ struct Trx_sys {
    * @return	the minimum trx id, or Trx_sys::max_trx_id if the trx list is empty
    */
   [[nodiscard]] trx_id_t get_min_trx_id() const noexcept {
-    ut_ad(mutex_own(&kernel_mutex));
+    ut_ad(mutex_own(&m_mutex));
 
     auto trx = UT_LIST_GET_LAST(m_trx_list);
 
@@ -220,7 +374,7 @@ struct Trx_sys {
    * @return	true if active
    */
   [[nodiscard]] bool is_active(trx_id_t trx_id) const noexcept {
-    ut_ad(mutex_own(&kernel_mutex));
+    ut_ad(mutex_own(&m_mutex));
 
     if (trx_id < get_min_trx_id()) {
 
@@ -236,19 +390,80 @@ struct Trx_sys {
 
       return true;
     } else {
-      auto trx = srv_trx_sys->get_on_id(trx_id);
+      auto trx = get_on_id(trx_id);
 
       return trx != nullptr && (trx->m_conc_state == TRX_ACTIVE || trx->m_conc_state == TRX_PREPARED);
     }
   }
 
+  /**
+   * Checks if a transaction with the given id is active, for the lock
+   * system. The caller owns the kernel mutex: a transaction can't commit in
+   * memory without it, so the result stays valid until the caller releases
+   * the kernel mutex.
+   *
+   * @param[in] trx_id	Trx id of the transaction
+   *
+   * @return	true if active
+   */
+  [[nodiscard]] bool is_active_off_kernel(trx_id_t trx_id) const noexcept {
+    ut_ad(mutex_own(&kernel_mutex));
+
+    mutex_acquire();
+
+    const auto active = is_active(trx_id);
+
+    mutex_release();
+
+    return active;
+  }
+
+  /**
+   * Looks for the trx handle with the given id in trx_list, for the lock
+   * system. The caller owns the kernel mutex, see is_active_off_kernel().
+   *
+   * @param[in] trx_id	Trx id to search for
+   *
+   * @return	the trx handle or nullptr if not found
+   */
+  [[nodiscard]] Trx *get_on_id_off_kernel(trx_id_t trx_id) noexcept {
+    ut_ad(mutex_own(&kernel_mutex));
+
+    mutex_acquire();
+
+    auto trx = get_on_id(trx_id);
+
+    mutex_release();
+
+    return trx;
+  }
+
+  /**
+   * Returns the minimum trx id in trx list, for the lock system. The caller
+   * owns the kernel mutex. The value can only grow after the trx system
+   * mutex is released.
+   *
+   * @return	the minimum trx id, or Trx_sys::max_trx_id if the trx list is empty
+   */
+  [[nodiscard]] trx_id_t get_min_trx_id_off_kernel() const noexcept {
+    ut_ad(mutex_own(&kernel_mutex));
+
+    mutex_acquire();
+
+    const auto trx_id = get_min_trx_id();
+
+    mutex_release();
+
+    return trx_id;
+  }
+
   /**
    * Allocates a new transaction id.
    * 
    * @return	new, allocated trx id
    */
   [[nodiscard]] trx_id_t get_new_trx_id() noexcept {
-    ut_ad(mutex_own(&kernel_mutex));
+    ut_ad(mutex_own(&m_mutex));
 
     /* VERY important: after the database is started, max_trx_id value is
     divisible by TRX_SYS_TRX_ID_WRITE_MARGIN, and the following if
@@ -275,7 +490,7 @@ struct Trx_sys {
    * @return	new, allocated trx number
    */
   [[nodiscard]] trx_id_t get_new_trx_no() noexcept {
-    ut_ad(mutex_own(&kernel_mutex));
+    ut_ad(mutex_own(&m_mutex));
 
     return get_new_trx_id();
   }
@@ -325,7 +540,8 @@ struct Trx_sys {
    * @return	pointer to rseg object, NULL if slot not in use
    */
   [[nodiscard]] trx_rseg_t *get_nth_rseg(ulint n) noexcept {
-    ut_ad(mutex_own(&kernel_mutex));
+    /* The slots are only set while the server starts or shuts down, when
+    no transaction can be started, so no mutex is needed here. */
     ut_ad(n < m_rsegs.size());
 
     return m_rsegs[n];
@@ -364,13 +580,72 @@ struct Trx_sys {
   void trx_lists_init_at_db_start(ib_recovery_t recovery) noexcept;
 
   /**
-   * Assigns a rollback segment to a transaction in a round-robin fashion.
-   * Skips the SYSTEM rollback segment if another is available.
-   * 
+   * Opens the undo tablespaces, creating the missing ones and their rollback
+   * segments. An undo tablespace without rollback segments, left behind by
+   * a crash during its truncation, is recreated.
+   *
+   * @return DB_SUCCESS or error code
+   */
+  [[nodiscard]] db_err open_undo_spaces() noexcept;
+
+  /**
+   * Checks if an inactive undo tablespace can be truncated: no transaction
+   * uses its rollback segments and their history lists are empty.
+   *
+   * @param[in] undo_space The undo tablespace.
+   *
+   * @return true if it can be truncated
+   */
+  [[nodiscard]] bool undo_space_is_unused(const Undo_space &undo_space) noexcept;
+
+  /**
+   * Truncates an unused undo tablespace by recreating its file at the
+   * initial size, with empty rollback segments, and marks it active again.
+   *
+   * @param[in,out] undo_space The undo tablespace.
+   *
+   * @return DB_SUCCESS or error code
+   */
+  [[nodiscard]] db_err truncate_undo_space(Undo_space &undo_space) noexcept;
+
+  /**
+   * Creates the missing rollback segments in the system tablespace, up to
+   * the configured number.
+   *
+   * @return DB_SUCCESS or error code
+   */
+  [[nodiscard]] db_err create_rsegs() noexcept;
+
+  /**
+   * Adds a rollback segment to the ones that transactions are assigned to.
+   * The SYSTEM rollback segment is not added.
+   *
+   * @param[in] rseg The rollback segment, its id must not be added yet.
+   */
+  void rseg_slot_add(trx_rseg_t *rseg) noexcept;
+
+  /**
+   * Assigns a rollback segment to a transaction. Each thread has a home
+   * rollback segment, so that concurrent transactions spread over the
+   * rollback segments without sharing a latch. Skips the SYSTEM rollback
+   * segment if another is available and the rollback segments of undo
+   * tablespaces that wait to be truncated. Does not need any mutex.
+   *
    * @return	assigned rollback segment id
    */
   [[nodiscard]] ulint trx_assign_rseg() noexcept;
 
+  /**
+   * Checks that a rollback segment picked by trx_assign_rseg() without a
+   * mutex can still be used: its undo tablespace may have been marked for
+   * truncation since. The caller must own the trx system mutex.
+   *
+   * @param[in] rseg_id The rollback segment id.
+   *
+   * @return true if a transaction can be started on it
+   */
+  [[nodiscard]] bool rseg_is_assignable(ulint rseg_id) const noexcept;
+
   /**
    * Creates a background transaction instance.
    *
@@ -397,7 +672,9 @@ struct Trx_sys {
   [[nodiscard]] Trx *create_user_trx(void *arg) noexcept;
 
   /**
-   * Frees a client transaction instance.
+   * Frees a client transaction instance. It is reset and kept in the pool
+   * of the calling thread for reuse by create_user_trx(), unless the pool
+   * is full.
    *
    * @param[in] trx The transaction object to be freed.
    */
@@ -523,6 +800,11 @@ struct Trx_sys {
 private:
 #endif /* UNIT_TEST */
 
+  /**
+   * Publishes a new snapshot built from m_active_ids and m_active_trx_nos.
+   */
+  void publish_snapshot() noexcept;
+
   /**
    * Creates the file page for the transaction system. This function is called
    * only at the database creation, before init().
@@ -558,43 +840,85 @@ private:
 
 public:
   /** The smallest number not yet assigned as a transaction
-  id or transaction number */
+  id or transaction number; protected by m_mutex */
   trx_id_t m_max_trx_id{};
 
-  /** List of read views sorted on trx no, biggest first */
+  /** Protects m_max_trx_id, m_trx_list, m_trx_ids, m_client_trx_list,
+  the active sets, the transaction counters and the Trx::m_conc_state of
+  the transactions in m_trx_list. Ordered after the kernel mutex: the lock
+  system reads the trx list while holding the kernel mutex. */
+  mutable mutex_t m_mutex{};
+
+  /** Protects m_view_list. A read view is created from the published
+  snapshot and added to the list while holding this mutex, so that the
+  list stays sorted and purge can never miss a view that is being opened. */
+  mutable mutex_t m_view_mutex{};
+
+  /** List of read views sorted on trx no, biggest first; protected by
+  m_view_mutex */
   UT_LIST_BASE_NODE_T_EXTERN(read_view_t, view_list) m_view_list{};
 
+  /** Ids of the active and prepared transactions, sorted ascending;
+  protected by m_mutex */
+  std::vector<trx_id_t> m_active_ids{};
+
+  /** Transaction numbers assigned to active transactions, sorted ascending;
+  protected by m_mutex */
+  std::vector<trx_id_t> m_active_trx_nos{};
+
+  /** The latest snapshot of m_active_ids, replaced under m_mutex whenever
+  the active sets change */
+  std::atomic<std::shared_ptr<const Trx_snapshot>> m_snapshot{std::make_shared<const Trx_snapshot>()};
+
   /** List of active and committed in memory transactions,
-  sorted on trx id, biggest first */
+  sorted on trx id, biggest first; protected by m_mutex */
   UT_LIST_BASE_NODE_T_EXTERN(Trx, m_trx_list) m_trx_list{};
 
-  /** List of transactions created for users */
+  /** Index on m_trx_list by trx id, used for the implicit lock checks. It
+  contains exactly the transactions in m_trx_list. */
+  std::unordered_map<trx_id_t, Trx *> m_trx_ids{};
+
+  /** List of transactions created for users; protected by m_mutex */
   UT_LIST_BASE_NODE_T_EXTERN(Trx, m_client_trx_list) m_client_trx_list{};
 
   /** List of rollback segment objects */
   UT_LIST_BASE_NODE_T_EXTERN(trx_rseg_t, rseg_list) m_rseg_list{};
 
-  /** Latest rollback segment in the round-robin assignment
-  of rollback segments to transactions */
-  trx_rseg_t *m_latest_rseg{};
+  /** Rollback segments that transactions are assigned to, all except the
+  SYSTEM rollback segment. Only appended to, under the kernel mutex: the
+  first m_n_rseg_slots entries never change and are read without a latch. */
+  std::array<trx_rseg_t *, TRX_SYS_N_USABLE_RSEGS> m_rseg_slots{};
+
+  /** Number of valid entries in m_rseg_slots */
+  std::atomic<ulint> m_n_rseg_slots{};
+
+  using Trx_pool = Bounded_channel<Trx *>;
+
+  /** Free client transaction objects, ready for reuse: their heaps are
+  emptied but not freed, and they keep their session. */
+  std::array<Trx_pool *, TRX_POOL_N_SHARDS> m_trx_pools{};
 
   /** Pointer array to rollback segments; NULL if slot not in use */
   std::array<trx_rseg_t *, TRX_SYS_N_RSEGS> m_rsegs{};
 
+  /** The undo tablespaces, not resized after startup */
+  std::vector<Undo_space> m_undo_spaces{};
+
   /** Length of the TRX_RSEG_HISTORY list (update undo logs for
-  committed transactions), protected by rseg->mutex */
-  ulint m_rseg_history_len{};
+  committed transactions). Updated under the mutex of the rollback
+  segment whose list changed, so that a commit does not need m_mutex. */
+  std::atomic<ulint> m_rseg_history_len{};
 
   /** The following is true when we are using the database in the file per table
    * format, we have successfully upgraded, or have created a new database installation */
   bool m_multiple_tablespace_format{};
 
   /** Number of transactions currently allocated for the client: protected by
-  the kernel mutex */
+  m_mutex */
   ulint m_n_user_trx{};
 
   /** Number of background transactions currently allocated: protected by
-   * the kernel mutex */
+   * m_mutex */
   ulint m_n_background_trx{};
 
   /** File space management instance. */
@@ -81,6 +81,13 @@ struct Trx {
    */
   static void destroy(Trx *&trx) noexcept;
 
+  /**
+   * Resets a transaction that is not started to the state of a newly
+   * created one, so that it can be reused. The object is destroyed and
+   * constructed again in place, only the session is kept.
+   */
+  void reset() noexcept;
+
   /**
    * Creates a transaction object.
    *
@@ -95,6 +102,8 @@ struct Trx {
    *  the system chooses the rollback segment automatically in a round-robin fashion.
    *
    * @return true if success, false if the rollback segment could not support this many transactions.
+   *
+   * @note The caller must own the trx system mutex, the kernel mutex is not needed.
    */
   [[nodiscard]] bool start_low(ulint rseg_id) noexcept;
 
@@ -107,6 +116,24 @@ struct Trx {
    */
   [[nodiscard]] bool start(ulint rseg_id) noexcept;
 
+  /**
+   * Starts a transaction on the read-only fast path: it gets no transaction
+   * id and no rollback segment and it is not added to the trx list, so it
+   * doesn't need the trx system mutex. Until set_rw_mode() is called it can
+   * only do consistent reads.
+   */
+  void start_read_only() noexcept;
+
+  /**
+   * Registers a transaction started with start_read_only() in the trx
+   * system, as start() would, before its first write or lock. Does nothing
+   * if the transaction is already registered.
+   *
+   * @return DB_SUCCESS, or DB_READONLY if the client declared the
+   *  transaction read-only.
+   */
+  [[nodiscard]] db_err set_rw_mode() noexcept;
+
   /**
    * Commits a transaction.
    */
@@ -122,11 +149,14 @@ struct Trx {
   void cleanup_at_db_startup() noexcept;
 
   /**
-   * Does the transaction prepare.
+   * Does the transaction prepare. A transaction on the read-only fast path
+   * is registered in the trx system first, a prepared transaction must have
+   * an id and be in the trx list.
    *
-   * @return 0 or error number.
+   * @return DB_SUCCESS, or DB_READONLY if the client declared the
+   *  transaction read-only.
    */
-  [[nodiscard]] ulint prepare() noexcept;
+  [[nodiscard]] db_err prepare() noexcept;
 
   /**
    * Calculates the "weight" of a transaction. The weight of one transaction
@@ -477,7 +507,8 @@ public:
   const char *m_op_info{};
 
   /** State of the trx from the point of view of concurrency control:
-   * TRX_ACTIVE, TRX_COMMITTED_IN_MEMORY, ... */
+   * TRX_ACTIVE, TRX_COMMITTED_IN_MEMORY, ...; changed under Trx_sys::m_mutex
+   * while the trx is in the trx list */
   Trx_status m_conc_state{TRX_NOT_STARTED};
 
    /** TRX_ISO_REPEATABLE_READ, ... */
@@ -509,6 +540,10 @@ public:
   /** TRX_DUP_IGNORE | TRX_DUP_REPLACE */
   ulint m_duplicates{};
 
+  /** Microseconds the DML of this transaction was delayed because the
+  purge was lagging, see Dml_throttle */
+  uint64_t m_dml_delay_us{};
+
   /* A mark field used in deadlock checking algorithm.  */
   bool m_deadlock_mark{};
 
@@ -535,6 +570,15 @@ public:
   /** false=normal transaction, true=recovered, must be rolled back */
   bool m_is_recovered{};
 
+  /** true if the client declared the transaction read-only, set_rw_mode()
+  then fails */
+  bool m_read_only{};
+
+  /** true while a transaction started with start_read_only() has not been
+  registered by set_rw_mode(): it has no id, no rollback segment and is
+  not in the trx list */
+  bool m_ro_fast_path{};
+
   /** Valid when conc_state == TRX_ACTIVE: TRX_QUE_RUNNING, TRX_QUE_LOCK_WAIT, ... */
   ulint m_que_state{TRX_QUE_RUNNING};
 
@@ -551,6 +595,10 @@ public:
   /** LSN at the time of the commit */
   lsn_t m_commit_lsn{};
 
+  /** If true, the commit does not write the log, the client is notified
+  by the log flusher thread once m_commit_lsn is durable */
+  bool m_flush_log_async{};
+
   /** Table to drop iff dict_operation is true, or 0. */
   trx_id_t m_table_id{};
 
@@ -566,10 +614,10 @@ public:
   /** how many tables the current SQL statement uses, except those in consistent read */
   ulint m_client_n_tables_locked{};
 
-  /** List of transactions */
+  /** List of transactions; protected by Trx_sys::m_mutex */
   UT_LIST_NODE_T(Trx) m_trx_list;
 
-  /** List of transactions created for client */
+  /** List of transactions created for client; protected by Trx_sys::m_mutex */
   UT_LIST_NODE_T(Trx) m_client_trx_list;
 
   /*!< 0 if no error, otherwise error number; NOTE That ONLY the
@@ -624,6 +672,30 @@ public:
   /** Lock wait started at this time */
   time_t m_wait_started{};
 
+  /** Lock wait started at this time, in microseconds, for the lock
+  queue wait statistics */
+  uint64_t m_wait_started_us{};
+
+  /** 1 + the number of transactions waiting, directly or through others,
+  for a lock of this transaction, see Lock_sys::update_schedule_weights();
+  protected by the kernel mutex */
+  ulint m_lock_schedule_weight{1};
+
+  /** The user thread waits for this event while it is suspended in a
+  lock wait, see InnoDB::suspend_user_thread() */
+  Cond_var *m_lock_wait_event{};
+
+  /** The query thread suspended in a lock wait, or nullptr; protected
+  by the kernel mutex */
+  que_thr_t *m_lock_wait_thr{};
+
+  /** The suspended lock wait times out at this time, 0 if the wait is
+  not on the lock wait timer wheel; protected by the kernel mutex */
+  ib_time_t m_lock_wait_deadline{};
+
+  /** Node in the lock wait timer wheel; protected by the kernel mutex */
+  UT_LIST_NODE_T(Trx) m_lock_wait_timers;
+
   /** Query threads belonging to this trx that are in the QUE_THR_LOCK_WAIT state */
   UT_LIST_BASE_NODE_T_EXTERN(que_thr_t, trx_thrs) m_wait_thrs;
 
@@ -689,3 +761,4 @@ public:
 
 UT_LIST_NODE_GETTER_DEFINITION(Trx, m_trx_list);
 UT_LIST_NODE_GETTER_DEFINITION(Trx, m_client_trx_list);
+UT_LIST_NODE_GETTER_DEFINITION(Trx, m_lock_wait_timers);
@@ -55,6 +55,9 @@ struct trx_sig_t;
 /** Rollback segment */
 struct trx_rseg_t;
 
+/** Tablespace dedicated to undo logs */
+struct Undo_space;
+
 /** Transaction undo log */
 struct trx_undo_t;
 
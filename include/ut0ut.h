@@ -174,10 +174,16 @@ void ut_print_timestamp(ib_stream_t ib_stream); /*!< in: file where to print */
 void ut_sprintf_timestamp(char *buf); /*!< in: buffer where to sprintf */
 
 /** Runs an idle loop on CPU. The argument gives the desired delay
-in microseconds on 100 MHz Pentium + Visual C++.
+in microseconds on 100 MHz Pentium + Visual C++. The number of
+UT_RELAX_CPU() iterations per unit is set by ut_delay_calibrate().
 @return	dummy value */
 ulint ut_delay(ulint delay); /*!< in: delay in microseconds on 100 MHz Pentium */
 
+/** Measures the cost of UT_RELAX_CPU() and scales ut_delay() so that one
+unit of delay takes about the same wall clock time on every CPU. The
+latency of PAUSE varies by more than 10x between processor generations. */
+void ut_delay_calibrate() noexcept;
+
 /**
  * Prints the contents of a memory buffer in hex and ascii as a warning
  *
@@ -27,6 +27,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
 #include <cstdio>
 
 #include <functional>
+#include <string>
 #include <vector>
 
 struct ib_trx_struct;
@@ -495,6 +496,10 @@ enum ib_shutdown_t {
 /** Generical InnoDB callback prototype. */
 using ib_cb_t = void(*)();
 
+/** Callback invoked by ib_trx_commit_async() once the commit is durable.
+ * The argument is the client context passed to ib_trx_commit_async(). */
+using ib_trx_durable_cb_t = void(*)(void*);
+
 /* Note: This is to make it easy for API users to have type
  * checking for arguments to our functions. Making it ib_opaque_t
  * by itself will result in pointer decay resulting in subverting
@@ -838,6 +843,18 @@ extern ib_client_cmp_t  ib_client_compare;
  * @return  innobase txn handle */
 [[nodiscard]] ib_trx_t ib_trx_begin(ib_trx_level_t  trx_level);
 
+/** Begin a read-only transaction. It only does consistent reads: it is not
+ * assigned a transaction id and never takes the kernel mutex. Writes, locks
+ * and schema changes fail with DB_READONLY, so does the XA prepare. If the
+ * "trx_auto_read_only" configuration variable is set, transactions started
+ * with ib_trx_begin() take the same fast path until their first write or
+ * lock.
+ * 
+ * @ingroup trx
+ * @param trx_level is the transaction isolation level
+ * @return  innobase txn handle */
+[[nodiscard]] ib_trx_t ib_trx_begin_read_only(ib_trx_level_t  trx_level);
+
 /** Set client data for a transaction. This is passed back to the client
  * in the trx_is_interrupted callback. InnoDB will only ever pass this
  * around, it will never dereference it.
@@ -876,6 +893,23 @@ void ib_trx_set_client_data(ib_trx_t trx, void* client_data);
 * @return  DB_SUCCESS or err code */
 [[nodiscard]] ib_err_t ib_trx_commit(ib_trx_t trx);
 
+/** Commit a transaction without waiting for the log write. The locks and
+* the schema latches are released and the transaction handle is freed as
+* with ib_trx_commit(), but the calling thread does not wait for the commit
+* to become durable: callback is invoked, with ctx as its argument, once the
+* log has been written up to the commit, as configured by the
+* "flush_log_at_trx_commit" setting. Commits from many threads are written
+* in groups by a single log flusher thread, which is also the thread that
+* invokes the callback unless the commit is already durable on return.
+* The callback must not block.
+*
+* @ingroup trx
+* @param trx is the transaction handle
+* @param callback is invoked once the commit is durable
+* @param ctx is the client context passed to callback
+* @return  DB_SUCCESS or err code */
+[[nodiscard]] ib_err_t ib_trx_commit_async(ib_trx_t trx, ib_trx_durable_cb_t callback, void *ctx);
+
 /** Rollback a transaction. This function will release the schema latches too.
 * It will also free the transaction handle.
 * 
@@ -1831,6 +1865,96 @@ struct ib_table_stats_t {
  * @returns \ref DB_SUCCESS or error. \ref DB_NOT_FOUND if index is not found */
 [[nodiscard]] ib_err_t ib_get_index_stat_n_diff_key_vals(ib_crsr_t crsr, const char* index_name, uint64_t *ncols, int64_t **n_diff);
 
+/** @struct ib_lock_hot_rec_t A record that lock requests waited for. */
+struct ib_lock_hot_rec_t {
+  /** Name of the table of the record */
+  std::string table_name;
+
+  /** Name of the index of the record */
+  std::string index_name;
+
+  /** Tablespace id of the page of the record */
+  uint32_t space_id;
+
+  /** Page number of the page of the record */
+  uint32_t page_no;
+
+  /** Heap number of the record on the page */
+  uint32_t heap_no;
+
+  /** Number of lock requests that waited for the record */
+  uint64_t n_waits;
+
+  /** Total time of the lock waits that ended, in microseconds */
+  uint64_t wait_time_us;
+};
+
+/** Check the consistency of the B-tree of an index, page by page.
+ *
+ * @ingroup misc
+ * @param crsr cursor on the table, attached to a transaction
+ * @param index_name name of the index to check
+ * @returns \ref DB_SUCCESS, \ref DB_NOT_FOUND if there is no such index or
+ *  \ref DB_CORRUPTION if the B-tree is not consistent. */
+[[nodiscard]] ib_err_t ib_validate_index(ib_crsr_t crsr, const char* index_name);
+
+/** Get the records that lock requests waited for the longest.
+ * 
+ * InnoDB profiles all record lock waits by record. Older waits gradually
+ * fade out of the profile once it is full. Use this to find the hot rows
+ * that serialize the transactions of an application.
+ * 
+ * @ingroup misc
+ * @param[out] hot_recs the records, the longest total wait time first
+ * @param n maximum number of records to return
+ * @returns \ref DB_SUCCESS or error. */
+[[nodiscard]] ib_err_t ib_lock_get_hot_records(std::vector<ib_lock_hot_rec_t> &hot_recs, size_t n);
+
+/** @struct ib_latch_stats_t Contention counters of the mutexes or rw-locks
+ * created at one source location. */
+struct ib_latch_stats_t {
+  /** Source file, without the directory, where the latches are created */
+  std::string file_name;
+
+  /** Line in file_name where the latches are created */
+  uint32_t line;
+
+  /** true for rw-locks, false for mutexes */
+  bool is_rw_lock;
+
+  /** Number of acquisitions */
+  uint64_t n_acquires;
+
+  /** Number of acquisitions that had to spin or wait */
+  uint64_t n_contended;
+
+  /** Total spin rounds of the contended acquisitions */
+  uint64_t n_spin_rounds;
+
+  /** Number of times a thread was suspended waiting */
+  uint64_t n_os_waits;
+
+  /** Total time of the contended acquisitions, in microseconds */
+  uint64_t wait_time_us;
+};
+
+/** Get the latches that threads waited for the longest.
+ * 
+ * The counters are only updated while the "latch_profile" configuration
+ * variable is set, it can be switched on and off at any time.
+ * 
+ * @ingroup misc
+ * @param[out] stats the latch creation sites, the longest total wait time first
+ * @param n maximum number of sites to return, 0 for all
+ * @returns \ref DB_SUCCESS or error. */
+[[nodiscard]] ib_err_t ib_latch_get_stats(std::vector<ib_latch_stats_t> &stats, size_t n);
+
+/** Reset the counters returned by ib_latch_get_stats().
+ * 
+ * @ingroup misc
+ * @returns \ref DB_SUCCESS or error. */
+[[nodiscard]] ib_err_t ib_latch_reset_stats();
+
 /** Force an update of table and index statistics
  * 
  * This function forces an update to the table and index statistics for the table crsr is opened on.
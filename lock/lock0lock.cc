@@ -27,6 +27,8 @@ Created 5/7/1996 Heikki Tuuri
 #include "api0ucode.h"
 #include "trx0purge.h"
 
+#include <algorithm>
+
 /** Restricts the length of search we will do in the waits-for
 graph of transactions */
 constexpr ulint LOCK_MAX_N_STEPS_IN_DEADLOCK_CHECK = 1000000;
@@ -373,9 +375,21 @@ struct Rec_lock_get_node {
 };
 
 /* Flags for recursive deadlock search */
-constexpr ulint LOCK_VICTIM_IS_START = 1;
-constexpr ulint LOCK_VICTIM_IS_OTHER = 2;
-constexpr ulint LOCK_EXCEED_MAX_DEPTH = 3;
+constexpr ulint LOCK_DEADLOCK_FOUND = 1;
+constexpr ulint LOCK_EXCEED_MAX_DEPTH = 2;
+
+/**
+ * Gets the time a transaction has been waiting for its lock wait.
+ *
+ * @param[in] trx Transaction in a record lock wait.
+ *
+ * @return wait time in microseconds.
+ */
+static uint64_t lock_wait_time_us(const Trx *trx) noexcept {
+  const auto now = ut_time_us(nullptr);
+
+  return now > trx->m_wait_started_us ? now - trx->m_wait_started_us : 0;
+}
 
 trx_id_t Lock::trx_id() const noexcept {
   return m_trx->m_id;
@@ -681,34 +695,32 @@ Lock_sys::Lock_sys(Trx_sys *trx_sys, ulint n_cells) noexcept
 
 Lock_sys::~Lock_sys() noexcept { }
 
-bool Lock_sys::check_trx_id_sanity(trx_id_t trx_id, const rec_t *rec, const Index *index, const ulint *offsets, bool has_kernel_mutex) noexcept {
+bool Lock_sys::check_trx_id_sanity(trx_id_t trx_id, const rec_t *rec, const Index *index, const ulint *offsets) noexcept {
   bool is_ok{true};
 
   ut_ad(rec_offs_validate(rec, index, offsets));
 
-  if (!has_kernel_mutex) {
-    mutex_enter(&kernel_mutex);
-  }
+  m_trx_sys->mutex_acquire();
+
+  const auto max_trx_id = m_trx_sys->m_max_trx_id;
+
+  m_trx_sys->mutex_release();
 
   /* A sanity check: the trx_id in rec must be smaller than the global trx id counter */
 
-  if (trx_id >= m_trx_sys->m_max_trx_id) {
+  if (trx_id >= max_trx_id) {
     log_err("Transaction id associated with record");
     log_err(rec_to_string(rec));
     log_err(std::format(
       "\nis {} which is higher than the global trx id counter {}"
       " The table is corrupt. You have to do dump + drop + reimport.",
       trx_id,
-      m_trx_sys->m_max_trx_id
+      max_trx_id
     ));
 
     is_ok = false;
   }
 
-  if (!has_kernel_mutex) {
-    mutex_exit(&kernel_mutex);
-  }
-
   return is_ok;
 }
 
@@ -975,7 +987,7 @@ Trx *Lock_sys::sec_rec_some_has_impl_off_kernel(const rec_t *rec, const Index *i
   max trx id to the log, and therefore during recovery, this value
   for a page may be incorrect. */
 
-  if (page_get_max_trx_id(page) < m_trx_sys->get_min_trx_id() && !recv_recovery_on) {
+  if (page_get_max_trx_id(page) < m_trx_sys->get_min_trx_id_off_kernel() && !recv_recovery_on) {
 
     return nullptr;
   }
@@ -983,7 +995,7 @@ Trx *Lock_sys::sec_rec_some_has_impl_off_kernel(const rec_t *rec, const Index *i
   /* Ok, in this case it is possible that some transaction has an
   implicit x-lock. We have to look in the clustered index. */
 
-  if (!check_trx_id_sanity(page_get_max_trx_id(page), rec, index, offsets, true)) {
+  if (!check_trx_id_sanity(page_get_max_trx_id(page), rec, index, offsets)) {
     buf_page_print(page, 0);
 
     /* The page is corrupt: try to avoid a crash by returning
@@ -1092,33 +1104,26 @@ db_err Lock_sys::rec_enqueue_waiting(Lock_mode type_mode, const Buf_block *block
   /* Enqueue the lock request that will wait to be granted */
   auto lock = rec_create(Lock_mode(type_mode | LOCK_WAIT), block, heap_no, index, trx);
 
-  /* Check if a deadlock occurs: if yes, remove the lock request and
-  return an error code */
-
-  if (unlikely(deadlock_occurs(lock, trx))) {
+  ut_a(trx->m_wait_lock == lock);
 
-    lock->reset();
-    lock->rec_reset_nth_bit(heap_no);
+  ++rec_get_locks(block->get_page_id())->m_n_waits;
 
-    return DB_DEADLOCK;
+  rec_profile_wait_start(lock);
 
-  } else if (unlikely(trx->m_wait_lock == nullptr)) {
-    /* If there was a deadlock but we chose another transaction as a
-    victim, it is possible that we already have the lock now granted! */
+  /* Record the new edge of the waits-for graph, the deadlock detector
+  thread searches for a cycle through it */
 
-    return DB_SUCCESS;
-
-  } else {
+  m_deadlock_waiters.push_back(trx);
 
-    trx->m_wait_started = time(nullptr);
-    trx->m_que_state = TRX_QUE_LOCK_WAIT;
-    trx->m_was_chosen_as_deadlock_victim = false;
+  trx->m_wait_started = time(nullptr);
+  trx->m_wait_started_us = ut_time_us(nullptr);
+  trx->m_que_state = TRX_QUE_LOCK_WAIT;
+  trx->m_was_chosen_as_deadlock_victim = false;
 
-    const auto success = que_thr_stop(thr);
-    ut_a(success);
+  const auto success = que_thr_stop(thr);
+  ut_a(success);
 
-    return DB_LOCK_WAIT;
-  }
+  return DB_LOCK_WAIT;
 }
 
 Lock *Lock_sys::rec_add_to_queue(Lock_mode type_mode, const Buf_block *block, ulint heap_no, const Index *index, const Trx *trx) noexcept {
@@ -1321,9 +1326,239 @@ bool Lock_sys::rec_has_to_wait_in_queue(const Rec_locks &rec_locks, Lock *waitin
   return false;
 }
 
+bool Lock_sys::rec_has_to_wait_for_granted(const Rec_locks &rec_locks, const Lock *wait_lock, ulint heap_no) const noexcept {
+  ut_ad(mutex_own(&kernel_mutex));
+  ut_ad(wait_lock->is_waiting());
+
+  for (auto lock : rec_locks) {
+
+    if (lock != wait_lock && !lock->is_waiting() && heap_no < lock->rec_get_n_bits() && lock->rec_is_nth_bit_set(heap_no) &&
+        wait_lock->has_to_wait_for(lock, heap_no)) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+void Lock_sys::rec_grant_waiting(Rec_locks &rec_locks, ulint heap_no) noexcept {
+  ut_ad(mutex_own(&kernel_mutex));
+
+  if (m_schedule == LOCK_SCHEDULE_FIFO) {
+    /* Grant locks if there are no conflicting locks ahead */
+
+    for (auto lock : rec_locks) {
+      if (lock->is_waiting() && (heap_no == ULINT_UNDEFINED || lock->rec_is_nth_bit_set(heap_no)) &&
+          !rec_has_to_wait_in_queue(rec_locks, lock, lock->rec_find_set_bit())) {
+        /* Grant the lock */
+        grant(lock);
+      }
+    }
+
+    return;
+  }
+
+  std::vector<Lock *> waiting;
+
+  for (auto lock : rec_locks) {
+    if (lock->is_waiting() && (heap_no == ULINT_UNDEFINED || lock->rec_is_nth_bit_set(heap_no))) {
+      waiting.push_back(lock);
+    }
+  }
+
+  if (waiting.empty()) {
+    return;
+  }
+
+  /* A stable sort: on a tie the queue order decides */
+  if (m_schedule == LOCK_SCHEDULE_CATS) {
+    std::stable_sort(waiting.begin(), waiting.end(), [](const Lock *lhs, const Lock *rhs) {
+      return lhs->m_trx->m_lock_schedule_weight > rhs->m_trx->m_lock_schedule_weight;
+    });
+  } else {
+    ut_ad(m_schedule == LOCK_SCHEDULE_AGE);
+
+    std::stable_sort(waiting.begin(), waiting.end(), [](const Lock *lhs, const Lock *rhs) {
+      return lhs->m_trx->m_id < rhs->m_trx->m_id;
+    });
+  }
+
+  for (auto lock : waiting) {
+    if (!rec_has_to_wait_for_granted(rec_locks, lock, lock->rec_find_set_bit())) {
+      /* Move the lock ahead of all the waiting requests, a request
+      that is left waiting must have a conflicting lock ahead of it */
+      rec_locks.remove(lock);
+      rec_locks.push_front(lock);
+
+      grant(lock);
+    }
+  }
+}
+
+Trx *Lock_sys::wait_blocker(const Lock *wait_lock) const noexcept {
+  ut_ad(mutex_own(&kernel_mutex));
+  ut_ad(wait_lock->is_waiting());
+
+  if (wait_lock->type() == LOCK_REC) {
+    const auto heap_no = wait_lock->rec_find_set_bit();
+    auto rec_locks = rec_get_locks(wait_lock->page_id());
+
+    for (auto lock = rec_locks->front(); lock != wait_lock; lock = lock->next()) {
+      if (heap_no < lock->rec_get_n_bits() && lock->rec_is_nth_bit_set(heap_no) && wait_lock->has_to_wait_for(lock, heap_no)) {
+        return lock->m_trx;
+      }
+    }
+
+  } else {
+
+    for (auto lock = UT_LIST_GET_PREV(m_table.m_locks, wait_lock); lock != nullptr; lock = UT_LIST_GET_PREV(m_table.m_locks, lock)) {
+      if (wait_lock->has_to_wait_for(lock, ULINT_UNDEFINED)) {
+        return lock->m_trx;
+      }
+    }
+  }
+
+  return nullptr;
+}
+
+void Lock_sys::update_schedule_weights() noexcept {
+  ut_ad(mutex_own(&kernel_mutex));
+
+  std::vector<Trx *> waiting;
+
+  m_trx_sys->mutex_acquire();
+
+  for (auto trx : m_trx_sys->m_trx_list) {
+    trx->m_lock_schedule_weight = 1;
+
+    if (trx->m_que_state == TRX_QUE_LOCK_WAIT && trx->m_wait_lock != nullptr) {
+      waiting.push_back(trx);
+    }
+  }
+
+  m_trx_sys->mutex_release();
+
+  /* Each waiting transaction adds itself to the weight of the
+  transactions on its chain of waits. The chain can be a cycle
+  that the deadlock detector has not yet broken: stop when we
+  come back to the start, or the chain gets too long. */
+
+  for (auto trx : waiting) {
+    auto blocker = wait_blocker(trx->m_wait_lock);
+
+    for (ulint depth{}; blocker != nullptr && blocker != trx && depth < LOCK_MAX_DEPTH_IN_DEADLOCK_CHECK; ++depth) {
+      ++blocker->m_lock_schedule_weight;
+
+      if (blocker->m_que_state != TRX_QUE_LOCK_WAIT || blocker->m_wait_lock == nullptr) {
+        break;
+      }
+
+      blocker = wait_blocker(blocker->m_wait_lock);
+    }
+  }
+}
+
+void Lock_sys::rec_profile_wait_start(const Lock *lock) noexcept {
+  ut_ad(mutex_own(&kernel_mutex));
+  ut_ad(lock->type() == LOCK_REC);
+
+  const Rec_wait_key key{lock->page_id(), lock->rec_find_set_bit()};
+
+  if (auto it = m_rec_wait_profile.find(key); it != m_rec_wait_profile.end()) {
+    auto &entry = it->second;
+    auto node = m_rec_waits.extract(entry.m_rec_waits_it);
+
+    node.key() = ++entry.m_hot_rec.m_n_waits;
+
+    entry.m_rec_waits_it = m_rec_waits.insert(std::move(node));
+
+    return;
+  }
+
+  ulint n_waits{1};
+  Rec_waits::iterator rec_waits_it;
+
+  if (m_rec_wait_profile.size() >= REC_WAIT_PROFILE_SIZE) {
+    /* Replace the record with the fewest waits, the new one takes over its
+    count so that it has to wait more often than that to stay. */
+    auto node = m_rec_waits.extract(m_rec_waits.begin());
+
+    m_rec_wait_profile.erase(node.mapped());
+
+    n_waits += node.key();
+
+    node.key() = n_waits;
+    node.mapped() = key;
+
+    rec_waits_it = m_rec_waits.insert(std::move(node));
+  } else {
+    rec_waits_it = m_rec_waits.emplace(n_waits, key);
+  }
+
+  const auto index = lock->m_rec.m_index;
+
+  Rec_wait_entry entry{
+    .m_hot_rec = {
+      .m_table_name = index->get_table_name(),
+      .m_index_name = index->m_name,
+      .m_page_id = key.m_page_id,
+      .m_heap_no = key.m_heap_no,
+      .m_n_waits = n_waits
+    },
+    .m_rec_waits_it = rec_waits_it
+  };
+
+  m_rec_wait_profile.emplace(key, std::move(entry));
+}
+
+void Lock_sys::rec_profile_wait_end(const Lock *lock, uint64_t wait_time_us) noexcept {
+  ut_ad(mutex_own(&kernel_mutex));
+  ut_ad(lock->type() == LOCK_REC);
+
+  /* The record may have been evicted from the profile during the wait */
+
+  if (auto it = m_rec_wait_profile.find({lock->page_id(), lock->rec_find_set_bit()}); it != m_rec_wait_profile.end()) {
+    it->second.m_hot_rec.m_wait_time_us += wait_time_us;
+  }
+}
+
+std::vector<Lock_sys::Hot_rec> Lock_sys::get_hot_records(ulint n) const noexcept {
+  std::vector<Hot_rec> hot_recs;
+
+  mutex_enter(&kernel_mutex);
+
+  hot_recs.reserve(m_rec_wait_profile.size());
+
+  for (const auto &[key, entry] : m_rec_wait_profile) {
+    hot_recs.push_back(entry.m_hot_rec);
+  }
+
+  mutex_exit(&kernel_mutex);
+
+  n = std::min<ulint>(n, hot_recs.size());
+
+  std::partial_sort(hot_recs.begin(), hot_recs.begin() + n, hot_recs.end(), [](const Hot_rec &lhs, const Hot_rec &rhs) {
+    return lhs.m_wait_time_us > rhs.m_wait_time_us || (lhs.m_wait_time_us == rhs.m_wait_time_us && lhs.m_n_waits > rhs.m_n_waits);
+  });
+
+  hot_recs.resize(n);
+
+  return hot_recs;
+}
+
 void Lock_sys::grant(Lock *lock) noexcept {
   ut_ad(mutex_own(&kernel_mutex));
 
+  if (lock->type() == LOCK_REC) {
+    auto rec_locks = rec_get_locks(lock->page_id());
+    const auto wait_time_us = lock_wait_time_us(lock->m_trx);
+
+    ++rec_locks->m_n_grants;
+    rec_locks->m_wait_time_us += wait_time_us;
+
+    rec_profile_wait_end(lock, wait_time_us);
+  }
+
   lock->reset();
 
   /* If we are resolving a deadlock by choosing another transaction
@@ -1340,6 +1575,8 @@ void Lock_sys::rec_cancel(Lock *lock) noexcept {
   ut_ad(mutex_own(&kernel_mutex));
   ut_ad(lock->type() == LOCK_REC);
 
+  rec_profile_wait_end(lock, lock_wait_time_us(lock->m_trx));
+
   /* Reset the bit (there can be only one set bit) in the lock bitmap */
   lock->rec_reset_nth_bit(lock->rec_find_set_bit());
 
@@ -1373,16 +1610,10 @@ void Lock_sys::rec_dequeue_from_page(Lock *lock) noexcept {
 
   trx->m_trx_locks.remove(lock);
 
-  /* Check if waiting locks in the queue can now be granted: grant
-  locks if there are no conflicting locks ahead. */
+  /* Check if waiting locks in the queue can now be granted */
 
   if (!rec_locks_empty) {
-    for (auto lock : rec_locks) {
-      if (lock->is_waiting() && !rec_has_to_wait_in_queue(rec_locks, lock, lock->rec_find_set_bit())) {
-        /* Grant the lock */
-        grant(lock);
-      }
-    }
+    rec_grant_waiting(rec_locks, ULINT_UNDEFINED);
   }
 }
 
@@ -1903,59 +2134,99 @@ void Lock_sys::rec_restore_from_page_infimum(const Buf_block *block, const rec_t
   mutex_exit(&kernel_mutex);
 }
 
-bool Lock_sys::deadlock_occurs(Lock *lock, Trx *trx) noexcept {
-  ulint ret;
-  ulint cost{};
-
+void Lock_sys::deadlock_detect() noexcept {
   ut_ad(mutex_own(&kernel_mutex));
 
-retry:
-  /* We check that adding this trx to the waits-for graph
-  does not produce a cycle. First mark all active transactions
-  with 0: */
-
-  for (auto mark_trx : m_trx_sys->m_trx_list) {
-    mark_trx->m_deadlock_mark = 0;
+  if (m_deadlock_waiters.empty()) {
+    return;
   }
 
-  ret = deadlock_recursive(trx, trx, lock, &cost, 0);
+  auto waiters = std::move(m_deadlock_waiters);
 
-  switch (ret) {
-    case LOCK_VICTIM_IS_OTHER:
-      /* We chose some other trx as a victim: retry if there still
-    is a deadlock */
-      goto retry;
+  m_deadlock_waiters.clear();
 
-    case LOCK_EXCEED_MAX_DEPTH:
-      log_info("TOO DEEP OR LONG SEARCH IN THE LOCK TABLE WAITS-FOR GRAPH, WE WILL ROLL BACK FOLLOWING TRANSACTION");
-      log_info("\n*** TRANSACTION:\n");
+  std::vector<Trx *> cycle;
+  std::vector<Trx *> visited;
 
-      log_info(trx->to_string(3000));
+  for (auto start : waiters) {
+    /* The wait may have ended since it was enqueued. Breaking a cycle by
+    rolling back some other transaction may leave another cycle through
+    the same edge, therefore search again until start is no longer waiting. */
 
-      log_info("*** WAITING FOR THIS LOCK TO BE GRANTED:n");
+    while (start->m_wait_lock != nullptr) {
+      ulint cost{};
 
-      log_info(lock->to_string(m_buf_pool));
-      break;
+      cycle.clear();
 
-    case LOCK_VICTIM_IS_START:
-      log_info("*** WE ROLL BACK TRANSACTION (2)");
-      break;
+      const auto ret = deadlock_search(start, start, start->m_wait_lock, &cost, 0, cycle, visited);
 
-    default:
-      /* No deadlock detected*/
-      return false;
-  }
+      for (auto trx : visited) {
+        trx->m_deadlock_mark = false;
+      }
 
-  lock_deadlock_found = true;
+      visited.clear();
 
-  return true;
+      if (ret == 0) {
+        /* No deadlock detected */
+        break;
+      }
+
+      auto victim = start;
+
+      if (ret == LOCK_EXCEED_MAX_DEPTH) {
+        log_info("TOO DEEP OR LONG SEARCH IN THE LOCK TABLE WAITS-FOR GRAPH, WE WILL ROLL BACK FOLLOWING TRANSACTION");
+        log_info("\n*** TRANSACTION:\n");
+
+        log_info(start->to_string(3000));
+
+        log_info("*** WAITING FOR THIS LOCK TO BE GRANTED:");
+
+        log_info(start->m_wait_lock->to_string(m_buf_pool));
+
+      } else {
+        ut_a(ret == LOCK_DEADLOCK_FOUND);
+
+        ulint i{};
+
+        for (auto trx : cycle) {
+          ++i;
+
+          log_info(std::format("\n*** ({}) TRANSACTION:", i));
+
+          log_info(trx->to_string(3000));
+
+          log_info(std::format("*** ({}) WAITING FOR THIS LOCK TO BE GRANTED:", i));
+
+          log_info(trx->m_wait_lock->to_string(m_buf_pool));
+
+          /* Roll back the transaction that is cheapest to roll back,
+          on a tie prefer the one whose lock wait closed the cycle */
+
+          if (Trx::weight_cmp(trx, victim) < 0) {
+            victim = trx;
+          }
+        }
+
+        log_info(std::format("*** WE ROLL BACK TRANSACTION {}", victim->m_id));
+      }
+
+      lock_deadlock_found = true;
+
+      victim->m_was_chosen_as_deadlock_victim = true;
+
+      /* The lock wait of the victim ends, its user thread will return DB_DEADLOCK */
+      cancel_waiting_and_release(victim->m_wait_lock);
+    }
+  }
 }
 
-ulint Lock_sys::deadlock_recursive(Trx *start, Trx *trx, Lock *wait_lock, ulint *cost, ulint depth) noexcept {
+ulint Lock_sys::deadlock_search(
+  const Trx *start, Trx *trx, Lock *wait_lock, ulint *cost, ulint depth, std::vector<Trx *> &cycle, std::vector<Trx *> &visited
+) noexcept {
   ulint ret;
   ut_ad(mutex_own(&kernel_mutex));
 
-  if (trx->m_deadlock_mark == 1) {
+  if (trx->m_deadlock_mark) {
     /* We have already exhaustively searched the subtree starting from this trx */
 
     return 0;
@@ -2001,9 +2272,11 @@ ulint Lock_sys::deadlock_recursive(Trx *start, Trx *trx, Lock *wait_lock, ulint
 
     if (found_lock == nullptr) {
       /* We can mark this subtree as searched */
-      trx->m_deadlock_mark = 1;
+      trx->m_deadlock_mark = true;
 
-      return false;
+      visited.push_back(trx);
+
+      return 0;
     }
 
     if (wait_lock->has_to_wait_for(found_lock, heap_no)) {
@@ -2014,53 +2287,11 @@ ulint Lock_sys::deadlock_recursive(Trx *start, Trx *trx, Lock *wait_lock, ulint
 
       if (lock_trx == start) {
 
-        /* We came back to the recursion starting point: a deadlock detected; or we have searched the waits-for graph too long */
-
-        log_info("\n*** (1) TRANSACTION:");
-
-        log_info(wait_lock->m_trx->to_string(3000));
-
-        log_info("*** (1) WAITING FOR THIS LOCK TO BE GRANTED:");
-
-        log_info(wait_lock->to_string(m_buf_pool));
-
-        log_info("*** (2) TRANSACTION:");
-
-        log_info(found_lock->m_trx->to_string(3000));
-
-        log_info("*** (2) HOLDS THE LOCK(S):");
-
-        log_info(found_lock->to_string(m_buf_pool));
-
-        log_info("*** (2) WAITING FOR THIS LOCK TO BE GRANTED:");
-
-        log_info(wait_lock->to_string(m_buf_pool));
-
-        log_info(start->m_wait_lock->to_string(m_buf_pool));
-
-        if (Trx::weight_cmp(wait_lock->m_trx, start) >= 0) {
-          /* Our recursion starting point transaction is 'smaller', let us
-          choose 'start' as the victim and roll back it */
-
-          return LOCK_VICTIM_IS_START;
-        }
-
-        lock_deadlock_found = true;
-
-        /* Let us choose the transaction of wait_lock as a victim to try
-        to avoid deadlocking our recursion starting point transaction */
-
-        log_info("*** WE ROLL BACK TRANSACTION (1)");
-
-        wait_lock->m_trx->m_was_chosen_as_deadlock_victim = true;
-
-        cancel_waiting_and_release(wait_lock);
+        /* We came back to the recursion starting point: a deadlock detected */
 
-        /* Since trx and wait_lock are no longer in the waits-for graph, we can return false;
-        note that our selective algorithm can choose several transactions as victims, but still
-        we may end up rolling back also the recursion starting point transaction! */
+        cycle.push_back(trx);
 
-        return LOCK_VICTIM_IS_OTHER;
+        return LOCK_DEADLOCK_FOUND;
       }
 
       if (too_far) {
@@ -2074,7 +2305,12 @@ ulint Lock_sys::deadlock_recursive(Trx *start, Trx *trx, Lock *wait_lock, ulint
 
         /* Another trx ahead has requested lock	in an incompatible mode, and is itself waiting for a lock */
 
-        ret = deadlock_recursive(start, lock_trx, lock_trx->m_wait_lock, cost, depth + 1);
+        ret = deadlock_search(start, lock_trx, lock_trx->m_wait_lock, cost, depth + 1, cycle, visited);
+
+        if (ret == LOCK_DEADLOCK_FOUND) {
+
+          cycle.push_back(trx);
+        }
 
         if (ret != 0) {
 
@@ -2158,25 +2394,12 @@ void Lock_sys::table_remove_low(Lock *lock) noexcept {
 
   auto lock = table_create(table, Lock_mode(mode | LOCK_WAIT), trx);
 
-  /* Check if a deadlock occurs: if yes, remove the lock request and
-  return an error code */
-
-  if (deadlock_occurs(lock, trx)) {
+  ut_a(trx->m_wait_lock == lock);
 
-    /* The order here is important, we don't want to
-    lose the state of the lock before calling remove. */
-    table_remove_low(lock);
-    lock->reset();
+  /* Record the new edge of the waits-for graph, the deadlock detector
+  thread searches for a cycle through it */
 
-    return DB_DEADLOCK;
-  }
-
-  if (trx->m_wait_lock == nullptr) {
-    /* Deadlock resolution chose another transaction as a victim,
-    and we accidentally got our lock granted! */
-
-    return DB_SUCCESS;
-  }
+  m_deadlock_waiters.push_back(trx);
 
   trx->m_que_state = TRX_QUE_LOCK_WAIT;
   trx->m_was_chosen_as_deadlock_victim = false;
@@ -2216,6 +2439,12 @@ db_err Lock_sys::lock_table(ulint flags, Table *table, Lock_mode mode, que_thr_t
 
   auto trx = thr_get_trx(thr);
 
+  /* A transaction on the read-only fast path is registered before it
+  takes its first lock. */
+  if (auto err = trx->set_rw_mode(); err != DB_SUCCESS) {
+    return err;
+  }
+
   mutex_enter(&kernel_mutex);
 
   /* Look for stronger locks the same trx already has on the table */
@@ -2325,12 +2554,7 @@ void Lock_sys::rec_unlock(Trx *trx, const Buf_block *block, const rec_t *rec, Lo
   }
 
   /* Check if we can now grant waiting lock requests */
-  for (auto lock : it->second) {
-    if (lock->rec_is_nth_bit_set(heap_no) && lock->is_waiting() && !rec_has_to_wait_in_queue(it->second, lock, heap_no)) {
-      /* Grant the lock */
-      grant(lock);
-    }
-  }
+  rec_grant_waiting(it->second, heap_no);
 
   mutex_exit(&kernel_mutex);
 }
@@ -2338,6 +2562,11 @@ void Lock_sys::rec_unlock(Trx *trx, const Buf_block *block, const rec_t *rec, Lo
 void Lock_sys::release_off_kernel(Trx *trx) noexcept {
   ut_ad(mutex_own(&kernel_mutex));
 
+  if (!m_deadlock_waiters.empty()) {
+    /* The deadlock detector must not see the transaction after it is freed */
+    std::erase(m_deadlock_waiters, trx);
+  }
+
   ulint count{};
   auto lock = trx->m_trx_locks.back();
 
@@ -2378,6 +2607,8 @@ void Lock_sys::cancel_waiting_and_release(Lock *lock) noexcept {
 
   if (lock->type() == LOCK_REC) {
 
+    rec_profile_wait_end(lock, lock_wait_time_us(lock->m_trx));
+
     rec_dequeue_from_page(lock);
   } else {
     ut_ad(lock->type() == LOCK_TABLE);
@@ -2505,7 +2736,7 @@ bool Lock_sys::print_info_summary(bool nowait) const noexcept {
     m_trx_sys->m_purge->m_purge_undo_no
   ));
 
-  log_info("History list length ", m_trx_sys->m_rseg_history_len);
+  log_info("History list length ", m_trx_sys->m_rseg_history_len.load());
 
   return true;
 }
@@ -2519,6 +2750,8 @@ void Lock_sys::print_info_all_transactions() noexcept {
 
   /* First print info on non-active transactions */
 
+  m_trx_sys->mutex_acquire();
+
   for (auto trx : m_trx_sys->m_client_trx_list) {
     if (trx->m_conc_state == TRX_NOT_STARTED) {
       log_info("---");
@@ -2526,6 +2759,8 @@ void Lock_sys::print_info_all_transactions() noexcept {
     }
   }
 
+  m_trx_sys->mutex_release();
+
   const Lock *lock{};
 
   for (;;) {
@@ -2537,6 +2772,8 @@ void Lock_sys::print_info_all_transactions() noexcept {
     obsolete now and we must loop through the trx list to
     get probably the same trx, or some other trx. */
 
+    m_trx_sys->mutex_acquire();
+
     for (auto tx : m_trx_sys->m_trx_list) {
       if (i == nth_trx) {
         trx = tx;
@@ -2546,6 +2783,8 @@ void Lock_sys::print_info_all_transactions() noexcept {
       ++i;
     }
 
+    m_trx_sys->mutex_release();
+
     if (trx == nullptr) {
       mutex_exit(&kernel_mutex);
 
@@ -2572,7 +2811,20 @@ void Lock_sys::print_info_all_transactions() noexcept {
           trx->m_wait_started)
         ));
 
-        log_info(lock->to_string(m_buf_pool));
+        const auto wait_lock = trx->m_wait_lock;
+
+        log_info(wait_lock->to_string(m_buf_pool));
+
+        if (wait_lock->type() == LOCK_REC) {
+          const auto rec_locks = rec_get_locks(wait_lock->page_id());
+
+          log_info(std::format(
+            "LOCK QUEUE OF THE PAGE: {} lock waits, {} granted after waiting, {} us average wait",
+            rec_locks->m_n_waits,
+            rec_locks->m_n_grants,
+            rec_locks->m_n_grants > 0 ? rec_locks->m_wait_time_us / rec_locks->m_n_grants : 0
+          ));
+        }
 
         log_info("------------------");
       }
@@ -2885,6 +3137,8 @@ bool Lock_sys::rec_validate_page(Page_id page_id) noexcept {
 bool Lock_sys::validate() noexcept {
   mutex_enter(&kernel_mutex);
 
+  m_trx_sys->mutex_acquire();
+
   for (auto trx : m_trx_sys->m_trx_list) {
 
     for (auto lock : trx->m_trx_locks) {
@@ -2896,6 +3150,8 @@ bool Lock_sys::validate() noexcept {
     }
   }
 
+  m_trx_sys->mutex_release();
+
   for (auto &[page_id, rec_locks] : m_rec_locks) {
 
     ut_a(m_trx_sys->in_trx_list(rec_locks.front()->m_trx));
@@ -3131,7 +3387,7 @@ db_err Lock_sys::sec_rec_read_check_and_lock(ulint flags, const Buf_block *block
   if the max trx id for the page >= min trx id for the trx list or a
   database recovery is running. */
 
-  if ((page_get_max_trx_id(block->m_frame) >= m_trx_sys->get_min_trx_id() || recv_recovery_on) && !page_rec_is_supremum(rec)) {
+  if ((page_get_max_trx_id(block->m_frame) >= m_trx_sys->get_min_trx_id_off_kernel() || recv_recovery_on) && !page_rec_is_supremum(rec)) {
 
     rec_convert_impl_to_expl(block, rec, index, offsets);
   }
@@ -40,6 +40,8 @@ Created 12/9/1995 Heikki Tuuri
 #include "sync0rw.h"
 #include "trx0sys.h"
 
+#include <algorithm>
+
 /*
 General philosophy of InnoDB redo-logs:
 
@@ -161,6 +163,8 @@ Log::Log() noexcept {
 
   os_event_set(m_one_flushed_event);
 
+  m_durable_event = os_event_create(nullptr);
+
   /*----------------------------*/
   m_adm_checkpoint_interval = ULINT_MAX;
 
@@ -935,6 +939,110 @@ void Log::buffer_flush_to_disk() noexcept {
   write_up_to(lsn, LOG_WAIT_ALL_GROUPS, true);
 }
 
+void Log::add_durable_waiter(lsn_t lsn, Durable_callback callback, void *ctx) noexcept {
+  if (lsn == 0 || srv_config.m_flush_log_at_trx_commit == 0) {
+    /* Nothing was written or the policy does not write at commit */
+    callback(ctx);
+    return;
+  }
+
+  acquire();
+
+  const auto durable_lsn =
+    srv_config.m_flush_log_at_trx_commit == 1 && srv_config.m_unix_file_flush_method != SRV_UNIX_NOSYNC
+      ? m_flushed_to_disk_lsn
+      : m_written_to_some_lsn;
+
+  if (durable_lsn >= lsn) {
+    release();
+    callback(ctx);
+    return;
+  }
+
+  m_durable_waiters.push_back(Durable_waiter{lsn, callback, ctx});
+
+  os_event_set(m_durable_event);
+
+  release();
+}
+
+void Log::wait_for_durable_waiters() noexcept {
+  acquire();
+
+  if (!m_durable_waiters.empty()) {
+    release();
+    return;
+  }
+
+  os_event_reset(m_durable_event);
+
+  release();
+
+  os_event_wait(m_durable_event);
+}
+
+bool Log::complete_durable_waiters() noexcept {
+  acquire();
+
+  if (m_durable_waiters.empty()) {
+    release();
+    return false;
+  }
+
+  /* All the waiters registered so far have a commit LSN <= m_lsn, one
+  write covers the whole group. Commits that arrive while we write are
+  served in the next round. */
+  const auto lsn = m_lsn;
+
+  release();
+
+  if (srv_config.m_flush_log_at_trx_commit == 0) {
+    /* Do nothing */
+  } else if (srv_config.m_flush_log_at_trx_commit == 1) {
+    if (srv_config.m_unix_file_flush_method == SRV_UNIX_NOSYNC) {
+      /* Write the log but do not flush it to disk */
+      write_up_to(lsn, LOG_WAIT_ONE_GROUP, false);
+    } else {
+      /* Write the log to the log files AND flush them to disk */
+      write_up_to(lsn, LOG_WAIT_ONE_GROUP, true);
+    }
+  } else if (srv_config.m_flush_log_at_trx_commit == 2) {
+    /* Write the log but do not flush it to disk */
+    write_up_to(lsn, LOG_WAIT_ONE_GROUP, false);
+  } else {
+    ut_error;
+  }
+
+  std::vector<Durable_waiter> completed;
+
+  acquire();
+
+  auto it = std::partition(m_durable_waiters.begin(), m_durable_waiters.end(), [lsn](const Durable_waiter &waiter) {
+    return waiter.m_lsn > lsn;
+  });
+
+  completed.assign(it, m_durable_waiters.end());
+  m_durable_waiters.erase(it, m_durable_waiters.end());
+
+  release();
+
+  /* Invoke the callbacks without holding the log mutex, they may start
+  new transactions. */
+  for (const auto &waiter : completed) {
+    waiter.m_callback(waiter.m_ctx);
+  }
+
+  return true;
+}
+
+void Log::wake_durable_flusher() noexcept {
+  acquire();
+
+  os_event_set(m_durable_event);
+
+  release();
+}
+
 void Log::buffer_sync_in_background(bool flush) noexcept {
   mutex_enter(&m_mutex);
 
@@ -1393,6 +1501,16 @@ void Log::shutdown() noexcept {
   os_event_free(m_no_flush_event);
   os_event_free(m_one_flushed_event);
 
+  /* A commit can register after the last pass of the log flusher thread.
+  The shutdown checkpoint flushed the log, its commit is durable. */
+  for (const auto &waiter : m_durable_waiters) {
+    waiter.m_callback(waiter.m_ctx);
+  }
+
+  m_durable_waiters.clear();
+
+  os_event_free(m_durable_event);
+
   rw_lock_free(&m_checkpoint_lock);
 }
 
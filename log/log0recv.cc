@@ -662,6 +662,10 @@ static byte *recv_parse_or_apply_log_rec_body(
       ut_ad(!page || page_type != FIL_PAGE_TYPE_ALLOCATED);
       ptr = mlog_parse_string(ptr, end_ptr, page);
       break;
+    case MLOG_FULL_PAGE:
+      /* Allow anything in page_type, the image replaces the page. */
+      ptr = mlog_parse_full_page(ptr, end_ptr, page);
+      break;
     case MLOG_FILE_CREATE:
     case MLOG_FILE_RENAME:
     case MLOG_FILE_DELETE:
@@ -280,6 +280,41 @@ byte *mlog_parse_string(byte *ptr, byte *end_ptr, byte *page) {
   return ptr + len;
 }
 
+void mlog_log_full_page(const page_t *page, mtr_t *mtr) {
+  auto log_ptr = mlog_open(mtr, 11);
+
+  /* If no logging is requested, we may return now */
+  if (log_ptr == nullptr) {
+
+    return;
+  }
+
+  log_ptr = mlog_write_initial_log_record_fast(page, MLOG_FULL_PAGE, log_ptr, mtr);
+
+  mlog_close(mtr, log_ptr);
+
+  /* The LSN is set by the log apply, skip it. */
+  mlog_catenate_string(mtr, page + FIL_PAGE_PREV, FIL_PAGE_LSN - FIL_PAGE_PREV);
+  mlog_catenate_string(mtr, page + FIL_PAGE_TYPE, UNIV_PAGE_SIZE - FIL_PAGE_TYPE - FIL_PAGE_DATA_END);
+}
+
+byte *mlog_parse_full_page(byte *ptr, byte *end_ptr, byte *page) {
+  const ulint links_len = FIL_PAGE_LSN - FIL_PAGE_PREV;
+  const ulint body_len = UNIV_PAGE_SIZE - FIL_PAGE_TYPE - FIL_PAGE_DATA_END;
+
+  if (end_ptr < ptr + links_len + body_len) {
+
+    return nullptr;
+  }
+
+  if (page != nullptr) {
+    memcpy(page + FIL_PAGE_PREV, ptr, links_len);
+    memcpy(page + FIL_PAGE_TYPE, ptr + links_len, body_len);
+  }
+
+  return ptr + links_len + body_len;
+}
+
 byte *mlog_open_and_write_index(mtr_t *mtr, const byte *rec, mlog_type_t type, ulint size) {
   auto log_ptr = mlog_open(mtr, 11 + size);
 
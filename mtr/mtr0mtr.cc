@@ -41,10 +41,12 @@ inline void mtr_memo_slot_release(mtr_t *mtr, mtr_memo_slot_t *slot) noexcept {
   auto type = slot->m_type;
 
   if (likely(object != nullptr)) {
-    if (type <= MTR_MEMO_BUF_FIX) {
+    if (type <= MTR_MEMO_PAGE_SX_FIX) {
       srv_buf_pool->release(static_cast<Buf_block *>(object), type, mtr);
     } else if (type == MTR_MEMO_S_LOCK) {
       rw_lock_s_unlock(static_cast<rw_lock_t *>(object));
+    } else if (type == MTR_MEMO_SX_LOCK) {
+      rw_lock_sx_unlock(static_cast<rw_lock_t *>(object));
 #ifndef UNIV_DEBUG
     } else {
       rw_lock_x_unlock(static_cast<rw_lock_t *>(object));
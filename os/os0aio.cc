@@ -815,6 +815,182 @@ void Impl::shutdown() noexcept {
   }
 }
 
+/** AIO_ring implementation, the requests are tagged with their address. */
+struct Ring_impl : public AIO_ring {
+  /**
+  * @brief Constructor.
+  *
+  * @param[in] n_entries Size of the io_uring queue
+  */
+  explicit Ring_impl(ulint n_entries) noexcept {
+    if (auto ret = io_uring_queue_init(n_entries, &m_iouring, 0); ret < 0) {
+      log_warn("Initializing io_uring queue failed: ", ret, ", using synchronous i/o");
+    } else {
+      m_initialized = true;
+    }
+  }
+
+  /** Destructor */
+  ~Ring_impl() noexcept override {
+    ut_a(m_n_pending == 0);
+
+    if (m_initialized) {
+      io_uring_queue_exit(&m_iouring);
+    }
+  }
+
+  [[nodiscard]] db_err submit(Request &req) noexcept override;
+
+  [[nodiscard]] db_err wait(Request &req) noexcept override;
+
+ private:
+  /**
+  * @brief Submits the remaining bytes of a request to the kernel.
+  *
+  * @param[in,out] req The request to submit.
+  * @return DB_SUCCESS or error code.
+  */
+  [[nodiscard]] db_err submit_low(Request &req) noexcept;
+
+  /**
+  * @brief Does the remaining bytes of a request with synchronous i/o.
+  *
+  * @param[in,out] req The request.
+  */
+  static void sync_io(Request &req) noexcept;
+
+ private:
+  /** true if m_iouring was set up. */
+  bool m_initialized{};
+
+  /** Number of requests in flight. */
+  ulint m_n_pending{};
+
+  /** io_uring instance. */
+  io_uring m_iouring{};
+};
+
+void Ring_impl::sync_io(Request &req) noexcept {
+  /* The errors are returned in the request like those of io_uring, the
+  os_file_*() functions would retry or exit on some of them, and loop at
+  the end of the file. */
+  while (req.m_done < req.m_len) {
+    auto ptr = req.m_ptr + req.m_done;
+    const auto n = req.m_len - req.m_done;
+    const auto off = req.m_off + off_t(req.m_done);
+
+    const auto ret = req.m_read ? pread(req.m_fh, ptr, n, off) : pwrite(req.m_fh, ptr, n, off);
+
+    if (ret > 0) {
+      req.m_done += ret;
+    } else if (ret == -1 && (errno == EINTR || errno == EAGAIN)) {
+      continue;
+    } else {
+      /* An error, or a read beyond the end of the file. */
+      req.m_ok = false;
+      req.m_done = req.m_len;
+    }
+  }
+}
+
+db_err Ring_impl::submit_low(Request &req) noexcept {
+  auto sqe = io_uring_get_sqe(&m_iouring);
+
+  if (sqe == nullptr) {
+    return DB_OUT_OF_MEMORY;
+  }
+
+  auto ptr = req.m_ptr + req.m_done;
+  const auto n = req.m_len - req.m_done;
+  const auto off = req.m_off + off_t(req.m_done);
+
+  if (req.m_read) {
+    io_uring_prep_read(sqe, req.m_fh, ptr, n, off);
+  } else {
+    io_uring_prep_write(sqe, req.m_fh, ptr, n, off);
+  }
+
+  io_uring_sqe_set_data64(sqe, uintptr_t(&req));
+
+  for (;;) {
+    const auto ret = io_uring_submit(&m_iouring);
+
+    switch (ret) {
+      case 1:
+        return DB_SUCCESS;
+      case -EINTR:
+      case -EAGAIN:
+        continue;
+      default:
+        log_err("io_uring_submit failed: ", ret);
+        return DB_ERROR;
+    }
+  }
+}
+
+db_err Ring_impl::submit(Request &req) noexcept {
+  ut_a(!req.m_pending);
+  ut_ad(req.m_len > 0);
+
+  req.m_done = 0;
+  req.m_ok = true;
+
+  if (m_initialized) {
+    if (const auto err = submit_low(req); err != DB_SUCCESS) {
+      return err;
+    }
+
+    ++m_n_pending;
+    req.m_pending = true;
+  } else {
+    sync_io(req);
+  }
+
+  return DB_SUCCESS;
+}
+
+db_err Ring_impl::wait(Request &req) noexcept {
+  while (req.m_pending) {
+    io_uring_cqe *cqe{};
+
+    const auto ret = io_uring_wait_cqe(&m_iouring, &cqe);
+
+    if (ret == -EINTR || ret == -EAGAIN) {
+      continue;
+    } else if (ret < 0) {
+      log_fatal("io_uring_wait_cqe failed: ", ret);
+    }
+
+    auto r = reinterpret_cast<Request *>(io_uring_cqe_get_data64(cqe));
+    const auto res = cqe->res;
+
+    io_uring_cqe_seen(&m_iouring, cqe);
+
+    ut_a(r->m_pending);
+
+    if (res > 0) {
+      ut_a(ulint(res) <= r->m_len - r->m_done);
+      r->m_done += res;
+    } else {
+      /* An error, or a read beyond the end of the file. */
+      r->m_ok = false;
+      r->m_done = r->m_len;
+    }
+
+    if (r->m_done < r->m_len && submit_low(*r) == DB_SUCCESS) {
+      /* It was a partial read/write, the remaining bytes are in flight. */
+      continue;
+    } else if (r->m_done < r->m_len) {
+      sync_io(*r);
+    }
+
+    r->m_pending = false;
+    --m_n_pending;
+  }
+
+  return req.m_ok ? DB_SUCCESS : DB_ERROR;
+}
+
 } // namespace aio
 
 void IO_ctx::validate() const noexcept {
@@ -834,3 +1010,15 @@ void AIO::destroy(AIO *&aio) noexcept {
   ut_delete(aio);
   aio = nullptr;
 }
+
+AIO_ring *AIO_ring::create(ulint n_entries) noexcept {
+  ut_a(n_entries > 0);
+
+  return new (ut_new(sizeof(aio::Ring_impl))) aio::Ring_impl(n_entries);
+}
+
+void AIO_ring::destroy(AIO_ring *&aio_ring) noexcept {
+  call_destructor(aio_ring);
+  ut_delete(aio_ring);
+  aio_ring = nullptr;
+}
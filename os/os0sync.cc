@@ -184,6 +184,8 @@ void Cond_var::wait(int64_t reset_sig_count) {
   std::unique_lock<std::mutex> lk(m_mutex);
   auto old_sig_count = reset_sig_count != 0 ? reset_sig_count : m_signal_count;
 
+  os_thread_set_parked(true);
+
   m_cond_var.wait(lk, [this, old_sig_count] {
     if (srv_shutdown_state == SRV_SHUTDOWN_EXIT_THREADS) {
       log_info("srv_shutdown_state == SRV_SHUTDOWN_EXIT_THREADS");
@@ -191,6 +193,8 @@ void Cond_var::wait(int64_t reset_sig_count) {
     }
     return m_is_set || m_signal_count != old_sig_count; }
   );
+
+  os_thread_set_parked(false);
 }
 
 ulint Cond_var::wait_time(std::chrono::microseconds timeout, int64_t reset_sig_count) {
@@ -208,6 +212,8 @@ ulint Cond_var::wait_time(std::chrono::microseconds timeout, int64_t reset_sig_c
     reset_sig_count = m_signal_count;
   }
 
+  os_thread_set_parked(true);
+
   auto ret = m_cond_var.wait_until(lk, timepoint, [this, reset_sig_count] {
     if (srv_shutdown_state == SRV_SHUTDOWN_EXIT_THREADS) {
       log_err("srv_shutdown_state == SRV_SHUTDOWN_EXIT_THREADS");
@@ -216,6 +222,8 @@ ulint Cond_var::wait_time(std::chrono::microseconds timeout, int64_t reset_sig_c
     return m_is_set || m_signal_count != reset_sig_count; }
   );
 
+  os_thread_set_parked(false);
+
   return ret ? 0 : OS_SYNC_TIME_EXCEEDED;
 }
 
@@ -22,6 +22,8 @@ The interface to the operating system thread control primitives
 Created 9/8/1995 Heikki Tuuri
 *******************************************************/
 
+#include <array>
+#include <atomic>
 #include <chrono>
 #include <thread>
 
@@ -76,5 +78,32 @@ void os_thread_yield() noexcept {
 }
 
 void os_thread_sleep(ulint sleep_time) noexcept {
+  os_thread_set_parked(true);
   std::this_thread::sleep_for(std::chrono::microseconds(sleep_time));
+  os_thread_set_parked(false);
+}
+
+/** Number of threads currently blocked in the OS, per run state slot */
+static std::array<std::atomic<uint32_t>, OS_THREAD_RUN_STATE_SLOTS> os_thread_n_parked{};
+
+/** Next run state slot to hand out */
+static std::atomic<uint32_t> os_thread_next_slot{};
+
+/** Run state slot of the calling thread */
+static thread_local const uint32_t os_thread_slot = os_thread_next_slot.fetch_add(1, std::memory_order_relaxed) % OS_THREAD_RUN_STATE_SLOTS;
+
+uint32_t os_thread_get_slot() noexcept {
+  return os_thread_slot;
+}
+
+void os_thread_set_parked(bool parked) noexcept {
+  if (parked) {
+    os_thread_n_parked[os_thread_slot].fetch_add(1, std::memory_order_relaxed);
+  } else {
+    os_thread_n_parked[os_thread_slot].fetch_sub(1, std::memory_order_relaxed);
+  }
+}
+
+bool os_thread_is_parked(uint32_t slot) noexcept {
+  return os_thread_n_parked[slot].load(std::memory_order_relaxed) > 0;
 }
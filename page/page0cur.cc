@@ -294,6 +294,10 @@ void page_cur_search_with_match(
   low_matched_fields = *ilow_matched_fields;
   low_matched_bytes = *ilow_matched_bytes;
 
+  /* The tuple is compared with about log2(n_recs) records, check once
+  if its fields can be compared as bytes. */
+  const Cmp_search_key search_key(index->m_cmp_ctx, tuple);
+
   /* Perform binary search. First the search is done through the page
   directory, after that as a linear search in the list of records
   owned by the upper limit directory slot. */
@@ -319,7 +323,7 @@ void page_cur_search_with_match(
       offsets = record.get_col_offsets(offsets, dtuple_get_n_fields_cmp(tuple), &heap, Current_location());
     }
 
-    cmp = cmp_dtuple_rec_with_match(index->m_cmp_ctx, tuple, mid_rec, offsets, &cur_matched_fields, &cur_matched_bytes);
+    cmp = search_key.compare(mid_rec, offsets, &cur_matched_fields, &cur_matched_bytes);
 
     if (likely(cmp > 0)) {
     low_slot_match:
@@ -375,7 +379,7 @@ void page_cur_search_with_match(
       offsets = record.get_col_offsets(offsets, dtuple_get_n_fields_cmp(tuple), &heap, Current_location());
     }
 
-    cmp = cmp_dtuple_rec_with_match(index->m_cmp_ctx, tuple, mid_rec, offsets, &cur_matched_fields, &cur_matched_bytes);
+    cmp = search_key.compare(mid_rec, offsets, &cur_matched_fields, &cur_matched_bytes);
 
     if (likely(cmp > 0)) {
     low_rec_match:
@@ -149,6 +149,56 @@ inline read_view_t *read_view_create_low(ulint n, mem_heap_t *heap) {
   return view;
 }
 
+/** Creates a read view from the latest published trx snapshot and adds it
+to the head of the view list. The caller must own the view mutex.
+@param[in] cr_trx_id            trx_id of creating transaction, or 0 used in purge
+@param[in] excluded_id          Active trx id that the view should see, or 0
+@param[in,out] heap             Memory heap to use for allocation.
+@return	own: read view struct */
+static read_view_t *read_view_open_now_low(trx_id_t cr_trx_id, trx_id_t excluded_id, mem_heap_t *heap) {
+  ut_ad(mutex_own(&srv_trx_sys->m_view_mutex));
+
+  const auto snapshot = srv_trx_sys->snapshot();
+  const auto &ids = snapshot->m_ids;
+
+  auto view = read_view_create_low(ids.size(), heap);
+
+  view->creator_trx_id = cr_trx_id;
+  view->type = VIEW_NORMAL;
+  view->undo_no = 0;
+
+  /* No future transactions should be visible in the view. NOTE that a
+  transaction whose trx number is < m_max_trx_id can still be active, if it
+  is in the middle of its commit! The snapshot takes that into account. */
+
+  view->low_limit_no = snapshot->m_low_limit_no;
+  view->low_limit_id = snapshot->m_max_trx_id;
+
+  ulint n = 0;
+
+  /* No active transaction should be visible, except excluded_id. The
+  snapshot is sorted ascending, the view wants the biggest id first. */
+  for (auto it = ids.rbegin(); it != ids.rend(); ++it) {
+    if (*it != excluded_id) {
+      read_view_set_nth_trx_id(view, n, *it);
+      ++n;
+    }
+  }
+
+  view->n_trx_ids = n;
+
+  if (n > 0) {
+    /* The last active transaction has the smallest id: */
+    view->up_limit_id = read_view_get_nth_trx_id(view, n - 1);
+  } else {
+    view->up_limit_id = view->low_limit_id;
+  }
+
+  UT_LIST_ADD_FIRST(srv_trx_sys->m_view_list, view);
+
+  return view;
+}
+
 read_view_t *read_view_oldest_copy_or_open_new(trx_id_t cr_trx_id, mem_heap_t *heap) {
   read_view_t *old_view;
   read_view_t *view_copy;
@@ -157,13 +207,21 @@ read_view_t *read_view_oldest_copy_or_open_new(trx_id_t cr_trx_id, mem_heap_t *h
   ulint n;
   ulint i;
 
-  ut_ad(mutex_own(&kernel_mutex));
+  /* Purge holds the trx system mutex, no snapshot can be published while it
+  opens its view. A view opened later can't use an older snapshot. */
+  ut_ad(mutex_own(&srv_trx_sys->m_mutex));
+
+  mutex_enter(&srv_trx_sys->m_view_mutex);
 
   old_view = UT_LIST_GET_LAST(srv_trx_sys->m_view_list);
 
   if (old_view == nullptr) {
 
-    return read_view_open_now(cr_trx_id, heap);
+    view_copy = read_view_open_now_low(cr_trx_id, cr_trx_id, heap);
+
+    mutex_exit(&srv_trx_sys->m_view_mutex);
+
+    return view_copy;
   }
 
   n = old_view->n_trx_ids;
@@ -207,78 +265,48 @@ read_view_t *read_view_oldest_copy_or_open_new(trx_id_t cr_trx_id, mem_heap_t *h
 
   UT_LIST_ADD_LAST(srv_trx_sys->m_view_list, view_copy);
 
+  mutex_exit(&srv_trx_sys->m_view_mutex);
+
   return view_copy;
 }
 
 read_view_t *read_view_open_now(trx_id_t cr_trx_id, mem_heap_t *heap) {
-  ut_ad(mutex_own(&kernel_mutex));
-
-  auto view = read_view_create_low(UT_LIST_GET_LEN(srv_trx_sys->m_trx_list), heap);
-
-  view->creator_trx_id = cr_trx_id;
-  view->type = VIEW_NORMAL;
-  view->undo_no = 0;
-
-  /* No future transactions should be visible in the view */
-
-  view->low_limit_no = srv_trx_sys->m_max_trx_id;
-  view->low_limit_id = view->low_limit_no;
-
-  ulint n = 0;
-
-  /* No active transaction should be visible, except cr_trx */
-  for (auto trx: srv_trx_sys->m_trx_list) {
-    ut_ad(trx->m_magic_n == TRX_MAGIC_N);
-
-    if (trx->m_id != cr_trx_id && (trx->m_conc_state == TRX_ACTIVE || trx->m_conc_state == TRX_PREPARED)) {
-
-      read_view_set_nth_trx_id(view, n, trx->m_id);
-
-      ++n;
-
-      /* NOTE that a transaction whose trx number is < srv_trx_sys->m_max_trx_id can still be active, if it is
-      in the middle of its commit! Note that when a transaction starts, we initialize trx->no to LSN_MAX. */
-
-      if (view->low_limit_no > trx->m_no) {
-
-        view->low_limit_no = trx->m_no;
-      }
-    }
-  }
+  mutex_enter(&srv_trx_sys->m_view_mutex);
 
-  view->n_trx_ids = n;
-
-  if (n > 0) {
-    /* The last active transaction has the smallest id: */
-    view->up_limit_id = read_view_get_nth_trx_id(view, n - 1);
-  } else {
-    view->up_limit_id = view->low_limit_id;
-  }
+  auto view = read_view_open_now_low(cr_trx_id, cr_trx_id, heap);
 
-  UT_LIST_ADD_FIRST(srv_trx_sys->m_view_list, view);
+  mutex_exit(&srv_trx_sys->m_view_mutex);
 
   return view;
 }
 
 void read_view_close(read_view_t *view) {
-  ut_ad(mutex_own(&kernel_mutex));
+  mutex_enter(&srv_trx_sys->m_view_mutex);
 
   UT_LIST_REMOVE(srv_trx_sys->m_view_list, view);
+
+  mutex_exit(&srv_trx_sys->m_view_mutex);
+}
+
+void read_view_set_creator(read_view_t *view, trx_id_t cr_trx_id) {
+  /* Purge reads the creator when it copies the oldest view. */
+  mutex_enter(&srv_trx_sys->m_view_mutex);
+
+  ut_a(view->creator_trx_id == 0);
+  view->creator_trx_id = cr_trx_id;
+
+  mutex_exit(&srv_trx_sys->m_view_mutex);
 }
 
 void read_view_close_for_read_committed(Trx *trx) {
   ut_a(trx->m_global_read_view);
 
-  mutex_enter(&kernel_mutex);
-
   read_view_close(trx->m_global_read_view);
 
   mem_heap_empty(trx->m_global_read_view_heap);
 
   trx->m_read_view = nullptr;
   trx->m_global_read_view = nullptr;
-
-  mutex_exit(&kernel_mutex);
 }
 
 std::string to_string(const read_view_t *view) noexcept {
@@ -322,55 +350,18 @@ cursor_view_t *read_cursor_view_create(Trx *cr_trx) {
   curview->n_client_tables_in_use = cr_trx->m_n_client_tables_in_use;
   cr_trx->m_n_client_tables_in_use = 0;
 
-  mutex_enter(&kernel_mutex);
+  mutex_enter(&srv_trx_sys->m_view_mutex);
 
-  curview->read_view = read_view_create_low(UT_LIST_GET_LEN(srv_trx_sys->m_trx_list), curview->heap);
+  /* No active transaction should be visible, not even the creator: its
+  changes up to undo_no are seen through the high granularity check. */
+  auto view = read_view_open_now_low(cr_trx->m_id, 0, curview->heap);
 
-  auto view = curview->read_view;
-  view->creator_trx_id = cr_trx->m_id;
   view->type = VIEW_HIGH_GRANULARITY;
   view->undo_no = cr_trx->m_undo_no;
 
-  /* No future transactions should be visible in the view */
-
-  view->low_limit_no = srv_trx_sys->m_max_trx_id;
-  view->low_limit_id = view->low_limit_no;
+  mutex_exit(&srv_trx_sys->m_view_mutex);
 
-  ulint n = 0;
-  /* No active transaction should be visible */
-
-  for (auto trx: srv_trx_sys->m_trx_list) {
-    if (trx->m_conc_state == TRX_ACTIVE || trx->m_conc_state == TRX_PREPARED) {
-
-      read_view_set_nth_trx_id(view, n, trx->m_id);
-
-      n++;
-
-      /* NOTE that a transaction whose trx number is <
-      srv_trx_sys->m_max_trx_id can still be active, if it is
-      in the middle of its commit! Note that when a
-      transaction starts, we initialize trx->no to
-      LSN_MAX. */
-
-      if (view->low_limit_no > trx->m_no) {
-
-        view->low_limit_no = trx->m_no;
-      }
-    }
-  }
-
-  view->n_trx_ids = n;
-
-  if (n > 0) {
-    /* The last active transaction has the smallest id: */
-    view->up_limit_id = read_view_get_nth_trx_id(view, n - 1);
-  } else {
-    view->up_limit_id = view->low_limit_id;
-  }
-
-  UT_LIST_ADD_FIRST(srv_trx_sys->m_view_list, view);
-
-  mutex_exit(&kernel_mutex);
+  curview->read_view = view;
 
   return curview;
 }
@@ -383,18 +374,19 @@ void read_cursor_view_close(Trx *trx, cursor_view_t *curview) {
   belong to this transaction */
   trx->m_n_client_tables_in_use += curview->n_client_tables_in_use;
 
-  mutex_enter(&kernel_mutex);
-
   read_view_close(curview->read_view);
+
+  srv_trx_sys->mutex_acquire();
+
   trx->m_read_view = trx->m_global_read_view;
 
-  mutex_exit(&kernel_mutex);
+  srv_trx_sys->mutex_release();
 
   mem_heap_free(curview->heap);
 }
 
 void read_cursor_set(Trx *trx, cursor_view_t *curview) {
-  mutex_enter(&kernel_mutex);
+  srv_trx_sys->mutex_acquire();
 
   if (likely(curview != nullptr)) {
     trx->m_read_view = curview->read_view;
@@ -402,5 +394,5 @@ void read_cursor_set(Trx *trx, cursor_view_t *curview) {
     trx->m_read_view = trx->m_global_read_view;
   }
 
-  mutex_exit(&kernel_mutex);
+  srv_trx_sys->mutex_release();
 }
@@ -28,6 +28,9 @@ Created 7/1/1994 Heikki Tuuri
 #include "api0ucode.h"
 #include "srv0srv.h"
 
+#include <algorithm>
+#include <bit>
+
 /*		ALPHABETICAL ORDER
 
 The records are put into alphabetical order in the following
@@ -72,21 +75,6 @@ static int cmp_debug_dtuple_rec_with_match(
   ulint *matched_fields) noexcept; 
 #endif /* UNIV_DEBUG */
 
-/**
- * Transforms the character code so that it is ordered appropriately for the
- * language. This is only used for the latin1 char set. The client does the
- * comparisons for other char sets.
- * 
- * @param[in] code code of a character stored in database record
- * 
- * @return	collation order position
- */
-inline ulint cmp_collate(ulint code) noexcept {
-  // return((ulint) srv_latin1_ordering[code]);
-  /* FIXME: Default to ASCII */
-  return code;
-}
-
 bool cmp_cols_are_equal(const Column *col1, const Column *col2, bool check_charsets) noexcept {
   if (dtype_is_non_binary_string_type(col1->mtype, col1->prtype) && dtype_is_non_binary_string_type(col2->mtype, col2->prtype)) {
 
@@ -315,7 +303,7 @@ int cmp_data_data_slow(
     return 1;
   }
 
-  if (mtype >= DATA_FLOAT || (mtype == DATA_BLOB && 0 == (prtype & DATA_BINARY_TYPE) && dtype_get_charset_coll(prtype) != DATA_CLIENT_LATIN1_SWEDISH_CHARSET_COLL)) {
+  if (!cmp_type_is_binary_comparable(mtype, prtype)) {
 
     /* prtype is really a 16 unsigned type. */
     return cmp_whole_field(cmp_ctx, mtype, (uint16_t)prtype, data1, (unsigned)len1, data2, (unsigned)len2);
@@ -383,6 +371,65 @@ int cmp_data_data_slow(
   return 0; /* Not reached */
 }
 
+uint64_t cmp_dfield_key_prefix(const dfield_t *fields, ulint n_fields) noexcept {
+  uint64_t prefix{};
+  ulint n_bytes{};
+
+  auto append = [&](ulint b) {
+    prefix = (prefix << 8) | b;
+    ++n_bytes;
+  };
+
+  for (ulint i{}; i < n_fields && n_bytes < sizeof(prefix); ++i) {
+    const auto field = &fields[i];
+    const auto type = dfield_get_type(field);
+
+    /* The prefix is made of the raw bytes. */
+    if (!cmp_type_is_byte_ordered(type->mtype, type->prtype)) {
+      break;
+    }
+
+    const auto len = dfield_get_len(field);
+
+    /* The SQL null is the smallest value and all nulls are equal,
+    the next field decides. */
+    if (len == UNIV_SQL_NULL) {
+      append(0);
+      continue;
+    }
+
+    append(1);
+
+    auto data = static_cast<const byte *>(dfield_get_data(field));
+
+    for (ulint j{}; j < len && n_bytes < sizeof(prefix); ++j) {
+      ut_ad(cmp_collate(data[j]) == data[j]);
+      append(data[j]);
+    }
+
+    /* The values of these types always have the same length, the
+    next field follows the last byte. */
+    if (type->mtype == DATA_INT || type->mtype == DATA_SYS || type->mtype == DATA_SYS_CHILD) {
+      continue;
+    }
+
+    /* A shorter value compares as if padded with the pad character.
+    Without one it is smaller than the longer values that start with
+    it, zero bytes keep it no greater. */
+    const auto pad = dtype_get_pad_char(type->mtype, type->prtype);
+
+    while (n_bytes < sizeof(prefix)) {
+      append(pad == ULINT_UNDEFINED ? 0 : pad);
+    }
+  }
+
+  if (n_bytes < sizeof(prefix)) {
+    prefix <<= 8 * (sizeof(prefix) - n_bytes);
+  }
+
+  return prefix;
+}
+
 int cmp_dtuple_rec_with_match(
   void *cmp_ctx,
   const DTuple *dtuple,
@@ -478,9 +525,7 @@ int cmp_dtuple_rec_with_match(
       }
     }
 
-    if (mtype >= DATA_FLOAT ||
-        (mtype == DATA_BLOB && 0 == (prtype & DATA_BINARY_TYPE) &&
-        dtype_get_charset_coll(prtype) != DATA_CLIENT_LATIN1_SWEDISH_CHARSET_COLL)) {
+    if (!cmp_type_is_binary_comparable(mtype, prtype)) {
 
       ret = cmp_whole_field(
         cmp_ctx, mtype, prtype, (byte *)dfield_get_data(dtuple_field), (unsigned)dtuple_f_len, rec_b_ptr, (unsigned)rec_f_len
@@ -586,6 +631,177 @@ order_resolved:
   return ret;
 }
 
+/**
+ * Finds the length of the common prefix of two byte strings, comparing
+ * a word at a time.
+ *
+ * @param[in] a                first string
+ * @param[in] b                second string
+ * @param[in] n                length of both strings
+ *
+ * @return	number of leading bytes that are equal
+ */
+static inline ulint cmp_common_prefix(const byte *a, const byte *b, ulint n) noexcept {
+  ulint i{};
+
+  for (; i + sizeof(uint64_t) <= n; i += sizeof(uint64_t)) {
+    uint64_t x;
+    uint64_t y;
+
+    memcpy(&x, a + i, sizeof(x));
+    memcpy(&y, b + i, sizeof(y));
+
+    if (x != y) {
+      /* The first differing byte is the lowest one in memory. */
+      if constexpr (std::endian::native == std::endian::little) {
+        return i + std::countr_zero(x ^ y) / 8;
+      } else {
+        return i + std::countl_zero(x ^ y) / 8;
+      }
+    }
+  }
+
+  while (i < n && a[i] == b[i]) {
+    ++i;
+  }
+
+  return i;
+}
+
+Cmp_search_key::Cmp_search_key(void *cmp_ctx, const DTuple *dtuple) noexcept
+    : m_cmp_ctx(cmp_ctx), m_dtuple(dtuple), m_info_bits(dtuple_get_info_bits(dtuple)), m_n_fields(dtuple_get_n_fields_cmp(dtuple)) {
+
+  ut_ad(dtuple_check_typed(dtuple));
+
+  m_binary = m_n_fields <= MAX_FIELDS;
+
+  for (ulint i{}; m_binary && i < m_n_fields; ++i) {
+    const auto dfield = dtuple_get_nth_field(dtuple, i);
+    const auto type = dfield_get_type(dfield);
+
+    if (!cmp_type_is_byte_ordered(type->mtype, type->prtype)) {
+      /* E.g., a latin1 string with a collation that is not the identity. */
+      m_binary = false;
+    } else {
+      auto &field = m_fields[i];
+
+      /* The raw bytes are the key. */
+      field.m_data = static_cast<const byte *>(dfield_get_data(dfield));
+      field.m_len = dfield_get_len(dfield);
+      field.m_pad = dtype_get_pad_char(type->mtype, type->prtype);
+
+#ifdef UNIV_DEBUG
+      for (ulint j{}; field.m_len != UNIV_SQL_NULL && j < field.m_len; ++j) {
+        ut_ad(cmp_collate(field.m_data[j]) == field.m_data[j]);
+      }
+#endif /* UNIV_DEBUG */
+    }
+  }
+}
+
+int Cmp_search_key::compare(const rec_t *rec, const ulint *offsets, ulint *matched_fields, ulint *matched_bytes) const noexcept {
+  if (!m_binary) {
+    return cmp_dtuple_rec_with_match(m_cmp_ctx, m_dtuple, rec, offsets, matched_fields, matched_bytes);
+  }
+
+  ut_ad(rec_offs_validate(rec, nullptr, offsets));
+
+  auto cur_field = *matched_fields;
+  auto cur_bytes = *matched_bytes;
+  int ret{};
+
+  ut_ad(cur_field <= m_n_fields);
+  ut_ad(cur_field <= rec_offs_n_fields(offsets));
+
+  if (cur_bytes == 0 && cur_field == 0) {
+    if (unlikely(rec_get_info_bits(rec) & REC_INFO_MIN_REC_FLAG)) {
+      ret = !(m_info_bits & REC_INFO_MIN_REC_FLAG);
+      goto order_resolved;
+    } else if (unlikely(m_info_bits & REC_INFO_MIN_REC_FLAG)) {
+      ret = -1;
+      goto order_resolved;
+    }
+  }
+
+  for (; cur_field < m_n_fields; ++cur_field, cur_bytes = 0) {
+    const auto &field = m_fields[cur_field];
+
+    ulint rec_len;
+    auto rec_data = rec_get_nth_field(rec, offsets, cur_field, &rec_len);
+
+    if (likely(cur_bytes == 0)) {
+      if (rec_offs_nth_extern(offsets, cur_field)) {
+        /* We do not compare to an externally stored field */
+        ret = 0;
+        goto order_resolved;
+      }
+
+      if (field.m_len == UNIV_SQL_NULL) {
+        if (rec_len == UNIV_SQL_NULL) {
+          continue;
+        }
+
+        ret = -1;
+        goto order_resolved;
+
+      } else if (rec_len == UNIV_SQL_NULL) {
+        /* The SQL null is the smallest value */
+        ret = 1;
+        goto order_resolved;
+      }
+    }
+
+    const auto common = std::min(field.m_len, rec_len);
+
+    if (cur_bytes < common) {
+      cur_bytes += cmp_common_prefix(field.m_data + cur_bytes, rec_data + cur_bytes, common - cur_bytes);
+
+      if (cur_bytes < common) {
+        ret = field.m_data[cur_bytes] > rec_data[cur_bytes] ? 1 : -1;
+        goto order_resolved;
+      }
+    }
+
+    if (field.m_len == rec_len) {
+      continue;
+    }
+
+    /* The shorter value is padded, or is smaller if the type has no
+    pad character. */
+    const auto tuple_longer = field.m_len > rec_len;
+
+    if (field.m_pad == ULINT_UNDEFINED) {
+      ret = tuple_longer ? 1 : -1;
+      goto order_resolved;
+    }
+
+    const auto longer = tuple_longer ? field.m_data : rec_data;
+    const auto len = tuple_longer ? field.m_len : rec_len;
+
+    while (cur_bytes < len && longer[cur_bytes] == field.m_pad) {
+      ++cur_bytes;
+    }
+
+    if (cur_bytes < len) {
+      ret = (longer[cur_bytes] > field.m_pad) == tuple_longer ? 1 : -1;
+      goto order_resolved;
+    }
+  }
+
+  /* If we ran out of fields, dtuple was equal to rec up to the common fields */
+  cur_bytes = 0;
+  ret = 0;
+
+order_resolved:
+
+  ut_ad(ret == cmp_dtuple_rec(m_cmp_ctx, m_dtuple, rec, offsets));
+
+  *matched_fields = cur_field;
+  *matched_bytes = cur_bytes;
+
+  return ret;
+}
+
 int cmp_dtuple_rec(void *cmp_ctx, const DTuple *dtuple, const rec_t *rec, const ulint *offsets) noexcept  {
   ulint matched_fields = 0;
   ulint matched_bytes = 0;
@@ -680,7 +896,7 @@ int cmp_rec_rec_simple(
       }
     }
 
-    if (mtype >= DATA_FLOAT || (mtype == DATA_BLOB && 0 == (prtype & DATA_BINARY_TYPE) && dtype_get_charset_coll(prtype) != DATA_CLIENT_LATIN1_SWEDISH_CHARSET_COLL)) {
+    if (!cmp_type_is_binary_comparable(mtype, prtype)) {
 
       int ret;
 
@@ -835,9 +1051,7 @@ int cmp_rec_rec_with_match(
       }
     }
 
-    if (mtype >= DATA_FLOAT ||
-        (mtype == DATA_BLOB && 0 == (prtype & DATA_BINARY_TYPE) &&
-	      dtype_get_charset_coll(prtype) != DATA_CLIENT_LATIN1_SWEDISH_CHARSET_COLL)) {
+    if (!cmp_type_is_binary_comparable(mtype, prtype)) {
 
       ret = cmp_whole_field(index->m_cmp_ctx, mtype, prtype, rec1_b_ptr, (unsigned)rec1_f_len, rec2_b_ptr, (unsigned)rec2_f_len);
 
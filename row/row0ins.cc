@@ -1566,6 +1566,12 @@ db_err Row_insert::index_entry_low(ulint mode, const Index *index, DTuple *entry
 
       err = btr_cur.optimistic_insert(0, entry, &insert_rec, &big_rec, n_ext, thr, &mtr);
 
+      /* Try to split the leaf without latching the tree. The leaf is
+      still latched and the cursor positioned: no new search is needed. */
+      if (err == DB_FAIL && btr_cur.split_leaf(entry, n_ext, &mtr)) {
+        err = btr_cur.optimistic_insert(0, entry, &insert_rec, &big_rec, n_ext, thr, &mtr);
+      }
+
     } else {
       ut_a(mode == BTR_MODIFY_TREE);
 
@@ -1808,6 +1814,11 @@ que_thr_t *Row_insert::step(que_thr_t *thr) noexcept {
   operation, and there is no need to set it again here. But we
   must write trx->m_id to node->trx_id. */
 
+  if (auto err = trx->set_rw_mode(); err != DB_SUCCESS) {
+    trx->m_error_state = err;
+    return nullptr;
+  }
+
   Trx_sys::write_trx_id(node->m_trx_id_buf, trx->m_id);
 
   auto insert_row = [&](ins_node_t *node, que_thr_t *thr) noexcept -> auto {
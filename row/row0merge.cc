@@ -27,6 +27,8 @@ Completed by Sunny Bains and Marko Makela
 #include "api0misc.h"
 #include "btr0btr.h"
 #include "btr0blob.h"
+#include "btr0load.h"
+#include "os0thread-create.h"
 #include "data0data.h"
 #include "data0type.h"
 #include "ddl0ddl.h"
@@ -37,6 +39,7 @@ Completed by Sunny Bains and Marko Makela
 #include "log0log.h"
 #include "mach0data.h"
 #include "mem0mem.h"
+#include "os0aio.h"
 #include "os0file.h"
 #include "os0proc.h"
 #include "pars0pars.h"
@@ -44,6 +47,7 @@ Completed by Sunny Bains and Marko Makela
 #include "rem0cmp.h"
 #include "row0ext.h"
 #include "row0ins.h"
+#include "row0pread.h"
 #include "row0row.h"
 #include "row0sel.h"
 #include "row0upd.h"
@@ -55,6 +59,12 @@ Completed by Sunny Bains and Marko Makela
 #include "trx0undo.h"
 #include "ut0sort.h"
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <thread>
+#include <vector>
+
 #ifdef HAVE_UNISTD_H
 #include <unistd.h>
 #endif
@@ -72,30 +82,47 @@ static bool row_merge_print_block;
 /* @} */
 #endif /* UNIV_DEBUG */
 
-/** @brief Block size for I/O operations in merge sort.
+/** @brief Block size for I/O operations in merge sort, the configuration
+variable "sort_block_size", a multiple of UNIV_PAGE_SIZE.
 
 The minimum is UNIV_PAGE_SIZE, or page_get_free_space_of_empty()
 rounded to a power of 2.
 
 When not creating a PRIMARY KEY that contains column prefixes, this
 can be set as small as UNIV_PAGE_SIZE / 2.  See the comment above
-ut_ad(data_size < sizeof(row_merge_block_t)). */
-typedef byte row_merge_block_t[1048576];
+ut_ad(data_size < row_merge_block_size()).
+@return	block size in bytes */
+static inline ulint row_merge_block_size() noexcept {
+  return srv_config.m_sort_block_size;
+}
+
+/** Number of blocks used by each thread that sorts a file: the current block
+and the read-ahead of the two lists being merged and the block being filled
+and the block being written of the output. */
+constexpr ulint ROW_MERGE_THREAD_BLOCKS = 6;
 
 /** @brief Secondary buffer for I/O operations of merge records.
 
 This buffer is used for writing or reading a record that spans two
-row_merge_block_t.  Thus, it must be able to hold one merge record,
-whose maximum size is the same as the minimum size of
-row_merge_block_t. */
+blocks.  Thus, it must be able to hold one merge record, whose maximum
+size is the same as the minimum block size. */
 typedef byte mrec_buf_t[UNIV_PAGE_SIZE];
 
-/** @brief Merge record in row_merge_block_t.
+/** @brief Merge record in a merge block.
 
 The format is the same as a record in ROW_FORMAT=COMPACT with the
 exception that the REC_N_NEW_EXTRA_BYTES are omitted. */
 typedef byte mrec_t;
 
+/** A row of a sort buffer and its normalized key prefix */
+struct Merge_sort_key {
+  /** cmp_dfield_key_prefix() of the unique fields of the row */
+  uint64_t m_prefix;
+
+  /** The row */
+  const dfield_t *m_row;
+};
+
 /** Buffer for sorting in main memory. */
 struct row_merge_buf_struct {
   /** memory heap where allocated */
@@ -118,6 +145,10 @@ struct row_merge_buf_struct {
 
   /** temporary copy of rows, for sorting */
   const dfield_t **tmp_tuples;
+
+  /** 2 * max_tuples keys for row_merge_buf_radix_sort(), the second half
+  is the scratch space of the passes */
+  Merge_sort_key *sort_keys;
 };
 
 /** Buffer for sorting in main memory. */
@@ -148,7 +179,7 @@ typedef struct merge_file_struct merge_file_t;
  */
 static row_merge_buf_t *row_merge_buf_create_low(mem_heap_t *heap, Index *index, ulint max_tuples, ulint buf_size) {
   ut_ad(max_tuples > 0);
-  ut_ad(max_tuples <= sizeof(row_merge_block_t));
+  ut_ad(max_tuples <= row_merge_block_size());
   ut_ad(max_tuples < buf_size);
 
   auto buf = reinterpret_cast<row_merge_buf_t *>(mem_heap_zalloc(heap, buf_size));
@@ -158,10 +189,27 @@ static row_merge_buf_t *row_merge_buf_create_low(mem_heap_t *heap, Index *index,
   buf->max_tuples = max_tuples;
   buf->rows = reinterpret_cast<const dfield_t **>(mem_heap_alloc(heap, 2 * max_tuples * sizeof *buf->rows));
   buf->tmp_tuples = buf->rows + max_tuples;
+  buf->sort_keys = reinterpret_cast<Merge_sort_key *>(mem_heap_alloc(heap, 2 * max_tuples * sizeof *buf->sort_keys));
 
   return buf;
 }
 
+/**
+ * @brief Memory used by a sort buffer of an index when it is full.
+ * 
+ * @param[in] index Secondary index.
+ * 
+ * @return Size in bytes.
+ */
+static ulint row_merge_buf_mem_size(const Index *index) noexcept {
+  const auto max_tuples = row_merge_block_size() / ut_max(1, index->get_min_size());
+
+  /* The buffer, the row pointers, the radix sort keys and the field data
+  of the tuples. */
+  return sizeof(row_merge_buf_t) + 3 * max_tuples * sizeof(dfield_t *) + 2 * max_tuples * sizeof(Merge_sort_key) +
+         row_merge_block_size();
+}
+
 /**
  * @brief Allocate a sort buffer.
  * 
@@ -170,9 +218,9 @@ static row_merge_buf_t *row_merge_buf_create_low(mem_heap_t *heap, Index *index,
  * @return Pointer to the allocated sort buffer.
  */
 static row_merge_buf_t *row_merge_buf_create(Index *index) noexcept {
-  auto max_tuples = sizeof(row_merge_block_t) / ut_max(1, index->get_min_size());
+  auto max_tuples = row_merge_block_size() / ut_max(1, index->get_min_size());
   auto buf_size = (sizeof(row_merge_buf_t)) + (max_tuples - 1) * sizeof row_merge_buf_t::rows;
-  auto heap = static_cast<mem_heap_t *>(mem_heap_create(buf_size + sizeof(row_merge_block_t)));
+  auto heap = static_cast<mem_heap_t *>(mem_heap_create(buf_size + row_merge_block_size()));
   auto row_merge_buf = row_merge_buf_create_low(heap, index, max_tuples, buf_size);
 
   return row_merge_buf;
@@ -309,16 +357,16 @@ static bool row_merge_buf_add(row_merge_buf_t *buf, const DTuple *row, const row
   }
 #endif /* UNIV_DEBUG */
 
-  /* Add to the total size of the record in row_merge_block_t
+  /* Add to the total size of the record in the merge block
   the encoded length of extra_size and the extra bytes (extra_size).
   See row_merge_buf_write() for the variable-length encoding
   of extra_size. */
   data_size += (extra_size + 1) + ((extra_size + 1) >= 0x80);
 
-  ut_ad(data_size < sizeof(row_merge_block_t));
+  ut_ad(data_size < row_merge_block_size());
 
-  /* Reserve one byte for the end marker of row_merge_block_t. */
-  if (buf->total_size + data_size >= sizeof(row_merge_block_t) - 1) {
+  /* Reserve one byte for the end marker of the merge block. */
+  if (buf->total_size + data_size >= row_merge_block_size() - 1) {
     return false;
   }
 
@@ -441,12 +489,117 @@ static void row_merge_tuple_sort(
   UT_SORT_FUNCTION_BODY(cmp_ctx, row_merge_tuple_sort_ctx, rows, aux, low, high, row_merge_tuple_cmp_ctx);
 }
 
+/** Buffers with fewer rows are sorted by comparing the rows */
+constexpr ulint ROW_MERGE_RADIX_SORT_MIN = 64;
+
+/**
+ * Sorts a buffer with an LSD radix sort of the normalized key prefixes of
+ * the rows. The rows with equal prefixes are then sorted by comparing their
+ * fields.
+ *
+ * @param[in,out] buf Sort buffer.
+ * @param[in,out] dup For reporting duplicates, or nullptr.
+ */
+static void row_merge_buf_radix_sort(row_merge_buf_t *buf, row_merge_dup_t *dup) noexcept {
+  constexpr ulint N_DIGITS = sizeof(uint64_t);
+  const auto n = buf->n_recs;
+  const auto n_field = buf->index->get_n_unique();
+  const auto cmp_ctx = buf->index->m_cmp_ctx;
+
+  std::array<std::array<ulint, 256>, N_DIGITS> counts{};
+
+  auto src = buf->sort_keys;
+  auto dst = buf->sort_keys + buf->max_tuples;
+
+  for (ulint i{}; i < n; ++i) {
+    const auto prefix = cmp_dfield_key_prefix(buf->rows[i], n_field);
+
+    src[i].m_prefix = prefix;
+    src[i].m_row = buf->rows[i];
+
+    for (ulint d{}; d < N_DIGITS; ++d) {
+      ++counts[d][(prefix >> (8 * d)) & 0xff];
+    }
+  }
+
+  for (ulint d{}; d < N_DIGITS; ++d) {
+    auto &count = counts[d];
+
+    /* Skip the bytes that are the same in all the prefixes, e.g., the
+    NULL flags and the high bytes of small integers. */
+    if (count[(src[0].m_prefix >> (8 * d)) & 0xff] == n) {
+      continue;
+    }
+
+    ulint pos{};
+
+    for (auto &c : count) {
+      const auto n_digit = c;
+
+      c = pos;
+      pos += n_digit;
+    }
+
+    for (ulint i{}; i < n; ++i) {
+      dst[count[(src[i].m_prefix >> (8 * d)) & 0xff]++] = src[i];
+    }
+
+    std::swap(src, dst);
+  }
+
+  auto less = [&](const Merge_sort_key &lhs, const Merge_sort_key &rhs) {
+    return row_merge_tuple_cmp(cmp_ctx, n_field, lhs.m_row, rhs.m_row, nullptr) < 0;
+  };
+
+  for (ulint i{}; i < n;) {
+    auto j = i + 1;
+
+    while (j < n && src[j].m_prefix == src[i].m_prefix) {
+      ++j;
+    }
+
+    if (j - i > 1) {
+      std::sort(src + i, src + j, less);
+
+      /* Equal rows are next to each other and have equal prefixes. */
+      if (dup != nullptr) {
+        for (auto k = i + 1; k < j; ++k) {
+          (void) row_merge_tuple_cmp(cmp_ctx, n_field, src[k - 1].m_row, src[k].m_row, dup);
+        }
+      }
+    }
+
+    i = j;
+  }
+
+  for (ulint i{}; i < n; ++i) {
+    buf->rows[i] = src[i].m_row;
+  }
+
+#ifdef UNIV_DEBUG
+  for (ulint i = 1; i < n; ++i) {
+    ut_ad(row_merge_tuple_cmp(cmp_ctx, n_field, buf->rows[i - 1], buf->rows[i], nullptr) <= 0);
+  }
+#endif /* UNIV_DEBUG */
+}
+
 /** Sort a buffer. */
 static void row_merge_buf_sort(
   row_merge_buf_t *buf, /*!< in/out: sort buffer */
   row_merge_dup_t *dup
 ) /*!< in/out: for reporting duplicates */
 {
+  /* The radix sort helps only if the leading field can be encoded in
+  the key prefix. */
+  if (buf->n_recs >= ROW_MERGE_RADIX_SORT_MIN) {
+    const auto type = dfield_get_type(&buf->rows[0][0]);
+
+    if (cmp_type_is_byte_ordered(type->mtype, type->prtype)) {
+      row_merge_buf_radix_sort(buf, dup);
+      return;
+    }
+  }
+
   row_merge_tuple_sort(buf->index->m_cmp_ctx, buf->index->get_n_unique(), dup, buf->rows, buf->tmp_tuples, 0, buf->n_recs);
 }
 
@@ -456,13 +609,14 @@ static void row_merge_buf_write(
 #ifdef UNIV_DEBUG
   const merge_file_t *of, /*!< in: output file */
 #endif                    /* UNIV_DEBUG */
-  row_merge_block_t *block
+  byte *block
 ) /*!< out: buffer for writing to file */
 #ifndef UNIV_DEBUG
 #define row_merge_buf_write(buf, of, block) row_merge_buf_write(buf, block)
 #endif /* !UNIV_DEBUG */
 {
-  auto b = &(*block)[0];
+  auto b = block;
+  const auto block_end = block + row_merge_block_size();
   const auto index = buf->index;
   const auto n_fields = index->get_n_fields();
 
@@ -480,7 +634,7 @@ static void row_merge_buf_write(
       *b++ = (byte)(size.first + 1);
     }
 
-    ut_ad(b + total_size < block[1]);
+    ut_ad(b + total_size < block_end);
 
     /* Encode into b + size.first */
     Phy_rec::encode(index, b + size.first, REC_STATUS_ORDINARY, {dfield, n_fields});
@@ -489,14 +643,14 @@ static void row_merge_buf_write(
   }
 
   /* Write an "end-of-chunk" marker. */
-  ut_a(b < block[1]);
-  ut_a(b == block[0] + buf->total_size);
+  ut_a(b < block_end);
+  ut_a(b == block + buf->total_size);
 
   *b++ = 0;
 
 #ifdef UNIV_DEBUG_VALGRIND
   /* The rest of the block is uninitialized. Initialize it to avoid bogus warnings. */
-  memset(b, 0xff, block[1] - b);
+  memset(b, 0xff, block_end - b);
 #endif /* UNIV_DEBUG_VALGRIND */
 }
 
@@ -548,12 +702,13 @@ static Index *row_merge_dict_table_get_index(
 static bool row_merge_read(
   int fd,       /*!< in: file descriptor */
   ulint offset, /*!< in: offset where to read */
-  row_merge_block_t *buf
+  byte *buf
 ) /*!< out: data */
 {
-  off_t off = ((off_t)offset) * sizeof(*buf);
+  const auto block_size = row_merge_block_size();
+  off_t off = off_t(offset) * block_size;
 
-  auto success = os_file_read_no_error_handling(OS_FILE_FROM_FD(fd), buf, sizeof(*buf), off);
+  auto success = os_file_read_no_error_handling(OS_FILE_FROM_FD(fd), buf, block_size, off);
 
   if (!success) {
     ut_print_timestamp(ib_stream);
@@ -563,7 +718,7 @@ static bool row_merge_read(
   return success;
 }
 
-/** Read a merge block from the file system.
+/** Write a merge block to the file system.
 @return	true if request was successful, false if fail */
 static bool row_merge_write(
   int fd,       /*!< in: file descriptor */
@@ -571,39 +726,236 @@ static bool row_merge_write(
   const void *buf
 ) /*!< in: data */
 {
-  off_t off = off_t(offset) * sizeof(row_merge_block_t);
+  const auto block_size = row_merge_block_size();
+  off_t off = off_t(offset) * block_size;
+
+  return os_file_write("(merge)", OS_FILE_FROM_FD(fd), buf, block_size, off);
+}
+
+/** Reads the blocks of a list in a merge file in ascending order. While the
+records of the current block are merged, the next block is read ahead into
+a second buffer. */
+struct Merge_input {
+  /** Ring for the read-ahead, nullptr if the blocks are read synchronously */
+  AIO_ring *m_aio{};
+
+  /** File descriptor */
+  int m_fd{-1};
+
+  /** Blocks at and above this offset are not read ahead, the end of the list */
+  ulint m_end{};
+
+  /** Offset of the block in m_block */
+  ulint m_foffs{};
+
+  /** The block whose records are being read */
+  byte *m_block{};
+
+  /** Buffer of the read-ahead */
+  byte *m_next{};
+
+  /** Offset of the block being read into m_next, ULINT_UNDEFINED if none */
+  ulint m_next_foffs{ULINT_UNDEFINED};
+
+  /** The read-ahead request */
+  AIO_ring::Request m_req{};
+
+  /** @return end of m_block */
+  const byte *end() const noexcept { return m_block + row_merge_block_size(); }
+};
+
+/** Writes blocks at the end of a merge file. A full block is written in the
+background while the next block is filled in a second buffer. */
+struct Merge_output {
+  /** Ring for the write-behind, nullptr if the blocks are written synchronously */
+  AIO_ring *m_aio{};
+
+  /** The file, its offset is the next block to write */
+  merge_file_t *m_file{};
+
+  /** The block being filled */
+  byte *m_block{};
+
+  /** The block being written */
+  byte *m_spare{};
+
+  /** The write-behind request */
+  AIO_ring::Request m_req{};
+
+  /** @return end of m_block */
+  byte *end() const noexcept { return m_block + row_merge_block_size(); }
+};
+
+/**
+ * Initializes a merge input stream, no block is read yet.
+ *
+ * @param[out] in Stream to initialize.
+ * @param[in] aio Ring for the read-ahead, or nullptr.
+ * @param[in] fd File descriptor.
+ * @param[in] end Offset of the first block after the list.
+ * @param[in] block Buffer for the current block.
+ * @param[in] next Buffer for the read-ahead, unused if aio == nullptr.
+ */
+static void row_merge_input_init(Merge_input &in, AIO_ring *aio, int fd, ulint end, byte *block, byte *next) noexcept {
+  in.m_aio = aio;
+  in.m_fd = fd;
+  in.m_end = end;
+  in.m_foffs = 0;
+  in.m_block = block;
+  in.m_next = next;
+  in.m_next_foffs = ULINT_UNDEFINED;
+}
+
+/**
+ * Waits for the read-ahead of a merge input stream and discards it, the
+ * buffers can then be reused.
+ *
+ * @param[in,out] in Stream.
+ */
+static void row_merge_input_close(Merge_input &in) noexcept {
+  if (in.m_next_foffs != ULINT_UNDEFINED) {
+    in.m_next_foffs = ULINT_UNDEFINED;
+    (void) in.m_aio->wait(in.m_req);
+  }
+}
+
+/**
+ * Makes a block the current block of a merge input stream and starts the
+ * read-ahead of the block after it. The read-ahead is used if it is the
+ * block that is asked for.
+ *
+ * @param[in,out] in Stream.
+ * @param[in] foffs Offset of the block.
+ * @return true if request was successful, false if fail
+ */
+static bool row_merge_input_read(Merge_input &in, ulint foffs) noexcept {
+  const auto block_size = row_merge_block_size();
+
+  if (in.m_next_foffs == foffs) {
+    in.m_next_foffs = ULINT_UNDEFINED;
+
+    if (in.m_aio->wait(in.m_req) != DB_SUCCESS) {
+      ut_print_timestamp(ib_stream);
+      ib_logger(ib_stream, "  failed to read merge block at %lu\n", (ulong)(foffs * block_size));
+      return false;
+    }
+
+    std::swap(in.m_block, in.m_next);
+
+  } else {
+    row_merge_input_close(in);
+
+    if (!row_merge_read(in.m_fd, foffs, in.m_block)) {
+      return false;
+    }
+  }
+
+  in.m_foffs = foffs;
+
+  if (in.m_aio != nullptr && foffs + 1 < in.m_end) {
+    auto &req = in.m_req;
+
+    req.m_read = true;
+    req.m_fh = in.m_fd;
+    req.m_ptr = in.m_next;
+    req.m_len = block_size;
+    req.m_off = off_t(foffs + 1) * block_size;
+
+    /* If the read-ahead can't be submitted the block is read when it is needed. */
+    if (in.m_aio->submit(req) == DB_SUCCESS) {
+      in.m_next_foffs = foffs + 1;
+    }
+  }
+
+  return true;
+}
+
+/**
+ * Initializes a merge output stream.
+ *
+ * @param[out] out Stream to initialize.
+ * @param[in] aio Ring for the write-behind, or nullptr.
+ * @param[in,out] file File to append to.
+ * @param[in] block Buffer for the block being filled.
+ * @param[in] spare Buffer for the write-behind, unused if aio == nullptr.
+ */
+static void row_merge_output_init(Merge_output &out, AIO_ring *aio, merge_file_t *file, byte *block, byte *spare) noexcept {
+  out.m_aio = aio;
+  out.m_file = file;
+  out.m_block = block;
+  out.m_spare = spare;
+}
+
+/**
+ * Waits for the block of a merge output stream that is being written.
+ *
+ * @param[in,out] out Stream.
+ * @return true if all the writes so far were successful
+ */
+static bool row_merge_output_flush(Merge_output &out) noexcept {
+  return out.m_aio == nullptr || out.m_aio->wait(out.m_req) == DB_SUCCESS;
+}
+
+/**
+ * Starts writing the current block of a merge output stream at the end of
+ * the file and makes the other buffer the current block.
+ *
+ * @param[in,out] out Stream.
+ * @return true if request was successful, false if fail
+ */
+static bool row_merge_output_write(Merge_output &out) noexcept {
+  const auto foffs = out.m_file->offset++;
+
+  if (out.m_aio == nullptr) {
+    return row_merge_write(out.m_file->fd, foffs, out.m_block);
+  }
+
+  if (!row_merge_output_flush(out)) {
+    return false;
+  }
+
+  const auto block_size = row_merge_block_size();
+  auto &req = out.m_req;
+
+  req.m_read = false;
+  req.m_fh = out.m_file->fd;
+  req.m_ptr = out.m_block;
+  req.m_len = block_size;
+  req.m_off = off_t(foffs) * block_size;
 
-  return os_file_write("(merge)", OS_FILE_FROM_FD(fd), buf, sizeof(row_merge_block_t), off);
+  if (out.m_aio->submit(req) != DB_SUCCESS) {
+    return row_merge_write(out.m_file->fd, foffs, out.m_block);
+  }
+
+  std::swap(out.m_block, out.m_spare);
+
+  return true;
 }
 
 /**
- * Reads a record from the specified file buffer and returns a pointer to the merge record.
+ * Reads a record from the specified merge input stream and returns a pointer to the merge record.
  * 
- * @param block The file buffer.
+ * @param in The input stream, the next block is read if the record spans two blocks.
  * @param buf The secondary buffer.
  * @param b Pointer to the record.
  * @param index Index of the record.
- * @param fd File descriptor.
- * @param foffs File offset.
  * @param mrec Pointer to the merge record.
  * @param offsets Column offsets of the merge record.
  * @return Pointer to the next record, or nullptr on end of list (non-NULL on I/O error).
  */
 static const byte *row_merge_read_rec(
-  row_merge_block_t *block,
+  Merge_input &in,
   mrec_buf_t *buf,
   const byte *b,
   const Index *index,
-  int fd,
-  ulint *foffs,
   const mrec_t **mrec,
   ulint *offsets
 ) {
   ulint extra_size;
   ulint avail_size;
 
-  ut_ad(b >= block[0]);
-  ut_ad(b < block[1]);
+  ut_ad(b >= in.m_block);
+  ut_ad(b < in.end());
 
   ut_ad(*offsets == 1 + REC_OFFS_HEADER_SIZE + index->get_n_fields());
 
@@ -618,8 +970,8 @@ static const byte *row_merge_read_rec(
   if (extra_size >= 0x80) {
     /* Read another byte of extra_size. */
 
-    if (unlikely(b >= block[1])) {
-      if (!row_merge_read(fd, ++(*foffs), block)) {
+    if (unlikely(b >= in.end())) {
+      if (!row_merge_input_read(in, in.m_foffs + 1)) {
       err_exit:
         /* Signal I/O error. */
         *mrec = b;
@@ -627,7 +979,7 @@ static const byte *row_merge_read_rec(
       }
 
       /* Wrap around to the beginning of the buffer. */
-      b = block[0];
+      b = in.m_block;
     }
 
     extra_size = (extra_size & 0x7f) << 8;
@@ -640,22 +992,22 @@ static const byte *row_merge_read_rec(
 
   /* Read the extra bytes. */
 
-  if (unlikely(b + extra_size >= block[1])) {
+  if (unlikely(b + extra_size >= in.end())) {
     /* The record spans two blocks.  Copy the entire record
     to the auxiliary buffer and handle this as a special
     case. */
 
-    avail_size = block[1] - b;
+    avail_size = in.end() - b;
 
     memcpy(*buf, b, avail_size);
 
-    if (!row_merge_read(fd, ++(*foffs), block)) {
+    if (!row_merge_input_read(in, in.m_foffs + 1)) {
 
       goto err_exit;
     }
 
     /* Wrap around to the beginning of the buffer. */
-    b = block[0];
+    b = in.m_block;
 
     /* Copy the record. */
     memcpy(*buf + avail_size, b, extra_size - avail_size);
@@ -674,7 +1026,7 @@ static const byte *row_merge_read_rec(
     records are much smaller than either buffer, and
     the record starts near the beginning of each buffer. */
     ut_a(extra_size + data_size < sizeof(*buf));
-    ut_a(b + data_size < block[1]);
+    ut_a(b + data_size < in.end());
 
     /* Copy the data bytes. */
     memcpy(*buf + extra_size, b, data_size);
@@ -695,7 +1047,7 @@ static const byte *row_merge_read_rec(
 
   b += extra_size + data_size;
 
-  if (likely(b < block[1])) {
+  if (likely(b < in.end())) {
     /* The record fits entirely in the block.  This is the normal case. */
     return b;
   }
@@ -703,7 +1055,7 @@ static const byte *row_merge_read_rec(
   /* The record spans two blocks.  Copy it to buf. */
 
   b -= extra_size + data_size;
-  avail_size = block[1] - b;
+  avail_size = in.end() - b;
   memcpy(*buf, b, avail_size);
   *mrec = *buf + extra_size;
 
@@ -716,13 +1068,13 @@ static const byte *row_merge_read_rec(
   offsets[3] = (ulint)index;
 #endif /* UNIV_DEBUG */
 
-  if (!row_merge_read(fd, ++(*foffs), block)) {
+  if (!row_merge_input_read(in, in.m_foffs + 1)) {
 
     goto err_exit;
   }
 
   /* Wrap around to the beginning of the buffer. */
-  b = block[0];
+  b = in.m_block;
 
   /* Copy the rest of the record. */
   memcpy(*buf + avail_size, b, extra_size + data_size - avail_size);
@@ -761,22 +1113,18 @@ static void row_merge_write_rec_low(
 /** Write a merge record.
 @return	pointer to end of block, or NULL on error */
 static byte *row_merge_write_rec(
-  row_merge_block_t *block, /*!< in/out: file buffer */
-  mrec_buf_t *buf,          /*!< in/out: secondary buffer */
-  byte *b,                  /*!< in: pointer to end of block */
-  int fd,                   /*!< in: file descriptor */
-  ulint *foffs,             /*!< in/out: file offset */
-  const mrec_t *mrec,       /*!< in: record to write */
+  Merge_output &out,  /*!< in/out: output stream */
+  mrec_buf_t *buf,    /*!< in/out: secondary buffer */
+  byte *b,            /*!< in: pointer to end of block */
+  const mrec_t *mrec, /*!< in: record to write */
   const ulint *offsets
 ) /*!< in: offsets of mrec */
 {
-  ut_ad(block);
   ut_ad(buf);
-  ut_ad(b >= block[0]);
-  ut_ad(b < block[1]);
+  ut_ad(b >= out.m_block);
+  ut_ad(b < out.end());
   ut_ad(mrec);
-  ut_ad(foffs);
-  ut_ad(mrec < block[0] || mrec > block[1]);
+  ut_ad(mrec < out.m_block || mrec > out.end());
   ut_ad(mrec < buf[0] || mrec > buf[1]);
 
   /* Normalize extra_size.  Value 0 signals "end of list". */
@@ -786,30 +1134,30 @@ static byte *row_merge_write_rec(
 
   ++extra_size;
 
-  if (unlikely(b + size >= block[1])) {
+  if (unlikely(b + size >= out.end())) {
     /* The record spans two blocks.
     Copy it to the temporary buffer first. */
-    auto avail_size = block[1] - b;
+    auto avail_size = out.end() - b;
 
-    row_merge_write_rec_low(buf[0], extra_size, size, fd, *foffs, mrec, offsets);
+    row_merge_write_rec_low(buf[0], extra_size, size, out.m_file->fd, out.m_file->offset, mrec, offsets);
 
     /* Copy the head of the temporary buffer, write
     the completed block, and copy the tail of the
     record to the head of the new block. */
     memcpy(b, buf[0], avail_size);
 
-    if (!row_merge_write(fd, (*foffs)++, block)) {
+    if (!row_merge_output_write(out)) {
       return (nullptr);
     }
 
-    UNIV_MEM_INVALID(block[0], sizeof block[0]);
+    UNIV_MEM_INVALID(out.m_block, row_merge_block_size());
 
     /* Copy the rest. */
-    b = block[0];
+    b = out.m_block;
     memcpy(b, buf[0] + avail_size, size - avail_size);
     b += size - avail_size;
   } else {
-    row_merge_write_rec_low(b, extra_size, size, fd, *foffs, mrec, offsets);
+    row_merge_write_rec_low(b, extra_size, size, out.m_file->fd, out.m_file->offset, mrec, offsets);
     b += size;
   }
 
@@ -819,37 +1167,34 @@ static byte *row_merge_write_rec(
 /** Write an end-of-list marker.
 @return	pointer to end of block, or NULL on error */
 static byte *row_merge_write_eof(
-  row_merge_block_t *block, /*!< in/out: file buffer */
-  byte *b,                  /*!< in: pointer to end of block */
-  int fd,                   /*!< in: file descriptor */
-  ulint *foffs
-) /*!< in/out: file offset */
-{
-  ut_ad(block);
-  ut_ad(b >= block[0]);
-  ut_ad(b < block[1]);
-  ut_ad(foffs);
+  Merge_output &out, /*!< in/out: output stream */
+  byte *b            /*!< in: pointer to end of block */
+) {
+  ut_ad(b >= out.m_block);
+  ut_ad(b < out.end());
 #ifdef UNIV_DEBUG
   if (row_merge_print_write) {
-    ib_logger(ib_stream, "row_merge_write %p,%p,%d,%lu EOF\n", (void *)b, (void *)block, fd, (ulong)*foffs);
+    ib_logger(
+      ib_stream, "row_merge_write %p,%p,%d,%lu EOF\n", (void *)b, (void *)out.m_block, out.m_file->fd, (ulong)out.m_file->offset
+    );
   }
 #endif /* UNIV_DEBUG */
 
   *b++ = 0;
-  UNIV_MEM_ASSERT_RW(block[0], b - block[0]);
-  UNIV_MEM_ASSERT_W(block[0], sizeof block[0]);
+  UNIV_MEM_ASSERT_RW(out.m_block, b - out.m_block);
+  UNIV_MEM_ASSERT_W(out.m_block, row_merge_block_size());
 #ifdef UNIV_DEBUG_VALGRIND
   /* The rest of the block is uninitialized.  Initialize it
   to avoid bogus warnings. */
-  memset(b, 0xff, block[1] - b);
+  memset(b, 0xff, out.end() - b);
 #endif /* UNIV_DEBUG_VALGRIND */
 
-  if (!row_merge_write(fd, (*foffs)++, block)) {
+  if (!row_merge_output_write(out)) {
     return (nullptr);
   }
 
-  UNIV_MEM_INVALID(block[0], sizeof block[0]);
-  return (block[0]);
+  UNIV_MEM_INVALID(out.m_block, row_merge_block_size());
+  return (out.m_block);
 }
 
 /** Compare two merge records.
@@ -881,6 +1226,170 @@ static int row_merge_cmp(
   return (cmp);
 }
 
+/**
+ * Adds the entries of a row to the sort buffers of the indexes. A buffer
+ * that is full is sorted and written to the file of its index first.
+ *
+ * @param table Client table object, for reporting erroneous records
+ * @param merge_buf Sort buffers, one for each index
+ * @param files Temporary files, one for each index
+ * @param n_index Number of indexes to create
+ * @param row Row to add, or nullptr to write out all the buffers
+ * @param ext Cache of externally stored column prefixes of row, or nullptr
+ * @param out Output stream, its file is set to the file of the buffer being written
+ * @param key_num Out: the index that failed
+ * @return DB_SUCCESS, DB_DUPLICATE_KEY or DB_OUT_OF_FILE_SPACE
+ */
+static db_err row_merge_buf_add_row(
+  table_handle_t table,
+  row_merge_buf_t **merge_buf,
+  merge_file_t *files,
+  ulint n_index,
+  const DTuple *row,
+  const row_ext_t *ext,
+  Merge_output &out,
+  ulint &key_num) noexcept
+{
+  for (ulint i{}; i < n_index; ++i) {
+    auto file = &files[i];
+    auto buf = merge_buf[i];
+    const auto index = buf->index;
+
+    if (likely(row && row_merge_buf_add(buf, row, ext))) {
+      file->n_rec++;
+      continue;
+    }
+
+    /* The buffer must be sufficiently large
+    to hold at least one record. */
+    ut_ad(buf->n_recs || row == nullptr);
+
+    /* We have enough data rows to form a block.
+    Sort them and write to disk. */
+
+    if (buf->n_recs) {
+      if (index->is_unique()) {
+        row_merge_dup_t dup;
+        dup.index = buf->index;
+        dup.table = table;
+        dup.n_dup = 0;
+
+        row_merge_buf_sort(buf, &dup);
+
+        if (dup.n_dup) {
+          key_num = i;
+          return DB_DUPLICATE_KEY;
+        }
+      } else {
+        row_merge_buf_sort(buf, nullptr);
+      }
+    }
+
+    out.m_file = file;
+
+    row_merge_buf_write(buf, file, out.m_block);
+
+    if (!row_merge_output_write(out)) {
+      key_num = i;
+      return DB_OUT_OF_FILE_SPACE;
+    }
+
+    UNIV_MEM_INVALID(out.m_block, row_merge_block_size());
+    merge_buf[i] = row_merge_buf_empty(buf);
+
+    if (likely(row != nullptr)) {
+      /* Try writing the record again, now
+      that the buffer has been written out
+      and emptied. */
+
+      if (unlikely(!row_merge_buf_add(merge_buf[i], row, ext))) {
+        /* An empty buffer should have enough
+        room for at least one record. */
+        ut_error;
+      }
+
+      file->n_rec++;
+    }
+  }
+
+  return DB_SUCCESS;
+}
+
+/**
+ * Finds the columns that are NOT NULL in the new table but not in the old
+ * table, these must be checked when the rows are copied.
+ *
+ * @param old_table Table where rows are read from
+ * @param new_table Table where indexes are created
+ * @param n_nonnull Out: number of columns found
+ * @return column numbers, to be freed with mem_free(), or nullptr if none
+ */
+static ulint *row_merge_get_nonnull(const Table *old_table, const Table *new_table, ulint &n_nonnull) noexcept {
+  n_nonnull = 0;
+
+  if (likely(old_table == new_table)) {
+    return nullptr;
+  }
+
+  ulint n_cols = old_table->get_n_cols();
+
+  /* A primary key will be created.  Identify the
+  columns that were flagged NOT NULL in the new table,
+  so that we can quickly check that the records in the
+  (old) clustered index do not violate the added NOT
+  NULL constraints. */
+
+  ut_a(n_cols == new_table->get_n_cols());
+
+  auto nonnull = static_cast<ulint *>(mem_alloc(n_cols * sizeof(ulint)));
+
+  for (ulint i{}; i < n_cols; ++i) {
+    if (old_table->get_nth_col(i)->prtype & DATA_NOT_NULL) {
+
+      continue;
+    }
+
+    if (new_table->get_nth_col(i)->prtype & DATA_NOT_NULL) {
+
+      nonnull[n_nonnull++] = i;
+    }
+  }
+
+  if (!n_nonnull) {
+    mem_free(nonnull);
+    nonnull = nullptr;
+  }
+
+  return nonnull;
+}
+
+/**
+ * Checks the columns that became NOT NULL and flags them NOT NULL in the row.
+ *
+ * @param row Row built from the old table
+ * @param nonnull Columns to check
+ * @param n_nonnull Number of columns to check
+ * @param key_num Out: the column that is NULL
+ * @return DB_SUCCESS or DB_PRIMARY_KEY_IS_NULL
+ */
+static db_err row_merge_check_nonnull(DTuple *row, const ulint *nonnull, ulint n_nonnull, ulint &key_num) noexcept {
+  for (ulint i = 0; i < n_nonnull; i++) {
+    dfield_t *field = &row->fields[nonnull[i]];
+    dtype_t *field_type = dfield_get_type(field);
+
+    ut_a(!(field_type->prtype & DATA_NOT_NULL));
+
+    if (dfield_is_null(field)) {
+      key_num = i;
+      return DB_PRIMARY_KEY_IS_NULL;
+    }
+
+    field_type->prtype |= DATA_NOT_NULL;
+  }
+
+  return DB_SUCCESS;
+}
+
 /**
  * Reads clustered index of the table and create temporary files
  * containing the index entries for the indexes to be built.
@@ -892,7 +1401,7 @@ static int row_merge_cmp(
  * @param index Indexes to be created
  * @param files Temporary files
  * @param n_index Number of indexes to create
- * @param block File buffer
+ * @param block File buffers, 2 blocks
  * @return DB_SUCCESS or error
  */
 static db_err row_merge_read_clustered_index(
@@ -903,7 +1412,7 @@ static db_err row_merge_read_clustered_index(
   Index **index,
   merge_file_t *files,
   ulint n_index,
-  row_merge_block_t *block) noexcept
+  byte *block) noexcept
 {
   ulint *nonnull{};
   ulint n_nonnull{};
@@ -937,44 +1446,27 @@ static db_err row_merge_read_clustered_index(
 
   pcur.open_at_index_side(true, clust_index, BTR_SEARCH_LEAF, true, 0, &mtr);
 
-  if (unlikely(old_table != new_table)) {
-    ulint n_cols = old_table->get_n_cols();
-
-    /* A primary key will be created.  Identify the
-    columns that were flagged NOT NULL in the new table,
-    so that we can quickly check that the records in the
-    (old) clustered index do not violate the added NOT
-    NULL constraints. */
-
-    ut_a(n_cols == new_table->get_n_cols());
-
-    nonnull = static_cast<ulint *>(mem_alloc(n_cols * sizeof *nonnull));
-
-    for (ulint i{}; i < n_cols; ++i) {
-      if (old_table->get_nth_col(i)->prtype & DATA_NOT_NULL) {
-
-        continue;
-      }
-
-      if (new_table->get_nth_col(i)->prtype & DATA_NOT_NULL) {
+  nonnull = row_merge_get_nonnull(old_table, new_table, n_nonnull);
 
-        nonnull[n_nonnull++] = i;
-      }
-    }
+  auto row_heap = mem_heap_create(sizeof(mrec_buf_t));
 
-    if (!n_nonnull) {
-      mem_free(nonnull);
-      nonnull = nullptr;
-    }
-  }
+  /* The full blocks are written while the scan continues. */
+  Merge_output out;
+  auto aio = AIO_ring::create(1);
 
-  auto row_heap = mem_heap_create(sizeof(mrec_buf_t));
+  row_merge_output_init(out, aio, &files[0], block, block + row_merge_block_size());
 
   auto func_exit = [&](db_err err) -> auto {
     pcur.close();
 
     mtr.commit();
 
+    if (!row_merge_output_flush(out) && err == DB_SUCCESS) {
+      err = DB_OUT_OF_FILE_SPACE;
+    }
+
+    AIO_ring::destroy(aio);
+
     mem_heap_free(row_heap);
 
     if (likely_null(nonnull)) {
@@ -996,7 +1488,7 @@ static db_err row_merge_read_clustered_index(
     const rec_t *rec;
     ulint *offsets;
     DTuple *row{};
-    row_ext_t *ext;
+    row_ext_t *ext{};
     bool has_next = true;
 
     pcur.move_to_next_on_page();
@@ -1004,9 +1496,6 @@ static db_err row_merge_read_clustered_index(
     /* When switching pages, commit the mini-transaction
     in order to release the latch on the old page. */
 
-    merge_file_t *file{};
-    const Index *index{};
-
     if (pcur.is_after_last_on_page()) {
       if (unlikely(trx_is_interrupted(trx))) {
         trx->m_error_key_num = ULINT_UNDEFINED;
@@ -1023,8 +1512,6 @@ static db_err row_merge_read_clustered_index(
       has_next = pcur.move_to_next_user_rec(&mtr);
     }
 
-    row_merge_buf_t *buf;
-
     if (likely(has_next)) {
       rec = pcur.get_rec();
 
@@ -1046,18 +1533,13 @@ static db_err row_merge_read_clustered_index(
       row = row_build(ROW_COPY_POINTERS, clust_index, rec, offsets, new_table, &ext, row_heap);
 
       if (likely_null(nonnull)) {
-        for (ulint i = 0; i < n_nonnull; i++) {
-          dfield_t *field = &row->fields[nonnull[i]];
-          dtype_t *field_type = dfield_get_type(field);
+        ulint key_num;
 
-          ut_a(!(field_type->prtype & DATA_NOT_NULL));
+        err = row_merge_check_nonnull(row, nonnull, n_nonnull, key_num);
 
-          if (dfield_is_null(field)) {
-            trx->m_error_key_num = i;
-            return func_exit(DB_PRIMARY_KEY_IS_NULL);
-          }
-
-          field_type->prtype |= DATA_NOT_NULL;
+        if (err != DB_SUCCESS) {
+          trx->m_error_key_num = key_num;
+          return func_exit(err);
         }
       }
     }
@@ -1065,93 +1547,242 @@ static db_err row_merge_read_clustered_index(
     /* Build all entries for all the indexes to be created
     in a single scan of the clustered index. */
 
-    for (ulint i{}; i < n_index; ++i) {
-      file = &files[i];
-      buf = merge_buf[i];
-      index = buf->index;
+    {
+      ulint key_num;
 
-      if (likely(row && row_merge_buf_add(buf, row, ext))) {
-        file->n_rec++;
-        continue;
+      err = row_merge_buf_add_row(table, merge_buf, files, n_index, row, ext, out, key_num);
+
+      if (err != DB_SUCCESS) {
+        trx->m_error_key_num = key_num;
+        return func_exit(err);
       }
+    }
 
-      /* The buffer must be sufficiently large
-      to hold at least one record. */
-      ut_ad(buf->n_recs || !has_next);
+    mem_heap_empty(row_heap);
 
-      /* We have enough data rows to form a block.
-      Sort them and write to disk. */
+    if (unlikely(!has_next)) {
+      return func_exit(err);
+    }
+  }
 
-      if (buf->n_recs) {
-        if (index->is_unique()) {
-          row_merge_dup_t dup;
-          dup.index = buf->index;
-          dup.table = table;
-          dup.n_dup = 0;
+  return func_exit(err);
+}
 
-          row_merge_buf_sort(buf, &dup);
+/** Sort buffers and files of one thread of a parallel clustered index scan */
+struct Merge_scan_thread {
+  /** Sort buffers, one for each index */
+  row_merge_buf_t **m_merge_buf{};
 
-          if (dup.n_dup) {
-            err = DB_DUPLICATE_KEY;
-            trx->m_error_key_num = i;
-            return func_exit(DB_DUPLICATE_KEY);
-          }
-        } else {
-          row_merge_buf_sort(buf, nullptr);
-        }
-      }
+  /** The files of the thread, one for each index */
+  merge_file_t *m_files{};
 
-      row_merge_buf_write(buf, file, block);
+  /** Ring for writing the files */
+  AIO_ring *m_aio{};
 
-      if (!row_merge_write(file->fd, file->offset++, block)) {
-        trx->m_error_key_num = i;
-        return func_exit(DB_OUT_OF_FILE_SPACE);
-      }
+  /** Output stream for writing the sort buffers */
+  Merge_output m_out{};
 
-      UNIV_MEM_INVALID(block[0], sizeof block[0]);
-      merge_buf[i] = row_merge_buf_empty(buf);
+  /** Heap for the row being added */
+  mem_heap_t *m_row_heap{};
 
-      if (likely(row != nullptr)) {
-        /* Try writing the record again, now
-        that the buffer has been written out
-        and emptied. */
+  /** Number of rows read */
+  ulint m_n_rows{};
 
-        if (unlikely(!row_merge_buf_add(buf, row, ext))) {
-          /* An empty buffer should have enough
-          room for at least one record. */
-          ut_error;
-        }
+  /** true if the sort buffers have been written out */
+  bool m_flushed{};
+};
+
+/**
+ * Reads the clustered index of the table with several threads and creates
+ * temporary files containing the index entries for the indexes to be built.
+ * Each thread fills its own sort buffers and writes them to its own file
+ * for each index, so that the files need not be shared.
+ *
+ * @param trx Transaction
+ * @param table Client table object, for reporting erroneous records
+ * @param old_table Table where rows are read from
+ * @param new_table Table where indexes are created; identical to old_table unless creating a PRIMARY KEY
+ * @param index Indexes to be created
+ * @param files Temporary files, n_threads for each index, the files of
+ *  index i start at files[i * n_threads]
+ * @param n_index Number of indexes to create
+ * @param n_threads Number of threads, reserved with Parallel_reader::available_threads()
+ * @param block File buffers, thread t uses 2 blocks starting at block t * ROW_MERGE_THREAD_BLOCKS
+ * @return DB_SUCCESS, DB_OUT_OF_RESOURCES if the threads could not be created, or error
+ */
+static db_err row_merge_read_clustered_index_parallel(
+  Trx *trx,
+  table_handle_t table,
+  const Table *old_table,
+  const Table *new_table,
+  Index **index,
+  merge_file_t *files,
+  ulint n_index,
+  ulint n_threads,
+  byte *block) noexcept
+{
+  ut_a(n_threads > 1);
+
+  trx->m_op_info = "reading clustered index";
+
+  ulint n_nonnull{};
+  auto nonnull = row_merge_get_nonnull(old_table, new_table, n_nonnull);
+  auto clust_index = const_cast<Index *>(old_table->get_clustered_index());
+
+  std::vector<Merge_scan_thread> threads(n_threads);
+
+  for (ulint t{}; t < n_threads; ++t) {
+    auto &thread = threads[t];
+
+    thread.m_merge_buf = static_cast<row_merge_buf_t **>(mem_alloc(n_index * sizeof(row_merge_buf_t *)));
+    thread.m_files = static_cast<merge_file_t *>(mem_alloc(n_index * sizeof(merge_file_t)));
+
+    for (ulint i{}; i < n_index; ++i) {
+      thread.m_merge_buf[i] = row_merge_buf_create(index[i]);
+      thread.m_files[i] = files[i * n_threads + t];
+    }
+
+    auto thread_block = block + t * ROW_MERGE_THREAD_BLOCKS * row_merge_block_size();
+
+    thread.m_aio = AIO_ring::create(1);
+
+    row_merge_output_init(thread.m_out, thread.m_aio, &thread.m_files[0], thread_block, thread_block + row_merge_block_size());
+    thread.m_row_heap = mem_heap_create(sizeof(mrec_buf_t));
+  }
+
+  std::atomic<ulint> error_key_num{ULINT_UNDEFINED};
+
+  auto flush = [&](Merge_scan_thread &thread) -> db_err {
+    ulint key_num;
+
+    thread.m_flushed = true;
+
+    auto err = row_merge_buf_add_row(table, thread.m_merge_buf, thread.m_files, n_index, nullptr, nullptr, thread.m_out, key_num);
+
+    if (err == DB_SUCCESS && !row_merge_output_flush(thread.m_out)) {
+      key_num = ULINT_UNDEFINED;
+      err = DB_OUT_OF_FILE_SPACE;
+    }
+
+    if (err != DB_SUCCESS) {
+      error_key_num.store(key_num, std::memory_order_relaxed);
+    }
+
+    return err;
+  };
 
-        file->n_rec++;
+  /* The scan is not a consistent read, the table is locked. The reader
+  skips delete marked records. */
+  Parallel_reader reader(n_threads);
+  Parallel_reader::Scan_range full_scan;
+  Parallel_reader::Config config(full_scan, clust_index);
+
+  auto err = reader.add_scan(nullptr, config, [&](const Parallel_reader::Ctx *ctx) -> db_err {
+    auto &thread = threads[ctx->thread_id()];
+
+    if (ctx->m_first_rec && unlikely(trx_is_interrupted(trx))) {
+      return DB_INTERRUPTED;
+    }
+
+    ++thread.m_n_rows;
+
+    row_ext_t *ext;
+
+    /* Build a row based on the clustered index. */
+    auto row = row_build(ROW_COPY_POINTERS, clust_index, ctx->m_rec, ctx->m_offsets, new_table, &ext, thread.m_row_heap);
+
+    ulint key_num;
+    db_err err{DB_SUCCESS};
+
+    if (likely_null(nonnull)) {
+      err = row_merge_check_nonnull(row, nonnull, n_nonnull, key_num);
+    }
+
+    if (err == DB_SUCCESS) {
+      err = row_merge_buf_add_row(table, thread.m_merge_buf, thread.m_files, n_index, row, ext, thread.m_out, key_num);
+    }
+
+    if (err != DB_SUCCESS) {
+      error_key_num.store(key_num, std::memory_order_relaxed);
+    }
+
+    mem_heap_empty(thread.m_row_heap);
+
+    return err;
+  });
+
+  if (err == DB_SUCCESS) {
+    reader.set_finish_callback([&](Parallel_reader::Thread_ctx *thread_ctx) -> db_err {
+      /* Write out the sort buffers while the other threads are still
+      scanning. */
+      if (thread_ctx->get_state() == Parallel_reader::State::THREAD && !reader.is_error_set()) {
+        return flush(threads[thread_ctx->m_thread_id]);
       }
+
+      return DB_SUCCESS;
+    });
+
+    err = reader.run(n_threads);
+  }
+
+  /* Threads that got no work, or all of them if the table is empty. */
+  for (auto &thread : threads) {
+    if (err == DB_SUCCESS && !thread.m_flushed) {
+      err = flush(thread);
     }
+  }
 
-    mem_heap_empty(row_heap);
+  if (err == DB_INTERRUPTED) {
+    trx->m_error_key_num = ULINT_UNDEFINED;
+  } else if (err != DB_SUCCESS) {
+    trx->m_error_key_num = error_key_num.load(std::memory_order_relaxed);
+  }
 
-    if (unlikely(!has_next)) {
-      return func_exit(err);
+  for (ulint t{}; t < n_threads; ++t) {
+    auto &thread = threads[t];
+
+    /* Wait for the last write if the scan failed. */
+    (void) row_merge_output_flush(thread.m_out);
+
+    AIO_ring::destroy(thread.m_aio);
+
+    for (ulint i{}; i < n_index; ++i) {
+      files[i * n_threads + t] = thread.m_files[i];
+      row_merge_buf_free(thread.m_merge_buf[i]);
     }
+
+    srv_n_rows_inserted += thread.m_n_rows;
+
+    mem_heap_free(thread.m_row_heap);
+    mem_free(thread.m_files);
+    mem_free(thread.m_merge_buf);
   }
 
-  return func_exit(err);
+  if (likely_null(nonnull)) {
+    mem_free(nonnull);
+  }
+
+  trx->m_op_info = "";
+
+  return err;
 }
 
-/** Write a record via buffer 2 and read the next record to buffer N.
-@param N	number of the buffer (0 or 1)
+/** Write a record via the output stream and read the next record of input stream N.
+@param N	number of the input stream (0 or 1)
 @param AT_END	statement to execute at end of input */
-#define ROW_MERGE_WRITE_GET_NEXT(N, AT_END)                                                               \
-  do {                                                                                                    \
-    b2 = row_merge_write_rec(&block[2], &buf[2], b2, of->fd, &of->offset, mrec##N, offsets##N);           \
-    if (unlikely(!b2 || ++of->n_rec > file->n_rec)) {                                                     \
-      goto corrupt;                                                                                       \
-    }                                                                                                     \
-    b##N = row_merge_read_rec(&block[N], &buf[N], b##N, index, file->fd, foffs##N, &mrec##N, offsets##N); \
-    if (unlikely(!b##N)) {                                                                                \
-      if (mrec##N) {                                                                                      \
-        goto corrupt;                                                                                     \
-      }                                                                                                   \
-      AT_END;                                                                                             \
-    }                                                                                                     \
+#define ROW_MERGE_WRITE_GET_NEXT(N, AT_END)                                          \
+  do {                                                                               \
+    b2 = row_merge_write_rec(out, &buf[2], b2, mrec##N, offsets##N);                 \
+    if (unlikely(!b2 || ++of->n_rec > file->n_rec)) {                                \
+      goto corrupt;                                                                  \
+    }                                                                                \
+    b##N = row_merge_read_rec(in##N, &buf[N], b##N, index, &mrec##N, offsets##N);    \
+    if (unlikely(!b##N)) {                                                           \
+      if (mrec##N) {                                                                 \
+        goto corrupt;                                                                \
+      }                                                                              \
+      AT_END;                                                                        \
+    }                                                                                \
   } while (0)
 
 /** Merge two blocks of records on disk and write a bigger block.
@@ -1160,12 +1791,15 @@ static db_err row_merge_blocks(
   const Index *index, /*!< in: index being created */
   const merge_file_t *file,  /*!< in: file containing
                                             index entries */
-  row_merge_block_t *block,  /*!< in/out: 3 buffers */
+  Merge_input &in0,          /*!< in/out: stream of the first
+                                            source list */
   ulint *foffs0,             /*!< in/out: offset of first
                                             source list in the file */
+  Merge_input &in1,          /*!< in/out: stream of the second
+                                            source list */
   ulint *foffs1,             /*!< in/out: offset of second
                                             source list in the file */
-  merge_file_t *of,          /*!< in/out: output file */
+  Merge_output &out,         /*!< in/out: output stream */
   table_handle_t table
 ) /*!< in/out: Client table, for
                                             reporting erroneous key value
@@ -1173,14 +1807,15 @@ static db_err row_merge_blocks(
 {
   mem_heap_t *heap; /*!< memory heap for offsets0, offsets1 */
 
-  mrec_buf_t buf[3];   /*!< buffer for handling split mrec in block[] */
-  const byte *b0;      /*!< pointer to block[0] */
-  const byte *b1;      /*!< pointer to block[1] */
-  byte *b2;            /*!< pointer to block[2] */
-  const mrec_t *mrec0; /*!< merge rec, points to block[0] or buf[0] */
-  const mrec_t *mrec1; /*!< merge rec, points to block[1] or buf[1] */
+  mrec_buf_t buf[3];   /*!< buffer for handling split mrec in blocks */
+  const byte *b0;      /*!< pointer to the block of in0 */
+  const byte *b1;      /*!< pointer to the block of in1 */
+  byte *b2;            /*!< pointer to the block of out */
+  const mrec_t *mrec0; /*!< merge rec, points to the block of in0 or buf[0] */
+  const mrec_t *mrec1; /*!< merge rec, points to the block of in1 or buf[1] */
   ulint *offsets0;     /* offsets of mrec0 */
   ulint *offsets1;     /* offsets of mrec1 */
+  auto of = out.m_file; /*!< output file */
 
 #ifdef UNIV_DEBUG
   if (row_merge_print_block) {
@@ -1203,18 +1838,18 @@ static db_err row_merge_blocks(
   /* Write a record and read the next record.  Split the output
   file in two halves, which can be merged on the following pass. */
 
-  if (!row_merge_read(file->fd, *foffs0, &block[0]) || !row_merge_read(file->fd, *foffs1, &block[1])) {
+  if (!row_merge_input_read(in0, *foffs0) || !row_merge_input_read(in1, *foffs1)) {
   corrupt:
     mem_heap_free(heap);
     return (DB_CORRUPTION);
   }
 
-  b0 = block[0];
-  b1 = block[1];
-  b2 = block[2];
+  b0 = in0.m_block;
+  b1 = in1.m_block;
+  b2 = out.m_block;
 
-  b0 = row_merge_read_rec(&block[0], &buf[0], b0, index, file->fd, foffs0, &mrec0, offsets0);
-  b1 = row_merge_read_rec(&block[1], &buf[1], b1, index, file->fd, foffs1, &mrec1, offsets1);
+  b0 = row_merge_read_rec(in0, &buf[0], b0, index, &mrec0, offsets0);
+  b1 = row_merge_read_rec(in1, &buf[1], b1, index, &mrec1, offsets1);
   if (unlikely(!b0 && mrec0) || unlikely(!b1 && mrec1)) {
 
     goto corrupt;
@@ -1255,8 +1890,13 @@ done0:
   }
 done1:
 
+  /* The offsets point to the beginning of the last page that
+  has been read. */
+  *foffs0 = in0.m_foffs;
+  *foffs1 = in1.m_foffs;
+
   mem_heap_free(heap);
-  b2 = row_merge_write_eof(&block[2], b2, of->fd, &of->offset);
+  b2 = row_merge_write_eof(out, b2);
   return (b2 ? DB_SUCCESS : DB_CORRUPTION);
 }
 
@@ -1265,22 +1905,23 @@ done1:
  *
  * @param[in] index The index being created.
  * @param[in] file The input file.
- * @param[in,out] block The 3 buffers.
+ * @param[in,out] in0 The input stream.
  * @param[in,out] foffs0 The input file offset.
- * @param[in,out] of The output file.
+ * @param[in,out] out The output stream.
  * 
  * @return true on success, false on failure.
  */
-static bool row_merge_blocks_copy(const Index *index, const merge_file_t *file, row_merge_block_t *block, ulint *foffs0, merge_file_t *of) {
+static bool row_merge_blocks_copy(const Index *index, const merge_file_t *file, Merge_input &in0, ulint *foffs0, Merge_output &out) {
   mem_heap_t *heap; /*!< memory heap for offsets0, offsets1 */
 
   mrec_buf_t buf[3];   /*!< buffer for handling
-                       split mrec in block[] */
-  const byte *b0;      /*!< pointer to block[0] */
-  byte *b2;            /*!< pointer to block[2] */
-  const mrec_t *mrec0; /*!< merge rec, points to block[0] */
+                       split mrec in blocks */
+  const byte *b0;      /*!< pointer to the block of in0 */
+  byte *b2;            /*!< pointer to the block of out */
+  const mrec_t *mrec0; /*!< merge rec, points to the block of in0 */
   ulint *offsets0;     /* offsets of mrec0 */
   ulint *offsets1;     /* dummy offsets */
+  auto of = out.m_file; /*!< output file */
 
 #ifdef UNIV_DEBUG
   if (row_merge_print_block) {
@@ -1301,16 +1942,16 @@ static bool row_merge_blocks_copy(const Index *index, const merge_file_t *file,
   /* Write a record and read the next record.  Split the output
   file in two halves, which can be merged on the following pass. */
 
-  if (!row_merge_read(file->fd, *foffs0, &block[0])) {
+  if (!row_merge_input_read(in0, *foffs0)) {
   corrupt:
     mem_heap_free(heap);
     return (false);
   }
 
-  b0 = block[0];
-  b2 = block[2];
+  b0 = in0.m_block;
+  b2 = out.m_block;
 
-  b0 = row_merge_read_rec(&block[0], &buf[0], b0, index, file->fd, foffs0, &mrec0, offsets0);
+  b0 = row_merge_read_rec(in0, &buf[0], b0, index, &mrec0, offsets0);
   if (unlikely(!b0 && mrec0)) {
 
     goto corrupt;
@@ -1326,10 +1967,10 @@ done0:
 
   /* The file offset points to the beginning of the last page
   that has been read.  Update it to point to the next block. */
-  (*foffs0)++;
+  *foffs0 = in0.m_foffs + 1;
 
   mem_heap_free(heap);
-  return (row_merge_write_eof(&block[2], b2, of->fd, &of->offset) != nullptr);
+  return (row_merge_write_eof(out, b2) != nullptr);
 }
 
 /** Merge disk files.
@@ -1340,12 +1981,15 @@ static __attribute__((nonnull)) db_err row_merge(
   merge_file_t *file,        /*!< in/out: file containing
                                      index entries */
   ulint *half,               /*!< in/out: half the file */
-  row_merge_block_t *block,  /*!< in/out: 3 buffers */
+  byte *block,               /*!< in/out: ROW_MERGE_THREAD_BLOCKS
+                                     buffers */
   int *tmpfd,                /*!< in/out: temporary file handle */
-  table_handle_t table
-) /*!< in/out: Client table, for
+  table_handle_t table,      /*!< in/out: Client table, for
                                      reporting erroneous key value
                                      if applicable */
+  AIO_ring *aio              /*!< in/out: ring for the read-ahead
+                                     and write-behind */
+)
 {
   ulint foffs0;    /*!< first input offset */
   ulint foffs1;    /*!< second input offset */
@@ -1355,13 +1999,37 @@ static __attribute__((nonnull)) db_err row_merge(
   /*!< half the input file */
   ulint ohalf; /*!< half the output file */
 
-  UNIV_MEM_ASSERT_W(block[0], 3 * sizeof block[0]);
+  const auto block_size = row_merge_block_size();
+
+  UNIV_MEM_ASSERT_W(block, ROW_MERGE_THREAD_BLOCKS * block_size);
   ut_ad(ihalf < file->offset);
 
   of.fd = *tmpfd;
   of.offset = 0;
   of.n_rec = 0;
 
+  Merge_input in0;
+  Merge_input in1;
+  Merge_output out;
+
+  /* The first list is not read ahead into the second one. */
+  row_merge_input_init(in0, aio, file->fd, ihalf, block, block + block_size);
+  row_merge_input_init(in1, aio, file->fd, file->offset, block + 2 * block_size, block + 3 * block_size);
+  row_merge_output_init(out, aio, &of, block + 4 * block_size, block + 5 * block_size);
+
+  /* Waits for the read-ahead and the write-behind, the buffers and the
+  files are reused after the pass. */
+  auto finish = [&](db_err err) -> db_err {
+    row_merge_input_close(in0);
+    row_merge_input_close(in1);
+
+    if (!row_merge_output_flush(out) && err == DB_SUCCESS) {
+      err = DB_CORRUPTION;
+    }
+
+    return err;
+  };
+
   /* Merge blocks to the output file. */
   ohalf = 0;
   foffs0 = 0;
@@ -1371,13 +2039,13 @@ static __attribute__((nonnull)) db_err row_merge(
     ulint ahalf; /*!< arithmetic half the input file */
 
     if (unlikely(trx_is_interrupted(trx))) {
-      return (DB_INTERRUPTED);
+      return finish(DB_INTERRUPTED);
     }
 
-    err = row_merge_blocks(index, file, block, &foffs0, &foffs1, &of, table);
+    err = row_merge_blocks(index, file, in0, &foffs0, in1, &foffs1, out, table);
 
     if (err != DB_SUCCESS) {
-      return err;
+      return finish(err);
     }
 
     /* Record the offset of the output file when
@@ -1401,11 +2069,11 @@ static __attribute__((nonnull)) db_err row_merge(
 
   while (foffs0 < ihalf) {
     if (unlikely(trx_is_interrupted(trx))) {
-      return (DB_INTERRUPTED);
+      return finish(DB_INTERRUPTED);
     }
 
-    if (!row_merge_blocks_copy(index, file, block, &foffs0, &of)) {
-      return (DB_CORRUPTION);
+    if (!row_merge_blocks_copy(index, file, in0, &foffs0, out)) {
+      return finish(DB_CORRUPTION);
     }
   }
 
@@ -1413,16 +2081,22 @@ static __attribute__((nonnull)) db_err row_merge(
 
   while (foffs1 < file->offset) {
     if (unlikely(trx_is_interrupted(trx))) {
-      return (DB_INTERRUPTED);
+      return finish(DB_INTERRUPTED);
     }
 
-    if (!row_merge_blocks_copy(index, file, block, &foffs1, &of)) {
-      return (DB_CORRUPTION);
+    if (!row_merge_blocks_copy(index, file, in1, &foffs1, out)) {
+      return finish(DB_CORRUPTION);
     }
   }
 
   ut_ad(foffs1 == file->offset);
 
+  err = finish(DB_SUCCESS);
+
+  if (err != DB_SUCCESS) {
+    return err;
+  }
+
   if (unlikely(of.n_rec != file->n_rec)) {
     return (DB_CORRUPTION);
   }
@@ -1432,7 +2106,7 @@ static __attribute__((nonnull)) db_err row_merge(
   *file = of;
   *half = ohalf;
 
-  UNIV_MEM_INVALID(block[0], 3 * sizeof block[0]);
+  UNIV_MEM_INVALID(block, ROW_MERGE_THREAD_BLOCKS * block_size);
 
   return (DB_SUCCESS);
 }
@@ -1444,12 +2118,15 @@ static db_err row_merge_sort(
   const Index *index, /*!< in: index being created */
   merge_file_t *file,        /*!< in/out: file containing
                                           index entries */
-  row_merge_block_t *block,  /*!< in/out: 3 buffers */
+  byte *block,               /*!< in/out: ROW_MERGE_THREAD_BLOCKS
+                                          buffers */
   int *tmpfd,                /*!< in/out: temporary file handle */
-  table_handle_t table
-) /*!< in/out: User table, for
+  table_handle_t table,      /*!< in/out: User table, for
                                           reporting erroneous key value
                                           if applicable */
+  AIO_ring *aio              /*!< in/out: ring for the read-ahead
+                                          and write-behind */
+)
 {
   ulint half = file->offset / 2;
 
@@ -1460,7 +2137,7 @@ static db_err row_merge_sort(
   do {
     db_err err;
 
-    err = row_merge(trx, index, file, &half, block, tmpfd, table);
+    err = row_merge(trx, index, file, &half, block, tmpfd, table, aio);
 
     if (err != DB_SUCCESS) {
       return err;
@@ -1474,6 +2151,105 @@ static db_err row_merge_sort(
   return (DB_SUCCESS);
 }
 
+/**
+ * Sorts the files of the indexes, each file into one list. The files are
+ * independent and are sorted by up to n_threads threads at a time.
+ *
+ * @param trx Transaction
+ * @param indexes Indexes being created
+ * @param files Temporary files, n_runs for each index, the files of
+ *  index i start at files[i * n_runs]
+ * @param n_indexes Number of indexes
+ * @param n_runs Number of files for each index
+ * @param n_threads Maximum number of threads to use
+ * @param block File buffers, ROW_MERGE_THREAD_BLOCKS for each thread
+ * @param table User table, for reporting erroneous key value if applicable
+ * @return DB_SUCCESS or error code
+ */
+static db_err row_merge_sort_files(
+  Trx *trx,
+  Index **indexes,
+  merge_file_t *files,
+  ulint n_indexes,
+  ulint n_runs,
+  ulint n_threads,
+  byte *block,
+  table_handle_t table) noexcept
+{
+  const auto n_files = n_indexes * n_runs;
+  std::atomic<ulint> next{};
+  std::atomic<db_err> error{DB_SUCCESS};
+  std::atomic<ulint> error_key_num{ULINT_UNDEFINED};
+
+  auto sort = [&](ulint thread_id) {
+    auto tmpfd = ib_create_tempfile("mrg");
+    auto thread_block = block + thread_id * ROW_MERGE_THREAD_BLOCKS * row_merge_block_size();
+
+    /* Two read-aheads and one write-behind. */
+    auto aio = AIO_ring::create(3);
+
+    for (;;) {
+      const auto i = next.fetch_add(1, std::memory_order_relaxed);
+
+      if (i >= n_files || error.load(std::memory_order_relaxed) != DB_SUCCESS) {
+        break;
+      }
+
+      const auto key_num = i / n_runs;
+      const auto err = row_merge_sort(trx, indexes[key_num], &files[i], thread_block, &tmpfd, table, aio);
+
+      if (err != DB_SUCCESS) {
+        auto expected = DB_SUCCESS;
+
+        if (error.compare_exchange_strong(expected, err)) {
+          error_key_num.store(key_num, std::memory_order_relaxed);
+        }
+
+        break;
+      }
+    }
+
+    AIO_ring::destroy(aio);
+
+    close(tmpfd);
+  };
+
+  std::vector<std::thread> threads;
+
+  n_threads = std::min(n_threads, n_files);
+
+  /* The scan released its threads, reserve them again. The calling
+  thread sorts too. */
+  const auto n_reserved = n_threads > 1 ? Parallel_reader::available_threads(n_threads - 1, false) : 0;
+
+  for (ulint t = 1; t <= n_reserved; ++t) {
+    try {
+      threads.emplace_back(create_joinable_thread(sort, t));
+    } catch (...) {
+      /* Sort with the threads that could be created. */
+      break;
+    }
+  }
+
+  sort(0);
+
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  if (n_reserved > 0) {
+    Parallel_reader::release_threads(n_reserved);
+  }
+
+  const auto err = error.load(std::memory_order_relaxed);
+
+  if (err != DB_SUCCESS) {
+    trx->m_error_key_num = error_key_num.load(std::memory_order_relaxed);
+  }
+
+  return err;
+}
+
 /** Copy externally stored columns to the data tuple. */
 static void row_merge_copy_blobs(
   const mrec_t *mrec,   /*!< in: merge record */
@@ -1508,117 +2284,273 @@ static void row_merge_copy_blobs(
   }
 }
 
+/** Reads the records of one sorted file of an index. */
+struct Merge_reader {
+  /** File to read */
+  const merge_file_t *m_file{};
+
+  /** The blocks of the file, read ahead */
+  Merge_input m_in{};
+
+  /** Buffer for a record that spans two blocks */
+  mrec_buf_t *m_buf{};
+
+  /** Position in the current block of m_in */
+  const byte *m_b{};
+
+  /** Current record, nullptr at the end of the file */
+  const mrec_t *m_mrec{};
+
+  /** Offsets of m_mrec */
+  ulint *m_offsets{};
+};
+
 /**
- * @brief Read sorted file containing index data rows and insert these data rows to the index.
- * 
- * @param[in] trx Transaction.
+ * @brief Merges the sorted files of an index and passes the data rows to a
+ * callback in ascending order.
+ *
+ * The files are merged on the fly: the smallest current record of the files
+ * is passed next, so that files sorted by different threads need not be
+ * merged into one file first.
+ *
  * @param[in] index Index.
- * @param[in] table New table.
- * @param[in] fd File descriptor.
- * @param[in] block File buffer.
- * 
+ * @param[in] files Sorted files, each of them one list.
+ * @param[in] n_files Number of files.
+ * @param[in] block File buffers, two for each file.
+ * @param[in,out] tuple_heap Heap for the data rows, emptied after each one.
+ * @param[in] f Called with each data row and its number of externally
+ *  stored columns, returns DB_SUCCESS to continue.
+ *
  * @return DB_SUCCESS or error number.
  */
-static db_err row_merge_insert_index_tuples(Trx *trx, Index *index, Table *table, int fd, row_merge_block_t *block) {
-  mrec_buf_t buf;
-  const byte *b;
-  que_thr_t *thr;
-  ins_node_t *node;
-  mem_heap_t *tuple_heap;
-  mem_heap_t *graph_heap;
-  enum db_err err = DB_SUCCESS;
-  ulint foffs = 0;
-  ulint *offsets;
+template <typename F>
+static db_err row_merge_read_sorted_files(
+  Index *index, const merge_file_t *files, ulint n_files, byte *block, mem_heap_t *tuple_heap, F &&f) {
+  db_err err{DB_SUCCESS};
+  std::vector<Merge_reader> readers(n_files);
+  auto reader_heap = mem_heap_create(n_files * sizeof(mrec_buf_t));
+
+  /* The next block of each file is read while the current blocks are
+  processed. */
+  auto aio = AIO_ring::create(n_files);
+
+  /* Min-heap of the readers that have a current record. */
+  std::vector<ulint> heap;
+
+  auto greater = [&](ulint lhs, ulint rhs) {
+    const auto &l = readers[lhs];
+    const auto &r = readers[rhs];
+
+    return row_merge_cmp(l.m_mrec, r.m_mrec, l.m_offsets, r.m_offsets, index) > 0;
+  };
+
+  heap.reserve(n_files);
+
+  for (ulint i{}; i < n_files; ++i) {
+    auto &reader = readers[i];
+    const ulint n = 1 + REC_OFFS_HEADER_SIZE + index->get_n_fields();
+
+    auto reader_block = block + 2 * i * row_merge_block_size();
+
+    reader.m_file = &files[i];
+    reader.m_buf = reinterpret_cast<mrec_buf_t *>(mem_heap_alloc(reader_heap, sizeof(mrec_buf_t)));
+    reader.m_offsets = reinterpret_cast<ulint *>(mem_heap_alloc(reader_heap, n * sizeof(ulint)));
+    reader.m_offsets[0] = n;
+    reader.m_offsets[1] = index->get_n_fields();
 
+    row_merge_input_init(reader.m_in, aio, reader.m_file->fd, reader.m_file->offset, reader_block, reader_block + row_merge_block_size());
+
+    if (!row_merge_input_read(reader.m_in, 0)) {
+      err = DB_CORRUPTION;
+      break;
+    }
+
+    reader.m_b = row_merge_read_rec(reader.m_in, reader.m_buf, reader.m_in.m_block, index, &reader.m_mrec, reader.m_offsets);
+
+    if (reader.m_b != nullptr) {
+      heap.push_back(i);
+      std::push_heap(heap.begin(), heap.end(), greater);
+    } else if (reader.m_mrec != nullptr) {
+      /* I/O error */
+      err = DB_CORRUPTION;
+      break;
+    }
+  }
+
+  while (err == DB_SUCCESS && !heap.empty()) {
+    std::pop_heap(heap.begin(), heap.end(), greater);
+
+    auto &reader = readers[heap.back()];
+    const auto mrec = reader.m_mrec;
+    const auto offsets = reader.m_offsets;
+
+    heap.pop_back();
+
+    /* Each file has been checked for duplicates by the merge sort. */
+    if (unlikely(index->is_unique()) && !heap.empty()) {
+      const auto &next = readers[heap.front()];
+
+      if (row_merge_cmp(mrec, next.m_mrec, offsets, next.m_offsets, index) == 0) {
+        err = DB_DUPLICATE_KEY;
+        break;
+      }
+    }
+
+    ulint n_ext;
+    auto dtuple = row_rec_to_index_entry_low(mrec, index, offsets, &n_ext, tuple_heap);
+
+    if (unlikely(n_ext)) {
+      row_merge_copy_blobs(mrec, offsets, dtuple, tuple_heap);
+    }
+
+    ut_ad(dtuple_validate(dtuple));
+
+    err = f(dtuple, n_ext);
+
+    if (err != DB_SUCCESS) {
+      break;
+    }
+
+    mem_heap_empty(tuple_heap);
+
+    /* The record has been processed, its block can be reused. */
+    reader.m_b = row_merge_read_rec(reader.m_in, reader.m_buf, reader.m_b, index, &reader.m_mrec, reader.m_offsets);
+
+    if (reader.m_b != nullptr) {
+      heap.push_back(&reader - &readers[0]);
+      std::push_heap(heap.begin(), heap.end(), greater);
+    } else if (reader.m_mrec != nullptr) {
+      /* I/O error */
+      err = DB_CORRUPTION;
+    }
+  }
+
+  for (auto &reader : readers) {
+    row_merge_input_close(reader.m_in);
+  }
+
+  AIO_ring::destroy(aio);
+
+  mem_heap_free(reader_heap);
+
+  return err;
+}
+
+/**
+ * @brief Read sorted files containing clustered index data rows and insert
+ * these data rows to the index.
+ *
+ * @param[in] trx Transaction.
+ * @param[in] index Clustered index.
+ * @param[in] table New table.
+ * @param[in] files Sorted files, each of them one list.
+ * @param[in] n_files Number of files.
+ * @param[in] block File buffers, two for each file.
+ *
+ * @return DB_SUCCESS or error number.
+ */
+static db_err row_merge_insert_index_tuples(Trx *trx, Index *index, Table *table, const merge_file_t *files, ulint n_files, byte *block) {
   ut_ad(trx);
   ut_ad(index);
   ut_ad(table);
+  ut_ad(n_files > 0);
+  ut_ad(index->is_clustered());
 
   /* We use the insert query graph as the dummy graph
   needed in the row module call */
 
   trx->m_op_info = "inserting index entries";
 
-  graph_heap = mem_heap_create(500);
-  node = srv_row_ins->node_create(INS_DIRECT, table, graph_heap);
+  auto graph_heap = mem_heap_create(500);
+  auto node = srv_row_ins->node_create(INS_DIRECT, table, graph_heap);
 
-  thr = pars_complete_graph_for_exec(node, trx, graph_heap);
+  auto thr = pars_complete_graph_for_exec(node, trx, graph_heap);
 
   que_thr_move_to_run_state(thr);
 
-  tuple_heap = mem_heap_create(1000);
+  auto tuple_heap = mem_heap_create(1000);
 
-  {
-    ulint i = 1 + REC_OFFS_HEADER_SIZE + index->get_n_fields();
-    offsets = reinterpret_cast<ulint *>(mem_heap_alloc(graph_heap, i * sizeof *offsets));
-    offsets[0] = i;
-    offsets[1] = index->get_n_fields();
-  }
+  /* Set if the error handling already stopped the query thread. */
+  bool thr_stopped{};
 
-  b = *block;
+  auto insert = [&](DTuple *dtuple, ulint) -> db_err {
+    node->m_row = dtuple;
+    node->m_table = table;
+    node->m_trx_id = trx->m_id;
 
-  if (!row_merge_read(fd, foffs, block)) {
-    err = DB_CORRUPTION;
-  } else {
     for (;;) {
-      const mrec_t *mrec;
-      DTuple *dtuple;
-      ulint n_ext;
-
-      b = row_merge_read_rec(block, &buf, b, index, fd, &foffs, &mrec, offsets);
-      if (unlikely(!b)) {
-        /* End of list, or I/O error */
-        if (mrec) {
-          err = DB_CORRUPTION;
-        }
-        break;
+      thr->run_node = thr;
+      thr->prev_node = thr->common.parent;
+
+      auto err = srv_row_ins->index_entry(index, dtuple, 0, false, thr);
+
+      if (likely(err == DB_SUCCESS)) {
+        return err;
       }
 
-      dtuple = row_rec_to_index_entry_low(mrec, index, offsets, &n_ext, tuple_heap);
+      thr->lock_state = QUE_THR_LOCK_ROW;
+      trx->m_error_state = err;
+      que_thr_stop_client(thr);
+      thr->lock_state = QUE_THR_LOCK_NOLOCK;
 
-      if (unlikely(n_ext)) {
-        row_merge_copy_blobs(mrec, offsets, dtuple, tuple_heap);
+      if (!ib_handle_errors(&err, trx, thr, nullptr)) {
+        thr_stopped = true;
+        return err;
       }
+    }
+  };
 
-      node->m_row = dtuple;
-      node->m_table = table;
-      node->m_trx_id = trx->m_id;
+  const auto err = row_merge_read_sorted_files(index, files, n_files, block, tuple_heap, insert);
 
-      ut_ad(dtuple_validate(dtuple));
+  if (!thr_stopped) {
+    que_thr_stop_for_client_no_error(thr, trx);
+  }
 
-      do {
-        thr->run_node = thr;
-        thr->prev_node = thr->common.parent;
+  que_graph_free(thr->graph);
 
-        err = srv_row_ins->index_entry(index, dtuple, 0, false, thr);
+  trx->m_op_info = "";
 
-        if (likely(err == DB_SUCCESS)) {
+  mem_heap_free(tuple_heap);
 
-          goto next_rec;
-        }
+  return err;
+}
 
-        thr->lock_state = QUE_THR_LOCK_ROW;
-        trx->m_error_state = err;
-        que_thr_stop_client(thr);
-        thr->lock_state = QUE_THR_LOCK_NOLOCK;
-      } while (ib_handle_errors(&err, trx, thr, nullptr));
+/**
+ * @brief Read sorted files containing secondary index data rows and build
+ * the index bottom-up from them.
+ *
+ * The merge sort has rejected duplicates and the new index is not yet
+ * visible to other transactions, the tuples are appended to the index
+ * without descending the tree for each one. Only the id of the transaction
+ * is used, several indexes of a transaction can be loaded concurrently.
+ *
+ * @param[in] trx_id Transaction that creates the index.
+ * @param[in] index Secondary index.
+ * @param[in] files Sorted files, each of them one list.
+ * @param[in] n_files Number of files.
+ * @param[in] block File buffers, two for each file.
+ *
+ * @return DB_SUCCESS or error number.
+ */
+static db_err row_merge_load_index_tuples(trx_id_t trx_id, Index *index, const merge_file_t *files, ulint n_files, byte *block) {
+  ut_ad(!index->is_clustered());
+  ut_ad(n_files > 0);
 
-      goto err_exit;
-    next_rec:
-      mem_heap_empty(tuple_heap);
-    }
-  }
+  Btree_load loader(srv_fsp, srv_btree_sys, index, trx_id, srv_config.m_index_fill_factor);
 
-  que_thr_stop_for_client_no_error(thr, trx);
+  auto tuple_heap = mem_heap_create(1000);
 
-err_exit:
-  que_graph_free(thr->graph);
+  auto load = [&](DTuple *dtuple, ulint n_ext) { return loader.insert(dtuple, n_ext); };
 
-  trx->m_op_info = "";
+  auto err = row_merge_read_sorted_files(index, files, n_files, block, tuple_heap, load);
+
+  if (err == DB_SUCCESS) {
+    err = loader.finish();
+  }
 
   mem_heap_free(tuple_heap);
 
-  return (err);
+  return err;
 }
 
 /** Drop an index from the InnoDB system tables.  The data dictionary must
@@ -1885,6 +2817,134 @@ db_err row_merge_drop_table(Trx *trx, Table *table) {
   return err;
 }
 
+/**
+ * @brief Inserts the sorted files of the indexes being created into the indexes.
+ *
+ * The clustered index is inserted into by the calling thread, the secondary
+ * indexes are built by up to ROW_MERGE_THREAD_BLOCKS / 2 threads at a time,
+ * each with two file buffers for each run.
+ *
+ * @param trx Transaction
+ * @param indexes Indexes being created
+ * @param table New table
+ * @param files Temporary files, n_runs for each index, the files of
+ *  index i start at files[i * n_runs]. They are closed once inserted.
+ * @param n_indexes Number of indexes
+ * @param n_runs Number of files for each index
+ * @param block File buffers, ROW_MERGE_THREAD_BLOCKS * n_runs
+ * @return DB_SUCCESS or error code
+ */
+static db_err row_merge_insert_indexes(
+  Trx *trx,
+  Index **indexes,
+  Table *table,
+  merge_file_t *files,
+  ulint n_indexes,
+  ulint n_runs,
+  byte *block) noexcept
+{
+  std::atomic<ulint> next{};
+  std::atomic<db_err> error{DB_SUCCESS};
+  std::atomic<ulint> error_key_num{ULINT_UNDEFINED};
+  const auto trx_id = trx->m_id;
+
+  auto set_error = [&](db_err err, ulint key_num) {
+    auto expected = DB_SUCCESS;
+
+    if (error.compare_exchange_strong(expected, err)) {
+      error_key_num.store(key_num, std::memory_order_relaxed);
+    }
+  };
+
+  auto thread_block = [&](ulint thread_id) {
+    return block + thread_id * 2 * n_runs * row_merge_block_size();
+  };
+
+  auto close_files = [&](ulint key_num) {
+    /* Close the temporary files to free up space. */
+    for (ulint j{}; j < n_runs; ++j) {
+      row_merge_file_destroy(&files[key_num * n_runs + j]);
+    }
+  };
+
+  auto load = [&](ulint thread_id) {
+    for (;;) {
+      const auto i = next.fetch_add(1, std::memory_order_relaxed);
+
+      if (i >= n_indexes || error.load(std::memory_order_relaxed) != DB_SUCCESS) {
+        break;
+      }
+
+      if (indexes[i]->is_clustered()) {
+        continue;
+      }
+
+      const auto err = row_merge_load_index_tuples(trx_id, indexes[i], &files[i * n_runs], n_runs, thread_block(thread_id));
+
+      close_files(i);
+
+      if (err != DB_SUCCESS) {
+        set_error(err, i);
+        break;
+      }
+    }
+  };
+
+  ulint n_secondary{};
+
+  for (ulint i{}; i < n_indexes; ++i) {
+    if (!indexes[i]->is_clustered()) {
+      ++n_secondary;
+    }
+  }
+
+  std::vector<std::thread> threads;
+
+  /* The calling thread loads secondary indexes too, once it has inserted
+  into the clustered index. */
+  const auto n_threads = std::min<ulint>(n_secondary, ROW_MERGE_THREAD_BLOCKS / 2);
+  const auto n_reserved = n_threads > 1 ? Parallel_reader::available_threads(n_threads - 1, false) : 0;
+
+  for (ulint t = 1; t <= n_reserved; ++t) {
+    try {
+      threads.emplace_back(create_joinable_thread(load, t));
+    } catch (...) {
+      /* Load with the threads that could be created. */
+      break;
+    }
+  }
+
+  for (ulint i{}; i < n_indexes; ++i) {
+    if (indexes[i]->is_clustered()) {
+      const auto err = row_merge_insert_index_tuples(trx, indexes[i], table, &files[i * n_runs], n_runs, thread_block(0));
+
+      close_files(i);
+
+      if (err != DB_SUCCESS) {
+        set_error(err, i);
+      }
+    }
+  }
+
+  load(0);
+
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  if (n_reserved > 0) {
+    Parallel_reader::release_threads(n_reserved);
+  }
+
+  const auto err = error.load(std::memory_order_relaxed);
+
+  if (err != DB_SUCCESS) {
+    trx->m_error_key_num = error_key_num.load(std::memory_order_relaxed);
+  }
+
+  return err;
+}
+
 db_err row_merge_build_indexes(
   Trx *trx,
   Table *old_table,
@@ -1901,22 +2961,77 @@ db_err row_merge_build_indexes(
 
   ut_a(trx->m_conc_state != TRX_NOT_STARTED);
 
-  /* Allocate memory for merge file data structure and initialize fields */
+  /* The clustered index is scanned by n_threads threads, each of them
+  writes its own file, a run, for each index. */
+  auto n_threads = srv_config.m_index_build_threads;
 
-  auto block_size = 3 * sizeof(row_merge_block_t);
-  auto block = static_cast<row_merge_block_t *>(os_mem_alloc_large(&block_size));
-  auto merge_files = static_cast<merge_file_t *>(mem_alloc(n_indexes * sizeof(merge_file_t)));
+  if (n_threads == 0) {
+    n_threads = std::max(std::thread::hardware_concurrency(), 1U);
+  }
+
+  n_threads = std::min<ulint>(n_threads, Parallel_reader::MAX_THREADS);
+
+  /* Each thread has ROW_MERGE_THREAD_BLOCKS file blocks and a sort buffer
+  for each index, use as many threads as fit in index_build_memory. */
+  auto thread_mem = ROW_MERGE_THREAD_BLOCKS * row_merge_block_size();
 
   for (ulint i{}; i < n_indexes; ++i) {
-    row_merge_file_create(&merge_files[i]);
+    thread_mem += row_merge_buf_mem_size(indexes[i]);
+  }
+
+  n_threads = std::min<ulint>(n_threads, std::max<ulint>(srv_config.m_index_build_memory / thread_mem, 1));
+
+  if (n_threads > 1) {
+    n_threads = Parallel_reader::available_threads(n_threads, false);
+
+    if (n_threads == 1) {
+      Parallel_reader::release_threads(n_threads);
+    }
   }
 
-  auto tmpfd = ib_create_tempfile("mrg");
+  ulint n_runs = n_threads > 1 ? n_threads : 1;
+  ulint n_files = n_indexes * n_runs;
+  const auto n_alloc = n_files;
+
+  /* Allocate memory for merge file data structure and initialize fields.
+  Each thread needs ROW_MERGE_THREAD_BLOCKS buffers for sorting, the
+  final merge needs two for each run. */
+
+  auto block_size = ROW_MERGE_THREAD_BLOCKS * n_runs * row_merge_block_size();
+  auto block = static_cast<byte *>(os_mem_alloc_large(&block_size));
+  auto merge_files = static_cast<merge_file_t *>(mem_alloc(n_alloc * sizeof(merge_file_t)));
+
+  for (ulint i{}; i < n_files; ++i) {
+    row_merge_file_create(&merge_files[i]);
+  }
 
   /* Read clustered index of the table and create files for
   secondary index entries for merge sort */
 
-  auto err = row_merge_read_clustered_index(trx, table, old_table, new_table, indexes, merge_files, n_indexes, block);
+  db_err err;
+
+  if (n_runs > 1) {
+    err = row_merge_read_clustered_index_parallel(trx, table, old_table, new_table, indexes, merge_files, n_indexes, n_runs, block);
+
+    if (err == DB_OUT_OF_RESOURCES) {
+      log_warn("Resource not available to create threads for the index build. Falling back to single thread mode.");
+
+      for (ulint i{}; i < n_files; ++i) {
+        row_merge_file_destroy(&merge_files[i]);
+      }
+
+      n_runs = 1;
+      n_files = n_indexes;
+
+      for (ulint i{}; i < n_files; ++i) {
+        row_merge_file_create(&merge_files[i]);
+      }
+    }
+  }
+
+  if (n_runs == 1) {
+    err = row_merge_read_clustered_index(trx, table, old_table, new_table, indexes, merge_files, n_indexes, block);
+  }
 
   if (err != DB_SUCCESS) {
 
@@ -1926,26 +3041,17 @@ db_err row_merge_build_indexes(
   /* Now we have files containing index entries ready for
   sorting and inserting. */
 
-  for (ulint i{}; i < n_indexes; ++i) {
-    err = row_merge_sort(trx, indexes[i], &merge_files[i], block, &tmpfd, table);
-
-    if (err == DB_SUCCESS) {
-      err = row_merge_insert_index_tuples(trx, indexes[i], new_table, merge_files[i].fd, block);
-    }
+  err = row_merge_sort_files(trx, indexes, merge_files, n_indexes, n_runs, n_runs, block, table);
 
-    /* Close the temporary file to free up space. */
-    row_merge_file_destroy(&merge_files[i]);
+  if (err != DB_SUCCESS) {
 
-    if (err != DB_SUCCESS) {
-      trx->m_error_key_num = i;
-      goto func_exit;
-    }
+    goto func_exit;
   }
 
-func_exit:
-  close(tmpfd);
+  err = row_merge_insert_indexes(trx, indexes, new_table, merge_files, n_indexes, n_runs, block);
 
-  for (ulint i{}; i < n_indexes; ++i) {
+func_exit:
+  for (ulint i{}; i < n_alloc; ++i) {
     row_merge_file_destroy(&merge_files[i]);
   }
 
@@ -127,7 +127,7 @@ void Parallel_reader::Scan_ctx::index_s_lock() {
   if (m_s_locks.fetch_add(1, std::memory_order_acquire) == 0) {
     auto index = m_config.m_index;
     /* The latch can be unlocked by a thread that didn't originally lock it. */
-    rw_lock_s_lock_gen(index->get_lock(), true);
+    rw_lock_sx_lock_gen(index->get_lock(), true);
   }
 }
 
@@ -135,7 +135,7 @@ void Parallel_reader::Scan_ctx::index_s_unlock() {
   if (m_s_locks.fetch_sub(1, std::memory_order_acquire) == 1) {
     auto index = m_config.m_index;
     /* The latch can be unlocked by a thread that didn't originally lock it. */
-    rw_lock_s_unlock_gen(index->get_lock(), true);
+    rw_lock_sx_unlock_gen(index->get_lock(), true);
   }
 }
 
@@ -627,7 +627,7 @@ dberr_t Parallel_reader::Ctx::traverse_recs(PCursor *pcursor, mtr_t *mtr) {
 
       mem_heap_empty(heap);
 
-      if (!(m_n_pages % TRX_IS_INTERRUPTED_PROBE) && trx()->is_interrupted()) {
+      if (!(m_n_pages % TRX_IS_INTERRUPTED_PROBE) && trx() != nullptr && trx()->is_interrupted()) {
         err = DB_INTERRUPTED;
         break;
       }
@@ -827,7 +827,7 @@ void Parallel_reader::worker(Parallel_reader::Thread_ctx *thread_ctx) {
       }
 
       /* Check for trx interrupted (useful in the case of small tables). */
-      if (err == DB_SUCCESS && ctx->trx()->is_interrupted()) {
+      if (err == DB_SUCCESS && ctx->trx() != nullptr && ctx->trx()->is_interrupted()) {
         err = DB_INTERRUPTED;
         scan_ctx->set_error_state(err);
         break;
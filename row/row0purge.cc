@@ -40,7 +40,6 @@ Created 3/14/1997 Heikki Tuuri
 #include "trx0undo.h"
 
 purge_node_t *row_purge_node_create(que_thr_t *parent, mem_heap_t *heap) {
-  ut_ad(parent);
   ut_ad(heap);
 
   auto ptr = mem_heap_alloc(heap, sizeof(purge_node_t));
@@ -432,17 +431,17 @@ skip_secondaries:
  *
  * @param[in] node          Row undo node.
  * @param[out] updated_extern  True if an externally stored field was updated.
- * @param[in] thr           Query thread.
+ * @param[in] trx           Transaction doing the purge.
  * 
  * @return                  True if purge operation required. NOTE that then the CALLER must unfreeze data dictionary!
  */
-static bool row_purge_parse_undo_rec(purge_node_t *node, bool *updated_extern, que_thr_t *thr) {
+static bool row_purge_parse_undo_rec(purge_node_t *node, bool *updated_extern, Trx *trx) {
   Undo_rec_pars pars;
-  auto trx = thr_get_trx(thr);
 
   auto ptr = trx_undo_rec_get_pars(node->undo_rec, pars);
 
   node->rec_type = pars.m_type;
+  *updated_extern = pars.m_extern;
 
   if (pars.m_type == TRX_UNDO_UPD_DEL_REC && !pars.m_extern) {
 
@@ -507,42 +506,14 @@ static bool row_purge_parse_undo_rec(purge_node_t *node, bool *updated_extern, q
   return true;
 }
 
-/**
- * @brief Fetches an undo log record and performs the purge for the recorded operation.
- *
- * If none left, or the current purge completed, returns the control to the
- * parent node, which is always a query thread node.
- *
- * @param[in] node Row purge node.
- * @param[in] thr Query thread.
- * 
- * @return DB_SUCCESS if operation successfully completed, else error code.
- */
-static ulint row_purge(purge_node_t *node, que_thr_t *thr) {
-  roll_ptr_t roll_ptr;
+void row_purge_rec(purge_node_t *node, Trx *trx) {
   bool purge_needed;
   bool updated_extern;
-  Trx *trx;
-
-  ut_ad(node && thr);
-
-  trx = thr_get_trx(thr);
-
-  node->undo_rec = srv_trx_sys->m_purge->fetch_next_rec(&roll_ptr, &node->reservation, node->heap);
-  if (!node->undo_rec) {
-    /* Purge completed for this query thread */
-
-    thr->run_node = que_node_get_parent(node);
-
-    return DB_SUCCESS;
-  }
-
-  node->roll_ptr = roll_ptr;
 
   if (node->undo_rec == &trx_purge_dummy_rec) {
     purge_needed = false;
   } else {
-    purge_needed = row_purge_parse_undo_rec(node, &updated_extern, thr);
+    purge_needed = row_purge_parse_undo_rec(node, &updated_extern, trx);
     /* If purge_needed == true, we must also remember to unfreeze
     data dictionary! */
   }
@@ -568,6 +539,37 @@ static ulint row_purge(purge_node_t *node, que_thr_t *thr) {
 
     srv_dict_sys->unfreeze_data_dictionary(trx);
   }
+}
+
+/**
+ * @brief Fetches an undo log record and performs the purge for the recorded operation.
+ *
+ * If none left, or the current purge completed, returns the control to the
+ * parent node, which is always a query thread node.
+ *
+ * @param[in] node Row purge node.
+ * @param[in] thr Query thread.
+ * 
+ * @return DB_SUCCESS if operation successfully completed, else error code.
+ */
+static ulint row_purge(purge_node_t *node, que_thr_t *thr) {
+  roll_ptr_t roll_ptr;
+
+  ut_ad(node && thr);
+
+  node->undo_rec = srv_trx_sys->m_purge->fetch_next_rec(&roll_ptr, &node->reservation, node->heap);
+
+  if (!node->undo_rec) {
+    /* Purge completed for this query thread */
+
+    thr->run_node = que_node_get_parent(node);
+
+    return DB_SUCCESS;
+  }
+
+  node->roll_ptr = roll_ptr;
+
+  row_purge_rec(node, thr_get_trx(thr));
 
   /* Do some cleanup */
   srv_trx_sys->m_purge->rec_release(node->reservation);
@@ -1370,6 +1370,15 @@ que_thr_t *Row_update::step(que_thr_t *thr) noexcept {
 
   if (node->m_state == UPD_NODE_SET_IX_LOCK) {
 
+    /* A transaction on the read-only fast path is registered before its
+    first write, lock_table() does it too but it may be skipped below. */
+    err = trx->set_rw_mode();
+
+    if (err != DB_SUCCESS) {
+
+      goto error_handling;
+    }
+
     if (!node->m_has_clust_rec_x_lock) {
       /* It may be that the current session has not yet
       started its transaction, or it has been committed: */
@@ -104,13 +104,13 @@ Trx *Row_vers::impl_x_locked_off_kernel(const rec_t *rec, const Index *index, co
 
   Trx *trx{};
 
-  if (!m_trx_sys->is_active(trx_id)) {
+  if (!m_trx_sys->is_active_off_kernel(trx_id)) {
     /* The transaction that modified or inserted clust_rec is no
     longer active: no implicit lock on rec */
     return func_exit(mtr, heap, nullptr);
   }
 
-  if (!m_lock_sys->check_trx_id_sanity(trx_id, clust_rec, clust_index, clust_offsets, true)) {
+  if (!m_lock_sys->check_trx_id_sanity(trx_id, clust_rec, clust_index, clust_offsets)) {
     /* Corruption noticed: try to avoid a crash by returning */
     return func_exit(mtr, heap, nullptr);
   }
@@ -156,7 +156,7 @@ Trx *Row_vers::impl_x_locked_off_kernel(const rec_t *rec, const Index *index, co
     if (prev_version == nullptr) {
       mutex_enter(&kernel_mutex);
 
-      if (!m_trx_sys->is_active(trx_id)) {
+      if (!m_trx_sys->is_active_off_kernel(trx_id)) {
         /* Transaction no longer active: no implicit x-lock */
 
         break;
@@ -168,7 +168,7 @@ Trx *Row_vers::impl_x_locked_off_kernel(const rec_t *rec, const Index *index, co
 
       /* It was a freshly inserted version: there is an implicit x-lock on rec */
 
-      trx = m_trx_sys->get_on_id(trx_id);
+      trx = m_trx_sys->get_on_id_off_kernel(trx_id);
 
       break;
     }
@@ -206,7 +206,7 @@ Trx *Row_vers::impl_x_locked_off_kernel(const rec_t *rec, const Index *index, co
 
     mutex_enter(&kernel_mutex);
 
-    if (!m_trx_sys->is_active(trx_id)) {
+    if (!m_trx_sys->is_active_off_kernel(trx_id)) {
       /* Transaction no longer active: no implicit x-lock */
 
       break;
@@ -227,7 +227,7 @@ Trx *Row_vers::impl_x_locked_off_kernel(const rec_t *rec, const Index *index, co
       required by prev_version */
 
       if (rec_del != vers_del) {
-        trx = m_trx_sys->get_on_id(trx_id);
+        trx = m_trx_sys->get_on_id_off_kernel(trx_id);
 
         break;
       }
@@ -240,7 +240,7 @@ Trx *Row_vers::impl_x_locked_off_kernel(const rec_t *rec, const Index *index, co
 
       if (cmp_dtuple_rec(index->m_cmp_ctx, entry, rec, offsets) != 0) {
 
-        trx = m_trx_sys->get_on_id(trx_id);
+        trx = m_trx_sys->get_on_id_off_kernel(trx_id);
 
         break;
       }
@@ -249,7 +249,7 @@ Trx *Row_vers::impl_x_locked_off_kernel(const rec_t *rec, const Index *index, co
 
       /* The delete mark should be set in rec for it to be in the state required by prev_version */
 
-      trx = m_trx_sys->get_on_id(trx_id);
+      trx = m_trx_sys->get_on_id_off_kernel(trx_id);
 
       break;
     }
@@ -521,13 +521,14 @@ db_err Row_vers::build_for_semi_consistent_read(Row &row) noexcept {
       rec_trx_id = version_trx_id;
     }
 
-    mutex_enter(&kernel_mutex);
+    m_trx_sys->mutex_acquire();
 
     auto version_trx = m_trx_sys->get_on_id(version_trx_id);
+    const auto committed = version_trx == nullptr || version_trx->m_conc_state == TRX_NOT_STARTED || version_trx->m_conc_state == TRX_COMMITTED_IN_MEMORY;
 
-    mutex_exit(&kernel_mutex);
+    m_trx_sys->mutex_release();
 
-    if (version_trx == nullptr || version_trx->m_conc_state == TRX_NOT_STARTED || version_trx->m_conc_state == TRX_COMMITTED_IN_MEMORY) {
+    if (committed) {
 
       /* We found a version that belongs to a committed transaction: return it. */
 
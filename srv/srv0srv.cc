@@ -63,6 +63,9 @@ Created 10/8/1995 Heikki Tuuri
 #include "ut0mem.h"
 #include "ut0ut.h"
 
+#include <algorithm>
+#include <array>
+
 /* FIXME: When we setup the session variables infrastructure. */
 #define sess_lock_wait_timeout(t) (ses_lock_wait_timeout)
 
@@ -77,10 +80,6 @@ ulint srv_activity_count = 0;
 /** The following is the maximum allowed duration of a lock wait. */
 ulint srv_fatal_semaphore_wait_threshold = 600;
 
-/** How much data manipulation language (DML) statements need to be delayed,
-in microseconds, in order to reduce the lagging of the purge thread. */
-ulint srv_dml_needed_delay = 0;
-
 bool srv_lock_timeout_active = false;
 bool srv_monitor_active = false;
 bool srv_error_monitor_active = false;
@@ -463,6 +462,11 @@ struct srv_slot_t {
 
 /** The server system struct */
 struct srv_sys_t {
+  /** Protects m_threads, m_tasks, srv_n_threads and srv_n_threads_active.
+  Ordered after the kernel mutex, a query thread is enqueued while holding
+  the kernel mutex. */
+  mutex_t m_mutex;
+
   /** Server thread table */
   srv_slot_t *m_threads{};
 
@@ -470,8 +474,98 @@ struct srv_sys_t {
   UT_LIST_BASE_NODE_T(que_thr_t, queue) m_tasks{};
 };
 
-/** Table for client threads where they will be suspended to wait for locks */
-static srv_slot_t *srv_client_table = nullptr;
+/** The deadlines of the suspended lock waits. A hashed timing wheel with
+a tick of one second, the resolution of the lock wait timeout: a wait is
+hooked to the slot of its deadline, and each tick the timeout thread only
+looks at the slot of that second. A wait with a deadline more than one
+turn away stays in its slot until the wheel comes round to it. Protected
+by the kernel mutex. */
+struct Lock_wait_timer_wheel {
+  /** Number of slots, one per second */
+  static constexpr ulint N_SLOTS = 64;
+
+  using Slot = UT_LIST_BASE_NODE_T_EXTERN(Trx, m_lock_wait_timers);
+
+  /**
+   * Adds the lock wait of a transaction to the wheel.
+   * 
+   * @param[in,out] trx	transaction suspended in a lock wait
+   * @param[in] deadline	time when the lock wait times out
+   */
+  void arm(Trx *trx, ib_time_t deadline) noexcept {
+    ut_ad(mutex_own(&kernel_mutex));
+    ut_ad(trx->m_lock_wait_deadline == 0);
+    ut_ad(deadline > 0);
+
+    trx->m_lock_wait_deadline = deadline;
+    m_slots[deadline % N_SLOTS].push_back(trx);
+    ++m_n_armed;
+  }
+
+  /**
+   * Removes the lock wait of a transaction from the wheel, if it is there.
+   * 
+   * @param[in,out] trx	transaction
+   */
+  void disarm(Trx *trx) noexcept {
+    ut_ad(mutex_own(&kernel_mutex));
+
+    if (trx->m_lock_wait_deadline != 0) {
+      m_slots[trx->m_lock_wait_deadline % N_SLOTS].remove(trx);
+      trx->m_lock_wait_deadline = 0;
+      --m_n_armed;
+    }
+  }
+
+  /**
+   * Removes the lock waits whose deadline has passed from the wheel.
+   * 
+   * @param[in] now	current time
+   * @param[in] expire	called for each lock wait that timed out
+   */
+  template <typename F>
+  void advance(ib_time_t now, F &&expire) noexcept {
+    ut_ad(mutex_own(&kernel_mutex));
+
+    if (m_tick == 0 || now < m_tick) {
+      /* First tick, or the system time went backwards */
+      m_tick = now - 1;
+    }
+
+    /* Look at each second passed since the previous tick, but at
+    most one turn of the wheel */
+    const auto n_ticks = std::min<ib_time_t>(now - m_tick, N_SLOTS);
+
+    for (ib_time_t t = now - n_ticks + 1; t <= now; ++t) {
+      auto &slot = m_slots[t % N_SLOTS];
+
+      for (auto trx = slot.front(); trx != nullptr;) {
+        auto next = UT_LIST_GET_NEXT(m_lock_wait_timers, trx);
+
+        if (trx->m_lock_wait_deadline <= now) {
+          disarm(trx);
+          expire(trx);
+        }
+
+        trx = next;
+      }
+    }
+
+    m_tick = now;
+  }
+
+  /** The wheel, deadline % N_SLOTS */
+  std::array<Slot, N_SLOTS> m_slots{};
+
+  /** Time of the previous tick, 0 before the first */
+  ib_time_t m_tick{};
+
+  /** Number of lock waits on the wheel */
+  ulint m_n_armed{};
+};
+
+/** The lock wait timeouts */
+static Lock_wait_timer_wheel srv_lock_wait_timers;
 
 Cond_var* srv_lock_timeout_thread_event;
 
@@ -481,7 +575,8 @@ static srv_sys_t *srv_sys = nullptr;
 the same memory cache line */
 byte srv_pad1[64];
 
-/** Mutex protecting the server, trx structs, query threads, and lock table */
+/** Mutex protecting the lock table and the query threads. The trx system
+and the server thread slots have mutexes of their own. */
 mutex_t *kernel_mutex_temp;
 
 /* padding to prevent other memory update hotspots from residing on the same
@@ -674,7 +769,6 @@ void InnoDB::var_init() noexcept {
   srv_lower_case_table_names = false;
   srv_activity_count = 0;
   srv_fatal_semaphore_wait_threshold = 600;
-  srv_dml_needed_delay = 0;
 
   srv_monitor_active = false;
   srv_lock_timeout_active = false;
@@ -720,7 +814,7 @@ void InnoDB::var_init() noexcept {
 
   srv_start_lsn = 0;
   srv_shutdown_lsn = 0;
-  srv_client_table = nullptr;
+  srv_lock_wait_timers.m_tick = 0;
   srv_lock_timeout_thread_event = nullptr;
   kernel_mutex_temp = nullptr;
 
@@ -747,14 +841,14 @@ static srv_slot_t *srv_table_get_nth_slot(ulint index) {
 ulint srv_get_n_threads() {
   ulint n_threads = 0;
 
-  mutex_enter(&kernel_mutex);
+  mutex_enter(&srv_sys->m_mutex);
 
   for (ulint i = SRV_COM; i < SRV_MASTER + 1; i++) {
 
     n_threads += srv_n_threads[i];
   }
 
-  mutex_exit(&kernel_mutex);
+  mutex_exit(&srv_sys->m_mutex);
 
   return n_threads;
 }
@@ -768,6 +862,7 @@ ulint srv_get_n_threads() {
  * @return reserved slot index
  */
 static ulint srv_table_reserve_slot(srv_thread_type type) {
+  ut_ad(mutex_own(&srv_sys->m_mutex));
   ut_a(type > 0);
   ut_a(type <= SRV_MASTER);
 
@@ -797,7 +892,7 @@ static ulint srv_table_reserve_slot(srv_thread_type type) {
  * @return	event for the calling thread to wait
  */
 static Cond_var* srv_suspend_thread(srv_slot_t *slot) {
-  ut_ad(mutex_own(&kernel_mutex));
+  ut_ad(mutex_own(&srv_sys->m_mutex));
 
   auto type = slot->m_type;
 
@@ -821,7 +916,7 @@ ulint InnoDB::release_threads(srv_thread_type type, ulint n) noexcept {
   ut_ad(type >= SRV_WORKER);
   ut_ad(type <= SRV_MASTER);
   ut_ad(n > 0);
-  ut_ad(mutex_own(&kernel_mutex));
+  ut_ad(mutex_own(&srv_sys->m_mutex));
 
   ulint count = 0;
 
@@ -855,6 +950,8 @@ void InnoDB::init() noexcept {
 
   mutex_create(&kernel_mutex, IF_DEBUG("kernel_mutex",) IF_SYNC_DEBUG(SYNC_KERNEL,) Current_location());
 
+  mutex_create(&srv_sys->m_mutex, IF_DEBUG("srv_sys_mutex",) IF_SYNC_DEBUG(SYNC_SRV_SYS,) Current_location());
+
   mutex_create(&srv_innodb_monitor_mutex, IF_DEBUG("monitor_mutex",) IF_SYNC_DEBUG(SYNC_NO_ORDER_CHECK,) Current_location());
 
   srv_sys->m_threads = static_cast<srv_slot_t *>(mem_alloc(OS_THREAD_MAX_N * sizeof(srv_slot_t)));
@@ -869,17 +966,6 @@ void InnoDB::init() noexcept {
     ut_a(slot->m_event);
   }
 
-  srv_client_table = static_cast<srv_slot_t *>(mem_alloc(OS_THREAD_MAX_N * sizeof(srv_slot_t)));
-
-  slot = srv_client_table;
-
-  for (ulint i = 0; i < OS_THREAD_MAX_N; ++i, ++slot) {
-    slot->m_in_use = false;
-    slot->m_type = SRV_NONE;
-    slot->m_event = os_event_create(nullptr);
-    ut_a(slot->m_event);
-  }
-
   srv_lock_timeout_thread_event = os_event_create(nullptr);
 
   for (ulint i = 0; i < SRV_MASTER + 1; i++) {
@@ -919,13 +1005,11 @@ void InnoDB::free() noexcept {
   mem_free(srv_sys->m_threads);
   srv_sys->m_threads = nullptr;
 
-  mem_free(srv_client_table);
-  srv_client_table = nullptr;
-
   mem_free(srv_conc_slots);
   srv_conc_slots = nullptr;
 
   mutex_free(&srv_innodb_monitor_mutex);
+  mutex_free(&srv_sys->m_mutex);
   mutex_free(&kernel_mutex);
 
   mem_free(kernel_mutex_temp);
@@ -995,62 +1079,6 @@ db_err InnoDB::boot() noexcept {
   return DB_SUCCESS;
 }
 
-/**
- * Reserves a slot in the thread table for the current user OS thread.
- * NOTE! The kernel mutex has to be reserved by the caller!
- * 
- * @return	reserved slot
- */
-static srv_slot_t *srv_table_reserve_slot_for_user_thread() {
-  ut_ad(mutex_own(&kernel_mutex));
-
-  ulint i{};
-  auto slot = srv_client_table + i;
-
-  while (slot->m_in_use) {
-    i++;
-
-    if (i >= OS_THREAD_MAX_N) {
-
-      log_err(std::format(
-        "There appear to be {} user threads currently waiting"
-        " inside InnoDB, which is the upper limit. Cannot continue"
-        " operation. We intentionally generate a seg fault to print"
-        " a stack trace on Linux. But first we print a list of waiting"
-        " threads.",
-        (ulong)i
-      ));
-
-      for (i = 0; i < OS_THREAD_MAX_N; i++) {
-
-        slot = srv_client_table + i;
-
-        log_err(std::format(
-          "Slot {}: thread id {}, type {}, in use {}, susp {}, time {}",
-          i,
-          os_thread_pf(slot->m_id),
-          (ulong) slot->m_type,
-          slot->m_in_use,
-          slot->m_suspended,
-          difftime(ut_time(),slot->m_suspend_time)
-        ));
-      }
-
-      ut_error;
-    }
-
-    slot = srv_client_table + i;
-  }
-
-  ut_a(slot->m_in_use == false);
-
-  slot->m_in_use = true;
-  slot->m_id = os_thread_get_curr_id();
-  slot->m_handle = os_thread_get_curr();
-
-  return slot;
-}
-
 void InnoDB::suspend_user_thread(que_thr_t *thr) noexcept {
   double wait_time;
   ulint had_dict_lock;
@@ -1065,8 +1093,6 @@ void InnoDB::suspend_user_thread(que_thr_t *thr) noexcept {
 
   auto trx = thr_get_trx(thr);
 
-  os_event_set(srv_lock_timeout_thread_event);
-
   mutex_enter(&kernel_mutex);
 
   trx->m_error_state = DB_SUCCESS;
@@ -1091,14 +1117,21 @@ void InnoDB::suspend_user_thread(que_thr_t *thr) noexcept {
 
   ut_ad(thr->is_active == false);
 
-  auto slot = srv_table_reserve_slot_for_user_thread();
-  auto event = slot->m_event;
+  auto event = trx->m_lock_wait_event;
 
-  slot->m_thr = thr;
+  ut_a(trx->m_lock_wait_thr == nullptr);
 
-  os_event_reset(event);
+  trx->m_lock_wait_thr = thr;
+
+  auto sig_count = os_event_reset(event);
 
-  slot->m_suspend_time = ut_time();
+  const auto suspend_time = ut_time();
+
+  /* InnoDB system transactions (such as the purge, and
+  incomplete transactions that are being rolled back after crash
+  recovery) will use the global value of
+  innodb_lock_wait_timeout, because trx->m_client_ctx == nullptr. */
+  lock_wait_timeout = sess_lock_wait_timeout(trx);
 
   if (thr->lock_state == QUE_THR_LOCK_ROW) {
     srv_n_lock_wait_count++;
@@ -1110,9 +1143,19 @@ void InnoDB::suspend_user_thread(que_thr_t *thr) noexcept {
       start_time = (int64_t)sec * 1000000 + ms;
     }
   }
-  /* Wake the lock timeout monitor thread, if it is suspended */
 
-  os_event_set(srv_lock_timeout_thread_event);
+  if (lock_wait_timeout < 100000000) {
+    /* The wait has timed out when more than lock_wait_timeout
+    seconds have passed */
+    srv_lock_wait_timers.arm(trx, suspend_time + lock_wait_timeout + 1);
+
+    if (srv_lock_wait_timers.m_n_armed == 1) {
+      /* Wake the lock timeout monitor thread, it is suspended
+      until there is a wait to time out */
+
+      os_event_set(srv_lock_timeout_thread_event);
+    }
+  }
 
   mutex_exit(&kernel_mutex);
 
@@ -1131,9 +1174,24 @@ void InnoDB::suspend_user_thread(que_thr_t *thr) noexcept {
 
   ut_a(trx->m_dict_operation_lock_mode == 0);
 
-  /* Suspend this thread and wait for the event. */
+  /* Suspend this thread and wait for the event. Wake up once a second
+  to check if the client has interrupted the transaction. */
 
-  os_event_wait(event);
+  while (event->wait_time(std::chrono::seconds(1), sig_count) == OS_SYNC_TIME_EXCEEDED) {
+
+    if (trx->is_interrupted()) {
+      mutex_enter(&kernel_mutex);
+
+      /* It is possible that the lock has already been granted:
+      in that case do nothing */
+
+      if (trx->m_wait_lock != nullptr) {
+        srv_lock_sys->cancel_waiting_and_release(trx->m_wait_lock);
+      }
+
+      mutex_exit(&kernel_mutex);
+    }
+  }
 
   /* After resuming, reacquire the data dictionary latch if
   necessary. */
@@ -1149,11 +1207,11 @@ void InnoDB::suspend_user_thread(que_thr_t *thr) noexcept {
 
   mutex_enter(&kernel_mutex);
 
-  /* Release the slot for others to use */
+  trx->m_lock_wait_thr = nullptr;
 
-  slot->m_in_use = false;
+  srv_lock_wait_timers.disarm(trx);
 
-  wait_time = ut_difftime(ut_time(), slot->m_suspend_time);
+  wait_time = ut_difftime(ut_time(), suspend_time);
 
   if (thr->lock_state == QUE_THR_LOCK_ROW) {
     if (ut_usectime(&sec, &ms) == -1) {
@@ -1183,12 +1241,6 @@ void InnoDB::suspend_user_thread(que_thr_t *thr) noexcept {
 
   mutex_exit(&kernel_mutex);
 
-  /* InnoDB system transactions (such as the purge, and
-  incomplete transactions that are being rolled back after crash
-  recovery) will use the global value of
-  innodb_lock_wait_timeout, because trx->m_client_ctx == nullptr. */
-  lock_wait_timeout = sess_lock_wait_timeout(trx);
-
   if (trx->is_interrupted() || (lock_wait_timeout < 100000000 && wait_time > (double)lock_wait_timeout)) {
 
     trx->m_error_state = DB_LOCK_WAIT_TIMEOUT;
@@ -1198,16 +1250,11 @@ void InnoDB::suspend_user_thread(que_thr_t *thr) noexcept {
 void InnoDB::release_user_thread_if_suspended(que_thr_t *thr) noexcept {
   ut_ad(mutex_own(&kernel_mutex));
 
-  for (ulint i{}; i < OS_THREAD_MAX_N; ++i) {
-
-    auto slot = srv_client_table + i;
-
-    if (slot->m_in_use && slot->m_thr == thr) {
+  auto trx = thr_get_trx(thr);
 
-      os_event_set(slot->m_event);
+  if (trx->m_lock_wait_thr == thr) {
 
-      return;
-    }
+    os_event_set(trx->m_lock_wait_event);
   }
 }
 
@@ -1278,6 +1325,10 @@ bool InnoDB::printf_innodb_monitor(
 
   sync_print(ib_stream);
 
+  if (sync_latch_profile.load(std::memory_order_relaxed)) {
+    sync_latch_profile_print(ib_stream, 20);
+  }
+
 #ifdef WITH_FOREIGN_KEY
   /* Conceptually, srv_innodb_monitor_mutex has a very high latching
   order level in sync0sync.h, while dict_foreign_err_mutex has a very
@@ -1468,6 +1519,12 @@ void InnoDB::export_innodb_status() noexcept {
   export_vars.innodb_rows_updated = srv_n_rows_updated;
   export_vars.innodb_rows_deleted = srv_n_rows_deleted;
 
+  const auto &dml_throttle = srv_trx_sys->m_purge->m_dml_throttle;
+
+  export_vars.innodb_dml_purge_delays = dml_throttle.m_n_delayed.load(std::memory_order_relaxed);
+  export_vars.innodb_dml_purge_delay_time = dml_throttle.m_delay_us.load(std::memory_order_relaxed) / 1000;
+  export_vars.innodb_dml_purge_rate = ulint(dml_throttle.rate());
+
   mutex_exit(&srv_innodb_monitor_mutex);
 }
 
@@ -1607,53 +1664,74 @@ exit_func:
 
 void *InnoDB::lock_timeout_thread(void *) noexcept {
   for (;;) {
-    /* When someone is waiting for a lock, we wake up every second
-    and check if a timeout has passed for a lock wait */
+    auto sig_count = os_event_reset(srv_lock_timeout_thread_event);
+
+    mutex_enter(&kernel_mutex);
+
+    const auto some_waits = srv_lock_wait_timers.m_n_armed > 0;
 
-    os_thread_sleep(1000000);
+    mutex_exit(&kernel_mutex);
+
+    /* When someone is waiting for a lock, we wake up every second, the
+    resolution of the lock wait timeout. Otherwise we sleep until the
+    next wait is put on the timer wheel. */
+
+    if (some_waits) {
+      srv_lock_timeout_thread_event->wait_time(std::chrono::seconds(1), sig_count);
+    } else {
+      os_event_wait_low(srv_lock_timeout_thread_event, sig_count);
+    }
 
     srv_lock_timeout_active = true;
 
     mutex_enter(&kernel_mutex);
 
-    auto some_waits = false;
+    /* Only the waits whose deadline has passed are looked at */
 
-    /* Check of all slots if a thread is waiting there, and if it
-    has exceeded the time limit */
+    srv_lock_wait_timers.advance(ut_time(), [](Trx *trx) {
+      /* Timeout exceeded: cancel the lock request queued by the
+      transaction and release possible other transactions waiting
+      behind; it is possible that the lock has already been granted:
+      in that case do nothing */
 
-    for (ulint i = 0; i < OS_THREAD_MAX_N; i++) {
+      if (trx->m_wait_lock != nullptr) {
+        srv_lock_sys->cancel_waiting_and_release(trx->m_wait_lock);
+      }
+    });
 
-      auto slot = srv_client_table + i;
+    mutex_exit(&kernel_mutex);
 
-      if (slot->m_in_use) {
-        some_waits = true;
-        auto wait_time = ut_difftime(ut_time(), slot->m_suspend_time);
-        auto trx = thr_get_trx(slot->m_thr);
-        auto lock_wait_timeout = sess_lock_wait_timeout(trx);
+    if (srv_shutdown_state >= SRV_SHUTDOWN_CLEANUP) {
+      srv_lock_timeout_active = false;
 
-        if (trx->is_interrupted() ||
-            (lock_wait_timeout < 100000000 &&
-             (wait_time > (double)lock_wait_timeout || wait_time < 0))) {
+      /* We count the number of threads in os_thread_exit(). A created
+      thread should always use that to exit and not use return() to exit. */
 
-          /* Timeout exceeded or a wrap-around in system time counter:
-          cancel the lock request queued by the transaction and release possible
-          other transactions waiting behind; it is possible that the lock has
-          already been granted: in that case do nothing */
-  
-          if (trx->m_wait_lock) {
-            srv_lock_sys->cancel_waiting_and_release(trx->m_wait_lock);
-          }
-        }
-      }
+      os_thread_exit();
+
+      return nullptr;
     }
 
-    os_event_reset(srv_lock_timeout_thread_event);
+    srv_lock_timeout_active = false;
+  }
+}
+
+void *InnoDB::lock_deadlock_thread(void *) noexcept {
+  for (;;) {
+    os_thread_sleep(srv_config.m_deadlock_detect_interval * 1000);
+
+    mutex_enter(&kernel_mutex);
+
+    /* Search from the lock waits enqueued since the previous run */
+    srv_lock_sys->deadlock_detect();
+
+    if (srv_lock_sys->get_schedule() == LOCK_SCHEDULE_CATS) {
+      srv_lock_sys->update_schedule_weights();
+    }
 
     mutex_exit(&kernel_mutex);
 
     if (srv_shutdown_state >= SRV_SHUTDOWN_CLEANUP) {
-      srv_lock_timeout_active = false;
-
       /* We count the number of threads in os_thread_exit(). A created
       thread should always use that to exit and not use return() to exit. */
 
@@ -1661,9 +1739,28 @@ void *InnoDB::lock_timeout_thread(void *) noexcept {
 
       return nullptr;
     }
+  }
+}
 
-    if (!some_waits) {
-      srv_lock_timeout_active = false;
+void *InnoDB::log_flusher_thread(void *) noexcept {
+  for (;;) {
+    log_sys->wait_for_durable_waiters();
+
+    /* A group commit: one log write (+ flush) for all the commits
+    that were registered while the previous one was running */
+    log_sys->complete_durable_waiters();
+
+    if (srv_shutdown_state >= SRV_SHUTDOWN_EXIT_THREADS) {
+      /* Serve the commits that registered during the last pass. */
+      while (log_sys->complete_durable_waiters()) {
+      }
+
+      /* We count the number of threads in os_thread_exit(). A created
+      thread should always use that to exit and not use return() to exit. */
+
+      os_thread_exit();
+
+      return nullptr;
     }
   }
 }
@@ -1705,12 +1802,6 @@ loop:
   /* Update the statistics collected for flush rate policy. */
   srv_buf_pool->m_flusher->stat_update();
 
-  /* In case mutex_exit is not a memory barrier, it is
-  theoretically possible some threads are left waiting though
-  the semaphore is already released. Wake up those threads: */
-
-  sync_arr_wake_threads_if_sema_free();
-
   if (sync_array_print_long_waits()) {
     fatal_cnt++;
     if (fatal_cnt > 10) {
@@ -1749,22 +1840,22 @@ void InnoDB::active_wake_master_thread() noexcept {
 
   if (srv_n_threads_active[SRV_MASTER] == 0) {
 
-    mutex_enter(&kernel_mutex);
+    mutex_enter(&srv_sys->m_mutex);
 
     release_threads(SRV_MASTER, 1);
 
-    mutex_exit(&kernel_mutex);
+    mutex_exit(&srv_sys->m_mutex);
   }
 }
 
 void InnoDB::wake_master_thread() noexcept {
   ++srv_activity_count;
 
-  mutex_enter(&kernel_mutex);
+  mutex_enter(&srv_sys->m_mutex);
 
   release_threads(SRV_MASTER, 1);
 
-  mutex_exit(&kernel_mutex);
+  mutex_exit(&srv_sys->m_mutex);
 }
 
 /**
@@ -1803,26 +1894,26 @@ void *InnoDB::master_thread(void*) noexcept {
 
   srv_main_thread_id = os_thread_pf(os_thread_get_curr_id());
 
-  auto slot_no = srv_table_reserve_slot(SRV_MASTER);
+  mutex_enter(&srv_sys->m_mutex);
 
-  mutex_enter(&kernel_mutex);
+  auto slot_no = srv_table_reserve_slot(SRV_MASTER);
 
   srv_n_threads_active[SRV_MASTER]++;
 
-  mutex_exit(&kernel_mutex);
+  mutex_exit(&srv_sys->m_mutex);
 
 loop:
   /* When there is database activity by users, we cycle in this loop */
 
-  srv_main_thread_op_info = "reserving kernel mutex";
+  srv_main_thread_op_info = "reserving server mutex";
 
   n_ios_very_old = log_sys->m_n_log_ios + srv_buf_pool->m_stat.n_pages_read + srv_buf_pool->m_stat.n_pages_written;
-  mutex_enter(&kernel_mutex);
+  mutex_enter(&srv_sys->m_mutex);
 
   /* Store the user activity counter at the start of this loop */
   old_activity_count = srv_activity_count;
 
-  mutex_exit(&kernel_mutex);
+  mutex_exit(&srv_sys->m_mutex);
 
   if (srv_config.m_force_recovery >= IB_RECOVERY_NO_BACKGROUND) {
 
@@ -1992,19 +2083,19 @@ loop:
     }
   }
 
-  srv_main_thread_op_info = "reserving kernel mutex";
+  srv_main_thread_op_info = "reserving server mutex";
 
-  mutex_enter(&kernel_mutex);
+  mutex_enter(&srv_sys->m_mutex);
 
   /* When there is database activity, we jump from here back to
   the start of loop */
 
   if (srv_activity_count != old_activity_count) {
-    mutex_exit(&kernel_mutex);
+    mutex_exit(&srv_sys->m_mutex);
     goto loop;
   }
 
-  mutex_exit(&kernel_mutex);
+  mutex_exit(&srv_sys->m_mutex);
 
   /* If the database is quiet, we enter the background loop */
 
@@ -2047,25 +2138,25 @@ background_loop:
 
   } while (n_pages_purged);
 
-  srv_main_thread_op_info = "reserving kernel mutex";
+  srv_main_thread_op_info = "reserving server mutex";
 
-  mutex_enter(&kernel_mutex);
+  mutex_enter(&srv_sys->m_mutex);
   if (srv_activity_count != old_activity_count) {
-    mutex_exit(&kernel_mutex);
+    mutex_exit(&srv_sys->m_mutex);
     goto loop;
   }
-  mutex_exit(&kernel_mutex);
+  mutex_exit(&srv_sys->m_mutex);
 
-  srv_main_thread_op_info = "reserving kernel mutex";
+  srv_main_thread_op_info = "reserving server mutex";
 
-  mutex_enter(&kernel_mutex);
+  mutex_enter(&srv_sys->m_mutex);
 
   if (srv_activity_count != old_activity_count) {
-    mutex_exit(&kernel_mutex);
+    mutex_exit(&srv_sys->m_mutex);
     goto loop;
   }
 
-  mutex_exit(&kernel_mutex);
+  mutex_exit(&srv_sys->m_mutex);
 
 flush_loop:
   srv_main_thread_op_info = "flushing buffer pool pages";
@@ -2079,14 +2170,14 @@ flush_loop:
     n_pages_flushed = 0;
   }
 
-  srv_main_thread_op_info = "reserving kernel mutex";
+  srv_main_thread_op_info = "reserving server mutex";
 
-  mutex_enter(&kernel_mutex);
+  mutex_enter(&srv_sys->m_mutex);
   if (srv_activity_count != old_activity_count) {
-    mutex_exit(&kernel_mutex);
+    mutex_exit(&srv_sys->m_mutex);
     goto loop;
   }
-  mutex_exit(&kernel_mutex);
+  mutex_exit(&srv_sys->m_mutex);
 
   srv_main_thread_op_info = "waiting for buffer pool flush to end";
   srv_buf_pool->m_flusher->wait_batch_end(BUF_FLUSH_LIST);
@@ -2112,14 +2203,14 @@ flush_loop:
     goto flush_loop;
   }
 
-  srv_main_thread_op_info = "reserving kernel mutex";
+  srv_main_thread_op_info = "reserving server mutex";
 
-  mutex_enter(&kernel_mutex);
+  mutex_enter(&srv_sys->m_mutex);
   if (srv_activity_count != old_activity_count) {
-    mutex_exit(&kernel_mutex);
+    mutex_exit(&srv_sys->m_mutex);
     goto loop;
   }
-  mutex_exit(&kernel_mutex);
+  mutex_exit(&srv_sys->m_mutex);
 
   /* Keep looping in the background loop if still work to do */
 
@@ -2145,6 +2236,8 @@ flush_loop:
 suspend_thread:
   srv_main_thread_op_info = "suspending";
 
+  /* The drop list is protected by the kernel mutex. Keep it until we are
+  suspended, so that a table added to the list wakes us up. */
   mutex_enter(&kernel_mutex);
 
   if (srv_dict_sys->m_ddl.get_background_drop_list_len() > 0) {
@@ -2153,9 +2246,13 @@ suspend_thread:
     goto loop;
   }
 
+  mutex_enter(&srv_sys->m_mutex);
+
   auto slot = srv_table_get_nth_slot(slot_no);
   event = srv_suspend_thread(slot);
 
+  mutex_exit(&srv_sys->m_mutex);
+
   mutex_exit(&kernel_mutex);
 
   /* DO NOT CHANGE THIS STRING. innobase_start_or_create()
@@ -2183,9 +2280,13 @@ suspend_thread:
 void InnoDB::que_task_enqueue_low(que_thr_t *thr) noexcept {
   ut_ad(mutex_own(&kernel_mutex));
 
+  mutex_enter(&srv_sys->m_mutex);
+
   UT_LIST_ADD_LAST(srv_sys->m_tasks, thr);
 
   release_threads(SRV_WORKER, 1);
+
+  mutex_exit(&srv_sys->m_mutex);
 }
 
 void InnoDB::panic(int panic_ib_error, char *fmt, ...) noexcept {
@@ -113,10 +113,10 @@ SRV_SHUTDOWN_CLEANUP and then to SRV_SHUTDOWN_LAST_PHASE, and so on */
 enum srv_shutdown_state srv_shutdown_state = SRV_SHUTDOWN_NONE;
 
 /** io_handler_thread parameters for thread identification */
-static std::array<ulint, SRV_MAX_N_IO_THREADS + 6> n;
+static std::array<ulint, SRV_MAX_N_IO_THREADS + 7> n;
 
 /** io_handler_thread identifiers */
-static os_thread_id_t thread_ids[SRV_MAX_N_IO_THREADS + 6];
+static os_thread_id_t thread_ids[SRV_MAX_N_IO_THREADS + 7];
 
 
 /** The system data file name. */
@@ -366,6 +366,10 @@ static void srv_startup_abort(db_err err) noexcept {
     srv_fil->close_all_files();
   }
 
+  if (srv_trx_sys != nullptr && srv_trx_sys->m_purge != nullptr) {
+    srv_trx_sys->m_purge->stop_workers();
+  }
+
   srv_threads_shutdown();
 
   log_sys->shutdown();
@@ -518,6 +522,7 @@ ib_err_t InnoDB::start() noexcept {
 
   ut_a(srv_lock_sys == nullptr);
   srv_lock_sys = Lock_sys::create(srv_trx_sys, srv_config.m_lock_table_size);
+  srv_lock_sys->set_schedule(Lock_schedule(srv_config.m_lock_schedule));
 
   ut_a(srv_btree_sys == nullptr);
   srv_btree_sys = Btree::create(srv_lock_sys, srv_fsp, srv_buf_pool);
@@ -891,6 +896,16 @@ ib_err_t InnoDB::start() noexcept {
     recv_recovery_rollback_active();
   }
 
+  if (auto err = srv_trx_sys->create_rsegs(); err != DB_SUCCESS) {
+    srv_startup_abort(err);
+    return DB_ERROR;
+  }
+
+  if (auto err = srv_trx_sys->open_undo_spaces(); err != DB_SUCCESS) {
+    srv_startup_abort(err);
+    return DB_ERROR;
+  }
+
   log_info("Max allowed record size ", page_get_free_space_of_empty() / 2);
 
   /* Create the thread which watches the timeouts for lock waits */
@@ -902,6 +917,12 @@ ib_err_t InnoDB::start() noexcept {
   /* Create the thread which prints InnoDB monitor info */
   os_thread_create(&InnoDB::monitor_thread, nullptr, &thread_ids[4 + SRV_MAX_N_IO_THREADS]);
 
+  /* Create the thread which writes the log for asynchronous commits */
+  os_thread_create(&InnoDB::log_flusher_thread, nullptr, &thread_ids[5 + SRV_MAX_N_IO_THREADS]);
+
+  /* Create the thread which resolves the deadlocks between lock waits */
+  os_thread_create(&InnoDB::lock_deadlock_thread, nullptr, &thread_ids[6 + SRV_MAX_N_IO_THREADS]);
+
   srv_is_being_started = false;
 
   ut_a(err == DB_SUCCESS);
@@ -951,6 +972,9 @@ static bool srv_threads_try_shutdown(Cond_var* lock_timeout_thread_event) noexce
   /* We wake the master thread so that it exits */
   InnoDB::wake_master_thread();
 
+  /* Let the log flusher thread exit */
+  log_sys->wake_durable_flusher();
+
   srv_aio->shutdown();
 
   if (os_thread_count.load(std::memory_order_relaxed) == 0) {
@@ -1024,11 +1048,18 @@ static void srv_prepare_for_shutdown(ib_recovery_t recovery, ib_shutdown_t shutd
     for the 'very fast' shutdown, because the InnoDB layer may have
     committed or prepared transactions and we don't want to lose them. */
 
-    if (srv_trx_sys != nullptr && (srv_trx_sys->m_n_user_trx > 0 || !srv_trx_sys->m_trx_list.empty())) {
+    if (srv_trx_sys != nullptr) {
+      srv_trx_sys->mutex_acquire();
 
-      mutex_exit(&kernel_mutex);
+      const auto trx_left = srv_trx_sys->m_n_user_trx > 0 || !srv_trx_sys->m_trx_list.empty();
 
-      continue;
+      srv_trx_sys->mutex_release();
+
+      if (trx_left) {
+        mutex_exit(&kernel_mutex);
+
+        continue;
+      }
     }
 
     if (shutdown == IB_SHUTDOWN_NO_BUFPOOL_FLUSH) {
@@ -1175,6 +1206,9 @@ db_err InnoDB::shutdown(ib_shutdown_t shutdown) noexcept {
     return DB_SUCCESS;
   }
 
+  /* The master thread is idle, it can't be running a purge batch. */
+  srv_trx_sys->m_purge->stop_workers();
+
   srv_threads_shutdown();
 
   log_sys->shutdown();
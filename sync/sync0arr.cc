@@ -64,20 +64,15 @@ As of 5.0.30 the above mentioned design is changed. Since now OS can
 handle millions of wait events efficiently, we no longer have this concept
 of each cell of wait array having one event.  Instead, now the event that
 a thread wants to wait on is embedded in the wait object (mutex or rw_lock).
-We still keep the global wait array for the sake of diagnostics and also
-to avoid infinite wait The error_monitor thread scans the global wait
-array to signal any waiting threads who have missed the signal. */
 
-/** A cell where an individual thread may wait suspended
-until a resource is released. The suspending is implemented
-using an operating system event semaphore. */
-struct Sync_cell {
-  /** Determines if we can wake up the thread waiting for a sempahore. */
-  bool can_wake_up();
-
-  /** Returns the event that the thread owning the cell waits for. */
-  Cond_var* get_event();
+Nowadays the threads do not wait on an event at all, they park directly on
+a futex word embedded in the mutex or rw_lock (see sync0sync.cc and
+sync0rw.cc), and a release can never miss a parked thread. The wait array
+is therefore no longer on the wait path: only UNIV_SYNC_DEBUG builds reserve
+cells, so that deadlocks can be detected and long waits reported. */
 
+/** A cell that records a thread waiting until a resource is released. */
+struct Sync_cell {
   /** Reports info of a wait array cell.
   @param[in,out] stream         Where to print */
   void print(ib_stream_t ib_stream);
@@ -103,25 +98,13 @@ struct Sync_cell {
   /** thread id of this waiting thread */
   os_thread_id_t m_thread{};
 
-  /** true if the thread has already called sync_array_event_wait on this cell */
+  /** true if the thread has already called sync_array_wait_start on this cell */
   bool m_waiting{};
 
-  /** We capture the signal_count of the m_wait_object when we reset
-  the event. This value is then passed on to os_event_wait and we
-  wait only if the event has not been signalled in the period between
-  the reset and wait call. */
-  int64_t m_signal_count{};
-
   /** time when the thread reserved the wait cell */
   time_t m_reservation_time{};
 };
 
-/* NOTE: It is allowed for a thread to wait
-for an event allocated for the array without owning the
-protecting mutex (depending on the case: OS or database mutex), but
-all changes (set or reset) to the state of the event must be made
-while owning the mutex. */
-
 using Cells = std::vector<Sync_cell>;
 
 /** Synchronization array */
@@ -189,9 +172,6 @@ struct Sync_check {
   prevent infinite recursion in implementation, we fall back to an OS mutex. */
   OS_mutex *m_os_mutex{};
 
-  /** Count of how many times an object has been signalled */
-  std::atomic<ulint> m_sg_count{};
-
   /** Count of cell reservations since creation of the array */
   ulint m_res_count{};
 };
@@ -271,17 +251,6 @@ void sync_array_free(Sync_check *arr) {
   delete arr;
 }
 
-/** Returns the event that the thread owning the cell waits for. */
-Cond_var* Sync_cell::get_event() {
-  if (m_request_type == SYNC_MUTEX) {
-    return reinterpret_cast<mutex_t *>(m_wait_object)->event;
-  } else if (m_request_type == RW_LOCK_WAIT_EX) {
-    return reinterpret_cast<rw_lock_t *>(m_wait_object)->m_wait_ex_event;
-  } else { /* RW_LOCK_SHARED and RW_LOCK_EX wait on the same event */
-    return reinterpret_cast<rw_lock_t *>(m_wait_object)->m_event;
-  }
-}
-
 void sync_array_reserve_cell(Sync_check *arr, void *object, ulint type, const char *file, ulint line, ulint *index) {
   ut_a(index != nullptr);
   ut_a(object != nullptr);
@@ -321,10 +290,6 @@ void sync_array_reserve_cell(Sync_check *arr, void *object, ulint type, const ch
 
     arr->release();
 
-    /* Make sure the event is reset and also store the value of
-    m_signal_count at which the event was reset. */
-    cell.m_signal_count = os_event_reset(cell.get_event());
-
     cell.m_reservation_time = time(nullptr);
 
     cell.m_thread = os_thread_get_curr_id();
@@ -338,7 +303,7 @@ void sync_array_reserve_cell(Sync_check *arr, void *object, ulint type, const ch
   return;
 }
 
-void sync_array_wait_event(Sync_check *arr, ulint index) {
+void sync_array_wait_start(Sync_check *arr, ulint index) {
   arr->acquire();
 
   auto &cell = arr->m_cells[index];
@@ -347,8 +312,6 @@ void sync_array_wait_event(Sync_check *arr, ulint index) {
   ut_a(cell.m_wait_object != nullptr);
   ut_ad(os_thread_get_curr_id() == cell.m_thread);
 
-  auto event = cell.get_event();
-
   cell.m_waiting = true;
 
 #ifdef UNIV_SYNC_DEBUG
@@ -370,10 +333,6 @@ void sync_array_wait_event(Sync_check *arr, ulint index) {
 #endif /* UNIV_SYNC_DEBUG */
 
   arr->release();
-
-  os_event_wait_low(event, cell.m_signal_count);
-
-  sync_array_free_cell(arr, index);
 }
 
 void Sync_cell::print(ib_stream_t ib_stream) {
@@ -395,16 +354,16 @@ void Sync_cell::print(ib_stream_t ib_stream) {
       "Last time reserved in file %s line %lu, "
 #endif /* UNIV_SYNC_DEBUG */
       "waiters flag %lu\n",
-      (void *)mutex, mutex->cfile_name, (ulong)mutex->cline, (ulong)mutex->lock_word,
+      (void *)mutex, mutex->cfile_name, (ulong)mutex->cline, (ulong)mutex->lock_word.load(),
 #ifdef UNIV_SYNC_DEBUG
       mutex->file_name, (ulong)mutex->line,
 #endif /* UNIV_SYNC_DEBUG */
-      (ulong)mutex->m_waiters.load()
+      (ulong)mutex_get_waiters(mutex)
     );
 
-  } else if (type == RW_LOCK_EX || type == RW_LOCK_WAIT_EX || type == RW_LOCK_SHARED) {
+  } else if (type == RW_LOCK_EX || type == RW_LOCK_WAIT_EX || type == RW_LOCK_SX || type == RW_LOCK_SHARED) {
 
-    ib_logger(ib_stream, "%s", type == RW_LOCK_EX ? "X-lock on" : "S-lock on");
+    ib_logger(ib_stream, "%s", type == RW_LOCK_EX ? "X-lock on" : type == RW_LOCK_SX ? "SX-lock on" : "S-lock on");
 
     auto rwlock = m_old_wait_rw_lock;
 
@@ -424,7 +383,7 @@ void Sync_cell::print(ib_stream_t ib_stream) {
       ib_logger(
         ib_stream,
         "a writer (thread id %lu) has reserved it in mode %s",
-        (ulong)thread_id, writer == RW_LOCK_EX ? " exclusive" : " wait exclusive"
+        (ulong)thread_id, writer == RW_LOCK_EX ? " exclusive" : writer == RW_LOCK_SX ? " SX" : " wait exclusive"
       );
     }
 
@@ -544,7 +503,7 @@ bool Sync_check::detect_deadlock(Sync_cell *start, Sync_cell *cell, ulint depth)
     /* No deadlock */
     return false;
 
-  } else if (cell->m_request_type == RW_LOCK_EX || cell->m_request_type == RW_LOCK_WAIT_EX) {
+  } else if (cell->m_request_type == RW_LOCK_EX || cell->m_request_type == RW_LOCK_WAIT_EX || cell->m_request_type == RW_LOCK_SX) {
 
     rw_lock_t *lock = cell->m_wait_object;
 
@@ -552,13 +511,14 @@ bool Sync_check::detect_deadlock(Sync_cell *start, Sync_cell *cell, ulint depth)
 
       auto thread = debug->thread_id;
 
-      if (((debug->lock_type == RW_LOCK_EX) && !os_thread_eq(thread, cell->m_thread)) ||
+      if (((debug->lock_type == RW_LOCK_EX || debug->lock_type == RW_LOCK_SX) && !os_thread_eq(thread, cell->m_thread)) ||
           ((debug->lock_type == RW_LOCK_WAIT_EX) && !os_thread_eq(thread, cell->m_thread)) ||
-	  debug->lock_type == RW_LOCK_SHARED) {
+	  (debug->lock_type == RW_LOCK_SHARED && cell->m_request_type != RW_LOCK_SX)) {
 
         /* The (wait) x-lock request can block infinitely only if someone (can be also cell
-        thread) is holding s-lock, or someone (cannot be cell thread) (wait) x-lock, and
-        he is blocked by start thread */
+        thread) is holding s-lock, or someone (cannot be cell thread) (wait) x-lock or
+        sx-lock, and he is blocked by start thread. An sx-lock request is not blocked
+        by s-locks. */
 
         if (deadlock_step(start, thread, debug->pass, depth)) {
           ib_logger(ib_stream, "rw-lock %p ", (void *)lock);
@@ -605,51 +565,6 @@ bool Sync_check::detect_deadlock(Sync_cell *start, Sync_cell *cell, ulint depth)
 }
 #endif /* UNIV_SYNC_DEBUG */
 
-bool Sync_cell::can_wake_up() {
-  if (m_request_type == SYNC_MUTEX) {
-
-    auto mutex = static_cast<mutex_t *>(m_wait_object);
-
-    if (mutex_get_lock_word(mutex) == 0) {
-
-      return true;
-    }
-
-  } else if (m_request_type == RW_LOCK_EX) {
-
-    auto lock = static_cast<rw_lock_t *>(m_wait_object);
-
-    if (lock->m_lock_word > 0) {
-
-      /* Either unlocked or only read locked. */
-
-      return true;
-    }
-
-  } else if (m_request_type == RW_LOCK_WAIT_EX) {
-
-    auto lock = static_cast<rw_lock_t *>(m_wait_object);
-
-    /* lock_word == 0 means all readers have left */
-    if (lock->m_lock_word == 0) {
-
-      return true;
-    }
-
-  } else if (m_request_type == RW_LOCK_SHARED) {
-
-    auto lock = static_cast<rw_lock_t *>(m_wait_object);
-
-    /* lock_word > 0 means no writer or reserved writer */
-    if (lock->m_lock_word > 0) {
-
-      return true;
-    }
-  }
-
-  return false;
-}
-
 void sync_array_free_cell(Sync_check *arr, ulint index) {
   arr->acquire();
 
@@ -659,7 +574,6 @@ void sync_array_free_cell(Sync_check *arr, ulint index) {
 
   cell.m_waiting = false;
   cell.m_wait_object = nullptr;
-  cell.m_signal_count = 0;
 
   ut_a(arr->m_n_reserved > 0);
   --arr->m_n_reserved;
@@ -667,39 +581,6 @@ void sync_array_free_cell(Sync_check *arr, ulint index) {
   arr->release();
 }
 
-void sync_array_object_signalled(Sync_check *arr) {
-  arr->m_sg_count.fetch_add(1);
-}
-
-void sync_arr_wake_threads_if_sema_free() {
-  auto arr = sync_primary_wait_array;
-
-  arr->acquire();
-
-  ulint i{};
-  ulint count{};
-
-  while (count < arr->m_n_reserved) {
-    auto &cell = arr->m_cells[i];
-
-    ++i;
-
-    if (cell.m_wait_object == nullptr) {
-
-      continue;
-    }
-
-    ++count;
-
-    if (cell.can_wake_up()) {
-
-      os_event_set(cell.get_event());
-    }
-  }
-
-  arr->release();
-}
-
 bool sync_array_print_long_waits() {
   auto arr = sync_primary_wait_array;
 
@@ -748,7 +629,7 @@ bool sync_array_print_long_waits() {
 }
 
 void Sync_check::output_info(ib_stream_t ib_stream) {
-  ib_logger(ib_stream, "OS WAIT ARRAY INFO: reservation count %ld, signal count %ld\n", (long)m_res_count, (long)m_sg_count);
+  ib_logger(ib_stream, "OS WAIT ARRAY INFO: reservation count %ld\n", (long)m_res_count);
 
   ulint i{};
   ulint count{};
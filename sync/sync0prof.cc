@@ -0,0 +1,153 @@
+/** Copyright (c) 2024 Sunny Bains. All rights reserved. */
+
+/** @file sync/sync0prof.cc
+Latch contention profiler. */
+
+#include <algorithm>
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <tuple>
+
+#include "sync0prof.h"
+
+#include "ut0ut.h"
+
+std::atomic<bool> sync_latch_profile{false};
+
+/** Key of a latch site. The file name is compared by value because the
+same __FILE__ may have different addresses in different objects. */
+using Latch_site_key = std::tuple<std::string, ulint, Latch_kind>;
+
+/** All latch sites. The latches can't be used to protect this, they call
+sync_latch_site_get() when they are created. */
+static std::mutex sync_latch_sites_mutex;
+
+/** All latch sites, protected by sync_latch_sites_mutex. */
+static std::map<Latch_site_key, std::unique_ptr<Latch_site>> sync_latch_sites;
+
+void Latch_site::acquired(bool contended, ulint spin_rounds, ulint os_waits, std::chrono::microseconds wait_time) noexcept {
+  m_n_acquires.inc();
+
+  if (contended) {
+    m_n_contended.inc();
+
+    if (spin_rounds > 0) {
+      m_n_spin_rounds.inc(spin_rounds);
+    }
+
+    if (os_waits > 0) {
+      m_n_os_waits.inc(os_waits);
+    }
+
+    if (wait_time.count() > 0) {
+      m_wait_time_us.inc(wait_time.count());
+    }
+  }
+}
+
+Latch_site *sync_latch_site_get(const char *file, ulint line, Latch_kind kind) noexcept {
+  std::lock_guard<std::mutex> lock(sync_latch_sites_mutex);
+
+  auto &site = sync_latch_sites[Latch_site_key{file != nullptr ? file : "", line, kind}];
+
+  if (!site) {
+    site = std::make_unique<Latch_site>();
+    site->m_file = file;
+    site->m_line = line;
+    site->m_kind = kind;
+  }
+
+  return site.get();
+}
+
+std::vector<Latch_site_stats> sync_latch_profile_get(ulint n) noexcept {
+  std::vector<Latch_site_stats> stats;
+
+  {
+    std::lock_guard<std::mutex> lock(sync_latch_sites_mutex);
+
+    for (auto &[key, site] : sync_latch_sites) {
+      const auto n_acquires = site->m_n_acquires.value();
+
+      if (n_acquires == 0) {
+        continue;
+      }
+
+      Latch_site_stats s;
+
+      s.m_file = std::filesystem::path(std::get<0>(key)).filename().string();
+      s.m_line = site->m_line;
+      s.m_kind = site->m_kind;
+      s.m_n_acquires = n_acquires;
+      s.m_n_contended = site->m_n_contended.value();
+      s.m_n_spin_rounds = site->m_n_spin_rounds.value();
+      s.m_n_os_waits = site->m_n_os_waits.value();
+      s.m_wait_time_us = site->m_wait_time_us.value();
+
+      stats.push_back(std::move(s));
+    }
+  }
+
+  auto hotter = [](const Latch_site_stats &lhs, const Latch_site_stats &rhs) {
+    if (lhs.m_wait_time_us != rhs.m_wait_time_us) {
+      return lhs.m_wait_time_us > rhs.m_wait_time_us;
+    } else if (lhs.m_n_contended != rhs.m_n_contended) {
+      return lhs.m_n_contended > rhs.m_n_contended;
+    } else {
+      return lhs.m_n_acquires > rhs.m_n_acquires;
+    }
+  };
+
+  if (n > 0 && n < stats.size()) {
+    std::partial_sort(stats.begin(), stats.begin() + n, stats.end(), hotter);
+    stats.resize(n);
+  } else {
+    std::sort(stats.begin(), stats.end(), hotter);
+  }
+
+  return stats;
+}
+
+void sync_latch_profile_reset() noexcept {
+  std::lock_guard<std::mutex> lock(sync_latch_sites_mutex);
+
+  for (auto &[key, site] : sync_latch_sites) {
+    site->m_n_acquires.clear();
+    site->m_n_contended.clear();
+    site->m_n_spin_rounds.clear();
+    site->m_n_os_waits.clear();
+    site->m_wait_time_us.clear();
+  }
+}
+
+void sync_latch_profile_print(ib_stream_t ib_stream, ulint n) noexcept {
+  const auto stats = sync_latch_profile_get(n);
+
+  ib_logger(
+    ib_stream,
+    "----------------\n"
+    "LATCH CONTENTION\n"
+    "----------------\n"
+  );
+
+  if (!sync_latch_profile.load(std::memory_order_relaxed)) {
+    ib_logger(ib_stream, "Latch profiling is off\n");
+  }
+
+  for (const auto &s : stats) {
+    ib_logger(
+      ib_stream,
+      "%s %s:%lu acquires %llu, contended %llu, spin rounds %llu, OS waits %llu, waited %llu us\n",
+      s.m_kind == LATCH_KIND_MUTEX ? "mutex" : "rw-lock",
+      s.m_file.c_str(),
+      (ulong)s.m_line,
+      (unsigned long long)s.m_n_acquires,
+      (unsigned long long)s.m_n_contended,
+      (unsigned long long)s.m_n_spin_rounds,
+      (unsigned long long)s.m_n_os_waits,
+      (unsigned long long)s.m_wait_time_us
+    );
+  }
+}
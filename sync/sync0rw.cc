@@ -40,23 +40,41 @@ Created 9/11/1995 Heikki Tuuri
         IMPLEMENTATION OF THE RW_LOCK
         =============================
 The status of a rw_lock is held in lock_word. The initial value of lock_word is
-X_LOCK_DECR. lock_word is decremented by 1 for each s-lock and by X_LOCK_DECR
-for each x-lock. This describes the lock state for each value of lock_word:
+X_LOCK_DECR. lock_word is decremented by 1 for each s-lock, by X_LOCK_HALF_DECR
+for the first sx-lock and by X_LOCK_DECR for the first x-lock. An sx-lock
+excludes other sx- and x-lockers but lets readers in; its holder can upgrade
+to an x-lock, which then only has to wait for the readers to exit. This
+describes the lock state for each value of lock_word:
 
 lock_word == X_LOCK_DECR:      Unlocked.
-0 < lock_word < X_LOCK_DECR:   Read locked, no waiting writers.
+X_LOCK_HALF_DECR < lock_word < X_LOCK_DECR:
+                               Read locked, no waiting writers.
                                (X_LOCK_DECR - lock_word) is the
                                number of readers that hold the lock.
+lock_word == X_LOCK_HALF_DECR: Sx locked, no readers.
+0 < lock_word < X_LOCK_HALF_DECR:
+                               Sx locked, with readers.
+                               (X_LOCK_HALF_DECR - lock_word) is the
+                               number of readers that hold the lock.
 lock_word == 0:		       Write locked
--X_LOCK_DECR < lock_word < 0:  Read locked, with a waiting writer.
+-X_LOCK_HALF_DECR < lock_word < 0:
+                               Read locked, with a waiting writer.
                                (-lock_word) is the number of readers
                                that hold the lock.
-lock_word <= -X_LOCK_DECR:     Recursively write locked. lock_word has been
-                               decremented by X_LOCK_DECR once for each lock,
-                               so the number of locks is:
-                               ((-lock_word) / X_LOCK_DECR) + 1
-When lock_word <= -X_LOCK_DECR, we also know that lock_word % X_LOCK_DECR == 0:
-other values of lock_word are invalid.
+lock_word == -X_LOCK_HALF_DECR: Write locked and sx locked by the same
+                               thread.
+-X_LOCK_DECR < lock_word < -X_LOCK_HALF_DECR:
+                               Sx locked and read locked, the sx holder
+                               waits to upgrade to a write lock.
+                               -(lock_word + X_LOCK_HALF_DECR) is the
+                               number of readers that hold the lock.
+lock_word <= -X_LOCK_DECR:     Recursively write locked, possibly also sx
+                               locked. The second x-lock decrements
+                               lock_word by X_LOCK_DECR, the others by 1,
+                               see rw_lock_get_x_lock_count().
+
+Sx-locks of the same thread are counted in sx_recursive: only the first
+one changes lock_word.
 
 The lock_word is always read and updated atomically and consistently, so that
 it always represents the state of the lock, and the state of the lock changes
@@ -69,7 +87,8 @@ writer_thread readable by all threads, but only writeable by the x-lock holder.
 The other members of the lock obey the following rules to remain consistent:
 
 recursive:	This and the writer_thread field together control the
-                behaviour of recursive x-locking.
+                behaviour of recursive x-locking and sx-locking. An
+                sx-lock holder is treated like an x-lock holder below.
                 lock->m_recursive must be false in following states:
                         1) The writer_thread contains garbage i.e.: the
                         lock has just been initialized.
@@ -98,15 +117,15 @@ waiters:	May be set to 1 anytime, but to avoid unnecessary wake-up
                 waiting on event. Must be 1 when a writer starts waiting to
                 ensure the current x-locking thread sends a wake-up signal
                 during unlock. May only be reset to 0 immediately before a
-                a wake-up signal is sent to event. On most platforms, a
+                a wake-up signal is sent to wake_seq. On most platforms, a
                 memory barrier is required after waiters is set, and before
                 verifying lock_word is still held, to ensure some unlocker
                 really does see the flags new value.
-event:		Threads wait on event for read or writer lock when another
-                thread has an x-lock or an x-lock reservation (wait_ex). A
-                thread may only	wait on event after performing the following
-                actions in order:
-                   (1) Record the counter value of event (with os_event_reset).
+wake_seq:	Threads park on this futex word for read or writer lock when
+                another thread has an x-lock or an x-lock reservation
+                (wait_ex). A thread may only wait on wake_seq after
+                performing the following actions in order:
+                   (1) Record the value of wake_seq.
                    (2) Set waiters to 1.
                    (3) Verify lock_word <= 0.
                 (1) must come before (2) to ensure signal is not missed.
@@ -115,11 +134,13 @@ event:		Threads wait on event for read or writer lock when another
                 Immediately before sending the wake-up signal, we should:
                    (1) Verify lock_word == X_LOCK_DECR (unlocked)
                    (2) Reset waiters to 0.
-wait_ex_event:	A thread may only wait on the wait_ex_event after it has
+                The signal increments wake_seq, so a thread that recorded
+                the old value either sees the new one and does not sleep,
+                or is woken up by the futex wake that follows.
+wait_ex_seq:	A thread may only wait on the wait_ex_seq after it has
                 performed the following actions in order:
                    (1) Decrement lock_word by X_LOCK_DECR.
-                   (2) Record counter value of wait_ex_event (os_event_reset,
-                       called from sync_array_reserve_cell).
+                   (2) Record the value of wait_ex_seq.
                    (3) Verify that lock_word < 0.
                 (1) must come first to ensures no other threads become reader
                 or next writer, and notifies unlocker that signal must be sent.
@@ -250,8 +271,10 @@ void rw_lock_create_func(
   lock->m_last_x_file_name = "not yet reserved";
   lock->m_last_s_line = 0;
   lock->m_last_x_line = 0;
-  lock->m_event = os_event_create(nullptr);
-  lock->m_wait_ex_event = os_event_create(nullptr);
+  lock->m_wake_seq = 0;
+  lock->m_wait_ex_seq = 0;
+  lock->m_sx_recursive = 0;
+  lock->m_site = sync_latch_site_get(cfile_name, cline, LATCH_KIND_RW_LOCK);
 
   mutex_enter(&rw_lock_list_mutex);
 
@@ -271,9 +294,6 @@ void rw_lock_free(rw_lock_t *lock) {
   lock->m_magic_n = 0;
 
   mutex_enter(&rw_lock_list_mutex);
-  os_event_free(lock->m_event);
-
-  os_event_free(lock->m_wait_ex_event);
 
   if (UT_LIST_GET_PREV(list, lock)) {
     ut_a(UT_LIST_GET_PREV(list, lock)->m_magic_n == RW_LOCK_MAGIC_N);
@@ -296,18 +316,51 @@ bool rw_lock_validate(rw_lock_t *lock) {
 
   ut_a(lock->m_magic_n == RW_LOCK_MAGIC_N);
   ut_a(waiters == 0 || waiters == 1);
-  ut_a(lock_word > -X_LOCK_DECR || (-lock_word) % X_LOCK_DECR == 0);
+  ut_a(lock_word <= X_LOCK_DECR);
 
   return true;
 }
 #endif /* UNIV_DEBUG */
 
+/** Parks the calling thread on a futex word of the lock until the word
+no longer holds the value sampled before the lock_word re-check.
+@param[in,out] lock             Lock being waited for.
+@param[in,out] seq              Futex word, m_wake_seq or m_wait_ex_seq.
+@param[in] sig                  Value of seq sampled by the caller.
+@param[in] type                 Lock type requested, for diagnostics.
+@param[in] file_name            File name where lock requested
+@param[in] line                 Line where requested */
+static void rw_lock_park(rw_lock_t *lock, std::atomic<uint32_t> &seq, uint32_t sig, ulint type, const char *file_name, ulint line) {
+#ifdef UNIV_SYNC_DEBUG
+  ulint index; /* index of the reserved wait cell */
+
+  sync_array_reserve_cell(sync_primary_wait_array, lock, type, file_name, line, &index);
+  sync_array_wait_start(sync_primary_wait_array, index);
+#else
+  UT_NOT_USED(lock);
+  UT_NOT_USED(type);
+  UT_NOT_USED(file_name);
+  UT_NOT_USED(line);
+#endif /* UNIV_SYNC_DEBUG */
+
+  os_thread_set_parked(true);
+  seq.wait(sig);
+  os_thread_set_parked(false);
+
+#ifdef UNIV_SYNC_DEBUG
+  sync_array_free_cell(sync_primary_wait_array, index);
+#endif /* UNIV_SYNC_DEBUG */
+}
+
 void rw_lock_s_lock_spin(rw_lock_t *lock, ulint pass, const char *file_name, ulint line) {
   ulint i{};
-  ulint index; /* index of the reserved wait cell */
 
   ut_ad(rw_lock_validate(lock));
 
+  Latch_wait wait{lock->m_site};
+
+  wait.contended();
+
   rw_s_spin_wait_count++; /*!< Count calls to this function */
 lock_loop:
 
@@ -337,6 +390,8 @@ lock_loop:
     );
   }
 
+  wait.spun(i);
+
   /* We try once again to obtain the lock */
   if (true == rw_lock_s_lock_low(lock, pass, file_name, line)) {
     rw_s_spin_round_count += i;
@@ -350,14 +405,13 @@ lock_loop:
 
     rw_s_spin_round_count += i;
 
-    sync_array_reserve_cell(sync_primary_wait_array, lock, RW_LOCK_SHARED, file_name, line, &index);
+    const auto sig = lock->m_wake_seq.load();
 
     /* Set waiters before checking lock_word to ensure wake-up
     signal is sent. This may lead to some unnecessary signals. */
     rw_lock_set_waiter_flag(lock);
 
     if (true == rw_lock_s_lock_low(lock, pass, file_name, line)) {
-      sync_array_free_cell(sync_primary_wait_array, index);
       return; /* Success */
     }
 
@@ -376,8 +430,9 @@ lock_loop:
     /* these stats may not be accurate */
     lock->m_count_os_wait++;
     rw_s_os_wait_count++;
+    wait.parked();
 
-    sync_array_wait_event(sync_primary_wait_array, index);
+    rw_lock_park(lock, lock->m_wake_seq, sig, RW_LOCK_SHARED, file_name, line);
 
     i = 0;
     goto lock_loop;
@@ -395,21 +450,28 @@ The caller must have already decremented lock_word by X_LOCK_DECR.
 @param[in] lock                 Select the next writer waiting on this lock.
 @param[in] pass                 Value; != 0, if the lock will be passed
                                 to another thread to unlock
+@param[in] threshold            Value of lock_word when there are no
+                                readers: 0, or -X_LOCK_HALF_DECR if the
+                                caller also holds an sx-lock.
 @param[in] file_name            File name where lock requested
-@param[in] line                 Line where requested */
+@param[in] line                 Line where requested
+@param[in,out] wait             Contention accounting of the acquisition */
 inline void rw_lock_x_lock_wait(
   rw_lock_t *lock,
 #ifdef UNIV_SYNC_DEBUG
   ulint pass,
 #endif /* UNIV_SYNC_DEBUG */
-  const char *file_name, ulint line
+  lint threshold, const char *file_name, ulint line, Latch_wait &wait
 ) {
-  ulint index;
   ulint i = 0;
 
-  ut_ad(lock->m_lock_word <= 0);
+  ut_ad(lock->m_lock_word <= threshold);
 
-  while (lock->m_lock_word < 0) {
+  if (lock->m_lock_word < threshold) {
+    wait.contended();
+  }
+
+  while (lock->m_lock_word < threshold) {
     if (srv_spin_wait_delay) {
       ut_delay(ut_rnd_interval(0, srv_spin_wait_delay));
     }
@@ -421,17 +483,19 @@ inline void rw_lock_x_lock_wait(
 
     /* If there is still a reader, then go to sleep.*/
     rw_x_spin_round_count += i;
+    wait.spun(i);
 
     i = 0;
 
-    sync_array_reserve_cell(sync_primary_wait_array, lock, RW_LOCK_WAIT_EX, file_name, line, &index);
+    const auto sig = lock->m_wait_ex_seq.load();
 
     /* Check lock_word to ensure wake-up isn't missed.*/
-    if (lock->m_lock_word < 0) {
+    if (lock->m_lock_word < threshold) {
 
       /* These stats may not be accurate */
       ++rw_x_os_wait_count;
       ++lock->m_count_os_wait;
+      wait.parked();
 
       /* Add debug info as it is needed to detect possible
       deadlock. We must add info for WAIT_EX thread for
@@ -440,19 +504,19 @@ inline void rw_lock_x_lock_wait(
       rw_lock_add_debug_info(lock, pass, RW_LOCK_WAIT_EX, file_name, line);
 #endif /* UNIV_SYNC_DEBUG */
 
-      sync_array_wait_event(sync_primary_wait_array, index);
+      rw_lock_park(lock, lock->m_wait_ex_seq, sig, RW_LOCK_WAIT_EX, file_name, line);
+
 #ifdef UNIV_SYNC_DEBUG
       rw_lock_remove_debug_info(lock, pass, RW_LOCK_WAIT_EX);
 #endif /* UNIV_SYNC_DEBUG */
 
-      /* It is possible to wake when lock_word < 0.
+      /* It is possible to wake when lock_word < threshold.
       We must pass the while-loop check to proceed.*/
-    } else {
-      sync_array_free_cell(sync_primary_wait_array, index);
     }
   }
 
   rw_x_spin_round_count += i;
+  wait.spun(i);
 }
 
 /** Low-level function for acquiring an exclusive lock.
@@ -461,9 +525,10 @@ inline void rw_lock_x_lock_wait(
                            another thread to unlock
 @param[in] file_name       File name where lock requested
 @param[in] line            Line in filen_ame where requested
+@param[in,out] wait        Contention accounting of the acquisition
 @return	RW_LOCK_NOT_LOCKED if did not succeed, RW_LOCK_EX if success. */
-inline bool rw_lock_x_lock_low(rw_lock_t *lock, ulint pass, const char *file_name, ulint line) {
-  if (rw_lock_lock_word_decr(lock, X_LOCK_DECR)) {
+inline bool rw_lock_x_lock_low(rw_lock_t *lock, ulint pass, const char *file_name, ulint line, Latch_wait &wait) {
+  if (rw_lock_lock_word_decr(lock, X_LOCK_DECR, X_LOCK_HALF_DECR)) {
 
     /* lock->m_recursive also tells us if the writer_thread
     field is stale or active. As we are going to write
@@ -479,15 +544,37 @@ inline bool rw_lock_x_lock_low(rw_lock_t *lock, ulint pass, const char *file_nam
 #ifdef UNIV_SYNC_DEBUG
       pass,
 #endif /* UNIV_SYNC_DEBUG */
+      0,
       file_name,
-      line
+      line,
+      wait
     );
 
   } else {
     /* Decrement failed: relock or failed lock */
     if (!pass && lock->m_recursive && lock->m_writer_thread.load() == std::this_thread::get_id()) {
-      /* Relock */
-      lock->m_lock_word -= X_LOCK_DECR;
+      /* The existing x- or sx-lock is ours. Other threads can still
+      take and release s-locks. */
+      if (rw_lock_lock_word_decr(lock, X_LOCK_DECR, 0)) {
+        /* We hold only sx-locks: upgrade, wait for the readers to exit. */
+        rw_lock_x_lock_wait(
+          lock,
+#ifdef UNIV_SYNC_DEBUG
+          pass,
+#endif /* UNIV_SYNC_DEBUG */
+          -X_LOCK_HALF_DECR,
+          file_name,
+          line,
+          wait
+        );
+      } else if (lock->m_lock_word == 0 || lock->m_lock_word == -X_LOCK_HALF_DECR) {
+        /* Relock, the second x-lock */
+        lock->m_lock_word -= X_LOCK_DECR;
+      } else {
+        /* Relock, there are two or more x-locks */
+        ut_ad(lock->m_lock_word <= -X_LOCK_DECR);
+        --lock->m_lock_word;
+      }
     } else {
       /* Another thread locked before us */
       return false;
@@ -505,29 +592,33 @@ inline bool rw_lock_x_lock_low(rw_lock_t *lock, ulint pass, const char *file_nam
 
 void rw_lock_x_lock_func(rw_lock_t *lock, ulint pass, const char *file_name, ulint line) {
   ulint i;
-  ulint index;
   bool spinning{false};
 
   ut_ad(rw_lock_validate(lock));
 
+  Latch_wait wait{lock->m_site};
+
   i = 0;
 
 lock_loop:
 
-  if (rw_lock_x_lock_low(lock, pass, file_name, line)) {
+  if (rw_lock_x_lock_low(lock, pass, file_name, line, wait)) {
     rw_x_spin_round_count += i;
+    wait.spun(i);
 
     return; /* Locking succeeded */
 
   } else {
 
+    wait.contended();
+
     if (!spinning) {
       spinning = true;
       rw_x_spin_wait_count++;
     }
 
     /* Spin waiting for the lock_word to become free */
-    while (i < SYNC_SPIN_ROUNDS && lock->m_lock_word <= 0) {
+    while (i < SYNC_SPIN_ROUNDS && lock->m_lock_word <= X_LOCK_HALF_DECR) {
       if (srv_spin_wait_delay) {
         ut_delay(ut_rnd_interval(0, srv_spin_wait_delay));
       }
@@ -542,6 +633,7 @@ lock_loop:
   }
 
   rw_x_spin_round_count += i;
+  wait.spun(i);
 
   if (srv_print_latch_waits) {
     ib_logger(
@@ -556,14 +648,13 @@ lock_loop:
     );
   }
 
-  sync_array_reserve_cell(sync_primary_wait_array, lock, RW_LOCK_EX, file_name, line, &index);
+  const auto sig = lock->m_wake_seq.load();
 
   /* Waiters must be set before checking lock_word, to ensure signal
   is sent. This could lead to a few unnecessary wake-up signals. */
   rw_lock_set_waiter_flag(lock);
 
-  if (rw_lock_x_lock_low(lock, pass, file_name, line)) {
-    sync_array_free_cell(sync_primary_wait_array, index);
+  if (rw_lock_x_lock_low(lock, pass, file_name, line, wait)) {
     return; /* Locking succeeded */
   }
 
@@ -582,8 +673,140 @@ lock_loop:
   /* these stats may not be accurate */
   lock->m_count_os_wait++;
   rw_x_os_wait_count++;
+  wait.parked();
 
-  sync_array_wait_event(sync_primary_wait_array, index);
+  rw_lock_park(lock, lock->m_wake_seq, sig, RW_LOCK_EX, file_name, line);
+
+  i = 0;
+  goto lock_loop;
+}
+
+/** Low-level function for acquiring a shared-exclusive lock.
+@param[in,out] lock        Lock instance on which to acquire an sx-lock
+@param[in] pass            Value; != 0, if the lock will be passed to
+                           another thread to unlock
+@param[in] file_name       File name where lock requested
+@param[in] line            Line in file_name where requested
+@return	true if success */
+inline bool rw_lock_sx_lock_low(rw_lock_t *lock, ulint pass, const char *file_name, ulint line) {
+  if (rw_lock_lock_word_decr(lock, X_LOCK_HALF_DECR, X_LOCK_HALF_DECR)) {
+
+    /* See rw_lock_x_lock_low(), the writer_thread field is stale. */
+    ut_a(!lock->m_recursive);
+
+    /* Decrement occurred: we are the sx-lock owner. */
+    rw_lock_set_writer_id_and_recursion_flag(lock, pass ? false : true);
+
+    lock->m_sx_recursive = 1;
+
+  } else if (!pass && lock->m_recursive && lock->m_writer_thread.load() == std::this_thread::get_id()) {
+    /* Relock: we own an x- or sx-lock. Only the first sx-lock changes
+    lock_word, and if we get here without an sx-lock we must hold an
+    x-lock, so no other thread can modify lock_word. */
+    if (lock->m_sx_recursive++ == 0) {
+      ut_ad(lock->m_lock_word == 0 || (lock->m_lock_word <= -X_LOCK_DECR && lock->m_lock_word > -(X_LOCK_DECR + X_LOCK_HALF_DECR)));
+
+      lock->m_lock_word -= X_LOCK_HALF_DECR;
+    }
+
+  } else {
+    /* Another thread locked before us */
+    return false;
+  }
+
+#ifdef UNIV_SYNC_DEBUG
+  rw_lock_add_debug_info(lock, pass, RW_LOCK_SX, file_name, line);
+#endif /* UNIV_SYNC_DEBUG */
+
+  lock->m_last_x_file_name = file_name;
+  lock->m_last_x_line = (unsigned int)line;
+
+  return true;
+}
+
+void rw_lock_sx_lock_func(rw_lock_t *lock, ulint pass, const char *file_name, ulint line) {
+  ulint i{};
+  bool spinning{false};
+
+  ut_ad(rw_lock_validate(lock));
+
+  Latch_wait wait{lock->m_site};
+
+lock_loop:
+  if (rw_lock_sx_lock_low(lock, pass, file_name, line)) {
+    rw_x_spin_round_count += i;
+    wait.spun(i);
+
+    return; /* Locking succeeded */
+
+  } else {
+
+    wait.contended();
+
+    if (!spinning) {
+      spinning = true;
+      rw_x_spin_wait_count++;
+    }
+
+    /* Spin waiting for the other writer to exit */
+    while (i < SYNC_SPIN_ROUNDS && lock->m_lock_word <= X_LOCK_HALF_DECR) {
+      if (srv_spin_wait_delay) {
+        ut_delay(ut_rnd_interval(0, srv_spin_wait_delay));
+      }
+
+      i++;
+    }
+    if (i == SYNC_SPIN_ROUNDS) {
+      os_thread_yield();
+    } else {
+      goto lock_loop;
+    }
+  }
+
+  rw_x_spin_round_count += i;
+  wait.spun(i);
+
+  if (srv_print_latch_waits) {
+    ib_logger(
+      ib_stream,
+      "Thread %lu spin wait rw-sx-lock at %p"
+      " cfile %s cline %lu rnds %lu\n",
+      os_thread_pf(os_thread_get_curr_id()),
+      (void *)lock,
+      lock->m_cfile_name,
+      (ulong)lock->m_cline,
+      (ulong)i
+    );
+  }
+
+  const auto sig = lock->m_wake_seq.load();
+
+  /* Waiters must be set before checking lock_word, to ensure signal
+  is sent. This could lead to a few unnecessary wake-up signals. */
+  rw_lock_set_waiter_flag(lock);
+
+  if (rw_lock_sx_lock_low(lock, pass, file_name, line)) {
+    return; /* Locking succeeded */
+  }
+
+  if (srv_print_latch_waits) {
+    ib_logger(
+      ib_stream,
+      "Thread %lu OS wait for rw-sx-lock at %p"
+      " cfile %s cline %lu\n",
+      os_thread_pf(os_thread_get_curr_id()),
+      (void *)lock,
+      lock->m_cfile_name,
+      (ulong)lock->m_cline
+    );
+  }
+
+  /* these stats may not be accurate */
+  lock->m_count_os_wait++;
+  rw_x_os_wait_count++;
+  wait.parked();
+
+  rw_lock_park(lock, lock->m_wake_seq, sig, RW_LOCK_SX, file_name, line);
 
   i = 0;
   goto lock_loop;
@@ -711,6 +934,10 @@ bool rw_lock_is_locked(rw_lock_t *lock, ulint lock_type) {
     if (rw_lock_get_writer(lock) == RW_LOCK_EX) {
       ret = true;
     }
+  } else if (lock_type == RW_LOCK_SX) {
+    if (rw_lock_get_sx_lock_count(lock) > 0) {
+      ret = true;
+    }
   } else {
     ut_error;
   }
@@ -801,6 +1028,8 @@ void rw_lock_debug_print(rw_lock_debug_t *info) {
     ib_logger(ib_stream, "S-LOCK");
   } else if (rwt == RW_LOCK_EX) {
     ib_logger(ib_stream, "X-LOCK");
+  } else if (rwt == RW_LOCK_SX) {
+    ib_logger(ib_stream, "SX-LOCK");
   } else if (rwt == RW_LOCK_WAIT_EX) {
     ib_logger(ib_stream, "WAIT X-LOCK");
   } else {
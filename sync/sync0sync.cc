@@ -29,6 +29,8 @@ Mutex, the basic synchronization primitive
 Created 9/5/1995 Heikki Tuuri
 *******************************************************/
 
+#include <algorithm>
+
 #include "sync0sync.h"
 
 #include "buf0buf.h"
@@ -108,56 +110,27 @@ perform numerous test-and-set instructions, because they generate memory
 traffic between the cache and the main memory. The read loop can just access
 the cache, saving bus bandwidth.
 
-If we cannot acquire the mutex lock in the specified time, we reserve a cell
-in the wait array, set the m_waiters byte in the mutex to 1. To avoid a race
-condition, after setting the m_waiters byte and before suspending the waiting
-thread, we still have to check that the mutex is reserved, because it may
-have happened that the thread which was holding the mutex has just released
-it and did not see the m_waiters byte set to 1, a case which would lead the
-other thread to an infinite wait.
-
-LEMMA 1: After a thread resets the event of a mutex (or rw_lock), some
-=======
-thread will eventually call os_event_set() on that particular event.
-Thus no infinite wait is possible in this case.
-
-Proof:	After making the reservation the thread sets the m_waiters field in the
-mutex to 1. Then it checks that the mutex is still reserved by some thread,
-or it reserves the mutex for itself. In any case, some thread (which may be
-also some earlier thread, not necessarily the one currently holding the mutex)
-will set the m_waiters field to 0 in mutex_exit, and then call
-os_event_set() with the mutex as an argument.
-Q.E.D.
-
-LEMMA 2: If an os_event_set() call is made after some thread has called
-=======
-the os_event_reset() and before it starts wait on that event, the call
-will not be lost to the second thread. This is true even if there is an
-intervening call to os_event_reset() by another thread.
-Thus no infinite wait is possible in this case.
-
-Proof (non-windows platforms): os_event_reset() returns a monotonically
-increasing value of signal_count. This value is increased at every
-call of os_event_set() If thread A has called os_event_reset() followed
-by thread B calling os_event_set() and then some other thread C calling
-os_event_reset(), the is_set flag of the event will be set to false;
-but now if thread A calls os_event_wait_low() with the signal_count
-value returned from the earlier call of os_event_reset(), it will
-return immediately without waiting.
-Q.E.D.
-
-Proof (windows): If there is a writer thread which is forced to wait for
-the lock, it may be able to set the state of rw_lock to RW_LOCK_WAIT_EX
-The design of rw_lock ensures that there is one and only one thread
-that is able to change the state to RW_LOCK_WAIT_EX and this thread is
-guaranteed to acquire the lock after it is released by the current
-holders and before any other waiter gets the lock.
-On windows this thread waits on a separate event i.e.: wait_ex_event.
-Since only one thread can wait on this event there is no chance
-of this event getting reset before the writer starts wait on it.
-Therefore, this thread is guaranteed to catch the os_set_event()
-signalled unconditionally at the release of the lock.
-Q.E.D. */
+If we cannot acquire the mutex lock in the specified time, we park the thread
+on the lock word itself, using the three state protocol described by Ulrich
+Drepper in "Futexes Are Tricky": 0 means unlocked, 1 locked and 2 locked with
+(possible) waiters. A thread that gives up spinning atomically exchanges 2 into
+the lock word. If the previous value was 0 it now owns the mutex, otherwise it
+waits on the lock word for as long as it still reads 2. With std::atomic wait
+and notify this is a futex(FUTEX_WAIT) keyed by the address of the lock word
+on Linux, the kernel re-checks the value under its own hash bucket lock before
+putting the thread to sleep.
+
+mutex_exit() exchanges 0 into the lock word and, only if the previous value
+was 2, wakes up one parked thread. The woken thread exchanges 2 into the lock
+word again, so if there are more waiters the next release will wake one of
+them too. Because the release and the read of the waiter state are a single
+atomic operation, and the kernel compares the lock word before sleeping, a
+wakeup cannot be lost: an uncontended release costs no system call and a
+contended one exactly one.
+
+The global wait array is not involved in the wait. In UNIV_SYNC_DEBUG builds
+a waiting thread still reserves a cell there, for the deadlock detector and
+for the long semaphore wait diagnostics. */
 
 /* Number of spin waits on mutexes: for performance monitoring */
 
@@ -242,11 +215,15 @@ void sync_var_init() {
 void mutex_create(mutex_t *mutex, IF_DEBUG(const char *cmutex_name, ) IF_SYNC_DEBUG(ulint level, ) Source_location loc) {
   new (mutex) mutex_t;
 
-  mutex->init();
-
   IF_SYNC_DEBUG(mutex->file_name = "not yet reserved"; mutex->level = level;)
 
-  IF_SYNC_DEBUG(mutex->cfile_name = cfile_name; mutex->cline = cline;)
+  mutex->cfile_name = loc.m_from.file_name();
+  mutex->cline = loc.m_from.line();
+  mutex->m_site = sync_latch_site_get(mutex->cfile_name, mutex->cline, LATCH_KIND_MUTEX);
+
+  /* Start with the full spin budget, the mutex learns a shorter one
+  once it has seen how long it is held. */
+  mutex->m_spin_avg.store(uint32_t(SYNC_SPIN_ROUNDS / 2 * MUTEX_SPIN_AVG_SCALE), std::memory_order_relaxed);
 
   ut_d(mutex->cmutex_name = cmutex_name);
 
@@ -270,11 +247,6 @@ void mutex_create(mutex_t *mutex, IF_DEBUG(const char *cmutex_name, ) IF_SYNC_DE
 }
 
 static void mutex_destroy(mutex_t *mutex) noexcept {
-  if (mutex->event != nullptr) {
-    os_event_free(mutex->event);
-    mutex->event = nullptr;
-  }
-
   /* If we free the mutex protecting the mutex list (freeing is
   necessary), we have to reset the magic number AFTER removing
   it from the list. */
@@ -284,8 +256,7 @@ static void mutex_destroy(mutex_t *mutex) noexcept {
 
 void mutex_free(mutex_t *mutex) {
   ut_ad(mutex_validate(mutex));
-  ut_a(mutex_get_lock_word(mutex) == 0);
-  ut_a(mutex_get_waiters(mutex) == 0);
+  ut_a(mutex_get_lock_word(mutex) == MUTEX_UNLOCKED);
 
   if (mutex != &mutex_list_mutex IF_SYNC_DEBUG(&&mutex != &sync_thread_mutex)) {
     mutex_enter(&mutex_list_mutex);
@@ -306,6 +277,8 @@ ulint mutex_enter_nowait_func(mutex_t *mutex IF_SYNC_DEBUG(, const char *file_na
 
   if (!mutex_test_and_set(mutex)) {
 
+    mutex_set_owner(mutex);
+    sync_latch_acquired(mutex->m_site);
     ut_d(mutex->thread_id = os_thread_get_curr_id());
     IF_SYNC_DEBUG(mutex_set_debug_info(mutex, file_name, line);)
 
@@ -326,129 +299,146 @@ bool mutex_validate(const mutex_t *mutex) {
 bool mutex_own(const mutex_t *mutex) {
   ut_ad(mutex_validate(mutex));
 
-  return mutex_get_lock_word(mutex) == 1 &&
+  return mutex_get_lock_word(mutex) != MUTEX_UNLOCKED &&
          os_thread_eq(mutex->thread_id, os_thread_get_curr_id());
 }
 #endif /* UNIV_DEBUG */
 
-void mutex_set_waiters(mutex_t *mutex, ulint n) {
-  mutex->m_waiters.store(n);
+/** Updates the spin statistics of a mutex after a thread spun for it.
+The updates are racy, a lost update only delays the learning a little.
+@param[in,out] mutex            Mutex that was spun on.
+@param[in] acquired             true if spinning got the mutex.
+@param[in] rounds               Number of spin rounds. */
+static void mutex_spin_update_stats(mutex_t *mutex, bool acquired, ulint rounds) noexcept {
+  const auto success = mutex->m_spin_success.load(std::memory_order_relaxed);
+  const auto target = acquired ? MUTEX_SPIN_SUCCESS_MAX : 0;
+
+  mutex->m_spin_success.store(success - success / 16 + target / 16, std::memory_order_relaxed);
+
+  if (acquired) {
+    const int64_t avg = mutex->m_spin_avg.load(std::memory_order_relaxed);
+    const int64_t sample = rounds * MUTEX_SPIN_AVG_SCALE;
+
+    mutex->m_spin_avg.store(uint32_t(avg + (sample - avg) / 8), std::memory_order_relaxed);
+  }
 }
 
-void mutex_spin_wait(mutex_t *mutex, const char *file_name, ulint line) {
-  ulint i;     /* spin round count */
-  ulint index; /* index of the reserved wait cell */
+/** Returns the number of rounds to spin for a mutex before parking.
+@param[in] mutex                Mutex to spin on.
+@return	spin rounds, at most SYNC_SPIN_ROUNDS */
+static ulint mutex_spin_limit(const mutex_t *mutex) noexcept {
+  ulint limit;
+
+  if (ut_rnd_interval(0, MUTEX_SPIN_PROBE_INTERVAL - 1) == 0) {
+    /* Only the spins that succeed within the limit feed the average.
+    Once in a while spin for the full budget, so that the limit can
+    grow again when the mutex is held longer than it used to be. */
+    limit = SYNC_SPIN_ROUNDS;
+  } else if (mutex->m_spin_success.load(std::memory_order_relaxed) < MUTEX_SPIN_SUCCESS_MAX / 8) {
+    /* Spinning rarely pays off for this mutex, only probe briefly so
+    that we notice if the hold times get shorter again. */
+    limit = SYNC_SPIN_MIN_ROUNDS;
+  } else {
+    /* Spin for about twice as long as it typically takes. */
+    limit = 2 * mutex->m_spin_avg.load(std::memory_order_relaxed) / MUTEX_SPIN_AVG_SCALE + SYNC_SPIN_MIN_ROUNDS;
+  }
+
+  return std::min<ulint>(limit, SYNC_SPIN_ROUNDS);
+}
 
+void mutex_spin_wait(mutex_t *mutex, const char *file_name, ulint line) {
   /* This update is not thread safe, but we don't mind if the count
   isn't exact. Moved out of ifdef that follows because we are willing
   to sacrifice the cost of counting this as the data is valuable.
   Count the number of calls to mutex_spin_wait. */
   mutex_spin_wait_count.inc(1);
 
-mutex_loop:
-
-  i = 0;
-
-  /* Spin waiting for the lock word to become zero. Note that we do
-  not have to assume that the read access to the lock word is atomic,
-  as the actual locking is always committed with atomic test-and-set.
-  In reality, however, all processors probably have an atomic read of
-  a memory word. */
-
-spin_loop:
   ut_d(mutex->count_spin_loop++);
 
-  while (mutex_get_lock_word(mutex) != 0 && i < SYNC_SPIN_ROUNDS) {
-    if (srv_spin_wait_delay) {
-      ut_delay(ut_rnd_interval(0, srv_spin_wait_delay));
+  ulint i{};
+  ulint delay{1};
+  bool acquired{};
+  bool owner_parked{};
+  const auto limit = mutex_spin_limit(mutex);
+  Latch_wait wait{mutex->m_site};
+
+  wait.contended();
+
+  /* Spin waiting for the lock word to become zero. It is wise to just
+  read the word in the loop and only try the atomic operation when it
+  looks free. The delay between the reads is doubled every round up to
+  srv_spin_wait_delay, so that many spinners do not keep hammering the
+  cache line. */
+  while (i < limit) {
+    if (mutex_get_lock_word(mutex) == MUTEX_UNLOCKED) {
+      if (mutex_test_and_set(mutex) == 0) {
+        acquired = true;
+        break;
+      }
+    } else if (os_thread_is_parked(mutex->m_owner_slot.load(std::memory_order_relaxed))) {
+      /* The owner is blocked in the OS, it will not release
+      the mutex within a spin. */
+      owner_parked = true;
+      break;
     }
 
-    i++;
-  }
+    if (srv_spin_wait_delay) {
+      ut_delay(ut_rnd_interval(0, delay));
+      delay = std::min<ulint>(delay * 2, srv_spin_wait_delay);
+    }
 
-  if (i == SYNC_SPIN_ROUNDS) {
-    ut_d(mutex->count_os_yield++);
-    os_thread_yield();
+    ++i;
   }
 
   mutex_spin_round_count.inc(i);
+  wait.spun(i);
 
   ut_d(mutex->count_spin_rounds += i);
 
-  if (mutex_test_and_set(mutex) == 0) {
-    /* Succeeded! */
+  if (!owner_parked) {
+    mutex_spin_update_stats(mutex, acquired, i);
+  }
 
+  if (acquired) {
+    mutex_set_owner(mutex);
     ut_d(mutex->thread_id = os_thread_get_curr_id());
     IF_SYNC_DEBUG(mutex_set_debug_info(mutex, file_name, line));
 
-    goto finish_timing;
+    return;
   }
 
-  /* We may end up with a situation where lock_word is 0 but the OS
-  fast mutex is still reserved. On FreeBSD the OS does not seem to
-  schedule a thread which is constantly calling pthread_mutex_trylock
-  (in mutex_test_and_set implementation). Then we could end up
-  spinning here indefinitely. The following 'i++' stops this infinite
-  spin. */
-
-  i++;
-
-  if (i < SYNC_SPIN_ROUNDS) {
-    goto spin_loop;
-  }
+#ifdef UNIV_SYNC_DEBUG
+  ulint index; /* index of the reserved wait cell */
 
   sync_array_reserve_cell(sync_primary_wait_array, mutex, SYNC_MUTEX, file_name, line, &index);
+  sync_array_wait_start(sync_primary_wait_array, index);
+#endif /* UNIV_SYNC_DEBUG */
 
-  /* The memory order of the array reservation and the change in the
-  m_waiters field is important: when we suspend a thread, we first
-  reserve the cell and then set m_waiters field to 1. When threads are
-  released in mutex_exit, the m_waiters field is first set to zero and
-  then the event is set to the signaled state. */
-
-  mutex_set_waiters(mutex, 1);
-
-  /* Try to reserve still a few times */
-  for (i = 0; i < 4; i++) {
-    if (mutex_test_and_set(mutex) == 0) {
-      /* Succeeded! Free the reserved wait cell */
-
-      sync_array_free_cell(sync_primary_wait_array, index);
-
-      ut_d(mutex->thread_id = os_thread_get_curr_id());
-
-      IF_SYNC_DEBUG(mutex_set_debug_info(mutex, file_name, line);)
+  /* Announce ourselves as a waiter. If the mutex was released meanwhile
+  we now own it, in the contended state: that costs at most one spurious
+  wakeup in mutex_exit(). */
+  while (mutex->lock_word.exchange(MUTEX_LOCKED_WAITERS) != MUTEX_UNLOCKED) {
+    mutex_os_wait_count.inc(1);
 
-      goto finish_timing;
+    mutex->count_os_wait++;
+    wait.parked();
 
-      /* Note that in this case we leave the m_waiters field
-      set to 1. We cannot reset it to zero, as we do not
-      know if there are other m_waiters. */
-    }
+    os_thread_set_parked(true);
+    mutex->lock_word.wait(MUTEX_LOCKED_WAITERS);
+    os_thread_set_parked(false);
   }
 
-  /* Now we know that there has been some thread holding the mutex
-  after the change in the wait array and the m_waiters field was made.
-  Now there is no risk of infinite wait on the event. */
-
-  mutex_os_wait_count.inc(1);
-
-  mutex->count_os_wait++;
-
-  sync_array_wait_event(sync_primary_wait_array, index);
-  goto mutex_loop;
-
-finish_timing:
+#ifdef UNIV_SYNC_DEBUG
+  sync_array_free_cell(sync_primary_wait_array, index);
+#endif /* UNIV_SYNC_DEBUG */
 
-  return;
+  mutex_set_owner(mutex);
+  ut_d(mutex->thread_id = os_thread_get_curr_id());
+  IF_SYNC_DEBUG(mutex_set_debug_info(mutex, file_name, line);)
 }
 
 void mutex_signal_object(mutex_t *mutex) {
-  mutex_set_waiters(mutex, 0);
-
-  /* The memory order of resetting the m_waiters field and
-  signaling the object is important. See LEMMA 1 above. */
-  os_event_set(mutex->event);
-  sync_array_object_signalled(sync_primary_wait_array);
+  mutex->lock_word.notify_one();
 }
 
 #ifdef UNIV_SYNC_DEBUG
@@ -861,12 +851,15 @@ void sync_thread_add_level(void *latch, ulint level) {
     case SYNC_THR_LOCAL:
     case SYNC_ANY_LATCH:
     case SYNC_TRX_SYS_HEADER:
+    case SYNC_SRV_SYS:
     case SYNC_FILE_FORMAT_TAG:
     case SYNC_DOUBLEWRITE:
     case SYNC_BUF_POOL:
     case SYNC_SEARCH_SYS:
     case SYNC_SEARCH_SYS_CONF:
     case SYNC_TRX_LOCK_HEAP:
+    case SYNC_TRX_SYS:
+    case SYNC_READ_VIEW:
     case SYNC_KERNEL:
     case SYNC_RSEG:
     case SYNC_TRX_UNDO:
@@ -1040,6 +1033,8 @@ void sync_init() {
 
   sync_initialized = true;
 
+  ut_delay_calibrate();
+
   /* Create the primary system wait array which is protected by an OS
   mutex */
 
@@ -0,0 +1,297 @@
+/***************************************************************************
+Copyright (c) 2024 Sunny Bains. All rights reserved.
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; version 2 of the License.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+
+************************************************************************/
+
+/* Scan an index while concurrent inserts split its leaf pages.
+
+ Create a database
+ CREATE TABLE t(c1 INT, c2 INT, c3 VARCHAR(256), PK(c1), KEY(c2));
+
+ In N_INSERTERS threads, thread i:
+   INSERT INTO t VALUES(k, -k, <random text>), k = i, i + N_INSERTERS, ...;
+   COMMIT every BATCH_SIZE rows
+
+ In N_SCANNERS threads, until the inserters are done:
+   SELECT c1 FROM t;               -- ascending, at least the committed rows
+   SELECT c2 FROM t FORCE INDEX(c2); -- ascending, at least the committed rows
+   SELECT * FROM t WHERE c1 = k;   -- for a committed k, must be found
+
+ The keys of the inserters interleave, so that the leaf splits happen all
+ over both indexes, mostly without the tree latch. Every row is checked to
+ be there at the end. */
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "test0aux.h"
+
+#define DATABASE "test"
+#define TABLE "t"
+
+/** Number of inserting threads. */
+static const int N_INSERTERS = 4;
+
+/** Number of scanning threads. */
+static const int N_SCANNERS = 4;
+
+/** Number of rows inserted by each thread. */
+static const int N_ROWS = 20000;
+
+/** Number of rows inserted per transaction. */
+static const int BATCH_SIZE = 100;
+
+/** Number of rows committed by all the inserters. */
+static std::atomic<int> n_committed;
+
+/** Number of the inserters that are done. */
+static std::atomic<int> n_done;
+
+/** Highest committed key of each inserter, -1 if none. */
+static std::atomic<int> max_committed[N_INSERTERS];
+
+/** CREATE TABLE t(c1 INT, c2 INT, c3 VARCHAR(256), PK(c1), KEY(c2)); */
+static void create_table() {
+  ib_id_t table_id = 0;
+  ib_tbl_sch_t ib_tbl_sch = nullptr;
+  ib_idx_sch_t ib_idx_sch = nullptr;
+
+  OK(ib_table_schema_create(DATABASE "/" TABLE, &ib_tbl_sch, IB_TBL_V1, 0));
+  OK(ib_table_schema_add_col(ib_tbl_sch, "c1", IB_INT, IB_COL_NONE, 0, 4));
+  OK(ib_table_schema_add_col(ib_tbl_sch, "c2", IB_INT, IB_COL_NONE, 0, 4));
+  OK(ib_table_schema_add_col(ib_tbl_sch, "c3", IB_VARCHAR, IB_COL_NONE, 0, 256));
+
+  OK(ib_table_schema_add_index(ib_tbl_sch, "PRIMARY", &ib_idx_sch));
+  OK(ib_index_schema_add_col(ib_idx_sch, "c1", 0));
+  OK(ib_index_schema_set_clustered(ib_idx_sch));
+
+  OK(ib_table_schema_add_index(ib_tbl_sch, "c2", &ib_idx_sch));
+  OK(ib_index_schema_add_col(ib_idx_sch, "c2", 0));
+
+  auto ib_trx = ib_trx_begin(IB_TRX_REPEATABLE_READ);
+
+  OK(ib_schema_lock_exclusive(ib_trx));
+  OK(ib_table_create(ib_trx, ib_tbl_sch, &table_id));
+  OK(ib_trx_commit(ib_trx));
+
+  ib_table_schema_delete(ib_tbl_sch);
+}
+
+/** Inserts the rows of one thread.
+@param[in] i                    Thread number. */
+static void inserter(int i) {
+  char text[256];
+  int k = i;
+
+  for (int n = 0; n < N_ROWS; n += BATCH_SIZE) {
+    ib_crsr_t crsr;
+    auto ib_trx = ib_trx_begin(IB_TRX_REPEATABLE_READ);
+
+    OK(ib_cursor_open_table(DATABASE "/" TABLE, ib_trx, &crsr));
+    OK(ib_cursor_lock(crsr, IB_LOCK_IX));
+
+    auto tpl = ib_clust_read_tuple_create(crsr);
+    assert(tpl != nullptr);
+
+    for (int j = 0; j < BATCH_SIZE; ++j, k += N_INSERTERS) {
+      auto len = gen_rand_text(text, sizeof(text));
+
+      OK(ib_tuple_write_i32(tpl, 0, k));
+      OK(ib_tuple_write_i32(tpl, 1, -k));
+      OK(ib_col_set_value(tpl, 2, text, len));
+      OK(ib_cursor_insert_row(crsr, tpl));
+
+      tpl = ib_tuple_clear(tpl);
+      assert(tpl != nullptr);
+    }
+
+    ib_tuple_delete(tpl);
+
+    OK(ib_cursor_close(crsr));
+    OK(ib_trx_commit(ib_trx));
+
+    max_committed[i] = k - N_INSERTERS;
+    n_committed += BATCH_SIZE;
+  }
+
+  ++n_done;
+}
+
+/** Scans an index in ascending order and checks the order of the keys.
+@param[in] crsr                 Cursor on the index.
+@param[in] clust                true if crsr is on the clustered index.
+@return the number of rows. */
+static int scan(ib_crsr_t crsr, bool clust) {
+  int n_rows{};
+  int32_t prev{};
+  auto tpl = clust ? ib_clust_read_tuple_create(crsr) : ib_sec_read_tuple_create(crsr);
+  assert(tpl != nullptr);
+
+  auto err = ib_cursor_first(crsr);
+
+  while (err == DB_SUCCESS) {
+    int32_t key;
+
+    OK(ib_cursor_read_row(crsr, tpl));
+    /* c1 in the clustered index, c2 in the secondary index */
+    OK(ib_tuple_read_i32(tpl, 0, &key));
+
+    assert(n_rows == 0 || key > prev);
+
+    prev = key;
+    ++n_rows;
+
+    err = ib_cursor_next(crsr);
+  }
+
+  assert(err == DB_END_OF_INDEX || err == DB_RECORD_NOT_FOUND);
+
+  ib_tuple_delete(tpl);
+
+  return n_rows;
+}
+
+/** SELECT * FROM t WHERE c1 = key; must find the row.
+@param[in] crsr                 Cursor on the clustered index.
+@param[in] key                  Committed key. */
+static void lookup(ib_crsr_t crsr, int key) {
+  int res;
+  auto key_tpl = ib_clust_search_tuple_create(crsr);
+  assert(key_tpl != nullptr);
+
+  OK(ib_tuple_write_i32(key_tpl, 0, key));
+  OK(ib_cursor_moveto(crsr, key_tpl, IB_CUR_GE, &res));
+  assert(res == 0);
+
+  ib_tuple_delete(key_tpl);
+}
+
+/** Scans both indexes and looks up committed rows until the inserters are
+done.
+@param[in] i                    Thread number. */
+static void scanner(int i) {
+  int n_scans{};
+
+  while (n_done < N_INSERTERS) {
+    ib_crsr_t crsr;
+    ib_crsr_t sec_crsr;
+
+    /* Rows committed before the scan starts must all be seen. */
+    const auto n_min = n_committed.load();
+    auto ib_trx = ib_trx_begin(IB_TRX_READ_COMMITTED);
+
+    OK(ib_cursor_open_table(DATABASE "/" TABLE, ib_trx, &crsr));
+
+    const auto n_rows = scan(crsr, true);
+    assert(n_rows >= n_min);
+
+    OK(ib_cursor_open_index_using_name(crsr, "c2", &sec_crsr));
+
+    const auto n_sec_rows = scan(sec_crsr, false);
+    assert(n_sec_rows >= n_min);
+
+    OK(ib_cursor_close(sec_crsr));
+
+    for (int j = 0; j < N_INSERTERS; ++j) {
+      const auto key = max_committed[j].load();
+
+      if (key >= 0) {
+        lookup(crsr, key);
+      }
+    }
+
+    OK(ib_cursor_close(crsr));
+    OK(ib_trx_commit(ib_trx));
+
+    ++n_scans;
+  }
+
+  printf("Scanner#%d - %d scans\n", i, n_scans);
+}
+
+/** Checks that every row is in both indexes. */
+static void check_rows() {
+  ib_crsr_t crsr;
+  ib_crsr_t sec_crsr;
+  auto ib_trx = ib_trx_begin(IB_TRX_REPEATABLE_READ);
+
+  OK(ib_cursor_open_table(DATABASE "/" TABLE, ib_trx, &crsr));
+
+  const auto n_rows = scan(crsr, true);
+  assert(n_rows == N_INSERTERS * N_ROWS);
+
+  OK(ib_cursor_open_index_using_name(crsr, "c2", &sec_crsr));
+
+  const auto n_sec_rows = scan(sec_crsr, false);
+  assert(n_sec_rows == N_INSERTERS * N_ROWS);
+
+  OK(ib_cursor_close(sec_crsr));
+
+  for (int k = 0; k < N_INSERTERS * N_ROWS; k += 997) {
+    lookup(crsr, k);
+  }
+
+  OK(ib_cursor_close(crsr));
+  OK(ib_trx_commit(ib_trx));
+}
+
+int main(int argc, char *argv[]) {
+  (void)argc;
+  (void)argv;
+
+  OK(ib_init());
+
+  test_configure();
+
+  OK(ib_startup("default"));
+
+  auto success = ib_database_create(DATABASE);
+  assert(success);
+
+  create_table();
+
+  for (auto &key : max_committed) {
+    key = -1;
+  }
+
+  std::vector<std::thread> threads;
+
+  for (int i = 0; i < N_INSERTERS; ++i) {
+    threads.emplace_back(inserter, i);
+  }
+
+  for (int i = 0; i < N_SCANNERS; ++i) {
+    threads.emplace_back(scanner, i);
+  }
+
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  check_rows();
+
+  OK(drop_table(DATABASE, TABLE));
+
+  OK(ib_shutdown(IB_SHUTDOWN_NORMAL));
+
+  return EXIT_SUCCESS;
+}
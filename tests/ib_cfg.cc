@@ -33,6 +33,7 @@ static void get_all() {
     "checksums",
     "data_file_path",
     "data_home_dir",
+    "deadlock_detect_interval",
     "doublewrite",
     "file_format",
     "file_io_threads",
@@ -40,6 +41,11 @@ static void get_all() {
     "flush_log_at_trx_commit",
     "flush_method",
     "force_recovery",
+    "index_build_memory",
+    "index_build_threads",
+    "index_fill_factor",
+    "latch_profile",
+    "lock_schedule",
     "lock_wait_timeout",
     "log_buffer_size",
     "log_file_size",
@@ -52,10 +58,17 @@ static void get_all() {
     "open_files",
     "pre_rollback_hook",
     "print_verbose_log",
+    "purge_batch_size",
+    "purge_threads",
     "rollback_on_timeout",
+    "rollback_segments",
+    "sort_block_size",
     "stats_sample_pages",
     "status_file",
     "sync_spin_loops",
+    "trx_auto_read_only",
+    "undo_tablespace_max_size",
+    "undo_tablespaces",
     "version",
     nullptr};
 
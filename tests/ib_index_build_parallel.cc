@@ -0,0 +1,237 @@
+/***************************************************************************
+Copyright (c) 2024 Sunny Bains. All rights reserved.
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; version 2 of the License.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+
+************************************************************************/
+
+/* Build indexes with several scan and sort threads.
+
+ Create a database
+ CREATE TABLE t(c1 INT, c2 INT, c3 INT, c4 VARCHAR(255), PK(c1));
+ INSERT INTO t VALUES(k, k, k, <random text>), k in [0, N_ROWS - 1);
+ INSERT INTO t VALUES(N_ROWS - 1, N_ROWS - 1, 0, <random text>);
+
+ SET index_build_threads = N_THREADS;
+
+ CREATE UNIQUE INDEX c2 ON t(c2);  -- succeeds, c2 is ascending
+ CREATE UNIQUE INDEX c3 ON t(c3);  -- DB_DUPLICATE_KEY, the first and the
+                                   -- last row are read by different threads
+ CREATE INDEX c4 ON t(c4);         -- the file of each thread has many
+                                   -- blocks, they are merged in several
+                                   -- passes before the final merge */
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "test0aux.h"
+
+#define DATABASE "test"
+#define TABLE "t"
+
+/** Number of rows in the table. */
+static const int N_ROWS = 200000;
+
+/** Number of rows inserted per transaction. */
+static const int BATCH_SIZE = 1000;
+
+/** Number of threads that build an index. */
+static const int N_THREADS = 4;
+
+/** CREATE TABLE t(c1 INT, c2 INT, c3 INT, c4 VARCHAR(255), PK(c1)); */
+static void create_table() {
+  ib_id_t table_id = 0;
+  ib_tbl_sch_t ib_tbl_sch = nullptr;
+  ib_idx_sch_t ib_idx_sch = nullptr;
+
+  OK(ib_table_schema_create(DATABASE "/" TABLE, &ib_tbl_sch, IB_TBL_V1, 0));
+  OK(ib_table_schema_add_col(ib_tbl_sch, "c1", IB_INT, IB_COL_NONE, 0, 4));
+  OK(ib_table_schema_add_col(ib_tbl_sch, "c2", IB_INT, IB_COL_NONE, 0, 4));
+  OK(ib_table_schema_add_col(ib_tbl_sch, "c3", IB_INT, IB_COL_NONE, 0, 4));
+  OK(ib_table_schema_add_col(ib_tbl_sch, "c4", IB_VARCHAR, IB_COL_NONE, 0, 255));
+
+  OK(ib_table_schema_add_index(ib_tbl_sch, "PRIMARY", &ib_idx_sch));
+  OK(ib_index_schema_add_col(ib_idx_sch, "c1", 0));
+  OK(ib_index_schema_set_clustered(ib_idx_sch));
+
+  auto ib_trx = ib_trx_begin(IB_TRX_REPEATABLE_READ);
+
+  OK(ib_schema_lock_exclusive(ib_trx));
+  OK(ib_table_create(ib_trx, ib_tbl_sch, &table_id));
+  OK(ib_trx_commit(ib_trx));
+
+  ib_table_schema_delete(ib_tbl_sch);
+}
+
+/** INSERT INTO t VALUES(k, k, k, <random text>), the last row has c3 = 0. */
+static void insert_rows() {
+  char text[255];
+
+  for (int k = 0; k < N_ROWS;) {
+    ib_crsr_t crsr;
+    auto ib_trx = ib_trx_begin(IB_TRX_REPEATABLE_READ);
+
+    OK(ib_cursor_open_table(DATABASE "/" TABLE, ib_trx, &crsr));
+    OK(ib_cursor_lock(crsr, IB_LOCK_IX));
+
+    auto tpl = ib_clust_read_tuple_create(crsr);
+    assert(tpl != nullptr);
+
+    for (int j = 0; j < BATCH_SIZE; ++j, ++k) {
+      auto len = gen_rand_text(text, sizeof(text));
+
+      OK(ib_tuple_write_i32(tpl, 0, k));
+      OK(ib_tuple_write_i32(tpl, 1, k));
+      OK(ib_tuple_write_i32(tpl, 2, k == N_ROWS - 1 ? 0 : k));
+      OK(ib_col_set_value(tpl, 3, text, len));
+      OK(ib_cursor_insert_row(crsr, tpl));
+
+      tpl = ib_tuple_clear(tpl);
+      assert(tpl != nullptr);
+    }
+
+    ib_tuple_delete(tpl);
+
+    OK(ib_cursor_close(crsr));
+    OK(ib_trx_commit(ib_trx));
+  }
+}
+
+/** CREATE [UNIQUE] INDEX name ON t(name);
+@param[in] name                 Name of the index and of its column.
+@param[in] unique               true for a unique index.
+@return the error code of the index creation. */
+static ib_err_t create_index(const char *name, bool unique) {
+  ib_id_t index_id = 0;
+  ib_idx_sch_t ib_idx_sch = nullptr;
+  auto ib_trx = ib_trx_begin(IB_TRX_REPEATABLE_READ);
+
+  OK(ib_schema_lock_exclusive(ib_trx));
+  OK(ib_index_schema_create(ib_trx, name, DATABASE "/" TABLE, &ib_idx_sch));
+  OK(ib_index_schema_add_col(ib_idx_sch, name, 0));
+
+  if (unique) {
+    OK(ib_index_schema_set_unique(ib_idx_sch));
+  }
+
+  const auto err = ib_index_create(ib_idx_sch, &index_id);
+
+  ib_index_schema_delete(ib_idx_sch);
+
+  if (err == DB_SUCCESS) {
+    OK(ib_trx_commit(ib_trx));
+  } else {
+    OK(ib_trx_rollback(ib_trx));
+  }
+
+  return err;
+}
+
+/** Checks the B-tree of an index and counts its entries.
+@param[in] name                 Name of the index.
+@param[in] ordered              true if the first column is an INT that must
+                                be unique and ascending. */
+static void check_index(const char *name, bool ordered) {
+  ib_crsr_t crsr;
+  ib_crsr_t sec_crsr;
+  int n_rows{};
+  int32_t prev{};
+  auto ib_trx = ib_trx_begin(IB_TRX_REPEATABLE_READ);
+
+  OK(ib_cursor_open_table(DATABASE "/" TABLE, ib_trx, &crsr));
+
+  OK(ib_validate_index(crsr, name));
+
+  OK(ib_cursor_open_index_using_name(crsr, name, &sec_crsr));
+
+  auto tpl = ib_sec_read_tuple_create(sec_crsr);
+  assert(tpl != nullptr);
+
+  auto err = ib_cursor_first(sec_crsr);
+
+  while (err == DB_SUCCESS) {
+    OK(ib_cursor_read_row(sec_crsr, tpl));
+
+    if (ordered) {
+      int32_t key;
+
+      OK(ib_tuple_read_i32(tpl, 0, &key));
+
+      assert(key == n_rows);
+      assert(n_rows == 0 || key > prev);
+
+      prev = key;
+    }
+
+    ++n_rows;
+
+    err = ib_cursor_next(sec_crsr);
+  }
+
+  assert(err == DB_END_OF_INDEX);
+  assert(n_rows == N_ROWS);
+
+  ib_tuple_delete(tpl);
+
+  OK(ib_cursor_close(sec_crsr));
+  OK(ib_cursor_close(crsr));
+  OK(ib_trx_commit(ib_trx));
+}
+
+int main(int argc, char *argv[]) {
+  (void)argc;
+  (void)argv;
+
+  OK(ib_init());
+
+  test_configure();
+
+  OK(ib_startup("default"));
+
+  auto success = ib_database_create(DATABASE);
+  assert(success);
+
+  create_table();
+
+  insert_rows();
+
+  OK(ib_cfg_set_int("index_build_threads", N_THREADS));
+
+  auto err = create_index("c2", true);
+  OK(err);
+
+  check_index("c2", true);
+
+  /* The duplicate is only found when the runs of two threads are merged. */
+  err = create_index("c3", true);
+  assert(err == DB_DUPLICATE_KEY);
+
+  ib_id_t index_id;
+
+  err = ib_index_get_id(DATABASE "/" TABLE, "c3", &index_id);
+  assert(err != DB_SUCCESS);
+
+  err = create_index("c4", false);
+  OK(err);
+
+  check_index("c4", false);
+
+  OK(drop_table(DATABASE, TABLE));
+
+  OK(ib_shutdown(IB_SHUTDOWN_NORMAL));
+
+  return EXIT_SUCCESS;
+}
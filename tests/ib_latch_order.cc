@@ -0,0 +1,219 @@
+/***************************************************************************
+Copyright (c) 2024 Sunny Bains. All rights reserved.
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; version 2 of the License.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+
+************************************************************************/
+
+/* Begin transactions and open read views while the kernel mutex is held.
+
+ Create a database
+ CREATE TABLE t(c1 INT, PK(c1));
+ INSERT INTO t VALUES(0);
+
+ While the test holds the kernel mutex, in N_THREADS threads:
+   BEGIN;  -- with a read view
+
+ Starting a transaction takes only the trx system mutex and a read view is
+ created from the published snapshot, the threads must get there without
+ the kernel mutex. The test then takes the trx system mutex after the
+ kernel mutex, the documented latch order, and checks that the transactions
+ are active. Once the kernel mutex is released the threads read the row with
+ their views and commit, and the transactions must no longer be active. */
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "test0aux.h"
+#include "srv0srv.h"
+#include "trx0sys.h"
+#include "trx0trx.h"
+
+#define DATABASE "test"
+#define TABLE "t"
+
+/** Number of threads that begin a transaction. */
+static const int N_THREADS = 4;
+
+/** How long to wait for the threads while holding the kernel mutex. */
+static const int BEGIN_TIMEOUT_SECS = 10;
+
+/** Id of the transaction of each thread. */
+static trx_id_t trx_ids[N_THREADS];
+
+/** Number of the threads that began their transaction. */
+static std::atomic<int> n_begun;
+
+/** CREATE TABLE t(c1 INT, PRIMARY KEY(c1)); INSERT INTO t VALUES(0); */
+static void create_table() {
+  ib_crsr_t crsr;
+  ib_id_t table_id = 0;
+  ib_tbl_sch_t ib_tbl_sch = nullptr;
+  ib_idx_sch_t ib_idx_sch = nullptr;
+
+  OK(ib_table_schema_create(DATABASE "/" TABLE, &ib_tbl_sch, IB_TBL_V1, 0));
+  OK(ib_table_schema_add_col(ib_tbl_sch, "c1", IB_INT, IB_COL_NONE, 0, 4));
+  OK(ib_table_schema_add_index(ib_tbl_sch, "c1", &ib_idx_sch));
+  OK(ib_index_schema_add_col(ib_idx_sch, "c1", 0));
+  OK(ib_index_schema_set_clustered(ib_idx_sch));
+
+  auto ib_trx = ib_trx_begin(IB_TRX_REPEATABLE_READ);
+
+  OK(ib_schema_lock_exclusive(ib_trx));
+  OK(ib_table_create(ib_trx, ib_tbl_sch, &table_id));
+  OK(ib_trx_commit(ib_trx));
+
+  ib_table_schema_delete(ib_tbl_sch);
+
+  ib_trx = ib_trx_begin(IB_TRX_REPEATABLE_READ);
+
+  OK(ib_cursor_open_table(DATABASE "/" TABLE, ib_trx, &crsr));
+  OK(ib_cursor_lock(crsr, IB_LOCK_IX));
+
+  auto tpl = ib_clust_read_tuple_create(crsr);
+  assert(tpl != nullptr);
+
+  OK(ib_tuple_write_i32(tpl, 0, 0));
+  OK(ib_cursor_insert_row(crsr, tpl));
+
+  ib_tuple_delete(tpl);
+
+  OK(ib_cursor_close(crsr));
+  OK(ib_trx_commit(ib_trx));
+}
+
+/** BEGIN; SELECT * FROM t; COMMIT; the BEGIN while the kernel mutex is held.
+@param[in] i                    Thread number. */
+static void reader(int i) {
+  ib_crsr_t crsr;
+  auto ib_trx = ib_trx_begin(IB_TRX_REPEATABLE_READ);
+  auto trx = reinterpret_cast<Trx *>(ib_trx);
+
+  auto view = trx->assign_read_view();
+  assert(view != nullptr);
+
+  trx_ids[i] = trx->m_id;
+
+  ++n_begun;
+
+  /* The table lock waits for the kernel mutex. */
+  OK(ib_cursor_open_table(DATABASE "/" TABLE, ib_trx, &crsr));
+
+  auto tpl = ib_clust_read_tuple_create(crsr);
+  assert(tpl != nullptr);
+
+  OK(ib_cursor_first(crsr));
+  OK(ib_cursor_read_row(crsr, tpl));
+
+  int32_t c1;
+
+  OK(ib_tuple_read_i32(tpl, 0, &c1));
+  assert(c1 == 0);
+
+  ib_tuple_delete(tpl);
+
+  OK(ib_cursor_close(crsr));
+  OK(ib_trx_commit(ib_trx));
+}
+
+/** Waits for the threads to begin their transactions.
+@return true if they all did before the timeout. */
+static bool wait_for_begin() {
+  for (int i = 0; i < BEGIN_TIMEOUT_SECS * 10; ++i) {
+    if (n_begun == N_THREADS) {
+      return true;
+    }
+
+    usleep(100000);
+  }
+
+  return false;
+}
+
+/** Checks that the transactions of the threads are no longer active, the
+lock system way: the trx system mutex is taken after the kernel mutex. */
+static void check_committed() {
+  mutex_enter(&kernel_mutex);
+
+  for (int i = 0; i < N_THREADS; ++i) {
+    assert(!srv_trx_sys->is_active_off_kernel(trx_ids[i]));
+  }
+
+  mutex_exit(&kernel_mutex);
+}
+
+int main(int argc, char *argv[]) {
+  (void)argc;
+  (void)argv;
+
+  OK(ib_init());
+
+  test_configure();
+
+  OK(ib_startup("default"));
+
+  auto success = ib_database_create(DATABASE);
+  assert(success);
+
+  create_table();
+
+  std::vector<std::thread> threads;
+
+  mutex_enter(&kernel_mutex);
+
+  for (int i = 0; i < N_THREADS; ++i) {
+    threads.emplace_back(reader, i);
+  }
+
+  const auto begun = wait_for_begin();
+
+  if (begun) {
+    /* The trx system mutex is ordered after the kernel mutex. */
+    srv_trx_sys->mutex_acquire();
+
+    for (int i = 0; i < N_THREADS; ++i) {
+      assert(srv_trx_sys->is_active(trx_ids[i]));
+    }
+
+    srv_trx_sys->mutex_release();
+  }
+
+  mutex_exit(&kernel_mutex);
+
+  if (!begun) {
+    fprintf(stderr, "Only %d of %d transactions begun with the kernel mutex held\n", n_begun.load(), N_THREADS);
+    exit(EXIT_FAILURE);
+  }
+
+  printf("%d transactions begun with the kernel mutex held\n", N_THREADS);
+
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  check_committed();
+
+  OK(drop_table(DATABASE, TABLE));
+
+  OK(ib_shutdown(IB_SHUTDOWN_NORMAL));
+
+  return EXIT_SUCCESS;
+}
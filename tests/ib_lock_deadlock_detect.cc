@@ -0,0 +1,232 @@
+/***************************************************************************
+Copyright (c) 2024 Sunny Bains. All rights reserved.
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; version 2 of the License.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+
+************************************************************************/
+
+/* Check that the deadlock detector thread breaks waits-for cycles.
+
+ Create a database
+ CREATE TABLE t(c1 INT, PK(c1));
+ INSERT INTO t VALUES(0), ..., (N_ROWS - 1);
+
+ For a cycle of length N, in N threads:
+
+ BEGIN;
+ SELECT * FROM t WHERE c1 = i FOR UPDATE;
+ -- wait for all the threads
+ SELECT * FROM t WHERE c1 = (i + 1) % N FOR UPDATE;
+ COMMIT;
+
+ Exactly one thread must get DB_DEADLOCK, long before the lock wait
+ timeout, its transaction must have been rolled back. The others commit. */
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <atomic>
+#include <barrier>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "test0aux.h"
+
+#define DATABASE "test"
+#define TABLE "t"
+
+/** Number of rows in the table, the longest cycle tested. */
+static const int N_ROWS = 4;
+
+/** Lock wait timeout in seconds, a deadlock must be found well before. */
+static const int LOCK_WAIT_TIMEOUT = 50;
+
+/** Deadlock detector interval in milliseconds. */
+static const int DEADLOCK_DETECT_INTERVAL = 10;
+
+/** Number of threads that got DB_DEADLOCK. */
+static std::atomic<int> n_deadlocks;
+
+/** CREATE TABLE t(c1 INT, PRIMARY KEY(c1)); */
+static void create_table() {
+  ib_id_t table_id = 0;
+  ib_tbl_sch_t ib_tbl_sch = nullptr;
+  ib_idx_sch_t ib_idx_sch = nullptr;
+
+  OK(ib_table_schema_create(DATABASE "/" TABLE, &ib_tbl_sch, IB_TBL_V1, 0));
+  OK(ib_table_schema_add_col(ib_tbl_sch, "c1", IB_INT, IB_COL_NONE, 0, 4));
+  OK(ib_table_schema_add_index(ib_tbl_sch, "c1", &ib_idx_sch));
+  OK(ib_index_schema_add_col(ib_idx_sch, "c1", 0));
+  OK(ib_index_schema_set_clustered(ib_idx_sch));
+
+  auto ib_trx = ib_trx_begin(IB_TRX_REPEATABLE_READ);
+
+  OK(ib_schema_lock_exclusive(ib_trx));
+  OK(ib_table_create(ib_trx, ib_tbl_sch, &table_id));
+  OK(ib_trx_commit(ib_trx));
+
+  ib_table_schema_delete(ib_tbl_sch);
+}
+
+/** INSERT INTO t VALUES(i), i in [0, N_ROWS). */
+static void insert_rows() {
+  ib_crsr_t crsr;
+  auto ib_trx = ib_trx_begin(IB_TRX_REPEATABLE_READ);
+
+  OK(ib_cursor_open_table(DATABASE "/" TABLE, ib_trx, &crsr));
+  OK(ib_cursor_lock(crsr, IB_LOCK_IX));
+
+  auto tpl = ib_clust_read_tuple_create(crsr);
+  assert(tpl != nullptr);
+
+  for (int i = 0; i < N_ROWS; ++i) {
+    OK(ib_tuple_write_i32(tpl, 0, i));
+    OK(ib_cursor_insert_row(crsr, tpl));
+
+    tpl = ib_tuple_clear(tpl);
+    assert(tpl != nullptr);
+  }
+
+  ib_tuple_delete(tpl);
+
+  OK(ib_cursor_close(crsr));
+  OK(ib_trx_commit(ib_trx));
+}
+
+/** SELECT * FROM t WHERE c1 = key FOR UPDATE;
+@param[in,out] crsr             Cursor on t, in X lock mode.
+@param[in] key                  Row to lock.
+@return the error code of the search. */
+static ib_err_t lock_row(ib_crsr_t crsr, int key) {
+  int res;
+  auto key_tpl = ib_clust_search_tuple_create(crsr);
+  assert(key_tpl != nullptr);
+
+  OK(ib_tuple_write_i32(key_tpl, 0, key));
+
+  auto err = ib_cursor_moveto(crsr, key_tpl, IB_CUR_GE, &res);
+  assert(err != DB_SUCCESS || res == 0);
+
+  ib_tuple_delete(key_tpl);
+
+  return err;
+}
+
+/** Locks row i, waits for the other threads and then locks row (i + 1) % n.
+@param[in] i                    Thread number.
+@param[in] n                    Number of threads in the cycle.
+@param[in,out] barrier          Synchronizes the first locks. */
+static void worker(int i, int n, std::barrier<> &barrier) {
+  ib_crsr_t crsr;
+
+  OK(ib_cursor_open_table(DATABASE "/" TABLE, nullptr, &crsr));
+
+  auto ib_trx = ib_trx_begin(IB_TRX_REPEATABLE_READ);
+
+  ib_cursor_attach_trx(crsr, ib_trx);
+
+  OK(ib_cursor_lock(crsr, IB_LOCK_IX));
+  OK(ib_cursor_set_lock_mode(crsr, IB_LOCK_X));
+
+  OK(lock_row(crsr, i));
+
+  barrier.arrive_and_wait();
+
+  const auto start = std::chrono::steady_clock::now();
+
+  auto err = lock_row(crsr, (i + 1) % n);
+
+  const auto waited = std::chrono::steady_clock::now() - start;
+
+  OK(ib_cursor_reset(crsr));
+
+  if (err == DB_DEADLOCK) {
+    /* The victim must not have waited for the lock wait timeout. */
+    assert(waited < std::chrono::seconds(LOCK_WAIT_TIMEOUT / 5));
+
+    ++n_deadlocks;
+
+    /* The transaction was rolled back by InnoDB, its locks are released. */
+    assert(ib_trx_state(ib_trx) != IB_TRX_ACTIVE);
+    OK(ib_trx_release(ib_trx));
+
+    printf("Thread#%d - deadlock after %lld ms, trx rolled back.\n", i,
+           (long long)std::chrono::duration_cast<std::chrono::milliseconds>(waited).count());
+  } else {
+    OK(err);
+
+    assert(ib_trx_state(ib_trx) == IB_TRX_ACTIVE);
+    OK(ib_trx_commit(ib_trx));
+  }
+
+  OK(ib_cursor_close(crsr));
+}
+
+/** Creates a waits-for cycle of n transactions and checks that exactly one
+of them is chosen as the victim.
+@param[in] n                    Length of the cycle. */
+static void test_cycle(int n) {
+  std::barrier<> barrier(n);
+  std::vector<std::thread> threads;
+
+  assert(n <= N_ROWS);
+
+  n_deadlocks = 0;
+
+  for (int i = 0; i < n; ++i) {
+    threads.emplace_back(worker, i, n, std::ref(barrier));
+  }
+
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  assert(n_deadlocks == 1);
+
+  printf("Cycle of %d transactions resolved\n", n);
+}
+
+int main(int argc, char *argv[]) {
+  (void)argc;
+  (void)argv;
+
+  OK(ib_init());
+
+  test_configure();
+
+  OK(ib_cfg_set_int("lock_wait_timeout", LOCK_WAIT_TIMEOUT));
+  OK(ib_cfg_set_int("deadlock_detect_interval", DEADLOCK_DETECT_INTERVAL));
+
+  OK(ib_startup("default"));
+
+  auto success = ib_database_create(DATABASE);
+  assert(success);
+
+  create_table();
+
+  insert_rows();
+
+  for (int n = 2; n <= N_ROWS; ++n) {
+    test_cycle(n);
+  }
+
+  OK(drop_table(DATABASE, TABLE));
+
+  OK(ib_shutdown(IB_SHUTDOWN_NORMAL));
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,239 @@
+/***************************************************************************
+Copyright (c) 2024 Sunny Bains. All rights reserved.
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; version 2 of the License.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+
+************************************************************************/
+
+/* Check the record lock wait profile.
+
+ Create a database
+ CREATE TABLE t(c1 INT, PK(c1));
+ INSERT INTO t VALUES(0), (1);
+
+ Main thread:
+ BEGIN;
+ SELECT * FROM t WHERE c1 IN (0, 1) FOR UPDATE;
+
+ In N_HOT_WAITERS threads:
+ BEGIN; SELECT * FROM t WHERE c1 = 0 FOR UPDATE; -- hold it; COMMIT;
+
+ In one thread:
+ BEGIN; SELECT * FROM t WHERE c1 = 1 FOR UPDATE; COMMIT;
+
+ Main thread:
+ COMMIT;
+
+ ib_lock_get_hot_records() must return row 0 first, with N_HOT_WAITERS
+ waits, then row 1 with one wait, both in the clustered index of t. */
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "test0aux.h"
+
+#define DATABASE "test"
+#define TABLE "t"
+#define INDEX "PRIMARY"
+
+/** Number of transactions that wait for the hot row. */
+static const int N_HOT_WAITERS = 3;
+
+/** Time for a thread to enqueue its lock request. */
+static const auto ENQUEUE_WAIT = std::chrono::milliseconds(200);
+
+/** How long a transaction holds a lock that it was granted. */
+static const auto HOLD_TIME = std::chrono::milliseconds(200);
+
+/** CREATE TABLE t(c1 INT, PRIMARY KEY(c1)); */
+static void create_table() {
+  ib_id_t table_id = 0;
+  ib_tbl_sch_t ib_tbl_sch = nullptr;
+  ib_idx_sch_t ib_idx_sch = nullptr;
+
+  OK(ib_table_schema_create(DATABASE "/" TABLE, &ib_tbl_sch, IB_TBL_V1, 0));
+  OK(ib_table_schema_add_col(ib_tbl_sch, "c1", IB_INT, IB_COL_NONE, 0, 4));
+  OK(ib_table_schema_add_index(ib_tbl_sch, INDEX, &ib_idx_sch));
+  OK(ib_index_schema_add_col(ib_idx_sch, "c1", 0));
+  OK(ib_index_schema_set_clustered(ib_idx_sch));
+
+  auto ib_trx = ib_trx_begin(IB_TRX_REPEATABLE_READ);
+
+  OK(ib_schema_lock_exclusive(ib_trx));
+  OK(ib_table_create(ib_trx, ib_tbl_sch, &table_id));
+  OK(ib_trx_commit(ib_trx));
+
+  ib_table_schema_delete(ib_tbl_sch);
+}
+
+/** INSERT INTO t VALUES(0), (1); */
+static void insert_rows() {
+  ib_crsr_t crsr;
+  auto ib_trx = ib_trx_begin(IB_TRX_REPEATABLE_READ);
+
+  OK(ib_cursor_open_table(DATABASE "/" TABLE, ib_trx, &crsr));
+  OK(ib_cursor_lock(crsr, IB_LOCK_IX));
+
+  auto tpl = ib_clust_read_tuple_create(crsr);
+  assert(tpl != nullptr);
+
+  for (int i = 0; i < 2; ++i) {
+    OK(ib_tuple_write_i32(tpl, 0, i));
+    OK(ib_cursor_insert_row(crsr, tpl));
+
+    tpl = ib_tuple_clear(tpl);
+    assert(tpl != nullptr);
+  }
+
+  ib_tuple_delete(tpl);
+
+  OK(ib_cursor_close(crsr));
+  OK(ib_trx_commit(ib_trx));
+}
+
+/** SELECT * FROM t WHERE c1 = key FOR UPDATE;
+@param[in,out] crsr             Cursor on t, in X lock mode.
+@param[in] key                  Row to lock. */
+static void lock_row(ib_crsr_t crsr, int key) {
+  int res;
+  auto key_tpl = ib_clust_search_tuple_create(crsr);
+  assert(key_tpl != nullptr);
+
+  OK(ib_tuple_write_i32(key_tpl, 0, key));
+  OK(ib_cursor_moveto(crsr, key_tpl, IB_CUR_GE, &res));
+  assert(res == 0);
+
+  ib_tuple_delete(key_tpl);
+}
+
+/** BEGIN; SELECT * FROM t WHERE c1 = key FOR UPDATE; -- hold it; COMMIT;
+@param[in] key                  Row to lock. */
+static void locker(int key) {
+  ib_crsr_t crsr;
+  auto ib_trx = ib_trx_begin(IB_TRX_REPEATABLE_READ);
+
+  OK(ib_cursor_open_table(DATABASE "/" TABLE, ib_trx, &crsr));
+  OK(ib_cursor_lock(crsr, IB_LOCK_IX));
+  OK(ib_cursor_set_lock_mode(crsr, IB_LOCK_X));
+
+  lock_row(crsr, key);
+
+  std::this_thread::sleep_for(HOLD_TIME);
+
+  OK(ib_cursor_close(crsr));
+  OK(ib_trx_commit(ib_trx));
+}
+
+/** Creates the lock waits on the two rows. */
+static void create_waits() {
+  ib_crsr_t crsr;
+  std::vector<std::thread> threads;
+  auto ib_trx = ib_trx_begin(IB_TRX_REPEATABLE_READ);
+
+  OK(ib_cursor_open_table(DATABASE "/" TABLE, ib_trx, &crsr));
+  OK(ib_cursor_lock(crsr, IB_LOCK_IX));
+  OK(ib_cursor_set_lock_mode(crsr, IB_LOCK_X));
+
+  lock_row(crsr, 0);
+  lock_row(crsr, 1);
+
+  for (int i = 0; i < N_HOT_WAITERS; ++i) {
+    threads.emplace_back(locker, 0);
+  }
+
+  threads.emplace_back(locker, 1);
+
+  std::this_thread::sleep_for(ENQUEUE_WAIT);
+
+  OK(ib_cursor_close(crsr));
+  OK(ib_trx_commit(ib_trx));
+
+  for (auto &thread : threads) {
+    thread.join();
+  }
+}
+
+/** Checks the profile of the waits created by create_waits(). */
+static void check_hot_records() {
+  std::vector<ib_lock_hot_rec_t> hot_recs;
+
+  OK(ib_lock_get_hot_records(hot_recs, 10));
+
+  assert(hot_recs.size() == 2);
+
+  for (const auto &hot_rec : hot_recs) {
+    printf("%s.%s page %u:%u heap_no %u: %llu waits, %llu us\n", hot_rec.table_name.c_str(), hot_rec.index_name.c_str(),
+           hot_rec.space_id, hot_rec.page_no, hot_rec.heap_no, (unsigned long long)hot_rec.n_waits,
+           (unsigned long long)hot_rec.wait_time_us);
+
+    assert(hot_rec.table_name == DATABASE "/" TABLE);
+    assert(hot_rec.index_name == INDEX);
+  }
+
+  /* The waiters for row 0 were serialized, they waited the longest. */
+  assert(hot_recs[0].n_waits == N_HOT_WAITERS);
+  assert(hot_recs[1].n_waits == 1);
+  assert(hot_recs[0].wait_time_us >= hot_recs[1].wait_time_us);
+
+  /* Both rows are on the root page. */
+  assert(hot_recs[0].space_id == hot_recs[1].space_id);
+  assert(hot_recs[0].page_no == hot_recs[1].page_no);
+  assert(hot_recs[0].heap_no < hot_recs[1].heap_no);
+
+  /* Only the hottest record is returned if asked for one. */
+  OK(ib_lock_get_hot_records(hot_recs, 1));
+
+  assert(hot_recs.size() == 1);
+  assert(hot_recs[0].n_waits == N_HOT_WAITERS);
+}
+
+int main(int argc, char *argv[]) {
+  (void)argc;
+  (void)argv;
+
+  OK(ib_init());
+
+  test_configure();
+
+  OK(ib_startup("default"));
+
+  auto success = ib_database_create(DATABASE);
+  assert(success);
+
+  create_table();
+
+  insert_rows();
+
+  std::vector<ib_lock_hot_rec_t> hot_recs;
+
+  /* Nothing has waited yet. */
+  OK(ib_lock_get_hot_records(hot_recs, 10));
+  assert(hot_recs.empty());
+
+  create_waits();
+
+  check_hot_records();
+
+  OK(drop_table(DATABASE, TABLE));
+
+  OK(ib_shutdown(IB_SHUTDOWN_NORMAL));
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,324 @@
+/***************************************************************************
+Copyright (c) 2024 Sunny Bains. All rights reserved.
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; version 2 of the License.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+
+************************************************************************/
+
+/* Check the order in which waiting record locks are granted.
+
+ Create a database
+ CREATE TABLE t(c1 INT, PK(c1));
+ INSERT INTO t VALUES(0), (1), (2), (3);
+
+ Age and FIFO: H locks row 0. Transactions O and Y are started in that
+ order, Y then O wait for row 0. H commits. With lock_schedule = 2 (age)
+ the older O is granted the lock first, with lock_schedule = 0 (FIFO) Y is.
+
+ CATS: H locks row 1, A locks row 2 and B locks row 3. Three transactions
+ wait for row 2, they are blocked by A. B then A wait for row 1. Once the
+ weights have been computed H commits. With lock_schedule = 1 A, which
+ blocks more transactions, is granted the lock first even though B asked
+ for it first.
+
+ lock_schedule can't be changed after startup, each schedule is tested in
+ a child process that starts InnoDB. */
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <sys/wait.h>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "test0aux.h"
+
+#define DATABASE "test"
+#define TABLE "t"
+
+/** Number of rows in the table. */
+static const int N_ROWS = 4;
+
+/** Deadlock detector interval in milliseconds, it also computes the weights. */
+static const int DEADLOCK_DETECT_INTERVAL = 10;
+
+/** Time for a thread to enqueue its lock request. */
+static const auto ENQUEUE_WAIT = std::chrono::milliseconds(200);
+
+/** How long a transaction holds a lock that it was granted. */
+static const auto HOLD_TIME = std::chrono::milliseconds(200);
+
+/** lock_schedule values, see Lock_schedule. */
+enum Schedule { FIFO = 0, CATS = 1, AGE = 2 };
+
+/** A transaction and a cursor on t attached to it. */
+struct Session {
+  ib_trx_t m_trx;
+  ib_crsr_t m_crsr;
+
+  /** Order in which the wait of the transaction ended, starting at 1. */
+  std::atomic<int> m_granted{};
+};
+
+/** Counts the waits that ended. */
+static std::atomic<int> n_granted;
+
+/** CREATE TABLE t(c1 INT, PRIMARY KEY(c1)); */
+static void create_table() {
+  ib_id_t table_id = 0;
+  ib_tbl_sch_t ib_tbl_sch = nullptr;
+  ib_idx_sch_t ib_idx_sch = nullptr;
+
+  OK(ib_table_schema_create(DATABASE "/" TABLE, &ib_tbl_sch, IB_TBL_V1, 0));
+  OK(ib_table_schema_add_col(ib_tbl_sch, "c1", IB_INT, IB_COL_NONE, 0, 4));
+  OK(ib_table_schema_add_index(ib_tbl_sch, "c1", &ib_idx_sch));
+  OK(ib_index_schema_add_col(ib_idx_sch, "c1", 0));
+  OK(ib_index_schema_set_clustered(ib_idx_sch));
+
+  auto ib_trx = ib_trx_begin(IB_TRX_REPEATABLE_READ);
+
+  OK(ib_schema_lock_exclusive(ib_trx));
+  OK(ib_table_create(ib_trx, ib_tbl_sch, &table_id));
+  OK(ib_trx_commit(ib_trx));
+
+  ib_table_schema_delete(ib_tbl_sch);
+}
+
+/** INSERT INTO t VALUES(i), i in [0, N_ROWS). */
+static void insert_rows() {
+  ib_crsr_t crsr;
+  auto ib_trx = ib_trx_begin(IB_TRX_REPEATABLE_READ);
+
+  OK(ib_cursor_open_table(DATABASE "/" TABLE, ib_trx, &crsr));
+  OK(ib_cursor_lock(crsr, IB_LOCK_IX));
+
+  auto tpl = ib_clust_read_tuple_create(crsr);
+  assert(tpl != nullptr);
+
+  for (int i = 0; i < N_ROWS; ++i) {
+    OK(ib_tuple_write_i32(tpl, 0, i));
+    OK(ib_cursor_insert_row(crsr, tpl));
+
+    tpl = ib_tuple_clear(tpl);
+    assert(tpl != nullptr);
+  }
+
+  ib_tuple_delete(tpl);
+
+  OK(ib_cursor_close(crsr));
+  OK(ib_trx_commit(ib_trx));
+}
+
+/** BEGIN; and open a cursor on t in X lock mode.
+@param[out] session             Transaction and cursor. */
+static void begin(Session &session) {
+  session.m_trx = ib_trx_begin(IB_TRX_REPEATABLE_READ);
+
+  OK(ib_cursor_open_table(DATABASE "/" TABLE, nullptr, &session.m_crsr));
+
+  ib_cursor_attach_trx(session.m_crsr, session.m_trx);
+
+  OK(ib_cursor_lock(session.m_crsr, IB_LOCK_IX));
+  OK(ib_cursor_set_lock_mode(session.m_crsr, IB_LOCK_X));
+}
+
+/** SELECT * FROM t WHERE c1 = key FOR UPDATE;
+@param[in,out] session          Session that locks the row.
+@param[in] key                  Row to lock. */
+static void lock_row(Session &session, int key) {
+  int res;
+  auto key_tpl = ib_clust_search_tuple_create(session.m_crsr);
+  assert(key_tpl != nullptr);
+
+  OK(ib_tuple_write_i32(key_tpl, 0, key));
+  OK(ib_cursor_moveto(session.m_crsr, key_tpl, IB_CUR_GE, &res));
+  assert(res == 0);
+
+  ib_tuple_delete(key_tpl);
+}
+
+/** COMMIT;
+@param[in,out] session          Session to end. */
+static void commit(Session &session) {
+  OK(ib_cursor_reset(session.m_crsr));
+  OK(ib_trx_commit(session.m_trx));
+  OK(ib_cursor_close(session.m_crsr));
+}
+
+/** Waits for the row lock, records the grant order, holds the lock for a
+while and commits.
+@param[in,out] session          Session that waits.
+@param[in] key                  Row to lock. */
+static void waiter(Session *session, int key) {
+  lock_row(*session, key);
+
+  session->m_granted = ++n_granted;
+
+  std::this_thread::sleep_for(HOLD_TIME);
+
+  commit(*session);
+}
+
+/** Starts a thread that waits for a row lock held by another session.
+@param[in,out] session          Session that waits.
+@param[in] key                  Row to lock.
+@return the thread. */
+static std::thread wait_for_row(Session &session, int key) {
+  std::thread thread(waiter, &session, key);
+
+  std::this_thread::sleep_for(ENQUEUE_WAIT);
+
+  /* The lock must not have been granted. */
+  assert(session.m_granted == 0);
+
+  return thread;
+}
+
+/** The older transaction is granted the lock first with the age schedule,
+the first to ask for it with FIFO.
+@param[in] schedule             AGE or FIFO. */
+static void test_age(Schedule schedule) {
+  Session h, o, y;
+
+  n_granted = 0;
+
+  begin(h);
+  lock_row(h, 0);
+
+  /* O gets the smaller trx id. */
+  begin(o);
+  begin(y);
+
+  auto y_thread = wait_for_row(y, 0);
+  auto o_thread = wait_for_row(o, 0);
+
+  commit(h);
+
+  y_thread.join();
+  o_thread.join();
+
+  if (schedule == AGE) {
+    assert(o.m_granted == 1 && y.m_granted == 2);
+  } else {
+    assert(y.m_granted == 1 && o.m_granted == 2);
+  }
+}
+
+/** The transaction that blocks the most waiters is granted the lock first. */
+static void test_cats() {
+  Session h, a, b;
+  Session w[3];
+  std::vector<std::thread> threads;
+
+  n_granted = 0;
+
+  begin(h);
+  lock_row(h, 1);
+
+  begin(a);
+  lock_row(a, 2);
+
+  begin(b);
+  lock_row(b, 3);
+
+  for (auto &session : w) {
+    begin(session);
+    threads.push_back(wait_for_row(session, 2));
+  }
+
+  auto b_thread = wait_for_row(b, 1);
+  auto a_thread = wait_for_row(a, 1);
+
+  /* Let the deadlock detector compute the weights. */
+  std::this_thread::sleep_for(std::chrono::milliseconds(DEADLOCK_DETECT_INTERVAL * 20));
+
+  commit(h);
+
+  a_thread.join();
+  b_thread.join();
+
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  /* A commits after holding the lock, which lets the transactions waiting
+  for row 2 proceed while B still waits for A. */
+  assert(a.m_granted == 1);
+  assert(b.m_granted > 1);
+}
+
+/** Starts InnoDB with the schedule and runs its test.
+@param[in] schedule             Lock schedule to test. */
+static void run(Schedule schedule) {
+  OK(ib_init());
+
+  test_configure();
+
+  OK(ib_cfg_set_int("lock_schedule", schedule));
+  OK(ib_cfg_set_int("deadlock_detect_interval", DEADLOCK_DETECT_INTERVAL));
+
+  OK(ib_startup("default"));
+
+  auto success = ib_database_create(DATABASE);
+  assert(success);
+
+  create_table();
+
+  insert_rows();
+
+  if (schedule == CATS) {
+    test_cats();
+  } else {
+    test_age(schedule);
+  }
+
+  OK(drop_table(DATABASE, TABLE));
+
+  OK(ib_shutdown(IB_SHUTDOWN_NORMAL));
+}
+
+int main(int argc, char *argv[]) {
+  (void)argc;
+  (void)argv;
+
+  for (auto schedule : {FIFO, AGE, CATS}) {
+    auto pid = fork();
+    assert(pid >= 0);
+
+    if (pid == 0) {
+      run(schedule);
+      exit(EXIT_SUCCESS);
+    }
+
+    int status;
+
+    auto ret = waitpid(pid, &status, 0);
+    assert(ret == pid);
+
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != EXIT_SUCCESS) {
+      fprintf(stderr, "lock_schedule = %d failed\n", schedule);
+      exit(EXIT_FAILURE);
+    }
+
+    printf("lock_schedule = %d passed\n", schedule);
+  }
+
+  return EXIT_SUCCESS;
+}
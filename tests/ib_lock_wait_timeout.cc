@@ -0,0 +1,263 @@
+/***************************************************************************
+Copyright (c) 2024 Sunny Bains. All rights reserved.
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; version 2 of the License.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+
+************************************************************************/
+
+/* Check the lock wait timeouts and wakeups.
+
+ Create a database
+ CREATE TABLE t(c1 INT, PK(c1));
+ INSERT INTO t VALUES(0);
+
+ Main thread:
+ BEGIN;
+ SELECT * FROM t WHERE c1 = 0 FOR UPDATE;
+
+ In N_WAITERS threads, started STAGGER_MS apart:
+ BEGIN;
+ SELECT * FROM t WHERE c1 = 0 FOR UPDATE;
+
+ Each waiter must get DB_LOCK_WAIT_TIMEOUT about lock_wait_timeout
+ seconds after its own wait started, not when the first one expired.
+
+ Then a waiter that is granted the lock before its timeout must be woken
+ up as soon as the holder commits. */
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "test0aux.h"
+
+#define DATABASE "test"
+#define TABLE "t"
+
+/** Lock wait timeout in seconds. */
+static const int LOCK_WAIT_TIMEOUT = 2;
+
+/** Number of threads that time out. */
+static const int N_WAITERS = 4;
+
+/** Delay between the start of two waiters. */
+static const auto STAGGER = std::chrono::milliseconds(300);
+
+/** The timeouts are checked once a second, allow for that and for the
+scheduling of the threads. */
+static const auto SLACK = std::chrono::milliseconds(1500);
+
+/** CREATE TABLE t(c1 INT, PRIMARY KEY(c1)); */
+static void create_table() {
+  ib_id_t table_id = 0;
+  ib_tbl_sch_t ib_tbl_sch = nullptr;
+  ib_idx_sch_t ib_idx_sch = nullptr;
+
+  OK(ib_table_schema_create(DATABASE "/" TABLE, &ib_tbl_sch, IB_TBL_V1, 0));
+  OK(ib_table_schema_add_col(ib_tbl_sch, "c1", IB_INT, IB_COL_NONE, 0, 4));
+  OK(ib_table_schema_add_index(ib_tbl_sch, "c1", &ib_idx_sch));
+  OK(ib_index_schema_add_col(ib_idx_sch, "c1", 0));
+  OK(ib_index_schema_set_clustered(ib_idx_sch));
+
+  auto ib_trx = ib_trx_begin(IB_TRX_REPEATABLE_READ);
+
+  OK(ib_schema_lock_exclusive(ib_trx));
+  OK(ib_table_create(ib_trx, ib_tbl_sch, &table_id));
+  OK(ib_trx_commit(ib_trx));
+
+  ib_table_schema_delete(ib_tbl_sch);
+}
+
+/** INSERT INTO t VALUES(0); */
+static void insert_row() {
+  ib_crsr_t crsr;
+  auto ib_trx = ib_trx_begin(IB_TRX_REPEATABLE_READ);
+
+  OK(ib_cursor_open_table(DATABASE "/" TABLE, ib_trx, &crsr));
+  OK(ib_cursor_lock(crsr, IB_LOCK_IX));
+
+  auto tpl = ib_clust_read_tuple_create(crsr);
+  assert(tpl != nullptr);
+
+  OK(ib_tuple_write_i32(tpl, 0, 0));
+  OK(ib_cursor_insert_row(crsr, tpl));
+
+  ib_tuple_delete(tpl);
+
+  OK(ib_cursor_close(crsr));
+  OK(ib_trx_commit(ib_trx));
+}
+
+/** BEGIN; SELECT * FROM t WHERE c1 = 0 FOR UPDATE;
+@param[out] crsr                Cursor on t, in X lock mode.
+@param[out] err                 Error code of the search.
+@return the transaction that owns the cursor. */
+static ib_trx_t lock_row(ib_crsr_t *crsr, ib_err_t *err) {
+  int res;
+  auto ib_trx = ib_trx_begin(IB_TRX_REPEATABLE_READ);
+
+  OK(ib_cursor_open_table(DATABASE "/" TABLE, nullptr, crsr));
+
+  ib_cursor_attach_trx(*crsr, ib_trx);
+
+  OK(ib_cursor_lock(*crsr, IB_LOCK_IX));
+  OK(ib_cursor_set_lock_mode(*crsr, IB_LOCK_X));
+
+  auto key_tpl = ib_clust_search_tuple_create(*crsr);
+  assert(key_tpl != nullptr);
+
+  OK(ib_tuple_write_i32(key_tpl, 0, 0));
+
+  *err = ib_cursor_moveto(*crsr, key_tpl, IB_CUR_GE, &res);
+  assert(*err != DB_SUCCESS || res == 0);
+
+  ib_tuple_delete(key_tpl);
+
+  return ib_trx;
+}
+
+/** COMMIT; or release the transaction if InnoDB rolled it back.
+@param[in] ib_trx               Transaction to end.
+@param[in] crsr                 Cursor attached to the transaction. */
+static void trx_end(ib_trx_t ib_trx, ib_crsr_t crsr) {
+  OK(ib_cursor_reset(crsr));
+
+  if (ib_trx_state(ib_trx) == IB_TRX_ACTIVE) {
+    OK(ib_trx_commit(ib_trx));
+  } else {
+    OK(ib_trx_release(ib_trx));
+  }
+
+  OK(ib_cursor_close(crsr));
+}
+
+/** Waits for the lock on row 0 and checks that the wait times out.
+@param[in] i                    Waiter number. */
+static void timeout_waiter(int i) {
+  ib_err_t err;
+  ib_crsr_t crsr;
+
+  const auto start = std::chrono::steady_clock::now();
+
+  auto ib_trx = lock_row(&crsr, &err);
+
+  const auto waited = std::chrono::steady_clock::now() - start;
+
+  assert(err == DB_LOCK_WAIT_TIMEOUT);
+  assert(waited >= std::chrono::seconds(LOCK_WAIT_TIMEOUT) - SLACK);
+  assert(waited <= std::chrono::seconds(LOCK_WAIT_TIMEOUT) + SLACK);
+
+  printf("Waiter#%d - timed out after %lld ms\n", i,
+         (long long)std::chrono::duration_cast<std::chrono::milliseconds>(waited).count());
+
+  trx_end(ib_trx, crsr);
+}
+
+/** Every waiter times out on its own deadline. */
+static void test_timeouts() {
+  ib_err_t err;
+  ib_crsr_t crsr;
+  std::vector<std::thread> threads;
+
+  auto ib_trx = lock_row(&crsr, &err);
+  OK(err);
+
+  for (int i = 0; i < N_WAITERS; ++i) {
+    threads.emplace_back(timeout_waiter, i);
+    std::this_thread::sleep_for(STAGGER);
+  }
+
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  /* The holder was never affected by the timeouts of the waiters. */
+  assert(ib_trx_state(ib_trx) == IB_TRX_ACTIVE);
+
+  trx_end(ib_trx, crsr);
+}
+
+/** A waiter that is granted the lock is woken up without delay. */
+static void test_wakeup() {
+  ib_err_t err;
+  ib_crsr_t crsr;
+  std::chrono::steady_clock::time_point granted;
+
+  auto ib_trx = lock_row(&crsr, &err);
+  OK(err);
+
+  std::thread waiter([&granted]() {
+    ib_err_t err;
+    ib_crsr_t crsr;
+
+    auto ib_trx = lock_row(&crsr, &err);
+
+    granted = std::chrono::steady_clock::now();
+
+    OK(err);
+
+    trx_end(ib_trx, crsr);
+  });
+
+  /* Let the waiter suspend, then release the lock half way to the timeout. */
+  std::this_thread::sleep_for(std::chrono::milliseconds(LOCK_WAIT_TIMEOUT * 1000 / 2));
+
+  const auto released = std::chrono::steady_clock::now();
+
+  trx_end(ib_trx, crsr);
+
+  waiter.join();
+
+  const auto delay = granted - released;
+
+  printf("Waiter woken up %lld ms after the release\n",
+         (long long)std::chrono::duration_cast<std::chrono::milliseconds>(delay).count());
+
+  assert(delay < std::chrono::milliseconds(500));
+}
+
+int main(int argc, char *argv[]) {
+  (void)argc;
+  (void)argv;
+
+  OK(ib_init());
+
+  test_configure();
+
+  OK(ib_cfg_set_int("lock_wait_timeout", LOCK_WAIT_TIMEOUT));
+
+  OK(ib_startup("default"));
+
+  auto success = ib_database_create(DATABASE);
+  assert(success);
+
+  create_table();
+
+  insert_row();
+
+  test_timeouts();
+
+  test_wakeup();
+
+  OK(drop_table(DATABASE, TABLE));
+
+  OK(ib_shutdown(IB_SHUTDOWN_NORMAL));
+
+  return EXIT_SUCCESS;
+}
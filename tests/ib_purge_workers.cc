@@ -0,0 +1,323 @@
+/***************************************************************************
+Copyright (c) 2024 Sunny Bains. All rights reserved.
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; version 2 of the License.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+
+************************************************************************/
+
+/* Purge the history of one hot table with several purge workers.
+
+ Create a database
+ CREATE TABLE t(c1 INT, c2 INT, PK(c1), KEY(c2));
+ INSERT INTO t VALUES(k, k), k = 0 .. N_ROWS - 1;
+
+ In N_UPDATERS threads, thread i, N_UPDATES times:
+   BEGIN;
+   UPDATE t SET c2 = c2 + N_ROWS WHERE c1 % N_UPDATERS = i;
+   COMMIT;
+
+ DELETE FROM t WHERE c1 % 2 = 1;
+
+ Every update changes the secondary key, so that purge has to remove the old
+ entries of each row in the order of its versions. The workers share the
+ records of the one table. Once the history is purged both indexes must
+ contain exactly the remaining rows with their last values. */
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <thread>
+#include <vector>
+
+#include "test0aux.h"
+#include "srv0srv.h"
+#include "trx0sys.h"
+
+#define DATABASE "test"
+#define TABLE "t"
+
+/** Number of purge worker threads. */
+static const int N_PURGE_THREADS = 4;
+
+/** Number of rows in the table. */
+static const int N_ROWS = 1000;
+
+/** Number of updating threads. */
+static const int N_UPDATERS = 4;
+
+/** Number of times each row is updated. */
+static const int N_UPDATES = 20;
+
+/** How long to wait for purge to empty the history. */
+static const int PURGE_TIMEOUT_SECS = 120;
+
+/** CREATE TABLE t(c1 INT, c2 INT, PK(c1), KEY(c2)); */
+static void create_table() {
+  ib_id_t table_id = 0;
+  ib_tbl_sch_t ib_tbl_sch = nullptr;
+  ib_idx_sch_t ib_idx_sch = nullptr;
+
+  OK(ib_table_schema_create(DATABASE "/" TABLE, &ib_tbl_sch, IB_TBL_V1, 0));
+  OK(ib_table_schema_add_col(ib_tbl_sch, "c1", IB_INT, IB_COL_NONE, 0, 4));
+  OK(ib_table_schema_add_col(ib_tbl_sch, "c2", IB_INT, IB_COL_NONE, 0, 4));
+
+  OK(ib_table_schema_add_index(ib_tbl_sch, "PRIMARY", &ib_idx_sch));
+  OK(ib_index_schema_add_col(ib_idx_sch, "c1", 0));
+  OK(ib_index_schema_set_clustered(ib_idx_sch));
+
+  OK(ib_table_schema_add_index(ib_tbl_sch, "c2", &ib_idx_sch));
+  OK(ib_index_schema_add_col(ib_idx_sch, "c2", 0));
+
+  auto ib_trx = ib_trx_begin(IB_TRX_REPEATABLE_READ);
+
+  OK(ib_schema_lock_exclusive(ib_trx));
+  OK(ib_table_create(ib_trx, ib_tbl_sch, &table_id));
+  OK(ib_trx_commit(ib_trx));
+
+  ib_table_schema_delete(ib_tbl_sch);
+}
+
+/** INSERT INTO t VALUES(k, k), k = 0 .. N_ROWS - 1; */
+static void insert_rows() {
+  ib_crsr_t crsr;
+  auto ib_trx = ib_trx_begin(IB_TRX_REPEATABLE_READ);
+
+  OK(ib_cursor_open_table(DATABASE "/" TABLE, ib_trx, &crsr));
+  OK(ib_cursor_lock(crsr, IB_LOCK_IX));
+
+  auto tpl = ib_clust_read_tuple_create(crsr);
+  assert(tpl != nullptr);
+
+  for (int k = 0; k < N_ROWS; ++k) {
+    OK(ib_tuple_write_i32(tpl, 0, k));
+    OK(ib_tuple_write_i32(tpl, 1, k));
+    OK(ib_cursor_insert_row(crsr, tpl));
+
+    tpl = ib_tuple_clear(tpl);
+    assert(tpl != nullptr);
+  }
+
+  ib_tuple_delete(tpl);
+
+  OK(ib_cursor_close(crsr));
+  OK(ib_trx_commit(ib_trx));
+}
+
+/** Positions the cursor on the row with the key.
+@param[in] crsr                 Cursor on the clustered index.
+@param[in] key                  Key of the row, it must exist. */
+static void moveto(ib_crsr_t crsr, int key) {
+  int res;
+  auto key_tpl = ib_clust_search_tuple_create(crsr);
+  assert(key_tpl != nullptr);
+
+  OK(ib_tuple_write_i32(key_tpl, 0, key));
+  OK(ib_cursor_moveto(crsr, key_tpl, IB_CUR_GE, &res));
+  assert(res == 0);
+
+  ib_tuple_delete(key_tpl);
+}
+
+/** UPDATE t SET c2 = c2 + N_ROWS WHERE c1 % N_UPDATERS = i; N_UPDATES times.
+@param[in] i                    Thread number. */
+static void updater(int i) {
+  for (int n = 0; n < N_UPDATES; ++n) {
+    ib_crsr_t crsr;
+    auto ib_trx = ib_trx_begin(IB_TRX_REPEATABLE_READ);
+
+    OK(ib_cursor_open_table(DATABASE "/" TABLE, ib_trx, &crsr));
+    OK(ib_cursor_lock(crsr, IB_LOCK_IX));
+    OK(ib_cursor_set_lock_mode(crsr, IB_LOCK_X));
+
+    auto old_tpl = ib_clust_read_tuple_create(crsr);
+    assert(old_tpl != nullptr);
+
+    auto new_tpl = ib_clust_read_tuple_create(crsr);
+    assert(new_tpl != nullptr);
+
+    for (int k = i; k < N_ROWS; k += N_UPDATERS) {
+      int32_t c2;
+
+      moveto(crsr, k);
+
+      OK(ib_cursor_read_row(crsr, old_tpl));
+      OK(ib_tuple_copy(new_tpl, old_tpl));
+      OK(ib_tuple_read_i32(new_tpl, 1, &c2));
+      OK(ib_tuple_write_i32(new_tpl, 1, c2 + N_ROWS));
+      OK(ib_cursor_update_row(crsr, old_tpl, new_tpl));
+
+      old_tpl = ib_tuple_clear(old_tpl);
+      assert(old_tpl != nullptr);
+
+      new_tpl = ib_tuple_clear(new_tpl);
+      assert(new_tpl != nullptr);
+    }
+
+    ib_tuple_delete(old_tpl);
+    ib_tuple_delete(new_tpl);
+
+    OK(ib_cursor_close(crsr));
+    OK(ib_trx_commit(ib_trx));
+  }
+}
+
+/** DELETE FROM t WHERE c1 % 2 = 1; */
+static void delete_rows() {
+  ib_crsr_t crsr;
+  auto ib_trx = ib_trx_begin(IB_TRX_REPEATABLE_READ);
+
+  OK(ib_cursor_open_table(DATABASE "/" TABLE, ib_trx, &crsr));
+  OK(ib_cursor_lock(crsr, IB_LOCK_IX));
+  OK(ib_cursor_set_lock_mode(crsr, IB_LOCK_X));
+
+  for (int k = 1; k < N_ROWS; k += 2) {
+    moveto(crsr, k);
+
+    OK(ib_cursor_delete_row(crsr));
+  }
+
+  OK(ib_cursor_close(crsr));
+  OK(ib_trx_commit(ib_trx));
+}
+
+/** @return the length of the history list. */
+static ulint history_len() {
+  return srv_trx_sys->m_rseg_history_len.load();
+}
+
+/** Waits for purge to empty the history. */
+static void wait_for_purge() {
+  printf("History length %lu\n", (unsigned long)history_len());
+
+  for (int i = 0; i < PURGE_TIMEOUT_SECS; ++i) {
+    if (history_len() == 0) {
+      printf("History purged\n");
+      return;
+    }
+
+    sleep(1);
+  }
+
+  fprintf(stderr, "History was not purged, length %lu\n", (unsigned long)history_len());
+  exit(EXIT_FAILURE);
+}
+
+/** Checks that both indexes contain exactly the even rows with their last
+values. */
+static void check_rows() {
+  ib_crsr_t crsr;
+  ib_crsr_t sec_crsr;
+  auto ib_trx = ib_trx_begin(IB_TRX_REPEATABLE_READ);
+
+  OK(ib_cursor_open_table(DATABASE "/" TABLE, ib_trx, &crsr));
+
+  auto tpl = ib_clust_read_tuple_create(crsr);
+  assert(tpl != nullptr);
+
+  int k{};
+  auto err = ib_cursor_first(crsr);
+
+  for (; err == DB_SUCCESS; k += 2) {
+    int32_t c1;
+    int32_t c2;
+
+    OK(ib_cursor_read_row(crsr, tpl));
+    OK(ib_tuple_read_i32(tpl, 0, &c1));
+    OK(ib_tuple_read_i32(tpl, 1, &c2));
+
+    assert(c1 == k);
+    assert(c2 == k + N_UPDATES * N_ROWS);
+
+    err = ib_cursor_next(crsr);
+  }
+
+  assert(err == DB_END_OF_INDEX || err == DB_RECORD_NOT_FOUND);
+  assert(k == N_ROWS);
+
+  ib_tuple_delete(tpl);
+
+  /* The secondary index has one entry for each row, in the same order. */
+  OK(ib_cursor_open_index_using_name(crsr, "c2", &sec_crsr));
+
+  tpl = ib_sec_read_tuple_create(sec_crsr);
+  assert(tpl != nullptr);
+
+  k = 0;
+  err = ib_cursor_first(sec_crsr);
+
+  for (; err == DB_SUCCESS; k += 2) {
+    int32_t c2;
+
+    OK(ib_cursor_read_row(sec_crsr, tpl));
+    OK(ib_tuple_read_i32(tpl, 0, &c2));
+
+    assert(c2 == k + N_UPDATES * N_ROWS);
+
+    err = ib_cursor_next(sec_crsr);
+  }
+
+  assert(err == DB_END_OF_INDEX || err == DB_RECORD_NOT_FOUND);
+  assert(k == N_ROWS);
+
+  ib_tuple_delete(tpl);
+
+  OK(ib_cursor_close(sec_crsr));
+  OK(ib_cursor_close(crsr));
+  OK(ib_trx_commit(ib_trx));
+}
+
+int main(int argc, char *argv[]) {
+  (void)argc;
+  (void)argv;
+
+  OK(ib_init());
+
+  test_configure();
+
+  OK(ib_cfg_set_int("purge_threads", N_PURGE_THREADS));
+
+  OK(ib_startup("default"));
+
+  auto success = ib_database_create(DATABASE);
+  assert(success);
+
+  create_table();
+
+  insert_rows();
+
+  std::vector<std::thread> threads;
+
+  for (int i = 0; i < N_UPDATERS; ++i) {
+    threads.emplace_back(updater, i);
+  }
+
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  delete_rows();
+
+  wait_for_purge();
+
+  check_rows();
+
+  OK(drop_table(DATABASE, TABLE));
+
+  OK(ib_shutdown(IB_SHUTDOWN_NORMAL));
+
+  return EXIT_SUCCESS;
+}
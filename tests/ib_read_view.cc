@@ -0,0 +1,239 @@
+/***************************************************************************
+Copyright (c) 2024 Sunny Bains. All rights reserved.
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; version 2 of the License.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+
+************************************************************************/
+
+/* Open read views while other transactions commit.
+
+ Create a database
+ CREATE TABLE t(c1 INT, PK(c1));
+
+ In N_WRITERS threads, writer w:
+   BEGIN;
+   INSERT INTO t VALUES(w * N_KEYS + 2 * k), (w * N_KEYS + 2 * k + 1);
+   COMMIT;  -- N_TRXS times, k = 0, 1, ...
+
+ In N_READERS threads, until the writers are done:
+   BEGIN;
+   SELECT c1 FROM t;  -- twice, in the same read view
+   COMMIT;
+
+ The view of a reader must contain every transaction that committed before
+ it was opened, no transaction that had not started when the reader's
+ second scan ended, and both or none of the rows of each transaction. Both
+ scans must return the same rows. */
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <array>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "test0aux.h"
+
+#define DATABASE "test"
+#define TABLE "t"
+
+/** Number of writing threads. */
+static const int N_WRITERS = 4;
+
+/** Number of reading threads. */
+static const int N_READERS = 4;
+
+/** Number of transactions of each writer. */
+static const int N_TRXS = 2000;
+
+/** Keys of each writer. */
+static const int N_KEYS = 2 * N_TRXS;
+
+/** Number of transactions started by each writer. */
+static std::array<std::atomic<int>, N_WRITERS> n_started;
+
+/** Number of transactions committed by each writer. */
+static std::array<std::atomic<int>, N_WRITERS> n_committed;
+
+/** Number of the writers that are done. */
+static std::atomic<int> n_done;
+
+/** CREATE TABLE t(c1 INT, PRIMARY KEY(c1)); */
+static void create_table() {
+  ib_id_t table_id = 0;
+  ib_tbl_sch_t ib_tbl_sch = nullptr;
+  ib_idx_sch_t ib_idx_sch = nullptr;
+
+  OK(ib_table_schema_create(DATABASE "/" TABLE, &ib_tbl_sch, IB_TBL_V1, 0));
+  OK(ib_table_schema_add_col(ib_tbl_sch, "c1", IB_INT, IB_COL_NONE, 0, 4));
+  OK(ib_table_schema_add_index(ib_tbl_sch, "c1", &ib_idx_sch));
+  OK(ib_index_schema_add_col(ib_idx_sch, "c1", 0));
+  OK(ib_index_schema_set_clustered(ib_idx_sch));
+
+  auto ib_trx = ib_trx_begin(IB_TRX_REPEATABLE_READ);
+
+  OK(ib_schema_lock_exclusive(ib_trx));
+  OK(ib_table_create(ib_trx, ib_tbl_sch, &table_id));
+  OK(ib_trx_commit(ib_trx));
+
+  ib_table_schema_delete(ib_tbl_sch);
+}
+
+/** Commits N_TRXS transactions of two rows each.
+@param[in] w                    Writer number. */
+static void writer(int w) {
+  for (int k = 0; k < N_TRXS; ++k) {
+    ib_crsr_t crsr;
+
+    ++n_started[w];
+
+    auto ib_trx = ib_trx_begin(IB_TRX_REPEATABLE_READ);
+
+    OK(ib_cursor_open_table(DATABASE "/" TABLE, ib_trx, &crsr));
+    OK(ib_cursor_lock(crsr, IB_LOCK_IX));
+
+    auto tpl = ib_clust_read_tuple_create(crsr);
+    assert(tpl != nullptr);
+
+    for (int j = 0; j < 2; ++j) {
+      OK(ib_tuple_write_i32(tpl, 0, w * N_KEYS + 2 * k + j));
+      OK(ib_cursor_insert_row(crsr, tpl));
+
+      tpl = ib_tuple_clear(tpl);
+      assert(tpl != nullptr);
+    }
+
+    ib_tuple_delete(tpl);
+
+    OK(ib_cursor_close(crsr));
+    OK(ib_trx_commit(ib_trx));
+
+    ++n_committed[w];
+  }
+
+  ++n_done;
+}
+
+/** SELECT c1 FROM t; counts the rows of each writer.
+@param[in] crsr                 Cursor on the table.
+@param[out] n_rows              Number of rows of each writer. */
+static void scan(ib_crsr_t crsr, std::array<int, N_WRITERS> &n_rows) {
+  n_rows.fill(0);
+
+  auto tpl = ib_clust_read_tuple_create(crsr);
+  assert(tpl != nullptr);
+
+  auto err = ib_cursor_first(crsr);
+
+  while (err == DB_SUCCESS) {
+    int32_t key;
+
+    OK(ib_cursor_read_row(crsr, tpl));
+    OK(ib_tuple_read_i32(tpl, 0, &key));
+
+    ++n_rows[key / N_KEYS];
+
+    err = ib_cursor_next(crsr);
+  }
+
+  assert(err == DB_END_OF_INDEX || err == DB_RECORD_NOT_FOUND);
+
+  ib_tuple_delete(tpl);
+}
+
+/** Checks the contents of read views opened while the writers commit.
+@param[in] i                    Reader number. */
+static void reader(int i) {
+  int n_views{};
+
+  while (n_done < N_WRITERS) {
+    ib_crsr_t crsr;
+    std::array<int, N_WRITERS> n_before;
+    std::array<int, N_WRITERS> n_after;
+    std::array<int, N_WRITERS> n_rows;
+    std::array<int, N_WRITERS> n_rows_again;
+
+    for (int w = 0; w < N_WRITERS; ++w) {
+      n_before[w] = n_committed[w];
+    }
+
+    auto ib_trx = ib_trx_begin(IB_TRX_REPEATABLE_READ);
+
+    OK(ib_cursor_open_table(DATABASE "/" TABLE, ib_trx, &crsr));
+
+    /* The first read opens the view. */
+    scan(crsr, n_rows);
+    scan(crsr, n_rows_again);
+
+    for (int w = 0; w < N_WRITERS; ++w) {
+      n_after[w] = n_started[w];
+    }
+
+    OK(ib_cursor_close(crsr));
+    OK(ib_trx_commit(ib_trx));
+
+    for (int w = 0; w < N_WRITERS; ++w) {
+      /* A transaction is seen whole or not at all. */
+      assert(n_rows[w] % 2 == 0);
+
+      assert(n_rows[w] / 2 >= n_before[w]);
+      assert(n_rows[w] / 2 <= n_after[w]);
+
+      assert(n_rows_again[w] == n_rows[w]);
+    }
+
+    ++n_views;
+  }
+
+  printf("Reader#%d - %d views\n", i, n_views);
+}
+
+int main(int argc, char *argv[]) {
+  (void)argc;
+  (void)argv;
+
+  OK(ib_init());
+
+  test_configure();
+
+  OK(ib_startup("default"));
+
+  auto success = ib_database_create(DATABASE);
+  assert(success);
+
+  create_table();
+
+  std::vector<std::thread> threads;
+
+  for (int w = 0; w < N_WRITERS; ++w) {
+    threads.emplace_back(writer, w);
+  }
+
+  for (int i = 0; i < N_READERS; ++i) {
+    threads.emplace_back(reader, i);
+  }
+
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  OK(drop_table(DATABASE, TABLE));
+
+  OK(ib_shutdown(IB_SHUTDOWN_NORMAL));
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,183 @@
+/***************************************************************************
+Copyright (c) 2024 Sunny Bains. All rights reserved.
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; version 2 of the License.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+
+************************************************************************/
+
+/* Assign rollback segments to the transactions of several threads.
+
+ Create a database with N_RSEGS rollback segments
+ CREATE TABLE t(c1 INT, PK(c1));
+
+ In N_THREADS threads, thread i, N_TRXS times:
+   BEGIN;
+   INSERT INTO t VALUES(i * N_TRXS + k);
+   COMMIT;
+
+ Every transaction of a thread must be assigned the same rollback segment,
+ the threads must be assigned different ones and never the SYSTEM rollback
+ segment. The rollback segment of a transaction is not visible through the
+ API, the test reads it from the trx object. */
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <atomic>
+#include <set>
+#include <thread>
+#include <vector>
+
+#include "test0aux.h"
+#include "srv0srv.h"
+#include "trx0rseg.h"
+#include "trx0sys.h"
+
+#define DATABASE "test"
+#define TABLE "t"
+
+/** Number of rollback segments, including the SYSTEM rollback segment. */
+static const int N_RSEGS = 32;
+
+/** Number of threads. */
+static const int N_THREADS = 8;
+
+/** Number of transactions of each thread. */
+static const int N_TRXS = 200;
+
+/** Rollback segment id assigned to each thread. */
+static ulint rseg_ids[N_THREADS];
+
+/** Number of the threads that started their first transaction. */
+static std::atomic<int> n_started;
+
+/** CREATE TABLE t(c1 INT, PRIMARY KEY(c1)); */
+static void create_table() {
+  ib_id_t table_id = 0;
+  ib_tbl_sch_t ib_tbl_sch = nullptr;
+  ib_idx_sch_t ib_idx_sch = nullptr;
+
+  OK(ib_table_schema_create(DATABASE "/" TABLE, &ib_tbl_sch, IB_TBL_V1, 0));
+  OK(ib_table_schema_add_col(ib_tbl_sch, "c1", IB_INT, IB_COL_NONE, 0, 4));
+  OK(ib_table_schema_add_index(ib_tbl_sch, "c1", &ib_idx_sch));
+  OK(ib_index_schema_add_col(ib_idx_sch, "c1", 0));
+  OK(ib_index_schema_set_clustered(ib_idx_sch));
+
+  auto ib_trx = ib_trx_begin(IB_TRX_REPEATABLE_READ);
+
+  OK(ib_schema_lock_exclusive(ib_trx));
+  OK(ib_table_create(ib_trx, ib_tbl_sch, &table_id));
+  OK(ib_trx_commit(ib_trx));
+
+  ib_table_schema_delete(ib_tbl_sch);
+}
+
+/** BEGIN; INSERT INTO t VALUES(c1); COMMIT;
+@param[in] c1                   Key.
+@return the id of the rollback segment of the transaction. */
+static ulint insert_row(int c1) {
+  ib_crsr_t crsr;
+  auto ib_trx = ib_trx_begin(IB_TRX_REPEATABLE_READ);
+
+  OK(ib_cursor_open_table(DATABASE "/" TABLE, ib_trx, &crsr));
+  OK(ib_cursor_lock(crsr, IB_LOCK_IX));
+
+  auto tpl = ib_clust_read_tuple_create(crsr);
+  assert(tpl != nullptr);
+
+  OK(ib_tuple_write_i32(tpl, 0, c1));
+  OK(ib_cursor_insert_row(crsr, tpl));
+
+  ib_tuple_delete(tpl);
+
+  OK(ib_cursor_close(crsr));
+
+  auto trx = reinterpret_cast<Trx *>(ib_trx);
+
+  assert(trx->m_rseg != nullptr);
+
+  const auto rseg_id = trx->m_rseg->id;
+
+  OK(ib_trx_commit(ib_trx));
+
+  return rseg_id;
+}
+
+/** Commits N_TRXS transactions, all on the same rollback segment.
+@param[in] i                    Thread number. */
+static void worker(int i) {
+  rseg_ids[i] = insert_row(i * N_TRXS);
+
+  assert(rseg_ids[i] != TRX_SYS_SYSTEM_RSEG_ID);
+
+  ++n_started;
+
+  for (int k = 1; k < N_TRXS; ++k) {
+    const auto rseg_id = insert_row(i * N_TRXS + k);
+
+    assert(rseg_id == rseg_ids[i]);
+  }
+}
+
+int main(int argc, char *argv[]) {
+  (void)argc;
+  (void)argv;
+
+  OK(ib_init());
+
+  test_configure();
+
+  OK(ib_cfg_set_int("rollback_segments", N_RSEGS));
+
+  OK(ib_startup("default"));
+
+  auto success = ib_database_create(DATABASE);
+  assert(success);
+
+  create_table();
+
+  assert(srv_trx_sys->m_n_rseg_slots.load() == N_RSEGS - 1);
+
+  std::vector<std::thread> threads;
+
+  /* The threads get their home rollback segment in the order of their first
+  transaction, start them one after the other. */
+  for (int i = 0; i < N_THREADS; ++i) {
+    threads.emplace_back(worker, i);
+
+    while (n_started <= i) {
+      std::this_thread::yield();
+    }
+  }
+
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  const std::set<ulint> distinct(rseg_ids, rseg_ids + N_THREADS);
+
+  assert(distinct.size() == N_THREADS);
+
+  for (int i = 0; i < N_THREADS; ++i) {
+    printf("Thread#%d - rollback segment %lu\n", i, (unsigned long)rseg_ids[i]);
+  }
+
+  OK(drop_table(DATABASE, TABLE));
+
+  OK(ib_shutdown(IB_SHUTDOWN_NORMAL));
+
+  return EXIT_SUCCESS;
+}
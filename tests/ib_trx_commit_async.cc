@@ -0,0 +1,270 @@
+/***************************************************************************
+Copyright (c) 2024 Sunny Bains. All rights reserved.
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; version 2 of the License.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+
+************************************************************************/
+
+/* Commit without waiting for the log write.
+
+ Create a database
+ CREATE TABLE t(c1 INT, PK(c1));
+
+ In N_THREADS threads, thread i, N_TRXS times:
+   BEGIN;
+   INSERT INTO t VALUES(i * N_TRXS + k);
+   COMMIT;  -- ib_trx_commit_async()
+
+ The callback of every commit must be invoked exactly once, and only when
+ the log is flushed past the commit. Then the same again just before the
+ shutdown, without waiting for the callbacks: they must all have been
+ invoked when ib_shutdown() returns, and all the rows must be there after a
+ restart. The commit LSN is not visible through the API, the test checks the
+ flushed LSN against the LSN read just before the commit, which is not after
+ it. */
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "test0aux.h"
+#include "log0log.h"
+
+#define DATABASE "test"
+#define TABLE "t"
+
+/** Number of committing threads. */
+static const int N_THREADS = 4;
+
+/** Number of transactions of each thread in a round. */
+static const int N_TRXS = 500;
+
+/** Number of rounds, the callbacks of the last one are left to the shutdown. */
+static const int N_ROUNDS = 2;
+
+/** How long to wait for the callbacks of a round. */
+static const int DURABLE_TIMEOUT_SECS = 60;
+
+/** A commit waiting for its callback. */
+struct Commit {
+  /** LSN just before the commit */
+  lsn_t m_lsn{};
+
+  /** Number of times the callback was invoked */
+  std::atomic<int> m_n_calls{};
+};
+
+/** The commits of each round and thread. */
+static Commit commits[N_ROUNDS][N_THREADS][N_TRXS];
+
+/** Number of callbacks invoked. */
+static std::atomic<int> n_durable;
+
+/** CREATE TABLE t(c1 INT, PRIMARY KEY(c1)); */
+static void create_table() {
+  ib_id_t table_id = 0;
+  ib_tbl_sch_t ib_tbl_sch = nullptr;
+  ib_idx_sch_t ib_idx_sch = nullptr;
+
+  OK(ib_table_schema_create(DATABASE "/" TABLE, &ib_tbl_sch, IB_TBL_V1, 0));
+  OK(ib_table_schema_add_col(ib_tbl_sch, "c1", IB_INT, IB_COL_NONE, 0, 4));
+  OK(ib_table_schema_add_index(ib_tbl_sch, "c1", &ib_idx_sch));
+  OK(ib_index_schema_add_col(ib_idx_sch, "c1", 0));
+  OK(ib_index_schema_set_clustered(ib_idx_sch));
+
+  auto ib_trx = ib_trx_begin(IB_TRX_REPEATABLE_READ);
+
+  OK(ib_schema_lock_exclusive(ib_trx));
+  OK(ib_table_create(ib_trx, ib_tbl_sch, &table_id));
+  OK(ib_trx_commit(ib_trx));
+
+  ib_table_schema_delete(ib_tbl_sch);
+}
+
+/** Invoked once the commit is durable.
+@param[in] ctx                  The commit. */
+static void durable(void *ctx) {
+  auto commit = static_cast<Commit *>(ctx);
+
+  log_sys->acquire();
+
+  const auto flushed_lsn = log_sys->m_flushed_to_disk_lsn;
+
+  log_sys->release();
+
+  assert(flushed_lsn >= commit->m_lsn);
+
+  const auto n_calls = ++commit->m_n_calls;
+  assert(n_calls == 1);
+
+  ++n_durable;
+}
+
+/** Inserts a row in each of N_TRXS transactions and commits them without
+waiting for the log write.
+@param[in] round                Round number.
+@param[in] i                    Thread number. */
+static void committer(int round, int i) {
+  for (int k = 0; k < N_TRXS; ++k) {
+    ib_crsr_t crsr;
+    auto commit = &commits[round][i][k];
+    auto ib_trx = ib_trx_begin(IB_TRX_REPEATABLE_READ);
+
+    OK(ib_cursor_open_table(DATABASE "/" TABLE, ib_trx, &crsr));
+    OK(ib_cursor_lock(crsr, IB_LOCK_IX));
+
+    auto tpl = ib_clust_read_tuple_create(crsr);
+    assert(tpl != nullptr);
+
+    OK(ib_tuple_write_i32(tpl, 0, (round * N_THREADS + i) * N_TRXS + k));
+    OK(ib_cursor_insert_row(crsr, tpl));
+
+    ib_tuple_delete(tpl);
+
+    OK(ib_cursor_close(crsr));
+
+    /* The commit is written after this LSN. */
+    commit->m_lsn = log_sys->get_lsn();
+
+    OK(ib_trx_commit_async(ib_trx, durable, commit));
+  }
+}
+
+/** Runs a round of commits in N_THREADS threads.
+@param[in] round                Round number. */
+static void run_round(int round) {
+  std::vector<std::thread> threads;
+
+  for (int i = 0; i < N_THREADS; ++i) {
+    threads.emplace_back(committer, round, i);
+  }
+
+  for (auto &thread : threads) {
+    thread.join();
+  }
+}
+
+/** Waits for the callbacks of all the commits so far.
+@param[in] n_commits            Number of commits. */
+static void wait_for_durable(int n_commits) {
+  for (int i = 0; i < DURABLE_TIMEOUT_SECS * 10; ++i) {
+    if (n_durable == n_commits) {
+      printf("%d commits durable\n", n_commits);
+      return;
+    }
+
+    usleep(100000);
+  }
+
+  fprintf(stderr, "Only %d of %d commits durable\n", n_durable.load(), n_commits);
+  exit(EXIT_FAILURE);
+}
+
+/** Checks that the callback of every commit of a round was invoked.
+@param[in] round                Round number. */
+static void check_round(int round) {
+  for (int i = 0; i < N_THREADS; ++i) {
+    for (int k = 0; k < N_TRXS; ++k) {
+      assert(commits[round][i][k].m_n_calls == 1);
+    }
+  }
+}
+
+/** SELECT COUNT(*) FROM t;
+@return the number of rows. */
+static int count_rows() {
+  ib_crsr_t crsr;
+  int n_rows{};
+  auto ib_trx = ib_trx_begin(IB_TRX_REPEATABLE_READ);
+
+  OK(ib_cursor_open_table(DATABASE "/" TABLE, ib_trx, &crsr));
+
+  auto tpl = ib_clust_read_tuple_create(crsr);
+  assert(tpl != nullptr);
+
+  auto err = ib_cursor_first(crsr);
+
+  while (err == DB_SUCCESS) {
+    OK(ib_cursor_read_row(crsr, tpl));
+
+    ++n_rows;
+
+    err = ib_cursor_next(crsr);
+  }
+
+  assert(err == DB_END_OF_INDEX || err == DB_RECORD_NOT_FOUND);
+
+  ib_tuple_delete(tpl);
+
+  OK(ib_cursor_close(crsr));
+  OK(ib_trx_commit(ib_trx));
+
+  return n_rows;
+}
+
+int main(int argc, char *argv[]) {
+  (void)argc;
+  (void)argv;
+
+  OK(ib_init());
+
+  test_configure();
+
+  OK(ib_startup("default"));
+
+  auto success = ib_database_create(DATABASE);
+  assert(success);
+
+  create_table();
+
+  for (int round = 0; round < N_ROUNDS - 1; ++round) {
+    run_round(round);
+
+    wait_for_durable((round + 1) * N_THREADS * N_TRXS);
+
+    check_round(round);
+  }
+
+  /* Leave the callbacks of the last round to the shutdown, the table is
+  dropped after a restart so that nothing else waits for the log before. */
+  run_round(N_ROUNDS - 1);
+
+  printf("%d of %d commits durable at shutdown\n", n_durable.load(), N_ROUNDS * N_THREADS * N_TRXS);
+
+  OK(ib_shutdown(IB_SHUTDOWN_NORMAL));
+
+  assert(n_durable == N_ROUNDS * N_THREADS * N_TRXS);
+
+  check_round(N_ROUNDS - 1);
+
+  OK(ib_init());
+
+  test_configure();
+
+  OK(ib_startup("default"));
+
+  assert(count_rows() == N_ROUNDS * N_THREADS * N_TRXS);
+
+  OK(drop_table(DATABASE, TABLE));
+
+  OK(ib_shutdown(IB_SHUTDOWN_NORMAL));
+
+  return EXIT_SUCCESS;
+}
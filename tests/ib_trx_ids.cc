@@ -0,0 +1,224 @@
+/***************************************************************************
+Copyright (c) 2024 Sunny Bains. All rights reserved.
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; version 2 of the License.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+
+************************************************************************/
+
+/* Look up transactions by id after begin, commit and rollback.
+
+ Create a database
+ CREATE TABLE t(c1 INT, PK(c1));
+
+ For N_ROUNDS rounds:
+   BEGIN; INSERT INTO t VALUES(k);  -- N_TRXS transactions open at once
+   -- every trx is found by its id
+   COMMIT the even ones, ROLLBACK the odd ones;
+   -- none of the ids is found, the ids of the trxs that reuse the pooled
+   -- objects in the next round are new
+
+ The index on the trx list by trx id is not visible through the API, the
+ test reads it from the trx system. */
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <vector>
+
+#include "test0aux.h"
+#include "srv0srv.h"
+#include "trx0sys.h"
+
+#define DATABASE "test"
+#define TABLE "t"
+
+/** Number of transactions open at the same time. */
+static const int N_TRXS = 64;
+
+/** Number of rounds, the later ones reuse the pooled trx objects. */
+static const int N_ROUNDS = 3;
+
+/** CREATE TABLE t(c1 INT, PRIMARY KEY(c1)); */
+static void create_table() {
+  ib_id_t table_id = 0;
+  ib_tbl_sch_t ib_tbl_sch = nullptr;
+  ib_idx_sch_t ib_idx_sch = nullptr;
+
+  OK(ib_table_schema_create(DATABASE "/" TABLE, &ib_tbl_sch, IB_TBL_V1, 0));
+  OK(ib_table_schema_add_col(ib_tbl_sch, "c1", IB_INT, IB_COL_NONE, 0, 4));
+  OK(ib_table_schema_add_index(ib_tbl_sch, "c1", &ib_idx_sch));
+  OK(ib_index_schema_add_col(ib_idx_sch, "c1", 0));
+  OK(ib_index_schema_set_clustered(ib_idx_sch));
+
+  auto ib_trx = ib_trx_begin(IB_TRX_REPEATABLE_READ);
+
+  OK(ib_schema_lock_exclusive(ib_trx));
+  OK(ib_table_create(ib_trx, ib_tbl_sch, &table_id));
+  OK(ib_trx_commit(ib_trx));
+
+  ib_table_schema_delete(ib_tbl_sch);
+}
+
+/** INSERT INTO t VALUES(c1); in the transaction.
+@param[in] ib_trx               Transaction.
+@param[in] c1                   Key. */
+static void insert_row(ib_trx_t ib_trx, int c1) {
+  ib_crsr_t crsr;
+
+  OK(ib_cursor_open_table(DATABASE "/" TABLE, ib_trx, &crsr));
+  OK(ib_cursor_lock(crsr, IB_LOCK_IX));
+
+  auto tpl = ib_clust_read_tuple_create(crsr);
+  assert(tpl != nullptr);
+
+  OK(ib_tuple_write_i32(tpl, 0, c1));
+  OK(ib_cursor_insert_row(crsr, tpl));
+
+  ib_tuple_delete(tpl);
+
+  OK(ib_cursor_close(crsr));
+}
+
+/** SELECT COUNT(*) FROM t;
+@return the number of rows. */
+static int count_rows() {
+  ib_crsr_t crsr;
+  int n_rows{};
+  auto ib_trx = ib_trx_begin(IB_TRX_REPEATABLE_READ);
+
+  OK(ib_cursor_open_table(DATABASE "/" TABLE, ib_trx, &crsr));
+
+  auto tpl = ib_clust_read_tuple_create(crsr);
+  assert(tpl != nullptr);
+
+  auto err = ib_cursor_first(crsr);
+
+  while (err == DB_SUCCESS) {
+    OK(ib_cursor_read_row(crsr, tpl));
+
+    ++n_rows;
+
+    err = ib_cursor_next(crsr);
+  }
+
+  assert(err == DB_END_OF_INDEX || err == DB_RECORD_NOT_FOUND);
+
+  ib_tuple_delete(tpl);
+
+  OK(ib_cursor_close(crsr));
+  OK(ib_trx_commit(ib_trx));
+
+  return n_rows;
+}
+
+/** Checks the index of the trx list by trx id.
+@param[in] ids                  Trx ids to look up.
+@param[in] trxs                 The trx of each id, nullptr if the id must
+                                not be found. */
+static void check_ids(const std::vector<trx_id_t> &ids, const std::vector<Trx *> &trxs) {
+  srv_trx_sys->mutex_acquire();
+
+  /* The index contains exactly the transactions in the list. */
+  const auto n_ids = srv_trx_sys->m_trx_ids.size();
+  const auto n_trxs = UT_LIST_GET_LEN(srv_trx_sys->m_trx_list);
+
+  for (size_t i = 0; i < ids.size(); ++i) {
+    const auto trx = srv_trx_sys->get_on_id(ids[i]);
+
+    assert(trx == trxs[i]);
+  }
+
+  srv_trx_sys->mutex_release();
+
+  assert(n_ids == n_trxs);
+}
+
+/** Runs one round of N_TRXS concurrent transactions.
+@param[in] round                Round number.
+@param[in,out] max_id           Biggest trx id of the previous rounds. */
+static void run_round(int round, trx_id_t &max_id) {
+  std::vector<trx_id_t> ids;
+  std::vector<Trx *> trxs;
+  std::vector<ib_trx_t> ib_trxs;
+
+  for (int i = 0; i < N_TRXS; ++i) {
+    auto ib_trx = ib_trx_begin(IB_TRX_REPEATABLE_READ);
+    assert(ib_trx != nullptr);
+
+    auto trx = reinterpret_cast<Trx *>(ib_trx);
+
+    /* A trx that reuses a pooled object gets a new id. */
+    assert(trx->m_id > max_id);
+
+    insert_row(ib_trx, round * N_TRXS + i);
+
+    ids.push_back(trx->m_id);
+    trxs.push_back(trx);
+    ib_trxs.push_back(ib_trx);
+  }
+
+  check_ids(ids, trxs);
+
+  for (int i = 0; i < N_TRXS; ++i) {
+    if (i % 2 == 0) {
+      OK(ib_trx_commit(ib_trxs[i]));
+    } else {
+      OK(ib_trx_rollback(ib_trxs[i]));
+    }
+
+    /* Only the ones not yet ended are found. */
+    trxs[i] = nullptr;
+
+    check_ids(ids, trxs);
+  }
+
+  for (auto id : ids) {
+    max_id = std::max(max_id, id);
+  }
+
+  const auto n_rows = count_rows();
+  assert(n_rows == (round + 1) * N_TRXS / 2);
+
+  printf("Round %d: %d transactions found and removed by id\n", round, N_TRXS);
+}
+
+int main(int argc, char *argv[]) {
+  (void)argc;
+  (void)argv;
+
+  OK(ib_init());
+
+  test_configure();
+
+  OK(ib_startup("default"));
+
+  auto success = ib_database_create(DATABASE);
+  assert(success);
+
+  create_table();
+
+  trx_id_t max_id{};
+
+  for (int round = 0; round < N_ROUNDS; ++round) {
+    run_round(round, max_id);
+  }
+
+  OK(drop_table(DATABASE, TABLE));
+
+  OK(ib_shutdown(IB_SHUTDOWN_NORMAL));
+
+  return EXIT_SUCCESS;
+}
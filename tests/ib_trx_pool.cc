@@ -0,0 +1,251 @@
+/***************************************************************************
+Copyright (c) 2024 Sunny Bains. All rights reserved.
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; version 2 of the License.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+
+************************************************************************/
+
+/* Reuse a pooled trx object after a lock wait timeout.
+
+ Create a database
+ CREATE TABLE t(c1 INT, PK(c1));
+ INSERT INTO t VALUES(0);
+
+ BEGIN;
+ SELECT * FROM t WHERE c1 = 0 FOR UPDATE;
+
+ In another trx:
+ SET ISOLATION LEVEL READ COMMITTED; BEGIN;
+ SELECT * FROM t WHERE c1 = 0 FOR UPDATE;  -- times out
+
+ Then begin transactions until one reuses the object of the one that timed
+ out. It must be in the state of a new transaction: nothing of the lock
+ wait, the error or the isolation level is left, and it can be used. The trx
+ objects are not visible through the API, the test reads their fields. */
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <vector>
+
+#include "test0aux.h"
+#include "trx0trx.h"
+
+#define DATABASE "test"
+#define TABLE "t"
+
+/** Lock wait timeout in seconds. */
+static const int LOCK_WAIT_TIMEOUT = 1;
+
+/** Maximum number of transactions begun to find the pooled object. */
+static const int MAX_TRXS = 256;
+
+/** CREATE TABLE t(c1 INT, PRIMARY KEY(c1)); INSERT INTO t VALUES(0); */
+static void create_table() {
+  ib_crsr_t crsr;
+  ib_id_t table_id = 0;
+  ib_tbl_sch_t ib_tbl_sch = nullptr;
+  ib_idx_sch_t ib_idx_sch = nullptr;
+
+  OK(ib_table_schema_create(DATABASE "/" TABLE, &ib_tbl_sch, IB_TBL_V1, 0));
+  OK(ib_table_schema_add_col(ib_tbl_sch, "c1", IB_INT, IB_COL_NONE, 0, 4));
+  OK(ib_table_schema_add_index(ib_tbl_sch, "c1", &ib_idx_sch));
+  OK(ib_index_schema_add_col(ib_idx_sch, "c1", 0));
+  OK(ib_index_schema_set_clustered(ib_idx_sch));
+
+  auto ib_trx = ib_trx_begin(IB_TRX_REPEATABLE_READ);
+
+  OK(ib_schema_lock_exclusive(ib_trx));
+  OK(ib_table_create(ib_trx, ib_tbl_sch, &table_id));
+  OK(ib_trx_commit(ib_trx));
+
+  ib_table_schema_delete(ib_tbl_sch);
+
+  ib_trx = ib_trx_begin(IB_TRX_REPEATABLE_READ);
+
+  OK(ib_cursor_open_table(DATABASE "/" TABLE, ib_trx, &crsr));
+  OK(ib_cursor_lock(crsr, IB_LOCK_IX));
+
+  auto tpl = ib_clust_read_tuple_create(crsr);
+  assert(tpl != nullptr);
+
+  OK(ib_tuple_write_i32(tpl, 0, 0));
+  OK(ib_cursor_insert_row(crsr, tpl));
+
+  ib_tuple_delete(tpl);
+
+  OK(ib_cursor_close(crsr));
+  OK(ib_trx_commit(ib_trx));
+}
+
+/** BEGIN; SELECT * FROM t WHERE c1 = 0 FOR UPDATE;
+@param[in] level                Isolation level.
+@param[out] crsr                Cursor on t, in X lock mode.
+@param[out] err                 Error code of the search.
+@return the transaction that owns the cursor. */
+static ib_trx_t lock_row(ib_trx_level_t level, ib_crsr_t *crsr, ib_err_t *err) {
+  int res;
+  auto ib_trx = ib_trx_begin(level);
+
+  OK(ib_cursor_open_table(DATABASE "/" TABLE, nullptr, crsr));
+
+  ib_cursor_attach_trx(*crsr, ib_trx);
+
+  OK(ib_cursor_lock(*crsr, IB_LOCK_IX));
+  OK(ib_cursor_set_lock_mode(*crsr, IB_LOCK_X));
+
+  auto key_tpl = ib_clust_search_tuple_create(*crsr);
+  assert(key_tpl != nullptr);
+
+  OK(ib_tuple_write_i32(key_tpl, 0, 0));
+
+  *err = ib_cursor_moveto(*crsr, key_tpl, IB_CUR_GE, &res);
+  assert(*err != DB_SUCCESS || res == 0);
+
+  ib_tuple_delete(key_tpl);
+
+  return ib_trx;
+}
+
+/** COMMIT; or release the transaction if InnoDB rolled it back.
+@param[in] ib_trx               Transaction to end.
+@param[in] crsr                 Cursor attached to the transaction. */
+static void trx_end(ib_trx_t ib_trx, ib_crsr_t crsr) {
+  OK(ib_cursor_reset(crsr));
+
+  if (ib_trx_state(ib_trx) == IB_TRX_ACTIVE) {
+    OK(ib_trx_commit(ib_trx));
+  } else {
+    OK(ib_trx_release(ib_trx));
+  }
+
+  OK(ib_cursor_close(crsr));
+}
+
+/** Checks that a reused trx object is in the state of a new transaction.
+@param[in] trx                  Transaction that reuses a pooled object.
+@param[in] prev_id              Id of the transaction that used it before. */
+static void check_new(const Trx *trx, trx_id_t prev_id) {
+  assert(trx->m_id > prev_id);
+  assert(trx->m_conc_state == TRX_ACTIVE);
+  assert(trx->m_isolation_level == TRX_ISO_REPEATABLE_READ);
+  assert(trx->m_que_state == TRX_QUE_RUNNING);
+  assert(trx->m_error_state == DB_SUCCESS);
+  assert(trx->m_error_info == nullptr);
+  assert(trx->m_detailed_error[0] == '\0');
+  assert(!trx->m_was_chosen_as_deadlock_victim);
+  assert(trx->m_wait_lock == nullptr);
+  assert(trx->m_wait_thrs.empty());
+  assert(trx->m_lock_wait_thr == nullptr);
+  assert(trx->m_lock_wait_deadline == 0);
+  assert(trx->m_wait_started == 0);
+  assert(trx->m_trx_locks.empty());
+  assert(trx->m_undo_no == 0);
+  assert(trx->m_insert_undo == nullptr);
+  assert(trx->m_update_undo == nullptr);
+  assert(trx->m_read_view == nullptr);
+  assert(trx->m_global_read_view == nullptr);
+  assert(strcmp(trx->m_op_info, "") == 0);
+}
+
+int main(int argc, char *argv[]) {
+  (void)argc;
+  (void)argv;
+
+  ib_err_t err;
+  ib_crsr_t crsr;
+  ib_crsr_t wait_crsr;
+
+  OK(ib_init());
+
+  test_configure();
+
+  OK(ib_cfg_set_int("lock_wait_timeout", LOCK_WAIT_TIMEOUT));
+
+  OK(ib_startup("default"));
+
+  auto success = ib_database_create(DATABASE);
+  assert(success);
+
+  create_table();
+
+  auto ib_trx = lock_row(IB_TRX_REPEATABLE_READ, &crsr, &err);
+  OK(err);
+
+  auto wait_trx = lock_row(IB_TRX_READ_COMMITTED, &wait_crsr, &err);
+  assert(err == DB_LOCK_WAIT_TIMEOUT);
+
+  const auto pooled = reinterpret_cast<const Trx *>(wait_trx);
+  const auto prev_id = pooled->m_id;
+
+  assert(pooled->m_isolation_level == TRX_ISO_READ_COMMITTED);
+
+  trx_end(wait_trx, wait_crsr);
+
+  /* The pool hands out its objects in order, begin transactions until the
+  one that timed out is reused. */
+  std::vector<ib_trx_t> ib_trxs;
+
+  for (int i = 0; i < MAX_TRXS; ++i) {
+    auto reused = ib_trx_begin(IB_TRX_REPEATABLE_READ);
+    assert(reused != nullptr);
+
+    ib_trxs.push_back(reused);
+
+    if (reinterpret_cast<const Trx *>(reused) == pooled) {
+      break;
+    }
+  }
+
+  assert(reinterpret_cast<const Trx *>(ib_trxs.back()) == pooled);
+
+  printf("Pooled trx reused after %d transactions\n", (int)ib_trxs.size());
+
+  check_new(pooled, prev_id);
+
+  /* The lock holder is gone, the reused trx can lock the row. */
+  trx_end(ib_trx, crsr);
+
+  OK(ib_cursor_open_table(DATABASE "/" TABLE, nullptr, &wait_crsr));
+
+  ib_cursor_attach_trx(wait_crsr, ib_trxs.back());
+
+  OK(ib_cursor_lock(wait_crsr, IB_LOCK_IX));
+  OK(ib_cursor_set_lock_mode(wait_crsr, IB_LOCK_X));
+
+  auto key_tpl = ib_clust_search_tuple_create(wait_crsr);
+  assert(key_tpl != nullptr);
+
+  int res;
+
+  OK(ib_tuple_write_i32(key_tpl, 0, 0));
+  OK(ib_cursor_moveto(wait_crsr, key_tpl, IB_CUR_GE, &res));
+  assert(res == 0);
+
+  ib_tuple_delete(key_tpl);
+
+  OK(ib_cursor_close(wait_crsr));
+
+  for (auto reused : ib_trxs) {
+    OK(ib_trx_commit(reused));
+  }
+
+  OK(drop_table(DATABASE, TABLE));
+
+  OK(ib_shutdown(IB_SHUTDOWN_NORMAL));
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,237 @@
+/***************************************************************************
+Copyright (c) 2024 Sunny Bains. All rights reserved.
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; version 2 of the License.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+
+************************************************************************/
+
+/* Test the read-only transaction fast path.
+
+ Create a database
+ CREATE TABLE t(c1 INT, PK(c1));
+
+ - With trx_auto_read_only off, ib_trx_begin() assigns a trx id at once.
+ - With trx_auto_read_only on, a transaction that only reads never gets a
+   trx id, one whose cursor writes gets it before the write.
+ - A transaction started with ib_trx_begin_read_only() can't write, lock
+   or prepare.
+ - Preparing an auto-detected read-only transaction registers it.
+
+ The trx id is not visible through the API, the test reads it from the
+ transaction object. */
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "test0aux.h"
+#include "trx0trx.h"
+
+#define DATABASE "test"
+#define TABLE "t"
+
+/** @return the id of the transaction, 0 if it has none yet. */
+static trx_id_t trx_id(ib_trx_t ib_trx) {
+  return reinterpret_cast<Trx *>(ib_trx)->m_id;
+}
+
+/** CREATE TABLE t(c1 INT, PRIMARY KEY(c1)); */
+static void create_table() {
+  ib_id_t table_id = 0;
+  ib_tbl_sch_t ib_tbl_sch = nullptr;
+  ib_idx_sch_t ib_idx_sch = nullptr;
+
+  OK(ib_table_schema_create(DATABASE "/" TABLE, &ib_tbl_sch, IB_TBL_V1, 0));
+  OK(ib_table_schema_add_col(ib_tbl_sch, "c1", IB_INT, IB_COL_NONE, 0, 4));
+  OK(ib_table_schema_add_index(ib_tbl_sch, "c1", &ib_idx_sch));
+  OK(ib_index_schema_add_col(ib_idx_sch, "c1", 0));
+  OK(ib_index_schema_set_clustered(ib_idx_sch));
+
+  auto ib_trx = ib_trx_begin(IB_TRX_REPEATABLE_READ);
+
+  OK(ib_schema_lock_exclusive(ib_trx));
+  OK(ib_table_create(ib_trx, ib_tbl_sch, &table_id));
+  OK(ib_trx_commit(ib_trx));
+
+  ib_table_schema_delete(ib_tbl_sch);
+}
+
+/** INSERT INTO t VALUES(c1);
+@return the error code of the insert. */
+static ib_err_t insert_row(ib_crsr_t crsr, int c1) {
+  auto tpl = ib_clust_read_tuple_create(crsr);
+  assert(tpl != nullptr);
+
+  OK(ib_tuple_write_i32(tpl, 0, c1));
+
+  auto err = ib_cursor_insert_row(crsr, tpl);
+
+  ib_tuple_delete(tpl);
+
+  return err;
+}
+
+/** SELECT COUNT(*) FROM t;
+@return the number of rows. */
+static int count_rows(ib_crsr_t crsr) {
+  int n_rows{};
+  auto tpl = ib_clust_read_tuple_create(crsr);
+  assert(tpl != nullptr);
+
+  auto err = ib_cursor_first(crsr);
+
+  while (err == DB_SUCCESS) {
+    OK(ib_cursor_read_row(crsr, tpl));
+
+    ++n_rows;
+
+    err = ib_cursor_next(crsr);
+  }
+
+  assert(err == DB_END_OF_INDEX || err == DB_RECORD_NOT_FOUND);
+
+  ib_tuple_delete(tpl);
+
+  return n_rows;
+}
+
+/** Without auto-detection every transaction is registered when it starts. */
+static void test_no_auto_read_only() {
+  OK(ib_cfg_set_bool_off("trx_auto_read_only"));
+
+  auto ib_trx = ib_trx_begin(IB_TRX_REPEATABLE_READ);
+
+  assert(trx_id(ib_trx) != 0);
+
+  OK(ib_trx_commit(ib_trx));
+}
+
+/** A cursor that only reads keeps the transaction off the trx system, the
+first write registers it. */
+static void test_auto_read_only() {
+  ib_crsr_t crsr;
+
+  OK(ib_cfg_set_bool_on("trx_auto_read_only"));
+
+  auto ib_trx = ib_trx_begin(IB_TRX_REPEATABLE_READ);
+
+  assert(trx_id(ib_trx) == 0);
+
+  OK(ib_cursor_open_table(DATABASE "/" TABLE, ib_trx, &crsr));
+
+  const auto n_rows = count_rows(crsr);
+
+  assert(trx_id(ib_trx) == 0);
+
+  OK(ib_cursor_lock(crsr, IB_LOCK_IX));
+
+  assert(trx_id(ib_trx) != 0);
+
+  OK(insert_row(crsr, n_rows + 1));
+
+  /* The read view created before the write must see the write. */
+  auto n_rows_after = count_rows(crsr);
+  assert(n_rows_after == n_rows + 1);
+
+  OK(ib_cursor_close(crsr));
+  OK(ib_trx_commit(ib_trx));
+
+  /* A read-only transaction that is committed leaves no trace. */
+  ib_trx = ib_trx_begin(IB_TRX_REPEATABLE_READ);
+
+  OK(ib_cursor_open_table(DATABASE "/" TABLE, ib_trx, &crsr));
+
+  n_rows_after = count_rows(crsr);
+  assert(n_rows_after == n_rows + 1);
+  assert(trx_id(ib_trx) == 0);
+
+  OK(ib_cursor_close(crsr));
+  OK(ib_trx_commit(ib_trx));
+}
+
+/** A declared read-only transaction fails to write and to prepare. */
+static void test_declared_read_only() {
+  ib_crsr_t crsr;
+  auto ib_trx = ib_trx_begin_read_only(IB_TRX_REPEATABLE_READ);
+
+  OK(ib_cursor_open_table(DATABASE "/" TABLE, ib_trx, &crsr));
+
+  auto err = ib_cursor_lock(crsr, IB_LOCK_IX);
+  assert(err == DB_READONLY);
+
+  err = insert_row(crsr, -1);
+  assert(err == DB_READONLY);
+
+  assert(trx_id(ib_trx) == 0);
+
+  auto trx = reinterpret_cast<Trx *>(ib_trx);
+
+  const auto prepare_err = trx->prepare();
+  assert(prepare_err == DB_READONLY);
+  assert(trx->m_conc_state == TRX_ACTIVE);
+  assert(trx_id(ib_trx) == 0);
+
+  OK(ib_cursor_close(crsr));
+  OK(ib_trx_commit(ib_trx));
+}
+
+/** The XA prepare of a transaction on the fast path registers it first. */
+static void test_prepare_auto_read_only() {
+  OK(ib_cfg_set_bool_on("trx_auto_read_only"));
+
+  auto ib_trx = ib_trx_begin(IB_TRX_REPEATABLE_READ);
+  auto trx = reinterpret_cast<Trx *>(ib_trx);
+
+  assert(trx_id(ib_trx) == 0);
+
+  OK(trx->prepare());
+
+  assert(trx_id(ib_trx) != 0);
+  assert(trx->m_conc_state == TRX_PREPARED);
+
+  OK(ib_trx_commit(ib_trx));
+}
+
+int main(int argc, char *argv[]) {
+  (void)argc;
+  (void)argv;
+
+  OK(ib_init());
+
+  test_configure();
+
+  OK(ib_startup("default"));
+
+  auto success = ib_database_create(DATABASE);
+  assert(success);
+
+  create_table();
+
+  test_no_auto_read_only();
+
+  test_auto_read_only();
+
+  test_declared_read_only();
+
+  test_prepare_auto_read_only();
+
+  OK(ib_cfg_set_bool_off("trx_auto_read_only"));
+
+  OK(drop_table(DATABASE, TABLE));
+
+  OK(ib_shutdown(IB_SHUTDOWN_NORMAL));
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,297 @@
+/***************************************************************************
+Copyright (c) 2024 Sunny Bains. All rights reserved.
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; version 2 of the License.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+
+************************************************************************/
+
+/* Fill an undo tablespace past undo_tablespace_max_size and check that
+ purge truncates it and that it is used again afterwards.
+
+ Create a database
+ CREATE TABLE t(c1 INT, c2 VARCHAR(512), PK(c1));
+ INSERT N_ROWS rows
+ With a read view open, so that purge can't remove the history:
+   UPDATE t SET c2 = <random text>; COMMIT; -- until the undo file is too big
+ Close the read view, wait for the undo file to shrink
+ Repeat the updates, the undo file must grow again
+ DROP TABLE t;
+
+ Only the undo tablespace rollback segments are used: rollback_segments is
+ set to 1, the system rollback segment is assigned only if there is no other.
+ The test must be run in an empty directory. */
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <sys/stat.h>
+
+#include "test0aux.h"
+
+#define DATABASE "test"
+#define TABLE "t"
+
+/** The undo tablespace file, in the data home directory. */
+static const char undo_file[] = "undo_001.ibd";
+
+/** Number of rows in the table. */
+static const int N_ROWS = 1000;
+
+/** Truncation limit of the undo tablespace. */
+static const uint64_t UNDO_MAX_SIZE = 4 * 1024 * 1024;
+
+/** How long to wait for purge to truncate the undo tablespace. */
+static const int TRUNCATE_TIMEOUT_SECS = 120;
+
+/** @return size of the undo tablespace file in bytes. */
+static uint64_t undo_file_size() {
+  struct stat st;
+
+  auto ret = stat(undo_file, &st);
+  assert(ret == 0);
+
+  return st.st_size;
+}
+
+/** CREATE TABLE t(c1 INT, c2 VARCHAR(512), PRIMARY KEY(c1)); */
+static void create_table() {
+  ib_id_t table_id = 0;
+  ib_tbl_sch_t ib_tbl_sch = nullptr;
+  ib_idx_sch_t ib_idx_sch = nullptr;
+  char table_name[IB_MAX_TABLE_NAME_LEN];
+
+  snprintf(table_name, sizeof(table_name), "%s/%s", DATABASE, TABLE);
+
+  OK(ib_table_schema_create(table_name, &ib_tbl_sch, IB_TBL_V1, 0));
+  OK(ib_table_schema_add_col(ib_tbl_sch, "c1", IB_INT, IB_COL_NONE, 0, 4));
+  OK(ib_table_schema_add_col(ib_tbl_sch, "c2", IB_VARCHAR, IB_COL_NONE, 0, 512));
+  OK(ib_table_schema_add_index(ib_tbl_sch, "c1", &ib_idx_sch));
+  OK(ib_index_schema_add_col(ib_idx_sch, "c1", 0));
+  OK(ib_index_schema_set_clustered(ib_idx_sch));
+
+  auto ib_trx = ib_trx_begin(IB_TRX_REPEATABLE_READ);
+
+  OK(ib_schema_lock_exclusive(ib_trx));
+  OK(ib_table_create(ib_trx, ib_tbl_sch, &table_id));
+  OK(ib_trx_commit(ib_trx));
+
+  ib_table_schema_delete(ib_tbl_sch);
+}
+
+/** INSERT INTO t VALUES(i, <random text>), i in [0, N_ROWS). */
+static void insert_rows() {
+  ib_crsr_t crsr;
+  char text[512];
+  auto ib_trx = ib_trx_begin(IB_TRX_REPEATABLE_READ);
+
+  OK(ib_cursor_open_table(DATABASE "/" TABLE, ib_trx, &crsr));
+  OK(ib_cursor_lock(crsr, IB_LOCK_IX));
+
+  auto tpl = ib_clust_read_tuple_create(crsr);
+  assert(tpl != nullptr);
+
+  for (int i = 0; i < N_ROWS; ++i) {
+    auto len = gen_rand_text(text, sizeof(text));
+
+    OK(ib_tuple_write_i32(tpl, 0, i));
+    OK(ib_col_set_value(tpl, 1, text, len));
+    OK(ib_cursor_insert_row(crsr, tpl));
+
+    tpl = ib_tuple_clear(tpl);
+    assert(tpl != nullptr);
+  }
+
+  ib_tuple_delete(tpl);
+
+  OK(ib_cursor_close(crsr));
+  OK(ib_trx_commit(ib_trx));
+}
+
+/** UPDATE t SET c2 = <text of length len>; in one transaction.
+@param[in] len                  Length of the new c2 values. */
+static void update_rows(int len) {
+  ib_crsr_t crsr;
+  char text[512];
+  auto ib_trx = ib_trx_begin(IB_TRX_REPEATABLE_READ);
+
+  memset(text, 'a' + len % 26, len);
+
+  OK(ib_cursor_open_table(DATABASE "/" TABLE, ib_trx, &crsr));
+  OK(ib_cursor_lock(crsr, IB_LOCK_IX));
+  OK(ib_cursor_set_lock_mode(crsr, IB_LOCK_X));
+
+  auto old_tpl = ib_clust_read_tuple_create(crsr);
+  assert(old_tpl != nullptr);
+
+  auto new_tpl = ib_clust_read_tuple_create(crsr);
+  assert(new_tpl != nullptr);
+
+  auto err = ib_cursor_first(crsr);
+
+  while (err == DB_SUCCESS) {
+    OK(ib_cursor_read_row(crsr, old_tpl));
+    OK(ib_tuple_copy(new_tpl, old_tpl));
+    OK(ib_col_set_value(new_tpl, 1, text, len));
+    OK(ib_cursor_update_row(crsr, old_tpl, new_tpl));
+
+    err = ib_cursor_next(crsr);
+  }
+
+  assert(err == DB_END_OF_INDEX);
+
+  ib_tuple_delete(old_tpl);
+  ib_tuple_delete(new_tpl);
+
+  OK(ib_cursor_close(crsr));
+  OK(ib_trx_commit(ib_trx));
+}
+
+/** Check that all rows have a c2 value of length len.
+@param[in] len                  Expected length of the c2 values. */
+static void check_rows(int len) {
+  ib_crsr_t crsr;
+  int n_rows{};
+  auto ib_trx = ib_trx_begin(IB_TRX_REPEATABLE_READ);
+
+  OK(ib_cursor_open_table(DATABASE "/" TABLE, ib_trx, &crsr));
+
+  auto tpl = ib_clust_read_tuple_create(crsr);
+  assert(tpl != nullptr);
+
+  auto err = ib_cursor_first(crsr);
+
+  while (err == DB_SUCCESS) {
+    OK(ib_cursor_read_row(crsr, tpl));
+    assert(ib_col_get_len(tpl, 1) == (ulint)len);
+
+    ++n_rows;
+
+    err = ib_cursor_next(crsr);
+  }
+
+  assert(err == DB_END_OF_INDEX);
+  assert(n_rows == N_ROWS);
+
+  ib_tuple_delete(tpl);
+
+  OK(ib_cursor_close(crsr));
+  OK(ib_trx_commit(ib_trx));
+}
+
+/** Opens a read view that stops purge from removing the history after it.
+@return the transaction that owns the view. */
+static ib_trx_t open_read_view() {
+  ib_crsr_t crsr;
+  auto ib_trx = ib_trx_begin(IB_TRX_REPEATABLE_READ);
+
+  OK(ib_cursor_open_table(DATABASE "/" TABLE, ib_trx, &crsr));
+
+  auto tpl = ib_clust_read_tuple_create(crsr);
+  assert(tpl != nullptr);
+
+  /* The view is created by the first consistent read. */
+  OK(ib_cursor_first(crsr));
+  OK(ib_cursor_read_row(crsr, tpl));
+
+  ib_tuple_delete(tpl);
+
+  OK(ib_cursor_close(crsr));
+
+  return ib_trx;
+}
+
+/** Updates all the rows until the undo tablespace is bigger than the limit.
+The history can't be purged while the updates run.
+@return the length of the last c2 values written. */
+static int fill_undo_space() {
+  int len = 1;
+  auto view_trx = open_read_view();
+
+  while (undo_file_size() <= UNDO_MAX_SIZE) {
+    len = len % 500 + 10;
+    update_rows(len);
+  }
+
+  printf("Undo tablespace filled to %llu bytes\n", (unsigned long long)undo_file_size());
+
+  OK(ib_trx_commit(view_trx));
+
+  return len;
+}
+
+/** Waits for purge to truncate the undo tablespace. */
+static void wait_for_truncate() {
+  for (int i = 0; i < TRUNCATE_TIMEOUT_SECS; ++i) {
+    if (undo_file_size() < UNDO_MAX_SIZE) {
+      printf("Undo tablespace truncated to %llu bytes\n", (unsigned long long)undo_file_size());
+      return;
+    }
+
+    sleep(1);
+  }
+
+  fprintf(stderr, "Undo tablespace %s was not truncated\n", undo_file);
+  exit(EXIT_FAILURE);
+}
+
+int main(int argc, char *argv[]) {
+  (void)argc;
+  (void)argv;
+
+  OK(ib_init());
+
+  test_configure();
+
+  OK(ib_cfg_set_int("undo_tablespaces", 1));
+  OK(ib_cfg_set_int("rollback_segments", 1));
+  OK(ib_cfg_set_int("undo_tablespace_max_size", UNDO_MAX_SIZE));
+
+  OK(ib_startup("default"));
+
+  auto success = ib_database_create(DATABASE);
+  assert(success);
+
+  create_table();
+
+  insert_rows();
+
+  const auto initial_size = undo_file_size();
+
+  auto len = fill_undo_space();
+
+  wait_for_truncate();
+
+  check_rows(len);
+
+  /* The recreated tablespace must be assigned to new transactions again. */
+  const auto truncated_size = undo_file_size();
+
+  len = fill_undo_space();
+
+  assert(undo_file_size() > truncated_size);
+  assert(undo_file_size() > initial_size);
+
+  wait_for_truncate();
+
+  check_rows(len);
+
+  OK(drop_table(DATABASE, TABLE));
+
+  OK(ib_shutdown(IB_SHUTDOWN_NORMAL));
+
+  return EXIT_SUCCESS;
+}
@@ -28,6 +28,7 @@ Created 3/26/1996 Heikki Tuuri
 #include "fut0fut.h"
 #include "mach0data.h"
 #include "mtr0log.h"
+#include "os0thread-create.h"
 #include "os0thread.h"
 #include "que0que.h"
 #include "read0read.h"
@@ -37,11 +38,50 @@ Created 3/26/1996 Heikki Tuuri
 #include "trx0roll.h"
 #include "trx0rseg.h"
 #include "trx0trx.h"
+#include "ut0mpmcbq.h"
+
+#include <algorithm>
 
 /** A dummy undo record used as a return value when we have a whole undo log
 which needs no purge */
 trx_undo_rec_t trx_purge_dummy_rec;
 
+/** An undo log record dispatched by the purge coordinator to a purge worker */
+struct Purge_rec {
+  /** Copy of the undo log record, owned by the coordinator */
+  trx_undo_rec_t *m_undo_rec{};
+
+  /** Roll pointer to the undo log record */
+  roll_ptr_t m_roll_ptr{};
+
+  /** Reservation for the undo log record in the purge array */
+  trx_undo_inf_t *m_cell{};
+};
+
+/** A purge worker thread and the state it owns. All the records of a row
+are purged by the same worker, see Purge_sys::dispatch(). */
+struct Purge_worker {
+  Purge_worker() noexcept : m_queue(PURGE_WORKER_QUEUE_SIZE) {}
+
+  /** Background transaction used to freeze the data dictionary */
+  Trx *m_trx{};
+
+  /** Heap where m_node is allocated */
+  mem_heap_t *m_heap{};
+
+  /** Purge node used to purge the records */
+  purge_node_t *m_node{};
+
+  /** Signalled when records are queued or the worker should exit */
+  Cond_var *m_event{};
+
+  /** Records queued by the coordinator */
+  Bounded_channel<Purge_rec> m_queue;
+
+  /** The worker thread */
+  std::thread m_thread;
+};
+
 /**
  * Gets the biggest pair of a trx number and an undo number in a purge array.
  * 
@@ -180,12 +220,10 @@ void Purge_sys::free_segment(trx_rseg_t *rseg, Fil_addr hdr_addr, ulint n_remove
 
   flst_cut_end(rseg_hdr + TRX_RSEG_HISTORY, log_hdr + TRX_UNDO_HISTORY_NODE, n_removed_logs, &mtr);
 
-  mutex_enter(&kernel_mutex);
-
-  ut_ad(srv_trx_sys->m_rseg_history_len >= n_removed_logs);
-  srv_trx_sys->m_rseg_history_len -= n_removed_logs;
+  const auto history_len = srv_trx_sys->m_rseg_history_len.fetch_sub(n_removed_logs, std::memory_order_relaxed);
+  ut_ad(history_len >= n_removed_logs);
 
-  mutex_exit(&kernel_mutex);
+  m_n_logs_purged += n_removed_logs;
 
   do {
     /* Here we assume that a file segment with just the header
@@ -242,12 +280,10 @@ void Purge_sys::truncate_rseg_history(trx_rseg_t *rseg, trx_id_t limit_trx_no, u
     }
 
     if (cmp >= 0) {
-      mutex_enter(&kernel_mutex);
+      const auto history_len = srv_trx_sys->m_rseg_history_len.fetch_sub(n_removed_logs, std::memory_order_relaxed);
+      ut_a(history_len >= n_removed_logs);
 
-      ut_a(srv_trx_sys->m_rseg_history_len >= n_removed_logs);
-      srv_trx_sys->m_rseg_history_len -= n_removed_logs;
-
-      mutex_exit(&kernel_mutex);
+      m_n_logs_purged += n_removed_logs;
 
       flst_truncate_end(rseg_hdr + TRX_RSEG_HISTORY, log_hdr + TRX_UNDO_HISTORY_NODE, n_removed_logs, &mtr);
 
@@ -372,7 +408,7 @@ void Purge_sys::rseg_get_next_history_log(trx_rseg_t *rseg) noexcept {
 
     mtr.commit();
 
-    mutex_enter(&kernel_mutex);
+    srv_trx_sys->mutex_acquire();
 
     /* Add debug code to track history list corruption reported
     on the MySQL mailing list on Nov 9, 2004. The fut0lst.c
@@ -386,11 +422,11 @@ void Purge_sys::rseg_get_next_history_log(trx_rseg_t *rseg) noexcept {
         log_warn(std::format(
           "Purge reached the head of the history list, but its length is still"
           " reported as {}! Please submit a detailed bug report.",
-          srv_trx_sys->m_rseg_history_len
+          srv_trx_sys->m_rseg_history_len.load()
         ));
     }
 
-    mutex_exit(&kernel_mutex);
+    srv_trx_sys->mutex_release();
 
     return;
   }
@@ -613,7 +649,11 @@ Purge_sys::Purge_sys(Trx *trx) noexcept : m_trx(trx) {
 
   m_heap = mem_heap_create(256);
 
-  m_arr = trx_undo_arr_create();
+  m_arr = trx_undo_arr_create(PURGE_MAX_RECS_IN_FLIGHT);
+
+  m_batch_size = srv_config.m_purge_batch_size;
+
+  m_done_event = Cond_var::create("purge_done");
 
   m_trx->m_is_purge = true;
 
@@ -628,20 +668,19 @@ Purge_sys::Purge_sys(Trx *trx) noexcept : m_trx(trx) {
 Purge_sys::~Purge_sys() noexcept {
   ut_ad(!mutex_own(&kernel_mutex));
 
+  /* The workers must have been stopped before the threads are shut down. */
+  ut_a(m_workers.empty());
+
+  Cond_var::destroy(m_done_event);
+
   que_graph_free(m_query);
 
   ut_a(m_trx->m_is_purge);
   m_trx->m_conc_state = TRX_NOT_STARTED;
 
   if (m_view != nullptr) {
-    /* Because acquiring the kernel mutex is a pre-condition
-    of read_view_close(). We don't really need it here. */
-    mutex_enter(&kernel_mutex);
-
     read_view_close(m_view);
     m_view = nullptr;
-
-    mutex_exit(&kernel_mutex);
   }
 
   trx_undo_arr_free(m_arr);
@@ -690,9 +729,7 @@ void Purge_sys::add_update_undo_to_history(Trx *trx, page_t *undo_page, mtr_t *m
   /* Add the log as the first in the history list */
   flst_add_first(rseg_header + TRX_RSEG_HISTORY, undo_header + TRX_UNDO_HISTORY_NODE, mtr);
 
-  mutex_enter(&kernel_mutex);
-  ++srv_trx_sys->m_rseg_history_len;
-  mutex_exit(&kernel_mutex);
+  srv_trx_sys->m_rseg_history_len.fetch_add(1, std::memory_order_relaxed);
 
   /* Write the trx number to the undo log header */
   mlog_write_uint64(undo_header + TRX_UNDO_TRX_NO, trx->m_no, mtr);
@@ -738,7 +775,7 @@ ulint Purge_sys::run() noexcept {
 
   rw_lock_x_lock(&m_latch);
 
-  mutex_enter(&kernel_mutex);
+  srv_trx_sys->mutex_acquire();
 
   /* Close and free the old purge view */
 
@@ -746,44 +783,48 @@ ulint Purge_sys::run() noexcept {
   m_view = nullptr;
   mem_heap_empty(m_heap);
 
-  /* Determine how much data manipulation language (DML) statements
-  need to be delayed in order to reduce the lagging of the purge
-  thread. */
-  srv_dml_needed_delay = 0; /* in microseconds; default: no delay */
-
-  /* If we cannot advance the 'purge view' because of an old
-  'consistent read view', then the DML statements cannot be delayed.
-  Also, srv_config.m_max_purge_lag <= 0 means 'infinity'. */
-  if (srv_config.m_max_purge_lag > 0 && !UT_LIST_GET_LAST(srv_trx_sys->m_view_list)) {
-    float ratio = (float)srv_trx_sys->m_rseg_history_len / srv_config.m_max_purge_lag;
-    if (ratio > (float)ULINT_MAX / 10000) {
-      /* Avoid overflow: maximum delay is 4295 seconds */
-      srv_dml_needed_delay = ULINT_MAX;
-    } else if (ratio > 1) {
-      /* If the history list length exceeds the
-      innodb_max_purge_lag, the
-      data manipulation statements are delayed
-      by at least 5000 microseconds. */
-      srv_dml_needed_delay = (ulint)((ratio - .5) * 10000);
-    }
-  }
+  /* Meter the data manipulation language (DML) statements in order to
+  reduce the lagging of the purge. */
+  const auto history_len = srv_trx_sys->m_rseg_history_len.load(std::memory_order_relaxed);
+
+  update_dml_throttle(history_len);
+
+  adapt_batch_size(history_len);
 
   m_view = read_view_oldest_copy_or_open_new(0, m_heap);
 
-  mutex_exit(&kernel_mutex);
+  srv_trx_sys->mutex_release();
 
   rw_lock_x_unlock(&m_latch);
 
   m_state = PURGE_STATE_ON;
 
-  /* Handle at most 20 undo log pages in one purge batch */
+  /* Handle at most m_batch_size undo log pages in one purge batch */
 
-  m_handle_limit = m_n_pages_handled + 20;
+  m_handle_limit = m_n_pages_handled + m_batch_size;
 
   old_pages_handled = m_n_pages_handled;
 
   mutex_exit(&m_mutex);
 
+  if (srv_config.m_n_purge_threads > 1) {
+
+    if (m_workers.empty()) {
+      start_workers();
+    }
+
+    if (srv_print_thread_releases) {
+
+      log_info("Starting purge");
+    }
+
+    dispatch();
+
+    truncate_undo_spaces();
+
+    return m_n_pages_handled - old_pages_handled;
+  }
+
   mutex_enter(&kernel_mutex);
 
   thr = que_fork_start_command(m_query);
@@ -807,9 +848,364 @@ ulint Purge_sys::run() noexcept {
 
   que_run_threads(thr);
 
+  truncate_undo_spaces();
+
   return m_n_pages_handled - old_pages_handled;
 }
 
+void Dml_throttle::set_rate(double rate) noexcept {
+  uint64_t interval{};
+
+  if (rate > 0) {
+    interval = std::max(uint64_t{1}, static_cast<uint64_t>(1000000.0 / rate));
+  }
+
+  m_interval_us.store(interval, std::memory_order_relaxed);
+}
+
+uint64_t Dml_throttle::acquire() noexcept {
+  if (!m_lagging.load(std::memory_order_relaxed)) {
+    return 0;
+  }
+
+  m_n_acquired.fetch_add(1, std::memory_order_relaxed);
+
+  const auto interval = m_interval_us.load(std::memory_order_relaxed);
+
+  if (interval == 0) {
+    return 0;
+  }
+
+  const auto now = ut_time_us(nullptr);
+
+  /* Tokens not taken while idle accumulate up to the burst size. */
+  const auto earliest = now - std::min(now, interval * DML_THROTTLE_BURST);
+
+  auto next = m_next_us.load(std::memory_order_relaxed);
+  uint64_t issue;
+
+  do {
+    issue = std::max(next, earliest);
+  } while (!m_next_us.compare_exchange_weak(next, issue + interval, std::memory_order_relaxed));
+
+  if (issue <= now) {
+    return 0;
+  }
+
+  const auto delay = issue - now;
+
+  m_n_delayed.fetch_add(1, std::memory_order_relaxed);
+  m_delay_us.fetch_add(delay, std::memory_order_relaxed);
+
+  return delay;
+}
+
+void Purge_sys::update_dml_throttle(ulint history_len) noexcept {
+  ut_ad(mutex_own(&m_mutex));
+
+  const auto now = ut_time_us(nullptr);
+
+  if (m_throttle_time_us != 0 && now - m_throttle_time_us < DML_THROTTLE_INTERVAL_US) {
+    return;
+  }
+
+  const auto n_acquired = m_dml_throttle.m_n_acquired.load(std::memory_order_relaxed);
+  const auto n_logs_purged = m_n_logs_purged - m_throttle_n_logs_purged;
+
+  /* The history list growth is the logs added less the logs purged. */
+  const auto n_logs_added = int64_t(history_len) - int64_t(m_throttle_history_len) + int64_t(n_logs_purged);
+
+  const auto elapsed_us = now - m_throttle_time_us;
+  const auto first = m_throttle_time_us == 0;
+  const auto dml_rate = double(n_acquired - m_throttle_n_acquired) * 1000000.0 / elapsed_us;
+
+  m_throttle_time_us = now;
+  m_throttle_n_logs_purged = m_n_logs_purged;
+  m_throttle_history_len = history_len;
+  m_throttle_n_acquired = n_acquired;
+
+  const auto lagging = srv_config.m_max_purge_lag > 0 && history_len > srv_config.m_max_purge_lag;
+
+  /* The DML is only counted while the purge is lagging, the first interval
+  after it starts lagging measures the DML rate. */
+  const auto was_lagging = m_dml_throttle.m_lagging.exchange(lagging, std::memory_order_relaxed);
+
+  /* If we cannot advance the 'purge view' because of an old 'consistent
+  read view', then the DML statements cannot be delayed. Also,
+  srv_config.m_max_purge_lag <= 0 means 'infinity'. */
+  bool view_open;
+
+  mutex_enter(&srv_trx_sys->m_view_mutex);
+
+  view_open = UT_LIST_GET_LAST(srv_trx_sys->m_view_list) != nullptr;
+
+  mutex_exit(&srv_trx_sys->m_view_mutex);
+
+  if (!lagging || view_open) {
+
+    m_dml_throttle.set_rate(0);
+
+    return;
+
+  } else if (first || !was_lagging || n_logs_added <= 0) {
+
+    /* Nothing to measure, keep the current rate. */
+    return;
+  }
+
+  /* Let the DML through at the rate at which the purge removes the history,
+  less the fraction by which the history list is over the limit. */
+  auto rate = dml_rate * (double(n_logs_purged) / n_logs_added) * (double(srv_config.m_max_purge_lag) / history_len);
+
+  /* Change the rate gradually so that the latency degrades smoothly. */
+  const auto current = m_dml_throttle.rate();
+
+  if (current > 0) {
+    rate = std::clamp(rate, current / 2, current * 2);
+  }
+
+  m_dml_throttle.set_rate(std::max(rate, DML_THROTTLE_MIN_RATE));
+}
+
+void Purge_sys::adapt_batch_size(ulint history_len) noexcept {
+  const auto min_size = srv_config.m_purge_batch_size;
+  const auto max_size = min_size * PURGE_BATCH_SIZE_MAX_FACTOR;
+
+  if (history_len > m_prev_history_len) {
+    m_batch_size *= 2;
+  } else {
+    m_batch_size /= 2;
+  }
+
+  m_batch_size = std::clamp(m_batch_size, min_size, max_size);
+
+  m_prev_history_len = history_len;
+}
+
+void Purge_sys::truncate_undo_spaces() noexcept {
+  auto trx_sys = srv_trx_sys;
+
+  for (auto &undo_space : trx_sys->m_undo_spaces) {
+    if (undo_space.m_active) {
+      continue;
+    }
+
+    if (trx_sys->undo_space_is_unused(undo_space)) {
+      if (auto err = trx_sys->truncate_undo_space(undo_space); err != DB_SUCCESS) {
+        log_err(std::format("Truncation of undo tablespace {} failed with error {}", undo_space.m_no, (int)err));
+      }
+    }
+
+    return;
+  }
+
+  if (srv_config.m_undo_tablespace_max_size == 0) {
+    return;
+  }
+
+  const auto max_size = srv_config.m_undo_tablespace_max_size / UNIV_PAGE_SIZE;
+
+  for (auto &undo_space : trx_sys->m_undo_spaces) {
+    const auto size = trx_sys->m_fsp->m_fil->space_get_size(undo_space.m_id);
+
+    if (size > max_size) {
+      trx_sys->mutex_acquire();
+
+      undo_space.m_active = false;
+
+      trx_sys->mutex_release();
+
+      log_info(std::format("Undo tablespace {} has {} pages, it will be truncated", undo_space.m_no, size));
+
+      return;
+    }
+  }
+}
+
+void Purge_sys::start_workers() noexcept {
+  ut_a(m_workers.empty());
+  ut_ad(!mutex_own(&kernel_mutex));
+
+  m_stop_workers.store(false, std::memory_order_relaxed);
+
+  for (ulint i{}; i < srv_config.m_n_purge_threads; ++i) {
+    auto ptr = ut_new(sizeof(Purge_worker));
+    auto worker = new (ptr) Purge_worker();
+
+    worker->m_trx = srv_trx_sys->create_background_trx(nullptr);
+    worker->m_heap = mem_heap_create(256);
+    worker->m_node = row_purge_node_create(nullptr, worker->m_heap);
+    worker->m_event = Cond_var::create("purge_worker");
+
+    m_workers.push_back(worker);
+  }
+
+  for (auto worker : m_workers) {
+    worker->m_thread = create_joinable_thread(&Purge_sys::worker_loop, this, worker);
+  }
+}
+
+void Purge_sys::stop_workers() noexcept {
+  if (m_workers.empty()) {
+    return;
+  }
+
+  m_stop_workers.store(true, std::memory_order_release);
+
+  for (auto worker : m_workers) {
+    worker->m_event->set();
+  }
+
+  for (auto worker : m_workers) {
+    worker->m_thread.join();
+
+    ut_a(worker->m_queue.empty());
+
+    mem_heap_free(worker->m_node->heap);
+    call_destructor(worker->m_node);
+    mem_heap_free(worker->m_heap);
+
+    Cond_var::destroy(worker->m_event);
+
+    srv_trx_sys->destroy_background_trx(worker->m_trx);
+
+    call_destructor(worker);
+    ut_delete(worker);
+  }
+
+  m_workers.clear();
+}
+
+void Purge_sys::worker_loop(Purge_worker *worker) noexcept {
+  auto node = worker->m_node;
+
+  for (;;) {
+    Purge_rec rec;
+
+    if (worker->m_queue.dequeue(rec)) {
+      node->undo_rec = rec.m_undo_rec;
+      node->roll_ptr = rec.m_roll_ptr;
+      node->reservation = rec.m_cell;
+
+      row_purge_rec(node, worker->m_trx);
+
+      rec_release(node->reservation);
+
+      mem_heap_empty(node->heap);
+
+      m_n_recs_done.fetch_add(1, std::memory_order_release);
+
+      m_done_event->set();
+
+      continue;
+    }
+
+    /* Reset before the final checks so that a record queued or a stop
+    requested after them is not missed by the wait. */
+    auto sig_count = worker->m_event->reset();
+
+    if (!worker->m_queue.empty()) {
+      continue;
+    } else if (m_stop_workers.load(std::memory_order_acquire)) {
+      break;
+    }
+
+    worker->m_event->wait(sig_count);
+  }
+}
+
+void Purge_sys::wait_for_workers(ulint n_recs_done) noexcept {
+  auto sig_count = m_done_event->reset();
+
+  if (m_n_recs_done.load(std::memory_order_acquire) == n_recs_done) {
+    m_done_event->wait(sig_count);
+  }
+}
+
+void Purge_sys::wait_for_all_workers(ulint n_recs_dispatched) noexcept {
+  for (;;) {
+    const auto n_recs_done = m_n_recs_done.load(std::memory_order_acquire);
+
+    if (n_recs_done == n_recs_dispatched) {
+      break;
+    }
+
+    wait_for_workers(n_recs_done);
+  }
+}
+
+void Purge_sys::dispatch() noexcept {
+  ulint n_recs_dispatched{};
+  const auto n_workers = m_workers.size();
+
+  /* The undo records must stay valid until the workers are done with
+  them, they are copied here and freed when all of them are purged. */
+  auto heap = mem_heap_create(UNIV_PAGE_SIZE);
+
+  m_n_recs_done.store(0, std::memory_order_relaxed);
+
+  for (;;) {
+    if (mem_heap_get_size(heap) > PURGE_MAX_HEAP_SIZE) {
+      wait_for_all_workers(n_recs_dispatched);
+
+      mem_heap_empty(heap);
+    }
+
+    /* Every record in flight holds a cell in the purge array. */
+    for (;;) {
+      const auto n_recs_done = m_n_recs_done.load(std::memory_order_acquire);
+
+      if (n_recs_dispatched - n_recs_done < PURGE_MAX_RECS_IN_FLIGHT - 1) {
+        break;
+      }
+
+      wait_for_workers(n_recs_done);
+    }
+
+    roll_ptr_t roll_ptr;
+    trx_undo_inf_t *cell;
+    auto undo_rec = fetch_next_rec(&roll_ptr, &cell, heap);
+
+    if (undo_rec == nullptr) {
+      break;
+    } else if (undo_rec == &trx_purge_dummy_rec) {
+      rec_release(cell);
+      continue;
+    }
+
+    /* Partition by row, the records of a row are queued to the same worker
+    and purged in the order of the history. */
+    auto worker = m_workers[trx_undo_update_rec_fold_row(undo_rec) % n_workers];
+    const Purge_rec rec{undo_rec, roll_ptr, cell};
+
+    for (;;) {
+      const auto n_recs_done = m_n_recs_done.load(std::memory_order_acquire);
+
+      if (worker->m_queue.enqueue(rec)) {
+        break;
+      }
+
+      wait_for_workers(n_recs_done);
+    }
+
+    ++n_recs_dispatched;
+
+    worker->m_event->set();
+  }
+
+  wait_for_all_workers(n_recs_dispatched);
+
+  mem_heap_free(heap);
+
+  /* fetch_next_rec() could not truncate the history while the workers
+  still had records reserved in the purge array. */
+  mutex_enter(&m_mutex);
+
+  truncate_if_arr_empty();
+
+  mutex_exit(&m_mutex);
+}
+
 trx_undo_rec_t *Purge_sys::fetch_next_rec(roll_ptr_t *roll_ptr, trx_undo_inf_t **cell, mem_heap_t *heap) noexcept {
   trx_undo_rec_t *undo_rec;
 
@@ -362,6 +362,35 @@ byte *trx_undo_rec_skip_row_ref(byte *ptr, Index *index) {
   return ptr;
 }
 
+ulint trx_undo_update_rec_fold_row(trx_undo_rec_t *undo_rec) noexcept {
+  Undo_rec_pars pars;
+  trx_id_t trx_id;
+  ulint info_bits;
+  roll_ptr_t roll_ptr;
+
+  auto ptr = trx_undo_rec_get_pars(undo_rec, pars);
+
+  ut_ad(pars.m_type != TRX_UNDO_INSERT_REC);
+
+  ptr = trx_undo_update_rec_get_sys_cols(ptr, &trx_id, &roll_ptr, &info_bits);
+
+  byte *field;
+  ulint len;
+  ulint orig_len;
+
+  /* The first field of the clustered index key is enough to keep the
+  records of a row together, the index is not needed to read it. */
+  trx_undo_rec_get_col_val(ptr, &field, &len, &orig_len);
+
+  const auto fold = ut_uint64_fold(pars.m_table_id);
+
+  if (len == UNIV_SQL_NULL) {
+    return fold;
+  }
+
+  return ut_fold_ulint_pair(fold, ut_fold_binary(field, len));
+}
+
 /** Fetch a prefix of an externally stored column, for writing to the undo log
 of an update or delete marking of a clustered index record.
 @return	ext_buf */
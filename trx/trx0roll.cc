@@ -57,6 +57,16 @@ db_err trx_general_rollback(Trx *trx, bool partial, trx_savept_t *savept) {
   que_thr_t *thr;
   roll_node_t *roll_node;
 
+  if (trx->m_ro_fast_path) {
+    /* The transaction has not written anything, there is nothing to undo. */
+    if (!partial) {
+      auto err = trx->commit();
+      ut_a(err == DB_SUCCESS);
+    }
+
+    return DB_SUCCESS;
+  }
+
   /* Tell Innobase server that there might be work for
   utility threads: */
 
@@ -252,7 +262,7 @@ static void trx_rollback_active(
 }
 
 void trx_rollback_or_clean_recovered(bool all) {
-  mutex_enter(&kernel_mutex);
+  srv_trx_sys->mutex_acquire();
 
   if (!UT_LIST_GET_FIRST(srv_trx_sys->m_trx_list)) {
     goto leave_function;
@@ -262,10 +272,10 @@ void trx_rollback_or_clean_recovered(bool all) {
     log_info("Starting in background the rollback of uncommitted transactions");
   }
 
-  mutex_exit(&kernel_mutex);
+  srv_trx_sys->mutex_release();
 
 loop:
-  mutex_enter(&kernel_mutex);
+  srv_trx_sys->mutex_acquire();
 
   for (auto trx : srv_trx_sys->m_trx_list) {
     if (!trx->m_is_recovered) {
@@ -278,14 +288,14 @@ loop:
         continue;
 
       case TRX_COMMITTED_IN_MEMORY:
-        mutex_exit(&kernel_mutex);
+        srv_trx_sys->mutex_release();
         log_info("Cleaning up trx with id ", TRX_ID_PREP_PRINTF(trx->m_id));
         trx->cleanup_at_db_startup();
         goto loop;
 
       case TRX_ACTIVE:
         if (all || trx->get_dict_operation() != TRX_DICT_OP_NONE) {
-          mutex_exit(&kernel_mutex);
+          srv_trx_sys->mutex_release();
           // FIXME: Need to get rid of this global access
           trx_rollback_active(srv_config.m_force_recovery, trx);
           goto loop;
@@ -298,7 +308,7 @@ loop:
   }
 
 leave_function:
-  mutex_exit(&kernel_mutex);
+  srv_trx_sys->mutex_release();
 }
 
 void *trx_rollback_or_clean_all_recovered(void *) {
@@ -312,18 +322,18 @@ void *trx_rollback_or_clean_all_recovered(void *) {
   return nullptr;
 }
 
-trx_undo_arr_t *trx_undo_arr_create() {
+trx_undo_arr_t *trx_undo_arr_create(ulint n_cells) {
   auto heap = mem_heap_create(1024);
   auto arr = reinterpret_cast<trx_undo_arr_t *>(mem_heap_alloc(heap, sizeof(trx_undo_arr_t)));
 
-  arr->infos = reinterpret_cast<trx_undo_inf_t *>(mem_heap_alloc(heap, sizeof(trx_undo_inf_t) * UNIV_MAX_PARALLELISM));
+  arr->infos = reinterpret_cast<trx_undo_inf_t *>(mem_heap_alloc(heap, sizeof(trx_undo_inf_t) * n_cells));
 
-  arr->n_cells = UNIV_MAX_PARALLELISM;
+  arr->n_cells = n_cells;
   arr->n_used = 0;
 
   arr->heap = heap;
 
-  for (ulint i = 0; i < UNIV_MAX_PARALLELISM; i++) {
+  for (ulint i = 0; i < n_cells; i++) {
     trx_undo_arr_get_nth_info(arr, i)->in_use = false;
   }
 
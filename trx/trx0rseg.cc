@@ -43,9 +43,6 @@ trx_rseg_t *trx_rseg_get_on_id(ulint id) {
 
 page_no_t trx_rseg_header_create(space_id_t space, ulint max_size, ulint *slot_no, mtr_t *mtr) {
   ut_ad(mutex_own(&kernel_mutex));
-  ut_ad(mtr->memo_contains(srv_fil->space_get_latch(space), MTR_MEMO_X_LOCK));
-
-  auto sys_header = srv_trx_sys->read_header(mtr);
 
   *slot_no = srv_trx_sys->frseg_find_free(mtr);
 
@@ -54,6 +51,15 @@ page_no_t trx_rseg_header_create(space_id_t space, ulint max_size, ulint *slot_n
     return FIL_NULL;
   }
 
+  return trx_rseg_header_create_in_slot(space, max_size, *slot_no, mtr);
+}
+
+page_no_t trx_rseg_header_create_in_slot(space_id_t space, ulint max_size, ulint slot_no, mtr_t *mtr) {
+  ut_ad(mutex_own(&kernel_mutex));
+  ut_ad(mtr->memo_contains(srv_fil->space_get_latch(space), MTR_MEMO_X_LOCK));
+
+  auto sys_header = srv_trx_sys->read_header(mtr);
+
   /* Allocate a new file segment for the rollback segment */
   auto block = srv_fsp->fseg_create(space, 0, TRX_RSEG + TRX_RSEG_FSEG_HEADER, mtr);
 
@@ -87,20 +93,18 @@ page_no_t trx_rseg_header_create(space_id_t space, ulint max_size, ulint *slot_n
   /* Add the rollback segment info to the free slot in the trx system
   header */
 
-  srv_trx_sys->frseg_set_space(sys_header, *slot_no, space, mtr);
-  srv_trx_sys->frseg_set_page_no(sys_header, *slot_no, page_no, mtr);
+  srv_trx_sys->frseg_set_space(sys_header, slot_no, space, mtr);
+  srv_trx_sys->frseg_set_page_no(sys_header, slot_no, page_no, mtr);
 
   return page_no;
 }
 
-void trx_rseg_mem_free(trx_rseg_t *rseg)
-{
-  mutex_free(&rseg->mutex);
-
-  /* There can't be any active transactions. */
-  ut_a(UT_LIST_GET_LEN(rseg->update_undo_list) == 0);
-  ut_a(UT_LIST_GET_LEN(rseg->insert_undo_list) == 0);
-
+/**
+ * Frees the cached undo log segment objects of a rollback segment.
+ * 
+ * @param[in,out] rseg The rollback segment.
+ */
+static void trx_rseg_free_cached(trx_rseg_t *rseg) {
   auto undo = UT_LIST_GET_FIRST(rseg->update_undo_cached);
 
   while (undo != nullptr) {
@@ -122,6 +126,17 @@ void trx_rseg_mem_free(trx_rseg_t *rseg)
 
     Undo::delete_undo(prev_undo);
   }
+}
+
+void trx_rseg_mem_free(trx_rseg_t *rseg)
+{
+  mutex_free(&rseg->mutex);
+
+  /* There can't be any active transactions. */
+  ut_a(UT_LIST_GET_LEN(rseg->update_undo_list) == 0);
+  ut_a(UT_LIST_GET_LEN(rseg->insert_undo_list) == 0);
+
+  trx_rseg_free_cached(rseg);
 
   srv_trx_sys->set_nth_rseg(rseg->id, nullptr);
 
@@ -148,6 +163,7 @@ static trx_rseg_t *trx_rseg_mem_create(
   rseg->id = id;
   rseg->space = space;
   rseg->page_no = page_no;
+  rseg->undo_space = nullptr;
 
   mutex_create(&rseg->mutex, IF_DEBUG("rseg_mutex",) IF_SYNC_DEBUG(SYNC_RSEG,) Current_location());
 
@@ -168,7 +184,7 @@ static trx_rseg_t *trx_rseg_mem_create(
   auto len = flst_get_len(rseg_header + TRX_RSEG_HISTORY, mtr);
 
   if (len > 0) {
-    srv_trx_sys->m_rseg_history_len += len;
+    srv_trx_sys->m_rseg_history_len.fetch_add(len, std::memory_order_relaxed);
 
     auto node_addr = trx_purge_get_log_from_hist(flst_get_last(rseg_header + TRX_RSEG_HISTORY, mtr));
 
@@ -183,13 +199,15 @@ static trx_rseg_t *trx_rseg_mem_create(
     rseg->last_page_no = FIL_NULL;
   }
 
+  srv_trx_sys->rseg_slot_add(rseg);
+
   return rseg;
 }
 
 void trx_rseg_list_and_array_init(ib_recovery_t recovery, trx_sysf_t *sys_header, mtr_t *mtr) {
   UT_LIST_INIT(srv_trx_sys->m_rseg_list);
 
-  srv_trx_sys->m_rseg_history_len = 0;
+  srv_trx_sys->m_rseg_history_len.store(0, std::memory_order_relaxed);
 
   for (ulint i{}; i < TRX_SYS_N_RSEGS; ++i) {
 
@@ -206,3 +224,38 @@ void trx_rseg_list_and_array_init(ib_recovery_t recovery, trx_sysf_t *sys_header
     }
   }
 }
+
+trx_rseg_t *trx_rseg_create(space_id_t space, mtr_t *mtr) {
+  ulint slot_no;
+  auto page_no = trx_rseg_header_create(space, ULINT_MAX, &slot_no, mtr);
+
+  if (page_no == FIL_NULL) {
+
+    return nullptr;
+  }
+
+  return trx_rseg_mem_create(IB_RECOVERY_DEFAULT, slot_no, space, page_no, mtr);
+}
+
+void trx_rseg_reset(trx_rseg_t *rseg, space_id_t space, mtr_t *mtr) {
+  ut_ad(mutex_own(&rseg->mutex));
+  ut_ad(mutex_own(&kernel_mutex));
+
+  /* The caller has checked that the rollback segment is not used. */
+  ut_a(UT_LIST_GET_LEN(rseg->update_undo_list) == 0);
+  ut_a(UT_LIST_GET_LEN(rseg->insert_undo_list) == 0);
+  ut_a(rseg->last_page_no == FIL_NULL);
+
+  /* The cached undo log segments were in the old file. */
+  trx_rseg_free_cached(rseg);
+
+  auto page_no = trx_rseg_header_create_in_slot(space, ULINT_MAX, rseg->id, mtr);
+  ut_a(page_no != FIL_NULL);
+
+  auto rseg_header = trx_rsegf_get_new(space, page_no, mtr);
+
+  rseg->space = space;
+  rseg->page_no = page_no;
+  rseg->max_size = mtr->read_ulint(rseg_header + TRX_RSEG_MAX_SIZE, MLOG_4BYTES);
+  rseg->curr_size = 1;
+}
@@ -23,7 +23,9 @@ Created 3/26/1996 Heikki Tuuri
 *******************************************************/
 
 #include "buf0dblwr.h"
+#include "buf0lru.h"
 #include "fsp0fsp.h"
+#include "fut0lst.h"
 #include "log0log.h"
 #include "mtr0log.h"
 #include "os0file.h"
@@ -35,10 +37,34 @@ Created 3/26/1996 Heikki Tuuri
 #include "trx0trx.h"
 #include "trx0undo.h"
 
+#include <algorithm>
+
 /** The transaction system */
 Trx_sys *srv_trx_sys{};
 
-Trx_sys::Trx_sys(FSP *fsp) noexcept : m_fsp(fsp) { }
+/**
+ * Gives each thread a small number, fixed for the life of the thread. It is
+ * used to spread the threads over the rollback segments and the shards of
+ * the transaction pool.
+ *
+ * @return the number of the calling thread
+ */
+static ulint thread_home() noexcept {
+  static std::atomic<ulint> n_threads{};
+  static thread_local const ulint home = n_threads.fetch_add(1, std::memory_order_relaxed);
+
+  return home;
+}
+
+Trx_sys::Trx_sys(FSP *fsp) noexcept : m_fsp(fsp) {
+  mutex_create(&m_mutex, IF_DEBUG("Trx_sys::m_mutex",) IF_SYNC_DEBUG(SYNC_TRX_SYS,) Current_location());
+  mutex_create(&m_view_mutex, IF_DEBUG("Trx_sys::m_view_mutex",) IF_SYNC_DEBUG(SYNC_READ_VIEW,) Current_location());
+
+  for (auto &pool : m_trx_pools) {
+    auto ptr = ut_new(sizeof(Trx_pool));
+    pool = new (ptr) Trx_pool(TRX_POOL_SHARD_SIZE);
+  }
+}
 
 Trx_sys::~Trx_sys() noexcept {
   /* Check that all read views are closed except read view owned
@@ -61,6 +87,21 @@ Trx_sys::~Trx_sys() noexcept {
   /* This is required only because it's a pre-condition for many
   of the functions that we need to call. */
   mutex_enter(&kernel_mutex);
+  mutex_acquire();
+
+  m_n_rseg_slots.store(0, std::memory_order_relaxed);
+
+  for (auto &pool : m_trx_pools) {
+    Trx *trx;
+
+    while (pool->dequeue(trx)) {
+      destroy_trx(trx);
+    }
+
+    call_destructor(pool);
+    ut_delete(pool);
+    pool = nullptr;
+  }
 
   /* There can't be any active transactions. */
   auto rseg = m_rseg_list.front();
@@ -88,11 +129,17 @@ Trx_sys::~Trx_sys() noexcept {
   }
 
   ut_a(m_trx_list.empty());
+  ut_a(m_trx_ids.empty());
   ut_a(m_rseg_list.empty());
   ut_a(m_view_list.empty());
   ut_a(m_client_trx_list.empty());
+  ut_a(m_active_ids.empty());
 
+  mutex_release();
   mutex_exit(&kernel_mutex);
+
+  mutex_free(&m_view_mutex);
+  mutex_free(&m_mutex);
 }
 
 dberr_t Trx_sys::start(ib_recovery_t recovery) noexcept {
@@ -110,7 +157,7 @@ dberr_t Trx_sys::start(ib_recovery_t recovery) noexcept {
 
   trx_rseg_list_and_array_init(recovery, sys_header, &mtr);
 
-  m_latest_rseg = UT_LIST_GET_FIRST(m_rseg_list);
+  mutex_acquire();
 
   /* VERY important: after the database is started, max_trx_id value is
    * divisible by TRX_SYS_TRX_ID_WRITE_MARGIN, and the 'if' in
@@ -126,6 +173,7 @@ dberr_t Trx_sys::start(ib_recovery_t recovery) noexcept {
 
   init_at_db_start(recovery);
 
+  publish_snapshot();
 
   int64_t rows_to_undo{};
 
@@ -157,6 +205,7 @@ dberr_t Trx_sys::start(ib_recovery_t recovery) noexcept {
     m_purge = new (ptr) Purge_sys(purge_trx);
   }
 
+  mutex_release();
   mutex_exit(&kernel_mutex);
 
   mtr.commit();
@@ -165,20 +214,92 @@ dberr_t Trx_sys::start(ib_recovery_t recovery) noexcept {
 }
 
 bool Trx_sys::in_trx_list(Trx *in_trx) noexcept {
-  ut_ad(mutex_own(&kernel_mutex));
+  mutex_acquire();
 
-  for (auto trx : m_trx_list) {
-    if (trx == in_trx) {
+  const auto found = get_on_id(in_trx->m_id) == in_trx;
 
-      return true;
-    }
+  mutex_release();
+
+  return found;
+}
+
+void Trx_sys::publish_snapshot() noexcept {
+  ut_ad(mutex_own(&m_mutex));
+
+  auto snapshot = std::make_shared<Trx_snapshot>();
+
+  snapshot->m_max_trx_id = m_max_trx_id;
+  snapshot->m_ids = m_active_ids;
+
+  if (m_active_trx_nos.empty() || m_active_trx_nos.front() > m_max_trx_id) {
+    snapshot->m_low_limit_no = m_max_trx_id;
+  } else {
+    snapshot->m_low_limit_no = m_active_trx_nos.front();
+  }
+
+  m_snapshot.store(std::move(snapshot), std::memory_order_release);
+}
+
+void Trx_sys::snapshot_add(const Trx *trx) noexcept {
+  ut_ad(mutex_own(&m_mutex));
+  ut_ad(trx->m_conc_state == TRX_ACTIVE || trx->m_conc_state == TRX_PREPARED);
+
+  /* New transactions get the biggest id so far, only the recovered
+  transactions can be added out of order. */
+  auto it = std::lower_bound(m_active_ids.begin(), m_active_ids.end(), trx->m_id);
+
+  ut_ad(it == m_active_ids.end() || *it != trx->m_id);
+  m_active_ids.insert(it, trx->m_id);
+
+  if (trx->m_no != LSN_MAX) {
+    auto it = std::lower_bound(m_active_trx_nos.begin(), m_active_trx_nos.end(), trx->m_no);
+
+    m_active_trx_nos.insert(it, trx->m_no);
+  }
+
+  publish_snapshot();
+}
+
+void Trx_sys::snapshot_remove(const Trx *trx) noexcept {
+  ut_ad(mutex_own(&m_mutex));
+
+  auto it = std::lower_bound(m_active_ids.begin(), m_active_ids.end(), trx->m_id);
+
+  ut_a(it != m_active_ids.end() && *it == trx->m_id);
+  m_active_ids.erase(it);
+
+  if (trx->m_no != LSN_MAX) {
+    auto it = std::lower_bound(m_active_trx_nos.begin(), m_active_trx_nos.end(), trx->m_no);
+
+    ut_a(it != m_active_trx_nos.end() && *it == trx->m_no);
+    m_active_trx_nos.erase(it);
+  }
+
+  publish_snapshot();
+}
+
+void Trx_sys::assign_trx_no(Trx *trx) noexcept {
+  ut_ad(mutex_own(&m_mutex));
+
+  if (trx->m_no != LSN_MAX) {
+    /* A recovered prepared transaction has a dummy trx number. */
+    auto it = std::lower_bound(m_active_trx_nos.begin(), m_active_trx_nos.end(), trx->m_no);
+
+    ut_a(it != m_active_trx_nos.end() && *it == trx->m_no);
+    m_active_trx_nos.erase(it);
   }
 
-  return false;
+  trx->m_no = get_new_trx_no();
+
+  /* Trx numbers are assigned in ascending order. */
+  ut_ad(m_active_trx_nos.empty() || m_active_trx_nos.back() < trx->m_no);
+  m_active_trx_nos.push_back(trx->m_no);
+
+  publish_snapshot();
 }
 
 void Trx_sys::flush_max_trx_id() noexcept {
-  ut_ad(mutex_own(&kernel_mutex));
+  ut_ad(mutex_own(&m_mutex));
 
   mtr_t mtr;
 
@@ -196,7 +317,8 @@ ulint Trx_sys::frseg_find_free(mtr_t *mtr) noexcept {
 
   auto sys_header = read_header(mtr);
 
-  for (ulint i{}; i < TRX_SYS_N_RSEGS; ++i) {
+  /* The slots above TRX_SYS_N_USABLE_RSEGS can't be addressed by a roll pointer. */
+  for (ulint i{}; i < TRX_SYS_N_USABLE_RSEGS; ++i) {
 
     const auto page_no = frseg_get_page_no(sys_header, i, mtr);
 
@@ -297,57 +419,69 @@ void Trx_sys::destroy_trx(Trx *&trx) noexcept {
 }
 
 Trx *Trx_sys::create_user_trx(void *arg) noexcept {
-  auto trx = create_trx(arg);
+  Trx *trx;
 
-  mutex_enter(&kernel_mutex);
+  if (m_trx_pools[thread_home() % m_trx_pools.size()]->dequeue(trx)) {
+    trx->m_client_ctx = arg;
+  } else {
+    trx = create_trx(arg);
+  }
+
+  mutex_acquire();
 
   ++m_n_user_trx;
 
   m_client_trx_list.push_front(trx);
 
-  mutex_exit(&kernel_mutex);
+  mutex_release();
 
   return trx;
 }
 
 void Trx_sys::destroy_user_trx(Trx *&trx) noexcept {
-  mutex_enter(&kernel_mutex);
+  mutex_acquire();
 
   m_client_trx_list.remove(trx);
 
-  destroy_trx(trx);
-
   ut_a(m_n_user_trx > 0);
   --m_n_user_trx;
 
-  mutex_exit(&kernel_mutex);
+  trx->reset();
+
+  if (!m_trx_pools[thread_home() % m_trx_pools.size()]->enqueue(trx)) {
+    destroy_trx(trx);
+  }
+
+  trx = nullptr;
+
+  mutex_release();
 }
 
 Trx *Trx_sys::create_background_trx(void *arg) noexcept {
   auto trx = create_trx(arg);
 
-  mutex_enter(&kernel_mutex);
+  mutex_acquire();
 
   ++m_n_background_trx;
 
-  mutex_exit(&kernel_mutex);
+  mutex_release();
 
   return trx;
 }
 
 void Trx_sys::destroy_background_trx(Trx *&trx) noexcept {
-  mutex_enter(&kernel_mutex);
+  mutex_acquire();
 
   destroy_trx(trx);
 
   ut_a(m_n_background_trx > 0);
   --m_n_background_trx;
 
-  mutex_exit(&kernel_mutex);
+  mutex_release();
 }
 
 void Trx_sys::trx_list_insert_ordered(Trx *in_trx) noexcept {
-  ut_ad(mutex_own(&kernel_mutex));
+  ut_ad(mutex_own(&m_mutex));
 
   Trx *prev_trx{};
 
@@ -370,34 +504,349 @@ void Trx_sys::trx_list_insert_ordered(Trx *in_trx) noexcept {
   } else {
     m_trx_list.push_back(in_trx);
   }
+
+  const auto inserted = m_trx_ids.emplace(in_trx->m_id, in_trx).second;
+  ut_a(inserted);
+
+  if (in_trx->m_conc_state == TRX_ACTIVE || in_trx->m_conc_state == TRX_PREPARED) {
+    snapshot_add(in_trx);
+  }
 }
 
-ulint Trx_sys::trx_assign_rseg() noexcept {
+void Trx_sys::rseg_slot_add(trx_rseg_t *rseg) noexcept {
   ut_ad(mutex_own(&kernel_mutex));
 
-  auto rseg = m_latest_rseg;
-  const auto n_rsegs = m_rseg_list.size();
+  if (rseg->id == TRX_SYS_SYSTEM_RSEG_ID) {
+    return;
+  }
 
-  for (;;) {
-    /* Get next rseg in a round-robin fashion */
+  const auto n = m_n_rseg_slots.load(std::memory_order_relaxed);
 
-    rseg = UT_LIST_GET_NEXT(rseg_list, rseg);
+  ut_a(n < m_rseg_slots.size());
+
+  m_rseg_slots[n] = rseg;
+
+  /* Publish the entry before the count, readers don't hold a mutex. */
+  m_n_rseg_slots.store(n + 1, std::memory_order_release);
+}
+
+ulint Trx_sys::trx_assign_rseg() noexcept {
+  const auto n_slots = m_n_rseg_slots.load(std::memory_order_acquire);
+
+  if (n_slots == 0) {
+    /* The SYSTEM rollback segment is the only one available */
+    return TRX_SYS_SYSTEM_RSEG_ID;
+  }
+
+  /* Start from the home rollback segment of this thread. */
+  const auto home = thread_home();
+
+  for (ulint i{}; i < n_slots; ++i) {
+    const auto rseg = m_rseg_slots[(home + i) % n_slots];
+
+    /* Skip the rollback segments of undo tablespaces waiting to be truncated. */
+    if (rseg->undo_space == nullptr || rseg->undo_space->m_active) {
+      return rseg->id;
+    }
+  }
+
+  return TRX_SYS_SYSTEM_RSEG_ID;
+}
+
+bool Trx_sys::rseg_is_assignable(ulint rseg_id) const noexcept {
+  ut_ad(mutex_own(&m_mutex));
+
+  const auto rseg = m_rsegs[rseg_id];
+
+  return rseg != nullptr && (rseg->undo_space == nullptr || rseg->undo_space->m_active);
+}
+
+db_err Trx_sys::create_rsegs() noexcept {
+  const auto n_wanted = std::min(srv_config.m_n_rollback_segments, TRX_SYS_MAX_SYSTEM_RSEGS);
+
+  ulint n_rsegs{};
+
+  mutex_enter(&kernel_mutex);
+
+  for (auto rseg : m_rseg_list) {
+    if (rseg->space == TRX_SYS_SPACE) {
+      ++n_rsegs;
+    }
+  }
+
+  mutex_exit(&kernel_mutex);
+
+  const auto n_existing = n_rsegs;
+
+  for (; n_rsegs < n_wanted; ++n_rsegs) {
+    mtr_t mtr;
+
+    mtr.start();
+
+    /* Same latching order as in create_system_tablespace(). */
+    mtr_x_lock(m_fsp->m_fil->space_get_latch(TRX_SYS_SPACE), &mtr);
+
+    mutex_enter(&kernel_mutex);
+
+    auto rseg = trx_rseg_create(TRX_SYS_SPACE, &mtr);
+
+    mutex_exit(&kernel_mutex);
+
+    mtr.commit();
 
     if (rseg == nullptr) {
-      rseg = m_rseg_list.front();
+      log_err(std::format("Failed to create rollback segment {} of {} in the system tablespace", n_rsegs + 1, n_wanted));
+      return DB_ERROR;
     }
+  }
 
-    /* If it is the SYSTEM rollback segment, and there exist others, skip it */
+  if (n_rsegs > n_existing) {
+    log_info(std::format("Created {} rollback segments, the system tablespace has {}", n_rsegs - n_existing, n_rsegs));
+  }
 
-    if ((rseg->id != TRX_SYS_SYSTEM_RSEG_ID) || n_rsegs == 1) {
-      m_latest_rseg = rseg;
-      return rseg->id;
+  return DB_SUCCESS;
+}
+
+/**
+ * @param[in] no                Number of the undo tablespace.
+ *
+ * @return the name of the undo tablespace file, without the extension.
+ */
+static std::string undo_space_name(ulint no) noexcept {
+  return std::format("undo_{:03}", no);
+}
+
+/**
+ * Creates the file of an undo tablespace with a new space id, deleting the
+ * existing file if there is one.
+ *
+ * @param[in] fsp                File space management instance.
+ * @param[in,out] undo_space     The undo tablespace, m_id is set to the new id.
+ *
+ * @return DB_SUCCESS or error code
+ */
+static db_err undo_space_create_file(FSP *fsp, Undo_space &undo_space) noexcept {
+  auto fil = fsp->m_fil;
+  const auto name = undo_space_name(undo_space.m_no);
+  space_id_t space_id = fil->get_space_id_for_table(name.c_str());
+
+  if (space_id != FIL_NULL) {
+    /* The undo logs in it are not needed, throw away its pages. */
+    srv_buf_pool->m_LRU->invalidate_tablespace(space_id);
+
+    if (!fil->delete_tablespace(space_id)) {
+      return DB_ERROR;
+    }
+  }
+
+  space_id = SYS_TABLESPACE;
+
+  auto err = fil->create_new_single_table_tablespace(&space_id, name.c_str(), false, 0, FIL_IBD_FILE_INITIAL_SIZE);
+
+  if (err != DB_SUCCESS) {
+    log_err(std::format("Failed to create undo tablespace {}", name));
+    return err;
+  }
+
+  mtr_t mtr;
+
+  mtr.start();
+
+  fsp->header_init(space_id, FIL_IBD_FILE_INITIAL_SIZE, &mtr);
+
+  mtr.commit();
+
+  undo_space.m_id = space_id;
+
+  return DB_SUCCESS;
+}
+
+db_err Trx_sys::open_undo_spaces() noexcept {
+  ut_a(m_undo_spaces.empty());
+
+  /* Undo_space is not movable, the vector is never resized. */
+  m_undo_spaces = std::vector<Undo_space>(std::min(srv_config.m_n_undo_tablespaces, TRX_SYS_MAX_UNDO_SPACES));
+
+  for (ulint i{}; i < m_undo_spaces.size(); ++i) {
+    auto &undo_space = m_undo_spaces[i];
+    const auto name = undo_space_name(i + 1);
+
+    undo_space.m_no = i + 1;
+    undo_space.m_id = m_fsp->m_fil->get_space_id_for_table(name.c_str());
+
+    ulint n_rsegs{};
+
+    if (undo_space.m_id != FIL_NULL) {
+      mutex_enter(&kernel_mutex);
+
+      for (auto rseg : m_rseg_list) {
+        if (rseg->space == undo_space.m_id) {
+          rseg->undo_space = &undo_space;
+          ++n_rsegs;
+        }
+      }
+
+      mutex_exit(&kernel_mutex);
+    }
+
+    if (n_rsegs > 0) {
+      continue;
+    }
+
+    if (auto err = undo_space_create_file(m_fsp, undo_space); err != DB_SUCCESS) {
+      return err;
+    }
+
+    for (ulint j{}; j < TRX_UNDO_SPACE_N_RSEGS; ++j) {
+      mtr_t mtr;
+
+      mtr.start();
+
+      /* Same latching order as in create_system_tablespace(). */
+      mtr_x_lock(m_fsp->m_fil->space_get_latch(undo_space.m_id), &mtr);
+
+      mutex_enter(&kernel_mutex);
+
+      auto rseg = trx_rseg_create(undo_space.m_id, &mtr);
+
+      if (rseg != nullptr) {
+        rseg->undo_space = &undo_space;
+      }
+
+      mutex_exit(&kernel_mutex);
+
+      mtr.commit();
+
+      if (rseg == nullptr) {
+        log_err(std::format("Failed to create a rollback segment in undo tablespace {}", name));
+        return DB_ERROR;
+      }
     }
+
+    log_info(std::format("Created undo tablespace {} with {} rollback segments", name, TRX_UNDO_SPACE_N_RSEGS));
   }
+
+  return DB_SUCCESS;
+}
+
+bool Trx_sys::undo_space_is_unused(const Undo_space &undo_space) noexcept {
+  bool unused{true};
+
+  mutex_acquire();
+
+  /* A transaction is assigned its rollback segment when it starts, the
+  undo logs are created on its first modification. The tablespace is
+  inactive, no transaction can be assigned to it after this check. */
+  for (auto trx : m_trx_list) {
+    if (trx->m_rseg != nullptr && trx->m_rseg->undo_space == &undo_space) {
+      unused = false;
+      break;
+    }
+  }
+
+  mutex_release();
+
+  /* The rseg mutex is above the kernel and trx system mutexes in the
+  latching order. The rseg list is not changed after startup. */
+  for (auto rseg : m_rseg_list) {
+    if (!unused) {
+      break;
+    } else if (rseg->undo_space != &undo_space) {
+      continue;
+    }
+
+    mtr_t mtr;
+
+    mtr.start();
+
+    mutex_enter(&rseg->mutex);
+
+    auto rseg_header = trx_rsegf_get(rseg->space, rseg->page_no, &mtr);
+
+    unused = UT_LIST_GET_LEN(rseg->update_undo_list) == 0 && UT_LIST_GET_LEN(rseg->insert_undo_list) == 0 &&
+             rseg->last_page_no == FIL_NULL && flst_get_len(rseg_header + TRX_RSEG_HISTORY, &mtr) == 0;
+
+    mutex_exit(&rseg->mutex);
+
+    mtr.commit();
+  }
+
+  return unused;
+}
+
+db_err Trx_sys::truncate_undo_space(Undo_space &undo_space) noexcept {
+  ut_a(!undo_space.m_active);
+
+  const auto name = undo_space_name(undo_space.m_no);
+  std::vector<trx_rseg_t *> rsegs;
+
+  /* Detach the rollback segments from the trx system header first and
+  make it durable. If we crash before they are attached again, the undo
+  tablespace has no rollback segments and is recreated at startup. */
+  {
+    mtr_t mtr;
+
+    mtr.start();
+
+    mutex_enter(&kernel_mutex);
+
+    auto sys_header = read_header(&mtr);
+
+    for (auto rseg : m_rseg_list) {
+      if (rseg->undo_space == &undo_space) {
+        frseg_set_page_no(sys_header, rseg->id, FIL_NULL, &mtr);
+        rsegs.push_back(rseg);
+      }
+    }
+
+    mutex_exit(&kernel_mutex);
+
+    mtr.commit();
+
+    log_sys->write_up_to(mtr.m_end_lsn, LOG_WAIT_ALL_GROUPS, true);
+  }
+
+  if (auto err = undo_space_create_file(m_fsp, undo_space); err != DB_SUCCESS) {
+    return err;
+  }
+
+  /* The rseg mutex is above the fsp latch and the kernel mutex in the
+  latching order, a committing transaction takes it before the kernel
+  mutex too. The kernel mutex protects the slots in the trx system header. */
+  for (auto rseg : rsegs) {
+    mtr_t mtr;
+
+    mtr.start();
+
+    mutex_enter(&rseg->mutex);
+
+    mtr_x_lock(m_fsp->m_fil->space_get_latch(undo_space.m_id), &mtr);
+
+    mutex_enter(&kernel_mutex);
+
+    trx_rseg_reset(rseg, undo_space.m_id, &mtr);
+
+    mutex_exit(&kernel_mutex);
+
+    mutex_exit(&rseg->mutex);
+
+    mtr.commit();
+  }
+
+  mutex_acquire();
+
+  undo_space.m_active = true;
+
+  mutex_release();
+
+  log_info(std::format("Truncated undo tablespace {}", name));
+
+  return DB_SUCCESS;
 }
 
 void Trx_sys::init_at_db_start(ib_recovery_t recovery) noexcept {
   ut_ad(mutex_own(&kernel_mutex));
+  ut_ad(mutex_own(&m_mutex));
 
   /* Look from the rollback segments if there exist undo logs for
   transactions */
@@ -542,7 +991,7 @@ int Trx_sys::recover(XID *xid_list, ulint len) noexcept{
 
   int count{};
 
-  mutex_enter(&kernel_mutex);
+  mutex_acquire();
 
   for (const auto trx : m_trx_list) {
     if (trx->m_conc_state == TRX_PREPARED) {
@@ -564,7 +1013,7 @@ int Trx_sys::recover(XID *xid_list, ulint len) noexcept{
     }
   }
 
-  mutex_exit(&kernel_mutex);
+  mutex_release();
 
   if (count > 0) {
     log_info(std::format("{} transactions in prepared state after recovery", count));
@@ -577,7 +1026,7 @@ int Trx_sys::recover(XID *xid_list, ulint len) noexcept{
 Trx *Trx_sys::get_trx_by_xid(XID *xid) noexcept {
   ut_a(xid != nullptr);
 
-  mutex_enter(&kernel_mutex);
+  mutex_acquire();
 
   Trx *xid_trx{};
 
@@ -594,7 +1043,7 @@ Trx *Trx_sys::get_trx_by_xid(XID *xid) noexcept {
     }
   }
 
-  mutex_exit(&kernel_mutex);
+  mutex_release();
 
   return xid_trx == nullptr ? nullptr : (xid_trx->m_conc_state != TRX_PREPARED ? nullptr : xid_trx);
 }
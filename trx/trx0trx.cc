@@ -52,6 +52,8 @@ Trx::Trx(Trx_sys *trx_sys, Session *sess, void *arg) noexcept
 
   m_global_read_view_heap = mem_heap_create(256);
 
+  m_lock_wait_event = os_event_create(nullptr);
+
 #ifdef WITH_XOPEN
   memset(&m_xid, 0, sizeof(m_xid));
   m_xid.formatID = -1;
@@ -61,7 +63,7 @@ Trx::Trx(Trx_sys *trx_sys, Session *sess, void *arg) noexcept
 }
 
 Trx::~Trx() noexcept {
-  ut_ad(mutex_own(&kernel_mutex));
+  ut_ad(m_trx_sys->mutex_is_owned());
 
   if (m_n_client_tables_in_use != 0 || m_client_n_tables_locked != 0) {
     log_err(std::format(
@@ -94,6 +96,10 @@ Trx::~Trx() noexcept {
 
   ut_a(m_wait_lock == nullptr);
   ut_a(m_wait_thrs.empty());
+  ut_a(m_lock_wait_thr == nullptr);
+  ut_a(m_lock_wait_deadline == 0);
+
+  os_event_free(m_lock_wait_event);
 
   ut_a(m_dict_operation_lock_mode == 0);
 
@@ -123,12 +129,32 @@ void Trx::destroy(Trx *&trx) noexcept {
   trx = nullptr;
 }
 
+void Trx::reset() noexcept {
+  ut_ad(m_trx_sys->mutex_is_owned());
+  ut_ad(m_magic_n == TRX_MAGIC_N);
+
+  /* The destructor only logs these, a pooled trx must not have them. */
+  ut_a(m_n_client_tables_in_use == 0);
+  ut_a(m_client_n_tables_locked == 0);
+  ut_a(m_trx_savepoints.empty());
+  ut_a(m_sess->m_graphs.empty());
+  ut_a(m_sess->m_state != Session::State::ERROR);
+
+  auto sess = m_sess;
+  auto trx_sys = m_trx_sys;
+
+  /* Reconstruct in place, every field gets the value of a new transaction. */
+  call_destructor(this);
+
+  new (this) Trx(trx_sys, sess, nullptr);
+}
+
 bool Trx::is_interrupted() const noexcept {
   return trx_is_interrupted(this);
 }
 
 bool Trx::start_low(ulint rseg_id) noexcept {
-  ut_ad(mutex_own(&kernel_mutex));
+  ut_ad(m_trx_sys->mutex_is_owned());
 
   ut_ad(m_magic_n == TRX_MAGIC_N);
 
@@ -142,7 +168,9 @@ bool Trx::start_low(ulint rseg_id) noexcept {
 
   ut_ad(m_conc_state != TRX_ACTIVE);
 
-  if (rseg_id == ULINT_UNDEFINED) {
+  /* The undo tablespace of a rollback segment picked in start() may have
+  been marked for truncation since, check it again under the trx system mutex. */
+  if (rseg_id == ULINT_UNDEFINED || !m_trx_sys->rseg_is_assignable(rseg_id)) {
 
     rseg_id = m_trx_sys->trx_assign_rseg();
   }
@@ -157,17 +185,69 @@ bool Trx::start_low(ulint rseg_id) noexcept {
   m_no = LSN_MAX;
   m_conc_state = TRX_ACTIVE;
   m_start_time = time(nullptr);
+  m_dml_delay_us = 0;
 
 #ifdef WITH_XOPEN
   m_flush_log_later = false;
   m_must_flush_log_later = false;
 #endif /* WITH_XOPEN */
 
-  m_trx_sys->m_trx_list.push_front(this);
+  m_trx_sys->trx_list_push_front(this);
+
+  m_trx_sys->snapshot_add(this);
 
   return true;
 }
 
+void Trx::start_read_only() noexcept {
+  ut_ad(m_magic_n == TRX_MAGIC_N);
+  ut_a(m_conc_state == TRX_NOT_STARTED);
+  ut_ad(m_rseg == nullptr);
+
+  m_id = 0;
+  m_no = LSN_MAX;
+  m_start_time = time(nullptr);
+  m_dml_delay_us = 0;
+  m_ro_fast_path = true;
+  m_conc_state = TRX_ACTIVE;
+}
+
+db_err Trx::set_rw_mode() noexcept {
+  if (likely(!m_ro_fast_path)) {
+    return DB_SUCCESS;
+  } else if (m_read_only) {
+    return DB_READONLY;
+  }
+
+  ut_ad(!mutex_own(&kernel_mutex));
+  ut_ad(m_conc_state == TRX_ACTIVE);
+
+  const auto start_time = m_start_time;
+  const auto dml_delay_us = m_dml_delay_us;
+  const auto rseg_id = m_trx_sys->trx_assign_rseg();
+
+  m_trx_sys->mutex_acquire();
+
+  m_ro_fast_path = false;
+  m_conc_state = TRX_NOT_STARTED;
+
+  auto started = start_low(rseg_id);
+  ut_a(started);
+
+  m_trx_sys->mutex_release();
+
+  m_start_time = start_time;
+  m_dml_delay_us = dml_delay_us;
+
+  if (m_global_read_view != nullptr) {
+    /* The view was created when the transaction had no id, it must
+    see the changes that the transaction is about to make. */
+    read_view_set_creator(m_global_read_view, m_id);
+  }
+
+  return DB_SUCCESS;
+}
+
 void Trx::set_detailed_error(const char *msg) noexcept {
   memcpy(m_detailed_error.data(), msg, m_detailed_error.size() - 1);
 }
@@ -183,17 +263,24 @@ bool Trx::start(ulint rseg_id) noexcept {
   /* FIXME: This requires an API change to support */
   /* trx->m_support_xa = ib_supports_xa(trx->m_client_ctx); */
 
-  mutex_enter(&kernel_mutex);
+  /* Pick the rollback segment outside the trx system mutex. Starting a
+  transaction does not need the kernel mutex. */
+  if (rseg_id == ULINT_UNDEFINED) {
+    rseg_id = m_trx_sys->trx_assign_rseg();
+  }
+
+  m_trx_sys->mutex_acquire();
 
   auto ret = start_low(rseg_id);
 
-  mutex_exit(&kernel_mutex);
+  m_trx_sys->mutex_release();
 
   return ret;
 }
 
 void Trx::commit_off_kernel() noexcept {
   ut_ad(mutex_own(&kernel_mutex));
+  ut_ad(!m_ro_fast_path);
 
   lsn_t lsn{};
   auto rseg{m_rseg};
@@ -221,10 +308,11 @@ void Trx::commit_off_kernel() noexcept {
     auto undo = m_update_undo;
 
     if (undo != nullptr) {
-      mutex_enter(&kernel_mutex);
-      m_no = m_trx_sys->get_new_trx_no();
+      m_trx_sys->mutex_acquire();
 
-      mutex_exit(&kernel_mutex);
+      m_trx_sys->assign_trx_no(this);
+
+      m_trx_sys->mutex_release();
 
       /* It is not necessary to obtain trx->undo_mutex here
       because only a single OS thread is allowed to do the
@@ -253,8 +341,8 @@ void Trx::commit_off_kernel() noexcept {
     transactions with an update undo log, do not necessarily come
     in exactly the same order as commit lsn's, if the transactions
     have different rollback segments. To get exactly the same
-    order we should hold the kernel mutex up to this point,
-    adding to the contention of the kernel mutex. However, if
+    order we should hold the trx system mutex up to this point,
+    adding to the contention of the trx system mutex. However, if
     a transaction T2 is able to see modifications made by
     a transaction T1, T2 will always get a bigger transaction
     number and a bigger commit lsn than T1. */
@@ -283,8 +371,14 @@ void Trx::commit_off_kernel() noexcept {
   flush fails, and T never gets committed, also T2 will never get
   committed. */
 
+  m_trx_sys->mutex_acquire();
+
   m_conc_state = TRX_COMMITTED_IN_MEMORY;
 
+  m_trx_sys->snapshot_remove(this);
+
+  m_trx_sys->mutex_release();
+
   /* If we release kernel_mutex below and we are still doing
   recovery i.e.: back ground rollback thread is still active
   then there is a chance that the rollback thread may see
@@ -343,8 +437,15 @@ void Trx::commit_off_kernel() noexcept {
     mutex would serialize all commits and prevent a group of
     transactions from gathering. */
 
+    /* If the client committed with ib_trx_commit_async(), it does not
+    wait here: the log flusher thread writes the log for a group of such
+    commits and notifies the client once m_commit_lsn is durable. */
+
     auto log = m_trx_sys->m_fsp->m_log;
 
+    if (m_flush_log_async) {
+      /* Do nothing, see Log::add_durable_waiter() */
+    } else
 #ifdef WITH_XOPEN
     if (m_flush_log_later) {
       /* Do nothing yet */
@@ -381,13 +482,18 @@ void Trx::commit_off_kernel() noexcept {
   m_undo_no = 0;
   m_rseg = nullptr;
   m_client_query_str = nullptr;
-  m_conc_state = TRX_NOT_STARTED;
   m_last_sql_stat_start.least_undo_no = 0;
 
   ut_ad(m_wait_thrs.empty());
   ut_ad(m_trx_locks.empty());
 
-  m_trx_sys->m_trx_list.remove(this);
+  m_trx_sys->mutex_acquire();
+
+  m_conc_state = TRX_NOT_STARTED;
+
+  m_trx_sys->trx_list_remove(this);
+
+  m_trx_sys->mutex_release();
 }
 
 void Trx::cleanup_at_db_startup() noexcept{
@@ -397,10 +503,15 @@ void Trx::cleanup_at_db_startup() noexcept{
 
   m_undo_no = 0;
   m_rseg = nullptr;
-  m_conc_state = TRX_NOT_STARTED;
   m_last_sql_stat_start.least_undo_no = 0;
 
-  m_trx_sys->m_trx_list.remove(this);
+  m_trx_sys->mutex_acquire();
+
+  m_conc_state = TRX_NOT_STARTED;
+
+  m_trx_sys->trx_list_remove(this);
+
+  m_trx_sys->mutex_release();
 }
 
 read_view_t *Trx::assign_read_view() noexcept {
@@ -410,14 +521,10 @@ read_view_t *Trx::assign_read_view() noexcept {
     return m_read_view;
   }
 
-  mutex_enter(&kernel_mutex);
-
-  if (m_read_view == nullptr) {
-    m_read_view = read_view_open_now(m_id, m_global_read_view_heap);
-    m_global_read_view = m_read_view;
-  }
-
-  mutex_exit(&kernel_mutex);
+  /* The view is created from the published trx snapshot, the kernel
+  mutex is not needed. */
+  m_read_view = read_view_open_now(m_id, m_global_read_view_heap);
+  m_global_read_view = m_read_view;
 
   return m_read_view;
 }
@@ -626,8 +733,12 @@ void Trx::sig_start_handling(que_thr_t *&next_thr) noexcept {
 
     if (m_conc_state == TRX_NOT_STARTED) {
 
+      m_trx_sys->mutex_acquire();
+
       auto success = start_low(ULINT_UNDEFINED);
       ut_a(success);
+
+      m_trx_sys->mutex_release();
     }
 
     /* If the trx is in a lock wait state, moves the waiting query threads
@@ -775,6 +886,29 @@ que_thr_t *Trx::commit_step(que_thr_t *thr) noexcept {
 }
 
 db_err Trx::commit() noexcept {
+  if (m_ro_fast_path) {
+    /* Nothing to write and not in the trx system, only the read view
+    and the savepoints need to be freed. */
+    ut_ad(m_trx_locks.empty());
+    ut_ad(m_conc_state == TRX_ACTIVE);
+
+    if (m_global_read_view != nullptr) {
+      read_view_close(m_global_read_view);
+      mem_heap_empty(m_global_read_view_heap);
+      m_global_read_view = nullptr;
+    }
+
+    m_read_view = nullptr;
+
+    trx_roll_free_all_savepoints(this);
+
+    m_client_query_str = nullptr;
+    m_ro_fast_path = false;
+    m_conc_state = TRX_NOT_STARTED;
+
+    return DB_SUCCESS;
+  }
+
   /* Because we do not do the commit by sending an Innobase
   sig to the transaction, we must here make sure that trx has been
   started. */
@@ -887,6 +1021,10 @@ ulint Trx::number_of_rows_locked() const noexcept {
     os << ", undo log entries " << m_undo_no;
   }
 
+  if (m_dml_delay_us > 0) {
+    os << ", purge lag delay " << m_dml_delay_us << " us";
+  }
+
   os << "\n";
 
   return os.str();
@@ -942,8 +1080,12 @@ void Trx::prepare_for_commit() noexcept {
 
   ut_ad(mutex_own(&kernel_mutex));
 
+  m_trx_sys->mutex_acquire();
+
   m_conc_state = TRX_PREPARED;
 
+  m_trx_sys->mutex_release();
+
   if (lsn > 0) {
     /* Depending on the config options, we may now write the log
     buffer to the log files, making the prepared state of the
@@ -984,11 +1126,15 @@ void Trx::prepare_for_commit() noexcept {
   }
 }
 
-ulint Trx::prepare() noexcept {
+db_err Trx::prepare() noexcept {
   /* Because we do not do the prepare by sending an Innobase
   sig to the transaction, we must here make sure that trx has been
   started. */
 
+  if (auto err = set_rw_mode(); err != DB_SUCCESS) {
+    return err;
+  }
+
   m_op_info = "preparing";
 
   mutex_enter(&kernel_mutex);
@@ -999,7 +1145,7 @@ ulint Trx::prepare() noexcept {
 
   m_op_info = "";
 
-  return 0;
+  return DB_SUCCESS;
 }
 
 #ifdef WITH_XOPEN
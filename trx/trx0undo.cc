@@ -945,6 +945,7 @@ db_err Undo::assign_undo(Trx *trx, ulint type) noexcept {
   auto rseg = trx->m_rseg;
 
   ut_ad(mutex_own(&trx->m_undo_mutex));
+  ut_a(!trx->m_ro_fast_path);
 
   mtr_t mtr;
 
@@ -0,0 +1,255 @@
+/** Copyright (c) 2024 Sunny Bains. All rights reserved. */
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <array>
+#include <vector>
+
+#include "innodb0types.h"
+
+#include "os0aio.h"
+#include "ut0mem.h"
+
+/** Size of the blocks written and read. */
+constexpr ulint BLOCK_SIZE = 64 * 1024;
+
+/** Number of blocks in the file. */
+constexpr ulint N_BLOCKS = 16;
+
+/** Number of requests in flight. */
+constexpr ulint N_ENTRIES = 4;
+
+namespace test {
+
+/** Creates an empty temporary file.
+@param[out] path                Path of the file, the file must be unlinked.
+@return the file handle opened for reading and writing. */
+int create_file(std::array<char, 32> &path) {
+  snprintf(path.data(), path.size(), "/tmp/test_aio_ringXXXXXX");
+
+  const auto fh = mkstemp(path.data());
+  ut_a(fh != -1);
+
+  return fh;
+}
+
+/** Fills a block with a pattern that depends on its number.
+@param[out] ptr                 Block.
+@param[in] n                    Block number. */
+void fill(byte *ptr, ulint n) {
+  for (ulint i{}; i < BLOCK_SIZE; ++i) {
+    ptr[i] = byte((n * 31 + i) % 251);
+  }
+}
+
+/** Checks the pattern written by fill().
+@param[in] ptr                  Block.
+@param[in] n                    Block number.
+@return true if the block has the pattern. */
+bool check(const byte *ptr, ulint n) {
+  for (ulint i{}; i < BLOCK_SIZE; ++i) {
+    if (ptr[i] != byte((n * 31 + i) % 251)) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+/** Writes the blocks of the file with N_ENTRIES writes in flight.
+@param[in,out] ring             Ring to use.
+@param[in] fh                   File handle. */
+void write_blocks(AIO_ring *ring, int fh) {
+  std::vector<byte> buf(N_ENTRIES * BLOCK_SIZE);
+  std::array<AIO_ring::Request, N_ENTRIES> reqs{};
+
+  for (ulint n{}; n < N_BLOCKS; ++n) {
+    auto &req = reqs[n % N_ENTRIES];
+
+    if (req.m_pending) {
+      const auto err = ring->wait(req);
+      ut_a(err == DB_SUCCESS);
+    }
+
+    req.m_read = false;
+    req.m_fh = fh;
+    req.m_ptr = &buf[(n % N_ENTRIES) * BLOCK_SIZE];
+    req.m_len = BLOCK_SIZE;
+    req.m_off = off_t(n * BLOCK_SIZE);
+
+    fill(req.m_ptr, n);
+
+    const auto err = ring->submit(req);
+    ut_a(err == DB_SUCCESS);
+  }
+
+  for (auto &req : reqs) {
+    const auto err = ring->wait(req);
+    ut_a(err == DB_SUCCESS);
+    ut_a(req.m_done == req.m_len);
+  }
+}
+
+/** Blocks written with several requests in flight are read back with
+read-ahead, in the order they are waited for and not completed. */
+void read_write() {
+  std::array<char, 32> path;
+
+  std::cout << "aio_ring: write and read " << N_BLOCKS << " blocks\n";
+
+  const auto fh = create_file(path);
+  auto ring = AIO_ring::create(N_ENTRIES);
+
+  write_blocks(ring, fh);
+
+  std::vector<byte> buf(2 * BLOCK_SIZE);
+  std::array<AIO_ring::Request, 2> reqs{};
+
+  /* Read block n + 1 ahead while block n is checked. */
+  for (ulint n{}; n <= N_BLOCKS; ++n) {
+    if (n < N_BLOCKS) {
+      auto &req = reqs[n % 2];
+
+      req.m_read = true;
+      req.m_fh = fh;
+      req.m_ptr = &buf[(n % 2) * BLOCK_SIZE];
+      req.m_len = BLOCK_SIZE;
+      req.m_off = off_t(n * BLOCK_SIZE);
+
+      const auto err = ring->submit(req);
+      ut_a(err == DB_SUCCESS);
+    }
+
+    if (n > 0) {
+      auto &req = reqs[(n - 1) % 2];
+
+      const auto err = ring->wait(req);
+      ut_a(err == DB_SUCCESS);
+      ut_a(!req.m_pending);
+      ut_a(check(req.m_ptr, n - 1));
+    }
+  }
+
+  AIO_ring::destroy(ring);
+  ut_a(ring == nullptr);
+
+  close(fh);
+  unlink(path.data());
+}
+
+/** Failed reads and writes are reported by wait(), and the ring can still be
+used after them. */
+void errors() {
+  std::array<char, 32> path;
+
+  std::cout << "aio_ring: error paths\n";
+
+  const auto fh = create_file(path);
+  auto ring = AIO_ring::create(N_ENTRIES);
+
+  write_blocks(ring, fh);
+
+  std::vector<byte> buf(2 * BLOCK_SIZE);
+  AIO_ring::Request req{};
+
+  req.m_read = true;
+  req.m_fh = fh;
+  req.m_ptr = buf.data();
+  req.m_len = BLOCK_SIZE;
+
+  /* A read that starts at the end of the file. */
+  req.m_off = off_t(N_BLOCKS * BLOCK_SIZE);
+
+  auto err = ring->submit(req);
+  ut_a(err == DB_SUCCESS);
+
+  err = ring->wait(req);
+  ut_a(err == DB_ERROR);
+  ut_a(!req.m_ok);
+  ut_a(!req.m_pending);
+
+  /* A read that ends beyond the end of the file: the first block is read,
+  the rest of the request is resubmitted and fails. */
+  req.m_len = 2 * BLOCK_SIZE;
+  req.m_off = off_t((N_BLOCKS - 1) * BLOCK_SIZE);
+
+  err = ring->submit(req);
+  ut_a(err == DB_SUCCESS);
+
+  err = ring->wait(req);
+  ut_a(err == DB_ERROR);
+  ut_a(!req.m_ok);
+  ut_a(check(req.m_ptr, N_BLOCKS - 1));
+
+  /* A read of a file that is only open for writing. */
+  const auto wr_fh = open(path.data(), O_WRONLY);
+  ut_a(wr_fh != -1);
+
+  req.m_fh = wr_fh;
+  req.m_len = BLOCK_SIZE;
+  req.m_off = 0;
+
+  err = ring->submit(req);
+  ut_a(err == DB_SUCCESS);
+
+  err = ring->wait(req);
+  ut_a(err == DB_ERROR);
+  ut_a(!req.m_ok);
+
+  close(wr_fh);
+
+  /* A write to a file that is only open for reading. */
+  const auto rd_fh = open(path.data(), O_RDONLY);
+  ut_a(rd_fh != -1);
+
+  req.m_read = false;
+  req.m_fh = rd_fh;
+
+  err = ring->submit(req);
+  ut_a(err == DB_SUCCESS);
+
+  err = ring->wait(req);
+  ut_a(err == DB_ERROR);
+  ut_a(!req.m_ok);
+
+  close(rd_fh);
+
+  /* The failures left nothing in flight, a valid read succeeds. */
+  req.m_read = true;
+  req.m_fh = fh;
+  req.m_off = off_t(3 * BLOCK_SIZE);
+
+  err = ring->submit(req);
+  ut_a(err == DB_SUCCESS);
+
+  err = ring->wait(req);
+  ut_a(err == DB_SUCCESS);
+  ut_a(req.m_ok);
+  ut_a(check(req.m_ptr, 3));
+
+  AIO_ring::destroy(ring);
+
+  close(fh);
+  unlink(path.data());
+}
+
+} // namespace test
+
+int main() {
+  // Startup
+  ut_mem_init();
+
+  // Run the tests
+  test::read_write();
+
+  test::errors();
+
+  // Shutdown
+  ut_delete_all_mem();
+
+  exit(EXIT_SUCCESS);
+}
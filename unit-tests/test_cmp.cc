@@ -0,0 +1,300 @@
+/** Copyright (c) 2024 Sunny Bains. All rights reserved. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <vector>
+
+#include "innodb0types.h"
+
+#include "data0data.h"
+#include "data0type.h"
+#include "mach0data.h"
+#include "mem0mem.h"
+#include "rem0cmp.h"
+#include "rem0rec.h"
+#include "ut0mem.h"
+
+/** Number of tuples generated for each schema. */
+constexpr ulint N_TUPLES = 150;
+
+/** Maximum length of the variable length values, longer than a key prefix. */
+constexpr ulint MAX_LEN = 12;
+
+namespace test {
+
+/** A column of a schema. */
+struct Col_def {
+  /** Main type */
+  ulint m_mtype;
+
+  /** Precise type, with the charset-collation */
+  ulint m_prtype;
+
+  /** Length of the fixed length types */
+  ulint m_len;
+};
+
+using Schema = std::vector<Col_def>;
+
+/** The INT values, stored big-endian, the byte order is their order. */
+const uint32_t INTS[] = {0, 1, 0x7fffffff, 0x80000000, 0xffffffff};
+
+/** The bytes of the string values: below, equal to and above the pad
+character, so that the padding decides some of the comparisons. */
+const byte CHARS[] = {0x00, 0x1f, 0x20, 'a', 'b', 0xff};
+
+/** @return the schemas to test, the types are mixed and the ones that are not
+byte ordered end the key prefix and disable the byte compare of the search
+key. */
+std::vector<Schema> schemas() {
+  const auto latin1 = dtype_form_prtype(0, DATA_CLIENT_LATIN1_SWEDISH_CHARSET_COLL);
+  const auto binary = dtype_form_prtype(0, DATA_CLIENT_BINARY_CHARSET_COLL);
+
+  return {
+    {{DATA_INT, DATA_UNSIGNED, 4}, {DATA_VARCHAR, latin1, 0}, {DATA_INT, DATA_UNSIGNED, 4}},
+    {{DATA_VARCHAR, latin1, 0}, {DATA_INT, DATA_UNSIGNED, 4}},
+    {{DATA_CHAR, latin1, 0}, {DATA_FIXBINARY, binary, 4}, {DATA_VARCHAR, latin1, 0}},
+    {{DATA_BINARY, binary, 0}, {DATA_BLOB, latin1, 0}, {DATA_INT, DATA_UNSIGNED, 4}},
+    {{DATA_INT, DATA_UNSIGNED, 4}, {DATA_FLOAT, 0, 4}, {DATA_VARCHAR, latin1, 0}},
+  };
+}
+
+/** Sets a random value, NULL one time in eight. Most of the bytes of the
+strings are the same, so that many key prefixes tie and the bytes after
+them decide.
+@param[in,out] dfield           Field with its type set.
+@param[in,out] heap             Heap for the value. */
+void set_random_value(dfield_t *dfield, mem_heap_t *heap) {
+  const auto type = dfield_get_type(dfield);
+
+  if (random() % 8 == 0) {
+    dfield_set_null(dfield);
+    return;
+  }
+
+  auto ptr = static_cast<byte *>(mem_heap_alloc(heap, MAX_LEN));
+
+  switch (type->mtype) {
+    case DATA_INT:
+      mach_write_to_4(ptr, INTS[random() % std::size(INTS)]);
+      dfield_set_data(dfield, ptr, 4);
+      return;
+
+    case DATA_FLOAT:
+      mach_float_write(ptr, float(random() % 4) - 1.5f);
+      dfield_set_data(dfield, ptr, 4);
+      return;
+
+    default: {
+      const ulint len = type->mtype == DATA_FIXBINARY ? type->len : random() % (MAX_LEN + 1);
+
+      for (ulint i{}; i < len; ++i) {
+        ptr[i] = random() % 4 == 0 ? CHARS[random() % std::size(CHARS)] : 'a';
+      }
+
+      dfield_set_data(dfield, ptr, len);
+      return;
+    }
+  }
+}
+
+/** Creates random tuples of a schema.
+@param[in] schema               Types of the fields.
+@param[in,out] heap             Heap for the tuples.
+@return the tuples. */
+std::vector<DTuple *> create_tuples(const Schema &schema, mem_heap_t *heap) {
+  std::vector<DTuple *> tuples;
+
+  for (ulint i{}; i < N_TUPLES; ++i) {
+    auto tuple = dtuple_create(heap, schema.size());
+
+    for (ulint j{}; j < schema.size(); ++j) {
+      const auto &col = schema[j];
+      auto dfield = dtuple_get_nth_field(tuple, j);
+
+      dtype_set(dfield_get_type(dfield), col.m_mtype, col.m_prtype, col.m_len);
+      set_random_value(dfield, heap);
+    }
+
+    tuples.push_back(tuple);
+  }
+
+  return tuples;
+}
+
+/** Compares two tuples field by field with the type aware comparator.
+@param[in] tuple1               Tuple.
+@param[in] tuple2               Tuple of the same schema.
+@param[in] n_fields             Number of fields to compare.
+@return 1, 0, -1, if tuple1 is greater, equal, less than tuple2. */
+int cmp_tuples(const DTuple *tuple1, const DTuple *tuple2, ulint n_fields) {
+  for (ulint i{}; i < n_fields; ++i) {
+    const auto ret = cmp_dfield_dfield(nullptr, dtuple_get_nth_field(tuple1, i), dtuple_get_nth_field(tuple2, i));
+
+    if (ret != 0) {
+      return ret;
+    }
+  }
+
+  return 0;
+}
+
+/** The shortcuts are only taken for byte ordered types, the latin1 strings
+are byte ordered only while the collation is the identity. */
+void byte_ordered() {
+  const auto latin1 = dtype_form_prtype(0, DATA_CLIENT_LATIN1_SWEDISH_CHARSET_COLL);
+  const auto binary = dtype_form_prtype(0, DATA_CLIENT_BINARY_CHARSET_COLL);
+  const auto utf8 = dtype_form_prtype(0, 33);
+
+  std::cout << "cmp: byte ordered types\n";
+
+  ut_a(cmp_type_is_byte_ordered(DATA_INT, DATA_UNSIGNED));
+  ut_a(cmp_type_is_byte_ordered(DATA_FIXBINARY, binary));
+  ut_a(cmp_type_is_byte_ordered(DATA_BINARY, binary));
+  ut_a(cmp_type_is_byte_ordered(DATA_BLOB, DATA_BINARY_TYPE));
+
+  ut_a(cmp_type_is_byte_ordered(DATA_CHAR, latin1) == cmp_collate_is_identity());
+  ut_a(cmp_type_is_byte_ordered(DATA_VARCHAR, latin1) == cmp_collate_is_identity());
+  ut_a(cmp_type_is_byte_ordered(DATA_BLOB, latin1) == cmp_collate_is_identity());
+
+  ut_a(!cmp_type_is_byte_ordered(DATA_BLOB, utf8));
+  ut_a(!cmp_type_is_byte_ordered(DATA_FLOAT, 0));
+  ut_a(!cmp_type_is_byte_ordered(DATA_DOUBLE, 0));
+  ut_a(!cmp_type_is_byte_ordered(DATA_DECIMAL, 0));
+  ut_a(!cmp_type_is_byte_ordered(DATA_VARCLIENT, latin1));
+}
+
+/** Tuples whose key prefixes differ compare like the prefixes, equal tuples
+have equal prefixes.
+@param[in] schema               Types of the fields. */
+void key_prefix(const Schema &schema) {
+  ulint n_ties{};
+  auto heap = mem_heap_create(1024);
+  const auto tuples = create_tuples(schema, heap);
+
+  std::vector<uint64_t> prefixes;
+
+  for (auto tuple : tuples) {
+    prefixes.push_back(cmp_dfield_key_prefix(dtuple_get_nth_field(tuple, 0), schema.size()));
+  }
+
+  for (ulint i{}; i < tuples.size(); ++i) {
+    for (ulint j{}; j < tuples.size(); ++j) {
+      const auto ret = cmp_tuples(tuples[i], tuples[j], schema.size());
+
+      if (prefixes[i] < prefixes[j]) {
+        ut_a(ret < 0);
+      } else if (prefixes[i] > prefixes[j]) {
+        ut_a(ret > 0);
+      } else if (ret != 0) {
+        /* The fields after the prefix decide. */
+        ++n_ties;
+      }
+    }
+  }
+
+  ut_a(n_ties > 0);
+
+  std::cout << "cmp: key prefix, " << schema.size() << " fields, " << n_ties << " ties\n";
+
+  mem_heap_free(heap);
+}
+
+/** The search key compares to the records like cmp_dtuple_rec_with_match(),
+with the same matched fields and bytes, from the start and when resuming from
+a partial match.
+@param[in] schema               Types of the fields. */
+void search_key(const Schema &schema) {
+  auto heap = mem_heap_create(1024);
+  const auto tuples = create_tuples(schema, heap);
+
+  std::vector<const rec_t *> recs;
+  std::vector<const ulint *> offsets;
+
+  for (auto tuple : tuples) {
+    auto buf = static_cast<byte *>(mem_heap_alloc(heap, rec_get_converted_size(nullptr, tuple, 0)));
+    auto rec = rec_convert_dtuple_to_rec(buf, nullptr, tuple, 0);
+
+    recs.push_back(rec);
+    offsets.push_back(Phy_rec(nullptr, rec).get_col_offsets(nullptr, ULINT_UNDEFINED, &heap, Current_location()));
+  }
+
+  for (ulint n_fields_cmp = schema.size(); n_fields_cmp > 0; --n_fields_cmp) {
+    bool binary{true};
+
+    for (ulint i{}; i < n_fields_cmp; ++i) {
+      binary = binary && cmp_type_is_byte_ordered(schema[i].m_mtype, schema[i].m_prtype);
+    }
+
+    for (ulint i{}; i < tuples.size(); ++i) {
+      auto tuple = tuples[i];
+
+      dtuple_set_n_fields_cmp(tuple, n_fields_cmp);
+
+      const Cmp_search_key key(nullptr, tuple);
+
+      ut_a(key.m_binary == binary);
+
+      for (ulint j{}; j < recs.size(); ++j) {
+        ulint matched_fields{};
+        ulint matched_bytes{};
+        ulint ref_matched_fields{};
+        ulint ref_matched_bytes{};
+
+        const auto ret = key.compare(recs[j], offsets[j], &matched_fields, &matched_bytes);
+        const auto ref = cmp_dtuple_rec_with_match(nullptr, tuple, recs[j], offsets[j], &ref_matched_fields, &ref_matched_bytes);
+
+        ut_a(ret == ref);
+        ut_a(matched_fields == ref_matched_fields);
+        ut_a(matched_bytes == ref_matched_bytes);
+
+        ut_a(ret == cmp_tuples(tuple, tuples[j], n_fields_cmp));
+
+        /* Resume from the match, at its field and at the byte within it. */
+        for (auto resume_bytes : {ulint{}, ref_matched_bytes}) {
+          matched_fields = ref_matched_fields;
+          matched_bytes = resume_bytes;
+
+          ut_a(key.compare(recs[j], offsets[j], &matched_fields, &matched_bytes) == ref);
+          ut_a(matched_fields == ref_matched_fields);
+          ut_a(matched_bytes == ref_matched_bytes);
+        }
+      }
+
+      dtuple_set_n_fields_cmp(tuple, schema.size());
+    }
+  }
+
+  std::cout << "cmp: search key, " << schema.size() << " fields\n";
+
+  mem_heap_free(heap);
+}
+
+} // namespace test
+
+int main() {
+  const auto seed = time(nullptr);
+
+  srandom(unsigned(seed));
+
+  std::cout << "cmp: seed " << seed << "\n";
+
+  // Startup
+  ut_mem_init();
+
+  // Run the tests
+  test::byte_ordered();
+
+  for (const auto &schema : test::schemas()) {
+    test::key_prefix(schema);
+
+    test::search_key(schema);
+  }
+
+  // Shutdown
+  ut_delete_all_mem();
+
+  exit(EXIT_SUCCESS);
+}
@@ -0,0 +1,114 @@
+/** Copyright (c) 2024 Sunny Bains. All rights reserved. */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "innodb0types.h"
+
+#include "trx0purge.h"
+#include "ut0mem.h"
+
+/** Token rate of the throttled tests, one token every millisecond. */
+constexpr double RATE = 1000.0;
+
+/** Number of tokens taken past the burst. */
+constexpr uint64_t N_DELAYED = 100;
+
+namespace test {
+
+/** While the purge keeps up no token is taken, whatever the rate. */
+void not_lagging() {
+  Dml_throttle throttle;
+
+  throttle.set_rate(RATE);
+
+  for (ulint i{}; i < 1000; ++i) {
+    ut_a(throttle.acquire() == 0);
+  }
+
+  ut_a(throttle.m_n_acquired == 0);
+  ut_a(throttle.m_n_delayed == 0);
+  ut_a(throttle.m_next_us == 0);
+
+  std::cout << "dml throttle: not lagging, no tokens taken\n";
+}
+
+/** While the purge lags the tokens beyond the burst are delayed by the token
+interval each, and once the rate is reset to 0 the DML is let through. */
+void throttles_and_releases() {
+  Dml_throttle throttle;
+
+  throttle.m_lagging = true;
+
+  /* Lagging but not throttled yet, the tokens are counted for the rate. */
+  ut_a(throttle.acquire() == 0);
+  ut_a(throttle.m_n_acquired == 1);
+
+  throttle.set_rate(RATE);
+
+  const auto interval = throttle.m_interval_us.load();
+
+  ut_a(interval == uint64_t(1000000.0 / RATE));
+  ut_a(throttle.rate() == RATE);
+
+  /* The idle period filled the bucket, these are not delayed. */
+  for (uint64_t i{}; i < DML_THROTTLE_BURST; ++i) {
+    ut_a(throttle.acquire() == 0);
+  }
+
+  uint64_t delay{};
+  const auto next_us = throttle.m_next_us.load();
+
+  /* Nobody waits for the tokens here, every one is issued one interval after
+  the previous one so the delays grow. */
+  for (uint64_t i{}; i < N_DELAYED; ++i) {
+    delay = throttle.acquire();
+  }
+
+  ut_a(throttle.m_next_us == next_us + N_DELAYED * interval);
+
+  ut_a(throttle.m_n_delayed >= N_DELAYED - 1);
+  ut_a(delay >= (N_DELAYED / 2) * interval);
+  ut_a(throttle.m_delay_us >= delay);
+
+  std::cout << "dml throttle: " << throttle.m_n_delayed << " tokens delayed, last by " << delay << " us\n";
+
+  /* The purge caught up. */
+  throttle.set_rate(0);
+
+  ut_a(throttle.rate() == 0.0);
+
+  const auto n_delayed = throttle.m_n_delayed.load();
+
+  for (ulint i{}; i < 1000; ++i) {
+    ut_a(throttle.acquire() == 0);
+  }
+
+  ut_a(throttle.m_n_delayed == n_delayed);
+
+  throttle.m_lagging = false;
+
+  const auto n_acquired = throttle.m_n_acquired.load();
+
+  ut_a(throttle.acquire() == 0);
+  ut_a(throttle.m_n_acquired == n_acquired);
+
+  std::cout << "dml throttle: released\n";
+}
+
+} // namespace test
+
+int main() {
+  // Startup
+  ut_mem_init();
+
+  // Run the tests
+  test::not_lagging();
+
+  test::throttles_and_releases();
+
+  // Shutdown
+  ut_delete_all_mem();
+
+  exit(EXIT_SUCCESS);
+}
@@ -3,6 +3,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 
+#include <thread>
 #include <vector>
 
 #include "innodb0types.h"
@@ -15,6 +16,9 @@ constexpr int N_TRXS = 8;
 constexpr int N_ROW_LOCKS = 1;
 constexpr int REC_BITMAP_SIZE = 104;
 
+/** Number of pages that each transaction of run_2() locks a record on. */
+constexpr int N_PAGES = 1000;
+
 #define kernel_mutex_enter() \
   do { \
     mutex_enter(kernel_mutex_temp); \
@@ -124,6 +128,84 @@ void run_1() {
 
 }
 
+/** Each of N_TRXS threads locks a record on N_PAGES pages of its own and
+releases the locks again, while the other threads do the same. Every page
+must end up with a queue of its own that only holds the lock of its
+transaction, and the lock table must be empty after the release. */
+void run_2() {
+  std::cout << "Locking records on " << N_PAGES << " pages in each of " << N_TRXS << " threads\n";
+
+  std::vector<Trx*> trxs(N_TRXS);
+  std::vector<std::thread> threads;
+
+  for (auto &trx : trxs) {
+    trx = trx_create();
+  }
+
+  for (int i = 0; i < N_TRXS; ++i) {
+    threads.emplace_back([&trxs](int i) {
+      for (int j = 0; j < N_PAGES; ++j) {
+        kernel_mutex_enter();
+
+        (void) srv_lock_sys->rec_create_low({space_id_t(i), page_no_t(j)}, LOCK_X, j % REC_BITMAP_SIZE, REC_BITMAP_SIZE, nullptr, trxs[i]);
+
+        kernel_mutex_exit();
+      }
+    }, i);
+  }
+
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  threads.clear();
+
+  kernel_mutex_enter();
+
+  ut_a(srv_lock_sys->get_n_rec_locks() == ulint(N_TRXS) * N_PAGES);
+
+  for (int i = 0; i < N_TRXS; ++i) {
+    for (int j = 0; j < N_PAGES; ++j) {
+      auto rec_locks = srv_lock_sys->rec_get_locks({space_id_t(i), page_no_t(j)});
+
+      ut_a(rec_locks != nullptr);
+
+      auto lock = rec_locks->front();
+
+      ut_a(lock->m_trx == trxs[i]);
+      ut_a(lock->next() == nullptr);
+      ut_a(lock->rec_is_nth_bit_set(j % REC_BITMAP_SIZE));
+      ut_a(!lock->is_waiting());
+    }
+  }
+
+  kernel_mutex_exit();
+
+  for (int i = 0; i < N_TRXS; ++i) {
+    threads.emplace_back([&trxs](int i) {
+      kernel_mutex_enter();
+
+      srv_lock_sys->release_off_kernel(trxs[i]);
+
+      kernel_mutex_exit();
+    }, i);
+  }
+
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  kernel_mutex_enter();
+
+  ut_a(srv_lock_sys->get_n_rec_locks() == 0);
+
+  kernel_mutex_exit();
+
+  for (auto &trx : trxs) {
+    trx_free(trx);
+  }
+}
+
 } // namespace test
 
 int main() {
@@ -136,7 +218,7 @@ int main() {
 
   os_sync_init();
 
-  srv_config.m_max_n_threads = N_TRXS;
+  srv_config.m_max_n_threads = N_TRXS * 2;
 
   sync_init();
 
@@ -161,15 +243,17 @@ int main() {
 
   srv_lock_sys = Lock_sys::create(srv_trx_sys, 1024 * 1024);
 
-  kernel_mutex_enter();
+  srv_trx_sys->mutex_acquire();
 
   UT_LIST_INIT(srv_trx_sys->m_client_trx_list);
 
-  kernel_mutex_exit();
+  srv_trx_sys->mutex_release();
 
   // Run the test
   test::run_1();
 
+  test::run_2();
+
   // Shutdown
   Lock_sys::destroy(srv_lock_sys);
 
@@ -0,0 +1,670 @@
+/** Copyright (c) 2024 Sunny Bains. All rights reserved. */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+#include "innodb0types.h"
+
+#include "srv0srv.h"
+#include "sync0prof.h"
+#include "sync0rw.h"
+#include "sync0sync.h"
+
+constexpr int N_THREADS = 8;
+constexpr int N_ITERATIONS = 100000;
+
+/** Time for the threads to give up spinning and park. */
+constexpr auto PARK_WAIT = std::chrono::milliseconds(500);
+
+/** Number of contended acquisitions in the spin budget tests. */
+constexpr int N_SPINS = 32;
+
+/** Spin rounds that take far longer than the spin budget tests hold the
+mutex for. */
+constexpr ulong LONG_SPIN_ROUNDS = 1UL << 24;
+
+namespace test {
+
+/** Runs f(i) in N_THREADS threads and waits for them to finish.
+@param[in] f                    Thread body, called with the thread number. */
+template <typename F>
+void run_threads(F &&f) {
+  std::vector<std::thread> threads;
+
+  for (int i = 0; i < N_THREADS; ++i) {
+    threads.emplace_back(f, i);
+  }
+
+  for (auto &thread : threads) {
+    thread.join();
+  }
+}
+
+/** Increments a counter under a mutex, some threads hold it long enough
+for the others to park. */
+void mutex_count() {
+  mutex_t mutex;
+  ulint count{};
+
+  std::cout << "mutex: " << N_THREADS << " threads x " << N_ITERATIONS << " increments\n";
+
+  mutex_create(&mutex, IF_DEBUG("test_mutex",) IF_SYNC_DEBUG(SYNC_NO_ORDER_CHECK,) Current_location());
+
+  run_threads([&](int i) {
+    for (int j = 0; j < N_ITERATIONS; ++j) {
+      mutex_enter(&mutex);
+
+      ++count;
+
+      if (j % 10000 == i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      }
+
+      mutex_exit(&mutex);
+    }
+  });
+
+  ut_a(count == ulint(N_THREADS) * N_ITERATIONS);
+  ut_a(mutex.lock_word == MUTEX_UNLOCKED);
+
+  mutex_free(&mutex);
+}
+
+/** Threads blocked on a held mutex park, and are all woken up once it is
+released. */
+void mutex_wakeup() {
+  mutex_t mutex;
+  std::atomic<int> n_entered{};
+
+  std::cout << "mutex: wake up " << N_THREADS << " parked threads\n";
+
+  mutex_create(&mutex, IF_DEBUG("test_mutex",) IF_SYNC_DEBUG(SYNC_NO_ORDER_CHECK,) Current_location());
+
+  mutex_enter(&mutex);
+
+  std::vector<std::thread> threads;
+
+  for (int i = 0; i < N_THREADS; ++i) {
+    threads.emplace_back([&]() {
+      mutex_enter(&mutex);
+      ++n_entered;
+      mutex_exit(&mutex);
+    });
+  }
+
+  std::this_thread::sleep_for(PARK_WAIT);
+
+  /* No thread got past the mutex, at least one parked on it. */
+  ut_a(n_entered == 0);
+  ut_a(mutex.lock_word == MUTEX_LOCKED_WAITERS);
+
+  mutex_exit(&mutex);
+
+  /* A release that misses a parked thread hangs here. */
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  ut_a(n_entered == N_THREADS);
+  ut_a(mutex.lock_word == MUTEX_UNLOCKED);
+
+  mutex_free(&mutex);
+}
+
+/** Waits until a thread blocked on the mutex gave up spinning and parked.
+@param[in] mutex                Mutex held by the caller or another thread. */
+void mutex_wait_for_waiter(const mutex_t *mutex) {
+  while (mutex->lock_word.load() != MUTEX_LOCKED_WAITERS) {
+    std::this_thread::yield();
+  }
+}
+
+/** Spins that fail lower the spin success rate, and leave the average
+spin rounds alone. */
+void mutex_spin_shrink() {
+  mutex_t mutex;
+
+  std::cout << "mutex: spin budget shrinks on failed spins\n";
+
+  mutex_create(&mutex, IF_DEBUG("test_mutex",) IF_SYNC_DEBUG(SYNC_NO_ORDER_CHECK,) Current_location());
+
+  const auto spin_avg = mutex.m_spin_avg.load();
+
+  ut_a(mutex.m_spin_success == MUTEX_SPIN_SUCCESS_MAX);
+
+  for (int i = 0; i < N_SPINS; ++i) {
+    mutex_enter(&mutex);
+
+    std::thread waiter([&]() {
+      mutex_enter(&mutex);
+      mutex_exit(&mutex);
+    });
+
+    /* The mutex is held until the waiter parks, its spin always fails. */
+    mutex_wait_for_waiter(&mutex);
+
+    mutex_exit(&mutex);
+
+    waiter.join();
+  }
+
+  ut_a(mutex.m_spin_success < MUTEX_SPIN_SUCCESS_MAX / 2);
+  ut_a(mutex.m_spin_avg == spin_avg);
+
+  std::cout << "mutex: spin success " << mutex.m_spin_success << " of " << MUTEX_SPIN_SUCCESS_MAX << "\n";
+
+  mutex_free(&mutex);
+}
+
+/** Spins that get the mutex raise the spin success rate and feed the
+average spin rounds. */
+void mutex_spin_grow() {
+  mutex_t mutex;
+  const auto n_spin_wait_rounds = srv_n_spin_wait_rounds;
+
+  std::cout << "mutex: spin budget grows on successful spins\n";
+
+  /* Spin for much longer than the mutex is held, so that every spin gets it. */
+  srv_n_spin_wait_rounds = LONG_SPIN_ROUNDS;
+
+  mutex_create(&mutex, IF_DEBUG("test_mutex",) IF_SYNC_DEBUG(SYNC_NO_ORDER_CHECK,) Current_location());
+
+  /* Just above the rate at which the waiters only probe briefly. */
+  mutex.m_spin_success = MUTEX_SPIN_SUCCESS_MAX / 8;
+  mutex.m_spin_avg = LONG_SPIN_ROUNDS * MUTEX_SPIN_AVG_SCALE;
+
+  for (int i = 0; i < N_SPINS; ++i) {
+    std::atomic<bool> entering{};
+
+    mutex_enter(&mutex);
+
+    std::thread waiter([&]() {
+      entering = true;
+
+      mutex_enter(&mutex);
+      mutex_exit(&mutex);
+    });
+
+    while (!entering) {
+      std::this_thread::yield();
+    }
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+    mutex_exit(&mutex);
+
+    waiter.join();
+  }
+
+  ut_a(mutex.m_spin_success > MUTEX_SPIN_SUCCESS_MAX / 8);
+  ut_a(mutex.m_spin_avg < LONG_SPIN_ROUNDS * MUTEX_SPIN_AVG_SCALE);
+  ut_a(mutex.lock_word == MUTEX_UNLOCKED);
+
+  std::cout << "mutex: spin success " << mutex.m_spin_success << " of " << MUTEX_SPIN_SUCCESS_MAX << ", average "
+            << mutex.m_spin_avg / MUTEX_SPIN_AVG_SCALE << " rounds\n";
+
+  mutex_free(&mutex);
+
+  srv_n_spin_wait_rounds = n_spin_wait_rounds;
+}
+
+/** A waiter does not spin for a mutex whose owner is blocked in the OS, it
+parks right away and leaves the spin statistics alone. */
+void mutex_parked_owner() {
+  mutex_t mutex;
+  std::atomic<bool> locked{};
+  const auto n_spin_wait_rounds = srv_n_spin_wait_rounds;
+
+  std::cout << "mutex: no spinning while the owner is parked\n";
+
+  /* A waiter that spun would fail, the owner holds the mutex until it parks. */
+  srv_n_spin_wait_rounds = LONG_SPIN_ROUNDS;
+
+  mutex_create(&mutex, IF_DEBUG("test_mutex",) IF_SYNC_DEBUG(SYNC_NO_ORDER_CHECK,) Current_location());
+
+  const auto spin_avg = mutex.m_spin_avg.load();
+  const auto spin_success = mutex.m_spin_success.load();
+
+  std::thread owner([&]() {
+    mutex_enter(&mutex);
+
+    os_thread_set_parked(true);
+
+    locked = true;
+
+    mutex_wait_for_waiter(&mutex);
+
+    os_thread_set_parked(false);
+
+    mutex_exit(&mutex);
+  });
+
+  while (!locked) {
+    std::this_thread::yield();
+  }
+
+  mutex_enter(&mutex);
+
+  ut_a(mutex.m_spin_success == spin_success);
+  ut_a(mutex.m_spin_avg == spin_avg);
+
+  mutex_exit(&mutex);
+
+  owner.join();
+
+  mutex_free(&mutex);
+
+  srv_n_spin_wait_rounds = n_spin_wait_rounds;
+}
+
+/** Writers update two counters under an x-lock, readers under an s-lock
+must always see them equal. */
+void rw_lock_count() {
+  rw_lock_t lock;
+  ulint a{};
+  ulint b{};
+  std::atomic<ulint> n_reads{};
+
+  std::cout << "rw-lock: " << N_THREADS / 2 << " writers, " << N_THREADS / 2 << " readers\n";
+
+  rw_lock_create(&lock, SYNC_NO_ORDER_CHECK);
+
+  run_threads([&](int i) {
+    for (int j = 0; j < N_ITERATIONS / 10; ++j) {
+      if (i % 2 == 0) {
+        rw_lock_x_lock(&lock);
+
+        ++a;
+
+        if (j % 1000 == i) {
+          std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+
+        ++b;
+
+        rw_lock_x_unlock(&lock);
+
+      } else {
+        rw_lock_s_lock(&lock);
+
+        ut_a(a == b);
+        ++n_reads;
+
+        rw_lock_s_unlock(&lock);
+      }
+    }
+  });
+
+  ut_a(a == ulint(N_THREADS / 2) * (N_ITERATIONS / 10));
+  ut_a(a == b);
+  ut_a(n_reads == ulint(N_THREADS / 2) * (N_ITERATIONS / 10));
+  ut_a(!rw_lock_is_locked(&lock, RW_LOCK_SHARED));
+  ut_a(!rw_lock_is_locked(&lock, RW_LOCK_EX));
+
+  rw_lock_free(&lock);
+}
+
+/** Readers and writers blocked on an x-locked rw-lock park, and are all
+woken up once it is released. */
+void rw_lock_wakeup() {
+  rw_lock_t lock;
+  std::atomic<int> n_entered{};
+  std::vector<std::thread> threads;
+
+  std::cout << "rw-lock: wake up " << N_THREADS << " parked threads\n";
+
+  rw_lock_create(&lock, SYNC_NO_ORDER_CHECK);
+
+  rw_lock_x_lock(&lock);
+
+  for (int i = 0; i < N_THREADS; ++i) {
+    threads.emplace_back([&](int i) {
+      if (i % 2 == 0) {
+        rw_lock_s_lock(&lock);
+        ++n_entered;
+        rw_lock_s_unlock(&lock);
+      } else {
+        rw_lock_x_lock(&lock);
+        ++n_entered;
+        rw_lock_x_unlock(&lock);
+      }
+    }, i);
+  }
+
+  std::this_thread::sleep_for(PARK_WAIT);
+
+  ut_a(n_entered == 0);
+  ut_a(rw_lock_get_waiters(&lock));
+
+  rw_lock_x_unlock(&lock);
+
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  ut_a(n_entered == N_THREADS);
+  ut_a(!rw_lock_is_locked(&lock, RW_LOCK_SHARED));
+  ut_a(!rw_lock_is_locked(&lock, RW_LOCK_EX));
+
+  rw_lock_free(&lock);
+}
+
+/** Takes the lock in a thread and checks whether it had to wait.
+@param[in,out] lock             Lock held by the caller in some mode.
+@param[in] lock_type            RW_LOCK_SHARED, RW_LOCK_SX or RW_LOCK_EX.
+@param[in] release              Releases the caller's lock after PARK_WAIT,
+                                called if the thread is blocked.
+@return true if the thread got the lock without waiting for release(). */
+template <typename F>
+bool rw_lock_compatible(rw_lock_t *lock, ulint lock_type, F &&release) {
+  std::atomic<bool> entered{};
+
+  std::thread thread([&]() {
+    switch (lock_type) {
+      case RW_LOCK_SHARED:
+        rw_lock_s_lock(lock);
+        entered = true;
+        rw_lock_s_unlock(lock);
+        break;
+      case RW_LOCK_SX:
+        rw_lock_sx_lock(lock);
+        entered = true;
+        rw_lock_sx_unlock(lock);
+        break;
+      default:
+        ut_a(lock_type == RW_LOCK_EX);
+        rw_lock_x_lock(lock);
+        entered = true;
+        rw_lock_x_unlock(lock);
+    }
+  });
+
+  std::this_thread::sleep_for(PARK_WAIT);
+
+  const bool compatible = entered;
+
+  if (!compatible) {
+    release();
+  }
+
+  thread.join();
+
+  ut_a(entered);
+
+  return compatible;
+}
+
+/** SX is compatible with S, and conflicts with SX and X. */
+void rw_lock_sx_compatibility() {
+  rw_lock_t lock;
+
+  std::cout << "rw-lock: sx compatibility\n";
+
+  rw_lock_create(&lock, SYNC_NO_ORDER_CHECK);
+
+  auto no_release = []() { ut_error; };
+  auto sx_unlock = [&]() { rw_lock_sx_unlock(&lock); };
+  auto s_unlock = [&]() { rw_lock_s_unlock(&lock); };
+
+  rw_lock_sx_lock(&lock);
+  ut_a(rw_lock_compatible(&lock, RW_LOCK_SHARED, no_release));
+  ut_a(!rw_lock_compatible(&lock, RW_LOCK_SX, sx_unlock));
+
+  rw_lock_sx_lock(&lock);
+  ut_a(!rw_lock_compatible(&lock, RW_LOCK_EX, sx_unlock));
+
+  rw_lock_s_lock(&lock);
+  ut_a(rw_lock_compatible(&lock, RW_LOCK_SX, no_release));
+  ut_a(!rw_lock_compatible(&lock, RW_LOCK_EX, s_unlock));
+
+  ut_a(!rw_lock_is_locked(&lock, RW_LOCK_SHARED));
+  ut_a(!rw_lock_is_locked(&lock, RW_LOCK_SX));
+  ut_a(!rw_lock_is_locked(&lock, RW_LOCK_EX));
+
+  rw_lock_free(&lock);
+}
+
+/** An sx-lock holder upgrades to an x-lock once the readers have left,
+and the x-lock blocks new readers. */
+void rw_lock_sx_upgrade() {
+  rw_lock_t lock;
+  std::atomic<bool> reader_done{};
+
+  std::cout << "rw-lock: sx to x upgrade\n";
+
+  rw_lock_create(&lock, SYNC_NO_ORDER_CHECK);
+
+  rw_lock_sx_lock(&lock);
+
+  std::thread reader([&]() {
+    rw_lock_s_lock(&lock);
+
+    std::this_thread::sleep_for(PARK_WAIT);
+
+    reader_done = true;
+
+    rw_lock_s_unlock(&lock);
+  });
+
+  /* Let the reader in before the upgrade. */
+  while (!rw_lock_is_locked(&lock, RW_LOCK_SHARED)) {
+    std::this_thread::yield();
+  }
+
+  rw_lock_x_lock(&lock);
+
+  /* The upgrade waited for the reader. */
+  ut_a(reader_done);
+  ut_a(rw_lock_is_locked(&lock, RW_LOCK_EX));
+
+  reader.join();
+
+  auto x_unlock = [&]() { rw_lock_x_unlock(&lock); };
+
+  ut_a(!rw_lock_compatible(&lock, RW_LOCK_SHARED, x_unlock));
+
+  /* The sx-lock is still held after the x-lock is released. */
+  ut_a(rw_lock_is_locked(&lock, RW_LOCK_SX));
+  ut_a(!rw_lock_is_locked(&lock, RW_LOCK_EX));
+
+  rw_lock_sx_unlock(&lock);
+
+  ut_a(!rw_lock_is_locked(&lock, RW_LOCK_SX));
+
+  rw_lock_free(&lock);
+}
+
+/** Threads take S, SX and X locks at random. SX and X holders update a
+counter, which the SX holders upgrade to X for, as a B-tree SMO does. */
+void rw_lock_sx_count() {
+  rw_lock_t lock;
+  ulint count{};
+  std::atomic<ulint> n_updates{};
+
+  std::cout << "rw-lock: " << N_THREADS << " threads taking s, sx and x locks\n";
+
+  rw_lock_create(&lock, SYNC_NO_ORDER_CHECK);
+
+  run_threads([&](int i) {
+    for (int j = 0; j < N_ITERATIONS / 10; ++j) {
+      switch ((i + j) % 3) {
+        case 0:
+          rw_lock_s_lock(&lock);
+          rw_lock_s_unlock(&lock);
+          break;
+        case 1: {
+          rw_lock_sx_lock(&lock);
+
+          /* Only one sx holder at a time, readers may be in. */
+          const auto old_count = count;
+
+          std::this_thread::yield();
+
+          ut_a(count == old_count);
+
+          if (j % 2 == 0) {
+            rw_lock_x_lock(&lock);
+            ++count;
+            ++n_updates;
+            rw_lock_x_unlock(&lock);
+          }
+
+          rw_lock_sx_unlock(&lock);
+          break;
+        }
+        default:
+          rw_lock_x_lock(&lock);
+          ++count;
+          ++n_updates;
+          rw_lock_x_unlock(&lock);
+      }
+    }
+  });
+
+  ut_a(count == n_updates);
+  ut_a(!rw_lock_is_locked(&lock, RW_LOCK_SHARED));
+  ut_a(!rw_lock_is_locked(&lock, RW_LOCK_SX));
+  ut_a(!rw_lock_is_locked(&lock, RW_LOCK_EX));
+
+  rw_lock_free(&lock);
+}
+
+/** Returns the profile of the latches created at a line of this file.
+@param[in] stats                Profile returned by sync_latch_profile_get().
+@param[in] loc                  Where the latches were created.
+@return	the counters of the site, nullptr if not in the profile */
+const Latch_site_stats *latch_site_find(const std::vector<Latch_site_stats> &stats, const Source_location &loc) {
+  for (const auto &s : stats) {
+    if (s.m_line == loc.m_from.line() && s.m_file == "test_sync.cc") {
+      return &s;
+    }
+  }
+
+  return nullptr;
+}
+
+/** Profiles a contended and an uncontended mutex and checks their counters
+and the order of the report. */
+void latch_profile() {
+  mutex_t hot;
+  mutex_t cold;
+  constexpr int N_ACQUIRES = 1000;
+
+  std::cout << "latch profile: hot and cold mutex\n";
+
+  const auto hot_loc = Current_location();
+  mutex_create(&hot, IF_DEBUG("hot_mutex",) IF_SYNC_DEBUG(SYNC_NO_ORDER_CHECK,) hot_loc);
+
+  const auto cold_loc = Current_location();
+  mutex_create(&cold, IF_DEBUG("cold_mutex",) IF_SYNC_DEBUG(SYNC_NO_ORDER_CHECK,) cold_loc);
+
+  sync_latch_profile_reset();
+  sync_latch_profile.store(true, std::memory_order_release);
+
+  run_threads([&](int i) {
+    for (int j = 0; j < N_ACQUIRES; ++j) {
+      mutex_enter(&hot);
+
+      if (j % 100 == i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      }
+
+      mutex_exit(&hot);
+    }
+  });
+
+  for (int j = 0; j < N_ACQUIRES; ++j) {
+    mutex_enter(&cold);
+    mutex_exit(&cold);
+  }
+
+  sync_latch_profile.store(false, std::memory_order_release);
+
+  const auto stats = sync_latch_profile_get(0);
+
+  /* Hottest first: longest wait, then most contended, then most acquired. */
+  ut_a(std::is_sorted(stats.begin(), stats.end(), [](const Latch_site_stats &lhs, const Latch_site_stats &rhs) {
+    return std::tuple(lhs.m_wait_time_us, lhs.m_n_contended, lhs.m_n_acquires) >
+           std::tuple(rhs.m_wait_time_us, rhs.m_n_contended, rhs.m_n_acquires);
+  }));
+
+  auto hot_stats = latch_site_find(stats, hot_loc);
+  auto cold_stats = latch_site_find(stats, cold_loc);
+
+  ut_a(hot_stats != nullptr && cold_stats != nullptr);
+  ut_a(hot_stats < cold_stats);
+
+  ut_a(hot_stats->m_kind == LATCH_KIND_MUTEX);
+  ut_a(hot_stats->m_n_acquires == ulint(N_THREADS) * N_ACQUIRES);
+  ut_a(hot_stats->m_n_contended > 0);
+  ut_a(hot_stats->m_n_os_waits > 0);
+  ut_a(hot_stats->m_wait_time_us > 0);
+
+  ut_a(cold_stats->m_n_acquires == N_ACQUIRES);
+  ut_a(cold_stats->m_n_contended == 0);
+  ut_a(cold_stats->m_n_os_waits == 0);
+  ut_a(cold_stats->m_wait_time_us == 0);
+
+  /* Nothing is counted while profiling is off. */
+  mutex_enter(&cold);
+  mutex_exit(&cold);
+
+  ut_a(latch_site_find(sync_latch_profile_get(0), cold_loc)->m_n_acquires == N_ACQUIRES);
+
+  mutex_free(&hot);
+  mutex_free(&cold);
+}
+
+} // namespace test
+
+int main() {
+  /* Note: The order of initializing and close of the sub-systems is very important. */
+
+  // Startup
+  ut_mem_init();
+
+  os_sync_init();
+
+  srv_config.m_max_n_threads = N_THREADS * 2;
+
+  sync_init();
+
+  // Run the tests
+  test::mutex_count();
+
+  test::mutex_wakeup();
+
+  test::mutex_spin_shrink();
+
+  test::mutex_spin_grow();
+
+  test::mutex_parked_owner();
+
+  test::rw_lock_count();
+
+  test::rw_lock_wakeup();
+
+  test::rw_lock_sx_compatibility();
+
+  test::rw_lock_sx_upgrade();
+
+  test::rw_lock_sx_count();
+
+  test::latch_profile();
+
+  // Shutdown
+  sync_close();
+
+  os_sync_free();
+
+  ut_delete_all_mem();
+
+  exit(EXIT_SUCCESS);
+}
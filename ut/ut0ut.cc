@@ -31,6 +31,8 @@ Created 5/11/1994 Heikki Tuuri
 
 #include <innodb0types.h>
 
+#include <algorithm>
+#include <chrono>
 #include <format>
 #include <sstream>
 
@@ -166,12 +168,40 @@ void ut_sprintf_timestamp(char *buf) {
   );
 }
 
+/** Wall clock time that one unit of ut_delay() should take. This is what
+50 PAUSE instructions used to cost before their latency was raised. */
+constexpr std::chrono::nanoseconds UT_DELAY_UNIT{150};
+
+/** Number of UT_RELAX_CPU() iterations per unit of ut_delay() */
+static ulint ut_delay_loops = 50;
+
+void ut_delay_calibrate() noexcept {
+  constexpr ulint n_loops = 10000;
+
+  /* Take the best of a few runs, the thread may get descheduled. */
+  auto best = std::chrono::nanoseconds::max();
+
+  for (ulint run = 0; run < 5; ++run) {
+    const auto start = std::chrono::steady_clock::now();
+
+    for (ulint i = 0; i < n_loops; ++i) {
+      UT_RELAX_CPU();
+    }
+
+    best = std::min(best, std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start));
+  }
+
+  if (best.count() > 0) {
+    ut_delay_loops = std::clamp<ulint>(UT_DELAY_UNIT.count() * n_loops / best.count(), 1, 1000);
+  }
+}
+
 ulint ut_delay(ulint delay) {
   ulint i, j;
 
   j = 0;
 
-  for (i = 0; i < delay * 50; i++) {
+  for (i = 0; i < delay * ut_delay_loops; i++) {
     j += i;
     UT_RELAX_CPU();
   }